@@ -14,12 +14,19 @@ namespace env
 	{
 		std::string m_name;
 		std::vector<System*> m_systemStack;
+
+		// Systems grouped so that no two systems in a stage conflict. Stages
+		// are updated in order, conflicting systems keep their stack order.
+		std::vector<std::vector<System*>> m_systemStages;
+		bool m_systemStagesDirty = true;
 		std::vector<Window*> m_windows;
 
 		env::IDGenerator m_IDGenerator;
 
 		Scene* m_activeScene = nullptr;
 
+		bool m_running = false;
+
 	public:
 
 		Application(int argc, char** argv, const std::string& name);
@@ -36,11 +43,18 @@ namespace env
 
 		Scene* GetActiveScene();
 
+		// Leaves the main loop after the current iteration
+		void Quit();
+
 	public:
 
 		void PublishEvent(Event& event);
 
 	private:
+
+		void BuildSystemStages();
+		void UpdateSystems(const Duration& delta);
+		void UpdateSystem(System& system, const Duration& delta);
 		
 		void Run();
 		friend int ::main(int argc, char** argv);
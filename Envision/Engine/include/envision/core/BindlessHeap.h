@@ -0,0 +1,55 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/BindlessIndexAllocator.h"
+
+namespace env
+{
+	// One large shader visible CBV/SRV/UAV heap. Views are written once when
+	// their resource is created and keep their index, shaders index the heap
+	// through a single table that covers all of it.
+	class BindlessHeap
+	{
+	private:
+
+		ID3D12DescriptorHeap* m_heap;
+		UINT m_stride;
+
+		D3D12_CPU_DESCRIPTOR_HANDLE m_beginCPU;
+		D3D12_GPU_DESCRIPTOR_HANDLE m_beginGPU;
+
+		BindlessIndexAllocator m_indices;
+		UINT m_numFailedAllocations;
+
+	public:
+
+		BindlessHeap();
+		BindlessHeap(UINT numDescriptors);
+		~BindlessHeap();
+
+		void Initialize(UINT numDescriptors);
+
+		BindlessHeap(BindlessHeap&& other) = delete;
+		BindlessHeap(const BindlessHeap& other) = delete;
+		BindlessHeap& operator=(BindlessHeap&& other) = delete;
+		BindlessHeap& operator=(const BindlessHeap& other) = delete;
+
+	public:
+
+		// Returns an invalid handle if the heap is full, no view may be
+		// written for it. The capacity is fixed when the heap is created.
+		BindlessHandle Allocate();
+
+		// Only once the GPU is done with the descriptor
+		void Free(BindlessHandle handle);
+
+		D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(BindlessHandle handle) const;
+
+		ID3D12DescriptorHeap* GetHeap();
+
+		// Start of the table covering the whole heap
+		D3D12_GPU_DESCRIPTOR_HANDLE GetTable() const;
+
+		const BindlessIndexAllocator& GetIndices() const;
+		UINT GetNumFailedAllocations() const;
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	// Index into a bindless descriptor heap. The generation changes each time
+	// the index is freed, so a handle kept after its descriptor was freed is
+	// detected instead of silently reading whatever reused the index.
+	struct BindlessHandle
+	{
+		static const uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t Index = INVALID_INDEX;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Index != INVALID_INDEX; }
+	};
+
+	// Hands out stable indices in [0, capacity), freed indices are reused
+	// most recent first. Only indices and generations are tracked, so the
+	// allocator is not tied to any graphics API and can be driven by a fake
+	// heap. Freeing has to wait until the GPU is done with the descriptor,
+	// the allocator does not check that.
+	class BindlessIndexAllocator
+	{
+	private:
+
+		uint32_t m_capacity;
+		uint32_t m_nextIndex; // Indices from here on have never been used
+		uint32_t m_numAllocated;
+
+		// Current generation of every index below m_nextIndex
+		std::vector<uint32_t> m_generations;
+		std::vector<bool> m_allocated;
+		std::vector<uint32_t> m_freeList;
+
+	public:
+
+		BindlessIndexAllocator();
+		BindlessIndexAllocator(uint32_t capacity);
+		~BindlessIndexAllocator() = default;
+
+		void Initialize(uint32_t capacity);
+
+		BindlessIndexAllocator(BindlessIndexAllocator&& other) = delete;
+		BindlessIndexAllocator(const BindlessIndexAllocator& other) = delete;
+		BindlessIndexAllocator& operator=(BindlessIndexAllocator&& other) = delete;
+		BindlessIndexAllocator& operator=(const BindlessIndexAllocator& other) = delete;
+
+	public:
+
+		// Returns an invalid handle if all indices are in use
+		BindlessHandle Allocate();
+		void Free(BindlessHandle handle);
+
+		// True if the handle is allocated and has not been freed since
+		bool IsCurrent(BindlessHandle handle) const;
+
+		uint32_t GetCapacity() const;
+		uint32_t GetNumAllocated() const;
+
+		// Highest index ever handed out plus one
+		uint32_t GetHighWaterMark() const;
+	};
+}
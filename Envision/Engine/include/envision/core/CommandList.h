@@ -1,6 +1,8 @@
 #pragma once
 #include "envision/envpch.h"
+#include "envision/core/CommandStream.h"
 #include "envision/resource/Resource.h"
+#include <memory>
 
 namespace env
 {
@@ -21,6 +23,9 @@ namespace env
 
 		ListState m_state;
 
+		// Acquired from a pool of GPU, returned to it when executed
+		bool m_pooled;
+
 	private:
 
 		// Queues has the ability to change state when
@@ -32,7 +37,10 @@ namespace env
 		const D3D12_COMMAND_LIST_TYPE m_type;
 
 		ID3D12GraphicsCommandList* m_list;
-		ID3D12CommandAllocator* m_allocator;
+		ID3D12CommandAllocator* m_allocator; // nullptr from execution until the next reset
+
+		// Only set while a frame is captured, see GPU::BeginCapture
+		std::shared_ptr<CommandStream> m_stream;
 
 		// class GPU is factory for CommandList
 		friend class env::GPU;
@@ -42,6 +50,8 @@ namespace env
 
 		virtual void ResetInherited() {}
 
+		void AttachCapture();
+
 	private:
 
 		CommandList(CommandList&& other) = delete;
@@ -61,6 +71,10 @@ namespace env
 		ID3D12GraphicsCommandList* GetNative();
 
 		void TransitionResource(Resource* resource, D3D12_RESOURCE_STATES newState);
+
+		// Issued as they are, the states of the resources are not updated
+		void ResourceBarriers(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers);
+
 		void SetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps);
 	};
 
@@ -173,5 +187,9 @@ namespace env
 		void SetTarget(WindowTarget* target, Texture2D* depthStencil = nullptr);
 		void SetIndexBuffer(Buffer* buffer);
 		void SetVertexBuffer(Buffer* buffer, UINT slot);
+
+		void SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+		void SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table);
+		void SetRoot32BitConstant(UINT rootIndex, UINT value, UINT offset = 0);
 	};
 }
\ No newline at end of file
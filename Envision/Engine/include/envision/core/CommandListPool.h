@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <assert.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace env
+{
+	// Command lists of one type, created on demand and reused once they have
+	// been executed. Any thread can acquire a list, so jobs can each record
+	// into their own. A list is only handed out again after it is released,
+	// which the queue does when it executes the list. Its allocator is
+	// recycled separately by fence value, so the list can be reset right away.
+	template <typename ListType>
+	class CommandListPool
+	{
+	private:
+
+		std::function<ListType*()> m_create;
+
+		mutable std::mutex m_mutex;
+		std::vector<std::unique_ptr<ListType>> m_lists;
+		std::vector<ListType*> m_free;
+
+	public:
+
+		CommandListPool(std::function<ListType*()> create) :
+			m_create(std::move(create))
+		{
+			//
+		}
+
+		~CommandListPool() = default;
+
+		CommandListPool(const CommandListPool& other) = delete;
+		CommandListPool(const CommandListPool&& other) = delete;
+		CommandListPool& operator=(const CommandListPool& other) = delete;
+		CommandListPool& operator=(const CommandListPool&& other) = delete;
+
+	public:
+
+		// Returns a free list, or a new one if there is none
+		ListType* Acquire()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (!m_free.empty()) {
+					ListType* list = m_free.back();
+					m_free.pop_back();
+					return list;
+				}
+			}
+
+			// Created outside the lock, creation can be slow
+			ListType* list = m_create();
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_lists.emplace_back(list);
+			return list;
+		}
+
+		void Release(ListType* list)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			assert(std::find(m_free.begin(), m_free.end(), list) == m_free.end());
+			m_free.push_back(list);
+		}
+
+		// Deletes all lists, including acquired ones. Only when the queues
+		// are idle.
+		void Clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_free.clear();
+			m_lists.clear();
+		}
+
+		size_t GetNumLists() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_lists.size();
+		}
+
+		size_t GetNumFree() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_free.size();
+		}
+	};
+}
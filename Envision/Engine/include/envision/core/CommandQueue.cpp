@@ -1,5 +1,6 @@
 #include "envision/envpch.h"
 #include "CommandQueue.h"
+#include "envision/core/GPU.h"
 
 env::CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE type) :
     m_type(type),
@@ -53,8 +54,9 @@ UINT64 env::CommandQueue::IncrementFence()
 
 bool env::CommandQueue::IsFenceReached(UINT64 value)
 {
-    if (value <= m_fenceValue)
-        return true;
+    // Values that have not been signaled yet can't have been reached
+    if (value > m_fenceValue)
+        return false;
 
     UINT64 completedValue = m_fence->GetCompletedValue();
     return value <= completedValue;
@@ -67,6 +69,15 @@ void env::CommandQueue::WaitForIdle()
     WaitForSingleObject(m_fenceEvent, INFINITE);
 }
 
+void env::CommandQueue::WaitForFenceCPU(UINT64 value)
+{
+    if (IsFenceReached(value))
+        return;
+
+    m_fence->SetEventOnCompletion(value, m_fenceEvent);
+    WaitForSingleObject(m_fenceEvent, INFINITE);
+}
+
 void env::CommandQueue::WaitForFence(ID3D12Fence* fence, UINT64 value)
 {
     m_queue->Wait(fence, value);
@@ -87,6 +98,11 @@ UINT64 env::CommandQueue::GetNextFenceValue() const
     return m_fenceValue + 1;
 }
 
+UINT64 env::CommandQueue::GetCompletedFenceValue() const
+{
+    return m_fence->GetCompletedValue();
+}
+
 ID3D12CommandQueue* env::CommandQueue::GetCommandQueue()
 {
     return m_queue;
@@ -101,7 +117,7 @@ void env::CommandQueue::QueueList(CommandList* list)
     list->m_state = ListState::Queued;
 }
 
-void env::CommandQueue::Execute()
+UINT64 env::CommandQueue::Execute()
 {
     std::vector<ID3D12CommandList*> lists;
 
@@ -111,11 +127,35 @@ void env::CommandQueue::Execute()
         [&lists](CommandList*& list) { lists.push_back(list->m_list); });
 
     m_queue->ExecuteCommandLists((UINT)lists.size(), lists.data());
+    UINT64 fenceValue = IncrementFence();
+
+    // Lists reset before the capture began have no stream
+    if (FrameCapture* capture = GPU::GetCapture()) {
+        std::vector<std::shared_ptr<CommandStream>> streams;
+        for (CommandList* list : m_queuedLists) {
+            if (list->m_stream)
+                streams.push_back(list->m_stream);
+        }
+        if (!streams.empty())
+            capture->AddSubmission(this, std::move(streams));
+    }
 
     // Return the state of each list to normal, so that the are
-    // not "queued" anymore.
+    // not "queued" anymore. Their allocators are in use until the
+    // fence is reached, the lists get new ones when reset.
     std::for_each(m_queuedLists.begin(),
         m_queuedLists.end(),
-        [](CommandList*& list) { list->m_state = ListState::Closed; });
+        [this, fenceValue](CommandList*& list) {
+            list->m_state = ListState::Closed;
+            list->m_stream = nullptr;
+            if (list->m_allocator) {
+                GPU::RetireCommandAllocator(list->m_type, list->m_allocator, *this, fenceValue);
+                list->m_allocator = nullptr;
+            }
+            if (list->m_pooled)
+                GPU::ReleaseCommandList(list);
+        });
     m_queuedLists.clear();
+
+    return fenceValue;
 }
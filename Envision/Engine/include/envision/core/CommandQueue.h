@@ -1,12 +1,13 @@
 #pragma once
 #include "envision/envpch.h"
 #include "envision/core/CommandList.h"
+#include "envision/core/FenceTimeline.h"
 
 namespace env
 {
 	class GPU;
 
-	class CommandQueue
+	class CommandQueue : public FenceTimeline
 	{
 	private:
 
@@ -35,20 +36,28 @@ namespace env
 
 	public:
 
-		~CommandQueue();
+		~CommandQueue() override;
 
-		UINT64 IncrementFence();
+		UINT64 IncrementFence() override;
 		bool IsFenceReached(UINT64 value);
 
+		// Prefer waiting for the fence value of the work that is needed,
+		// WaitForFenceCPU returns right away if it has been reached
 		void WaitForIdle();
+		void WaitForFenceCPU(UINT64 value);
 		void WaitForFence(ID3D12Fence* fence, UINT64 value);
 		void WaitForQueue(CommandQueue* queue, UINT64 value);
 
 		UINT64 GetFenceValue() const;
 		UINT64 GetNextFenceValue() const;
+		UINT64 GetCompletedFenceValue() const override;
 		ID3D12CommandQueue* GetCommandQueue();
 
 		void QueueList(CommandList* list);
-		void Execute();
+
+		// Executes the queued lists and signals the fence after them. The
+		// allocators of the lists are retired with the returned value, so
+		// the lists can be reset right away.
+		UINT64 Execute();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+#include "envision/envpch.h"
+
+namespace env
+{
+	enum class StreamCommand : UINT8
+	{
+		Transition = 0,
+		SetDescriptorHeaps,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		SetPrimitiveTopology,
+		SetPipelineState,
+		SetViewport,
+		SetScissorRect,
+		SetRenderTarget,
+		SetIndexBuffer,
+		SetVertexBuffer,
+		SetRootConstantBufferView,
+		SetRootDescriptorTable,
+		SetRoot32BitConstant,
+		CopyBufferRegion,
+		CopyResource,
+		Dispatch,
+		Barriers, // Transitions and aliasing barriers issued as one batch
+
+		COUNT
+	};
+
+	const char* GetStreamCommandName(StreamCommand command);
+
+	struct CommandStreamStatistics
+	{
+		UINT NumCommands[(UINT)StreamCommand::COUNT] = { 0 };
+		UINT64 NumBytes = 0; // Encoded commands, without the object table
+		UINT64 NumCopiedBytes = 0;
+		UINT64 NumDrawnInstances = 0;
+
+		void Add(const CommandStreamStatistics& other);
+		UINT GetNumCommands() const;
+	};
+
+	// Compact binary record of what one command list emitted. Each command is
+	// an opcode byte followed by its arguments, integers as LEB128 varints.
+	// Objects are written as indices into a table of the stream, which holds
+	// a reference to each of them, so a stream can be replayed after the
+	// scene that recorded it is gone. Descriptor handles and GPU addresses
+	// are written as they are and are only valid in the recording process.
+	class CommandStream
+	{
+	private:
+
+		const D3D12_COMMAND_LIST_TYPE m_type;
+
+		std::vector<UINT8> m_data;
+
+		std::vector<IUnknown*> m_objects;
+		std::unordered_map<IUnknown*, UINT> m_objectIndices;
+
+	public:
+
+		CommandStream(D3D12_COMMAND_LIST_TYPE type);
+		~CommandStream();
+
+		CommandStream(const CommandStream& other) = delete;
+		CommandStream(const CommandStream&& other) = delete;
+		CommandStream& operator=(const CommandStream& other) = delete;
+		CommandStream& operator=(const CommandStream&& other) = delete;
+
+	public:
+
+		D3D12_COMMAND_LIST_TYPE GetType() const;
+		size_t GetNumBytes() const;
+		size_t GetNumObjects() const;
+
+		// Issues the recorded commands to a native list. With a nullptr list
+		// the stream is only decoded, to fill in the statistics.
+		void Replay(ID3D12GraphicsCommandList* list, CommandStreamStatistics* statistics = nullptr) const;
+
+	public:
+
+		void RecordTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+		void RecordSetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps);
+		void RecordClearRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, const FLOAT color[4]);
+		void RecordClearDepthStencil(D3D12_CPU_DESCRIPTOR_HANDLE target, D3D12_CLEAR_FLAGS flags, FLOAT depth, UINT8 stencil);
+		void RecordDrawInstanced(UINT numVertices, UINT numInstances, UINT vertexOffset, UINT instanceOffset);
+		void RecordDrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT indexOffset, INT vertexOffset, UINT instanceOffset);
+		void RecordSetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+		void RecordSetPipelineState(ID3D12RootSignature* rootSignature, ID3D12PipelineState* state);
+		void RecordSetViewport(const D3D12_VIEWPORT& viewport);
+		void RecordSetScissorRect(const D3D12_RECT& rect);
+		void RecordSetRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil);
+		void RecordSetIndexBuffer(ID3D12Resource* buffer, const D3D12_INDEX_BUFFER_VIEW& view);
+		void RecordSetVertexBuffer(ID3D12Resource* buffer, UINT slot, const D3D12_VERTEX_BUFFER_VIEW& view);
+		void RecordSetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address);
+		void RecordSetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table);
+		void RecordSetRoot32BitConstant(UINT rootIndex, UINT value, UINT offset);
+		void RecordCopyBufferRegion(ID3D12Resource* dest, UINT64 destOffset, ID3D12Resource* src, UINT64 srcOffset, UINT64 numBytes);
+		void RecordCopyResource(ID3D12Resource* dest, ID3D12Resource* src);
+		void RecordDispatch(UINT numThreadGroupsX, UINT numThreadGroupsY, UINT numThreadGroupsZ);
+		void RecordBarriers(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers);
+
+	private:
+
+		void WriteCommand(StreamCommand command);
+		void WriteUInt(UINT64 value);
+		void WriteInt(INT64 value);
+		void WriteFloat(FLOAT value);
+		void WriteObject(IUnknown* object);
+	};
+}
@@ -38,6 +38,16 @@ namespace env
 		}
 	};
 
+	// The transform of an entity with a parent is relative to the parent
+	struct ParentComponent
+	{
+		ID Parent = (ID)entt::entity(entt::null);
+
+		ParentComponent() = default;
+		ParentComponent(ID parent) : Parent(parent) {}
+		ParentComponent(const ParentComponent& other) = default;
+	};
+
 	struct RenderComponent
 	{
 		ID Mesh = ID_ERROR;
@@ -54,4 +64,25 @@ namespace env
 		TransformComponent() = default;
 		TransformComponent(const TransformComponent& other) = default;
 	};
+
+	// Slot in the scene's TransformPool, used instead of a TransformComponent
+	// for entities without a parent. Added and removed through the scene.
+	struct PooledTransformComponent
+	{
+		uint32_t Index = ~0u;
+
+		PooledTransformComponent() = default;
+		PooledTransformComponent(uint32_t index) : Index(index) {}
+		PooledTransformComponent(const PooledTransformComponent& other) = default;
+	};
+
+	// World matrix of the entity, written by the TransformSystem
+	struct WorldTransformComponent
+	{
+		Float4x4 Matrix = Float4x4::Identity;
+
+		WorldTransformComponent() = default;
+		WorldTransformComponent(const Float4x4& matrix) : Matrix(matrix) {}
+		WorldTransformComponent(const WorldTransformComponent& other) = default;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace env
+{
+	// Six planes (left, right, bottom, top, near, far) as normal xyz and
+	// distance w, normalized and pointing into the frustum.
+	struct Frustum
+	{
+		float Planes[6][4];
+
+		// Extracts the planes from a row-major view projection matrix, using
+		// the row vector convention (clip = position * matrix) and a [0, w]
+		// clip space depth range.
+		static Frustum FromViewProjection(const float* matrix);
+	};
+
+	// Tests a sphere against the frustum. Spheres touching the frustum
+	// count as visible, spheres with a NaN center or radius are culled.
+	bool IsSphereVisible(const Frustum& frustum, float centerX, float centerY, float centerZ, float radius);
+
+	// Tests count spheres, stored as separate arrays of each component, four
+	// at a time. Writes 1 to visible for each sphere inside the frustum and 0
+	// otherwise, and returns the number of visible spheres.
+	size_t CullSpheres(const Frustum& frustum,
+		const float* centersX,
+		const float* centersY,
+		const float* centersZ,
+		const float* radii,
+		size_t count,
+		uint8_t* visible);
+}
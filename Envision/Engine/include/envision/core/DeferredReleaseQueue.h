@@ -0,0 +1,55 @@
+#pragma once
+#include "envision/core/FenceTimeline.h"
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace env
+{
+	// Releases objects the GPU might still use once every queue that could
+	// use them has completed the work executed before the release was asked
+	// for, instead of waiting for the queues to go idle.
+	class DeferredReleaseQueue
+	{
+	private:
+
+		struct Fence
+		{
+			FenceTimeline* Timeline;
+			uint64_t Value;
+		};
+
+		struct Entry
+		{
+			std::vector<Fence> Fences;
+			std::function<void()> Release;
+		};
+
+		std::vector<Entry> m_entries;
+
+	public:
+
+		DeferredReleaseQueue() = default;
+		~DeferredReleaseQueue() = default;
+
+		DeferredReleaseQueue(const DeferredReleaseQueue& other) = delete;
+		DeferredReleaseQueue(const DeferredReleaseQueue&& other) = delete;
+		DeferredReleaseQueue& operator=(const DeferredReleaseQueue& other) = delete;
+		DeferredReleaseQueue& operator=(const DeferredReleaseQueue&& other) = delete;
+
+	public:
+
+		// Signals every timeline, release is called once all of them have
+		// reached the signaled values
+		void Push(std::initializer_list<FenceTimeline*> timelines, std::function<void()> release);
+
+		// Calls the releases whose fences have been reached, returns how many
+		size_t Collect();
+
+		// Calls all releases without checking the fences, only when the
+		// queues are known to be idle
+		void ReleaseAll();
+
+		size_t GetNumPending() const;
+	};
+}
@@ -1,30 +1,58 @@
 #pragma once
 #include "envision/envpch.h"
-#include "envision/resource/Resource.h"
+#include "envision/core/RangeAllocator.h"
 
 namespace env
 {
 	struct DescriptorAllocation
 	{
-		D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle;
-		D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle;
+		D3D12_CPU_DESCRIPTOR_HANDLE CPUHandle = { 0 };
+		D3D12_GPU_DESCRIPTOR_HANDLE GPUHandle = { 0 };
+		UINT NumDescriptors = 0;
+
+		// Heap in the allocator's chain and the range in it. Ranges from a
+		// LinearDescriptorAllocator have no range of their own.
+		UINT HeapIndex = 0;
+		RangeAllocation Range;
+
+		bool IsValid() const { return NumDescriptors > 0; }
 	};
 
+	struct DescriptorAllocatorStatistics
+	{
+		UINT NumHeaps = 0;
+		UINT NumDescriptors = 0; // In all heaps
+		UINT NumAllocated = 0;
+		UINT NumAllocations = 0;
+		UINT NumFreeRanges = 0;
+		UINT LargestFreeRange = 0; // In any one heap
+	};
+
+	// Contiguous descriptor ranges from a chain of heaps. Ranges are found
+	// and merged again when freed by a RangeAllocator per heap, and another
+	// heap is added when no heap has a free range that fits.
+	//
+	// A range is always within one heap. Only one shader visible heap per
+	// type can be bound, so with a shader visible allocator the heap of an
+	// allocation has to be the one that is bound when its table is used.
 	class DescriptorAllocator
 	{
 	private:
 
+		struct Heap
+		{
+			ID3D12DescriptorHeap* Native;
+			D3D12_CPU_DESCRIPTOR_HANDLE BeginCPU;
+			D3D12_GPU_DESCRIPTOR_HANDLE BeginGPU;
+			RangeAllocator Ranges;
+		};
+
 		D3D12_DESCRIPTOR_HEAP_TYPE m_type;
 		UINT m_stride;
+		UINT m_heapSize; // Descriptors per heap, larger ranges get a heap of their own
+		bool m_isShaderVisible;
 
-		ID3D12DescriptorHeap* m_heap;
-
-		D3D12_CPU_DESCRIPTOR_HANDLE m_beginCPU;
-		D3D12_GPU_DESCRIPTOR_HANDLE m_beginGPU;
-		UINT m_nextIndex;
-		UINT m_endIndex;
-
-		std::vector<UINT> m_freeList;
+		std::vector<Heap*> m_heaps;
 
 	public:
 
@@ -33,7 +61,8 @@ namespace env
 		~DescriptorAllocator();
 
 		void Initialize(D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptors, bool isShaderVisible);
-		ID3D12DescriptorHeap* GetHeap();
+		ID3D12DescriptorHeap* GetHeap(const DescriptorAllocation& allocation);
+		UINT GetStride() const;
 
 		DescriptorAllocator(DescriptorAllocator&& other) = delete;
 		DescriptorAllocator(const DescriptorAllocator& other) = delete;
@@ -43,7 +72,54 @@ namespace env
 	public:
 
 		DescriptorAllocation Allocate(UINT numDescriptors = 1);
-		void Free(DescriptorAllocation handle);
+		void Free(const DescriptorAllocation& allocation);
+
+		// Frees all ranges, the heaps are kept
 		void Clear();
+
+		DescriptorAllocatorStatistics GetStatistics() const;
+
+	private:
+
+		void AddHeap(UINT numDescriptors);
+		void ReleaseHeaps();
+	};
+
+	// Linear sub-allocator for descriptor tables that only live for a frame.
+	// Blocks are taken from a DescriptorAllocator as needed and kept, Reset
+	// starts over from the first block. Keep one per frame in flight and
+	// reset it once the GPU is done with that frame.
+	class LinearDescriptorAllocator
+	{
+	private:
+
+		DescriptorAllocator* m_parent;
+		UINT m_blockSize;
+
+		std::vector<DescriptorAllocation> m_blocks;
+		UINT m_currentBlock;
+		UINT m_nextOffset; // In the current block
+
+	public:
+
+		LinearDescriptorAllocator();
+		LinearDescriptorAllocator(DescriptorAllocator& parent, UINT blockSize);
+		~LinearDescriptorAllocator();
+
+		void Initialize(DescriptorAllocator& parent, UINT blockSize);
+
+		LinearDescriptorAllocator(LinearDescriptorAllocator&& other) = delete;
+		LinearDescriptorAllocator(const LinearDescriptorAllocator& other) = delete;
+		LinearDescriptorAllocator& operator=(LinearDescriptorAllocator&& other) = delete;
+		LinearDescriptorAllocator& operator=(const LinearDescriptorAllocator& other) = delete;
+
+	public:
+
+		// The returned range can't be freed on its own, only through Reset
+		DescriptorAllocation Allocate(UINT numDescriptors);
+		void Reset();
+
+		// Hands all blocks back to the parent
+		void Release();
 	};
-}
\ No newline at end of file
+}
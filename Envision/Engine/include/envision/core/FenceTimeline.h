@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+
+namespace env
+{
+	// Fence of a queue as seen by the CPU. The queue signals increasing values
+	// once all work executed before the signal is done. Implemented by
+	// CommandQueue, and by MockQueue to drive fenced recycling without a device.
+	class FenceTimeline
+	{
+	public:
+
+		virtual ~FenceTimeline() = default;
+
+		// Signals the next value after all work executed so far, returns it
+		virtual uint64_t IncrementFence() = 0;
+
+		virtual uint64_t GetCompletedFenceValue() const = 0;
+	};
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "envision/core/FenceTimeline.h"
+#include <cstddef>
+#include <deque>
+#include <utility>
+
+namespace env
+{
+	// Pool of objects that are handed out again once the queue they were last
+	// used on has reached the fence value they were retired with. Objects are
+	// checked oldest first, objects retired on different queues may be handed
+	// out in any order.
+	template <typename T>
+	class FencedPool
+	{
+	private:
+
+		struct Retired
+		{
+			const FenceTimeline* Timeline;
+			uint64_t FenceValue;
+			T Item;
+		};
+
+		std::deque<Retired> m_retired;
+
+	public:
+
+		FencedPool() = default;
+		~FencedPool() = default;
+
+		FencedPool(const FencedPool& other) = delete;
+		FencedPool(const FencedPool&& other) = delete;
+		FencedPool& operator=(const FencedPool& other) = delete;
+		FencedPool& operator=(const FencedPool&& other) = delete;
+
+	public:
+
+		// Returns false if no retired object has completed yet
+		bool Acquire(T& item)
+		{
+			for (auto it = m_retired.begin(); it != m_retired.end(); ++it) {
+				if (it->FenceValue <= it->Timeline->GetCompletedFenceValue()) {
+					item = std::move(it->Item);
+					m_retired.erase(it);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void Retire(T item, const FenceTimeline& timeline, uint64_t fenceValue)
+		{
+			m_retired.push_back({ &timeline, fenceValue, std::move(item) });
+		}
+
+		// Calls func(item) for every retired object and empties the pool,
+		// regardless of the fences
+		template <typename Func>
+		void Clear(Func func)
+		{
+			for (Retired& retired : m_retired)
+				func(retired.Item);
+			m_retired.clear();
+		}
+
+		size_t GetNumRetired() const
+		{
+			return m_retired.size();
+		}
+	};
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/CommandStream.h"
+#include <memory>
+#include <mutex>
+
+namespace env
+{
+	class CommandQueue;
+
+	struct FrameReplayStatistics
+	{
+		UINT NumLists = 0;
+		float RecordTime = 0.f; // Seconds spent decoding the streams into native lists
+		float ExecuteTime = 0.f; // Seconds spent in CommandQueue::Execute
+	};
+
+	// The command streams of every list executed while the capture is set
+	// on the GPU, in execution order. Replaying records the streams into
+	// pooled lists again and executes them on the queues they were captured
+	// from, so a frame can be re-run without the scene or the renderer.
+	//
+	// The captured states are replayed as they are, so a capture should
+	// start and end with the resources in the same states, as whole frames
+	// do. Don't replay while a capture is set.
+	class FrameCapture
+	{
+	private:
+
+		struct Submission
+		{
+			CommandQueue* Queue;
+			std::vector<std::shared_ptr<CommandStream>> Streams;
+		};
+
+		std::mutex m_mutex;
+		std::vector<Submission> m_submissions;
+
+	public:
+
+		FrameCapture() = default;
+		~FrameCapture() = default;
+
+		FrameCapture(const FrameCapture& other) = delete;
+		FrameCapture(const FrameCapture&& other) = delete;
+		FrameCapture& operator=(const FrameCapture& other) = delete;
+		FrameCapture& operator=(const FrameCapture&& other) = delete;
+
+	public:
+
+		// Called by the queues when they execute lists with streams
+		void AddSubmission(CommandQueue* queue, std::vector<std::shared_ptr<CommandStream>>&& streams);
+
+		void Clear();
+
+		bool IsEmpty();
+		size_t GetNumSubmissions();
+		size_t GetNumStreams();
+
+		// Decodes all streams without executing them
+		CommandStreamStatistics GetStatistics();
+
+		// Records and executes the captured frame once. Queues only wait for
+		// each other where the captured submissions switch queue.
+		FrameReplayStatistics Replay();
+	};
+}
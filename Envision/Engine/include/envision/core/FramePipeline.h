@@ -0,0 +1,135 @@
+#pragma once
+#include <array>
+#include <assert.h>
+#include <chrono>
+#include <cstdint>
+
+namespace env
+{
+	// Keeps up to depth frames in flight on a queue. Every frame uses one of
+	// depth slots for its per frame resources, and before a slot is used
+	// again the frame that last used it has to be completed by the queue.
+	// The CPU can thus build the next frames while the queue executes the
+	// previous ones.
+	//
+	// QueueType is a CommandQueue or anything with the same fence functions:
+	//	uint64_t IncrementFence()			Signals after all executed work
+	//	bool IsFenceReached(uint64_t value)
+	//	void WaitForFenceCPU(uint64_t value)
+	template <typename QueueType>
+	class FramePipeline
+	{
+	public:
+
+		static constexpr unsigned int MAX_DEPTH = 3;
+
+	private:
+
+		QueueType& m_queue;
+		unsigned int m_depth;
+
+		uint64_t m_numFrames;
+		unsigned int m_frameIndex;
+
+		// Fence value signaled after the last frame in each slot, 0 if none
+		std::array<uint64_t, MAX_DEPTH> m_fenceValues;
+
+		float m_waitTime;
+
+	public:
+
+		FramePipeline(QueueType& queue, unsigned int depth = 2) :
+			m_queue(queue),
+			m_depth(depth),
+			m_numFrames(0),
+			m_frameIndex(0),
+			m_waitTime(0.f)
+		{
+			assert(depth >= 1 && depth <= MAX_DEPTH);
+			m_fenceValues.fill(0);
+		}
+
+		~FramePipeline() = default;
+
+		FramePipeline(const FramePipeline& other) = delete;
+		FramePipeline(const FramePipeline&& other) = delete;
+		FramePipeline& operator=(const FramePipeline& other) = delete;
+		FramePipeline& operator=(const FramePipeline&& other) = delete;
+
+	public:
+
+		// Waits until the slot of the next frame is free and returns its index
+		unsigned int BeginFrame()
+		{
+			m_frameIndex = (unsigned int)(m_numFrames % m_depth);
+			m_numFrames++;
+
+			auto waitStart = std::chrono::high_resolution_clock::now();
+			uint64_t fenceValue = m_fenceValues[m_frameIndex];
+			if (fenceValue != 0)
+				m_queue.WaitForFenceCPU(fenceValue);
+			m_waitTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - waitStart).count();
+
+			return m_frameIndex;
+		}
+
+		// Call after the frame's work has been executed on the queue. Returns
+		// the fence value the slot waits for before it is used again.
+		uint64_t EndFrame()
+		{
+			uint64_t fenceValue = m_queue.IncrementFence();
+			m_fenceValues[m_frameIndex] = fenceValue;
+			return fenceValue;
+		}
+
+		// Waits until all frames in flight are completed
+		void Flush()
+		{
+			for (uint64_t& fenceValue : m_fenceValues) {
+				if (fenceValue != 0)
+					m_queue.WaitForFenceCPU(fenceValue);
+				fenceValue = 0;
+			}
+		}
+
+		// Flushes the pipeline before changing the depth, so no slot that is
+		// still in use is handed out again
+		void SetDepth(unsigned int depth)
+		{
+			assert(depth >= 1 && depth <= MAX_DEPTH);
+			if (depth == m_depth)
+				return;
+
+			Flush();
+			m_depth = depth;
+			m_numFrames = 0;
+		}
+
+		unsigned int GetDepth() const
+		{
+			return m_depth;
+		}
+
+		// Slot of the frame since the last BeginFrame
+		unsigned int GetFrameIndex() const
+		{
+			return m_frameIndex;
+		}
+
+		unsigned int GetNumFramesInFlight()
+		{
+			unsigned int numInFlight = 0;
+			for (uint64_t fenceValue : m_fenceValues) {
+				if (fenceValue != 0 && !m_queue.IsFenceReached(fenceValue))
+					numInFlight++;
+			}
+			return numInFlight;
+		}
+
+		// Seconds the last BeginFrame was blocked by the queue
+		float GetWaitTime() const
+		{
+			return m_waitTime;
+		}
+	};
+}
@@ -2,6 +2,10 @@
 #include "envision/envpch.h"
 #include "envision/core/CommandQueue.h"
 #include "envision/core/CommandList.h"
+#include "envision/core/CommandListPool.h"
+#include "envision/core/FencedPool.h"
+#include "envision/core/FrameCapture.h"
+#include <atomic>
 
 namespace env
 {
@@ -20,6 +24,19 @@ namespace env
 		CommandQueue m_copyQueue;
 		CommandQueue m_presentQueue;
 
+		// Executed command allocators, per list type. Lists are recorded on
+		// several threads, so the pools are guarded.
+		std::mutex m_allocatorMutex;
+		FencedPool<ID3D12CommandAllocator*> m_directAllocators;
+		FencedPool<ID3D12CommandAllocator*> m_computeAllocators;
+		FencedPool<ID3D12CommandAllocator*> m_copyAllocators;
+
+		CommandListPool<DirectList> m_directListPool;
+		CommandListPool<ComputeList> m_computeListPool;
+		CommandListPool<CopyList> m_copyListPool;
+
+		std::atomic<FrameCapture*> m_capture;
+
 	public:
 
 		static GPU* Initialize();
@@ -45,6 +62,7 @@ namespace env
 	public:
 
 		static ID3D12Device* GetDevice();
+		static size_t GetMaxVideoMemory(); // Dedicated memory of the adapter
 		static CommandQueue& GetDirectQueue();
 		static CommandQueue& GetComputeQueue();
 		static CommandQueue& GetCopyQueue();
@@ -54,8 +72,30 @@ namespace env
 		static ComputeList* CreateComputeCommandList(bool recordDirectly = false);
 		static CopyList* CreateCopyCommandList(bool recordDirectly = false);
 
+		// Pooled lists for recording a single submission, safe to call from
+		// any thread. The list is reset and recording, and goes back to the
+		// pool when a queue executes it.
+		static DirectList* AcquireDirectList();
+		static ComputeList* AcquireComputeList();
+		static CopyList* AcquireCopyList();
+		static void ReleaseCommandList(CommandList* list);
+
+		// Command allocators are recycled once the queue they were executed
+		// on has reached the fence value they were retired with. An acquired
+		// allocator is reset, or new if none is free.
+		static ID3D12CommandAllocator* AcquireCommandAllocator(D3D12_COMMAND_LIST_TYPE type);
+		static void RetireCommandAllocator(D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* allocator, const FenceTimeline& timeline, UINT64 fenceValue);
+
+		// Lists reset while a capture is set record a command stream, which
+		// is added to the capture when the list is executed. Set and unset
+		// between frames.
+		static void BeginCapture(FrameCapture* capture);
+		static void EndCapture();
+		static FrameCapture* GetCapture();
+
 	private:
 
 		void InitDevice();
+		FencedPool<ID3D12CommandAllocator*>& GetAllocatorPool(D3D12_COMMAND_LIST_TYPE type);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,71 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/GPUMemoryPools.h"
+
+namespace env
+{
+	// Places resources in large heaps instead of giving each its own
+	// committed heap. Each pool has its own list of heaps, as tier 1 heaps
+	// only hold buffers, textures or targets, and a RangeAllocator per heap
+	// hands out whole 64 KB pages. Another heap is added when none has room.
+	//
+	// Small constant buffers would still take a page each, so they are
+	// packed at 256 byte alignment into shared page sized buffers instead.
+	// Their native resource is the shared buffer and their data starts at
+	// GPUAllocation::Offset. Large resources and ones with a larger than
+	// page alignment get a committed resource of their own.
+	//
+	// Which pages each resource takes is kept by GPUMemoryPools, this creates
+	// the heaps, shared buffers and resources on the device. Memory is only
+	// freed with Free once the GPU is done with the resource and its native
+	// resource has been released.
+	class GPUMemoryAllocator : public GPUMemoryBlockFactory
+	{
+	private:
+
+		struct Block
+		{
+			ID3D12Heap* Heap = nullptr; // Placed pools
+			ID3D12Resource* Buffer = nullptr; // The shared buffer of a small buffer block
+			GPUAllocation BufferAllocation;
+		};
+
+		// Which pages are taken, m_blocks has the native block of each
+		GPUMemoryPools m_pools;
+		std::vector<Block> m_blocks[(UINT)GPUMemoryPool::COUNT];
+
+	public:
+
+		GPUMemoryAllocator();
+		~GPUMemoryAllocator();
+
+		GPUMemoryAllocator(const GPUMemoryAllocator& other) = delete;
+		GPUMemoryAllocator(const GPUMemoryAllocator&& other) = delete;
+		GPUMemoryAllocator& operator=(const GPUMemoryAllocator& other) = delete;
+		GPUMemoryAllocator& operator=(const GPUMemoryAllocator&& other) = delete;
+
+	public:
+
+		// Places the resource in a heap of the pool that matches its type and
+		// flags, or creates it committed if it is too large to share a heap
+		ID3D12Resource* CreateResource(const D3D12_RESOURCE_DESC& desc,
+			D3D12_HEAP_TYPE heapType,
+			D3D12_RESOURCE_STATES initialState,
+			const D3D12_CLEAR_VALUE* clearValue,
+			GPUAllocation& allocation);
+
+		// Returns a reference to a shared buffer in the COMMON state, the
+		// data starts at allocation.Offset
+		ID3D12Resource* CreateSmallBuffer(UINT64 numBytes, GPUAllocation& allocation);
+
+		void Free(const GPUAllocation& allocation);
+
+		GPUMemoryStatistics GetStatistics() const;
+
+	private:
+
+		GPUMemoryPool GetPool(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType) const;
+
+		void CreateBlock(GPUMemoryPool pool, uint64_t numBytes) override;
+	};
+}
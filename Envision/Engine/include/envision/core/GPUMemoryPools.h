@@ -0,0 +1,139 @@
+#pragma once
+#include "envision/core/RangeAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace env
+{
+	enum class GPUMemoryPool : uint32_t
+	{
+		DefaultBuffers = 0,
+		DefaultTextures,
+		DefaultTargets, // Render target and depth stencil textures
+		UploadBuffers,
+		SmallBuffers, // Constant buffers sharing a buffer from DefaultBuffers
+
+		COUNT,
+		Committed = COUNT,
+	};
+
+	const char* GetGPUMemoryPoolName(GPUMemoryPool pool);
+
+	// Where the memory of a resource lives
+	struct GPUAllocation
+	{
+		GPUMemoryPool Pool = GPUMemoryPool::Committed;
+		uint32_t BlockIndex = 0;
+		RangeAllocation Range; // In pages of the pool
+		uint64_t NumBytes = 0; // As reserved, rounded up to whole pages
+
+		// Into the native resource, only small buffers don't start at zero
+		uint64_t Offset = 0;
+	};
+
+	struct GPUMemoryPoolStatistics
+	{
+		uint32_t NumBlocks = 0;
+		uint64_t BlockBytes = 0; // Reserved in the blocks
+		uint32_t NumAllocations = 0;
+		uint64_t AllocatedBytes = 0;
+	};
+
+	struct GPUMemoryStatistics
+	{
+		GPUMemoryPoolStatistics Pools[(uint32_t)GPUMemoryPool::COUNT];
+
+		uint32_t NumCommitted = 0;
+		uint64_t CommittedBytes = 0;
+
+		// Dedicated video memory of the adapter, 0 if unknown
+		uint64_t Budget = 0;
+
+		// Heaps and committed resources, small buffer pages are counted in
+		// the blocks of DefaultBuffers
+		uint64_t GetReservedBytes() const;
+	};
+
+	// Creates the native memory of a new block. Implemented by
+	// GPUMemoryAllocator with heaps and buffers on the device, and by tests
+	// to drive the pools without one.
+	class GPUMemoryBlockFactory
+	{
+	public:
+
+		virtual ~GPUMemoryBlockFactory() = default;
+
+		// Called when the pool has no room, the block gets the next index
+		virtual void CreateBlock(GPUMemoryPool pool, uint64_t numBytes) = 0;
+	};
+
+	// Which pages of which block each allocation of GPUMemoryAllocator takes,
+	// without the heaps themselves. Each pool has its own list of blocks, and
+	// a RangeAllocator per block hands out whole pages. Another block is
+	// added when none has room.
+	//
+	// Small buffers are packed at 256 byte alignment into page sized blocks.
+	// Large allocations and ones with a larger than page alignment are only
+	// counted, they get committed memory of their own.
+	class GPUMemoryPools
+	{
+	public:
+
+		// D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT and
+		// D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT
+		static const uint64_t PAGE_SIZE = 64 * 1024;
+		static const uint64_t BLOCK_SIZE = 64 * 1024 * 1024;
+		static const uint64_t SMALL_BUFFER_ALIGNMENT = 256;
+		static const uint64_t SMALL_BUFFER_MAX_SIZE = 4096;
+
+	private:
+
+		struct Pool
+		{
+			uint64_t PageSize;
+			uint64_t BlockSize;
+			std::vector<std::unique_ptr<RangeAllocator>> Blocks;
+		};
+
+		GPUMemoryBlockFactory& m_factory;
+		Pool m_pools[(uint32_t)GPUMemoryPool::COUNT];
+
+		uint32_t m_numCommitted;
+		uint64_t m_committedBytes;
+
+	public:
+
+		GPUMemoryPools(GPUMemoryBlockFactory& factory);
+		~GPUMemoryPools() = default;
+
+		GPUMemoryPools(const GPUMemoryPools& other) = delete;
+		GPUMemoryPools(const GPUMemoryPools&& other) = delete;
+		GPUMemoryPools& operator=(const GPUMemoryPools& other) = delete;
+		GPUMemoryPools& operator=(const GPUMemoryPools&& other) = delete;
+
+	public:
+
+		// Pages in a block of the pool, or committed memory if the resource is
+		// half a block or more, which would mostly waste the rest of the
+		// block, or needs a larger alignment than the pages have
+		GPUAllocation Allocate(GPUMemoryPool pool, uint64_t numBytes, uint64_t alignment);
+
+		// A slot in a shared buffer of the SmallBuffers pool, its data starts
+		// at Offset into the buffer of the block
+		GPUAllocation AllocateSmallBuffer(uint64_t numBytes);
+
+		void Free(const GPUAllocation& allocation);
+
+		// Budget is left at 0, only the device knows it
+		GPUMemoryStatistics GetStatistics() const;
+
+		uint32_t GetNumBlocks(GPUMemoryPool pool) const;
+
+	private:
+
+		// Finds pages in any block of the pool, adds a block if none has room
+		GPUAllocation AllocatePages(GPUMemoryPool pool, uint64_t numBytes);
+	};
+}
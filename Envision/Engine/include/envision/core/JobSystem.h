@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace env
+{
+	// Singleton
+	// Worker threads that each own a deque of jobs. A worker takes the
+	// newest job from its own deque and steals the oldest job from another
+	// worker when its own is empty. Jobs can depend on other jobs and are
+	// only queued once all of their dependencies are done. Threads waiting
+	// for a job run other jobs in the meantime, so waiting from within a job
+	// is allowed.
+	class JobSystem
+	{
+	public:
+
+		struct Job;
+		using JobHandle = std::shared_ptr<Job>;
+
+		struct Job
+		{
+			std::function<void()> Function;
+
+			// Dependencies left, plus one until the job has been scheduled
+			std::atomic<int> NumPending;
+			std::atomic<bool> Done;
+
+			std::mutex Mutex;
+			std::vector<JobHandle> Continuations; // Jobs depending on this one
+		};
+
+	private:
+
+		struct Worker
+		{
+			std::mutex Mutex;
+			std::deque<JobHandle> Jobs;
+		};
+
+		std::vector<std::thread> m_threads;
+		std::vector<std::unique_ptr<Worker>> m_workers;
+
+		// Jobs scheduled from threads that are not workers
+		Worker m_sharedQueue;
+
+		std::atomic<size_t> m_numQueued;
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wakeCondition;
+		bool m_stop;
+
+		std::atomic<uint64_t> m_numStolen;
+
+	public:
+
+		static JobSystem* Initialize(unsigned int numThreads = 0);
+		static JobSystem* Get();
+		static void Finalize();
+
+	private:
+
+		static JobSystem* s_instance;
+
+		JobSystem(unsigned int numThreads);
+		~JobSystem();
+
+		JobSystem(const JobSystem& other) = delete;
+		JobSystem(const JobSystem&& other) = delete;
+		JobSystem& operator=(const JobSystem& other) = delete;
+		JobSystem& operator=(const JobSystem&& other) = delete;
+
+	private:
+
+		void WorkerLoop(size_t workerIndex);
+		void Push(const JobHandle& job);
+		JobHandle Pop(size_t workerIndex);
+		void Execute(const JobHandle& job);
+
+	public:
+
+		// Number of threads running jobs, including one waiting thread
+		unsigned int GetNumThreads() const;
+
+		// Number of jobs taken from another worker since the start
+		uint64_t GetNumStolen() const;
+
+		// The job is queued once all dependencies are done
+		JobHandle Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies = {});
+		JobHandle Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies);
+
+		// Runs other jobs until the job is done
+		void Wait(const JobHandle& job);
+		void Wait(const std::vector<JobHandle>& jobs);
+
+		// Runs one queued job if there is any, returns false otherwise
+		bool RunOne();
+
+		// Calls task(i) for all i in [0, numTasks) and returns when all calls
+		// have returned. Indices are handed out in order to the participating
+		// threads. maxThreads limits the number of threads used, 0 uses all
+		// of them.
+		void ParallelFor(size_t numTasks, const std::function<void(size_t)>& task, unsigned int maxThreads = 0);
+	};
+}
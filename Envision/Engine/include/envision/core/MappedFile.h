@@ -0,0 +1,40 @@
+#pragma once
+#include "envision/envpch.h"
+
+namespace env
+{
+	// Read-only view of a whole file mapped into memory
+	class MappedFile
+	{
+	private:
+
+#ifdef PLATFORM_NULL
+		int m_file; // POSIX file descriptor
+#else
+		HANDLE m_file;
+		HANDLE m_mapping;
+#endif
+		const void* m_data;
+		size_t m_size;
+
+	public:
+
+		MappedFile();
+		~MappedFile();
+
+		MappedFile(MappedFile&& other) = delete;
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(MappedFile&& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+
+	public:
+
+		// Returns false if the file can't be opened or is empty
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const;
+		const void* GetData() const;
+		size_t GetSize() const;
+	};
+}
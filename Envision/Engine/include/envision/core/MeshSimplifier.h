@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	struct SimplifiedMesh
+	{
+		std::vector<uint32_t> Indices;
+
+		// Largest collapse error so far, as a distance in the units of the
+		// positions. Roughly how far the surface moved from the original.
+		float Error = 0.f;
+	};
+
+	// Quadric error metric simplification by edge collapses. Vertices are
+	// only ever collapsed onto other vertices, so every result is an index
+	// list over the original vertices and can share their vertex buffer.
+	//
+	// Vertices are structs of floats starting with the position, vertexStride
+	// is in bytes. Vertices at the same position are simplified as one, when
+	// a corner moves to another position it takes the vertex there whose
+	// other floats, like the normal and texture coordinates, are closest to
+	// its own. Border edges are kept in place by extra planes along them.
+	//
+	// One greedy pass takes the cheapest collapse first and writes a result
+	// each time the number of indices drops below the next target, so the
+	// targets have to be in decreasing order. The pass stops early when no
+	// collapse is left that keeps the surface from folding over. What it got
+	// to is then written if it has fewer indices than the result before, and
+	// nothing is written for the remaining targets, so there may be fewer
+	// results than targets.
+	void SimplifyMesh(const float* vertices, size_t vertexStride, size_t numVertices,
+		const uint32_t* indices, size_t numIndices,
+		const size_t* targetNumIndices, size_t numTargets,
+		std::vector<SimplifiedMesh>& results);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "envision/core/FenceTimeline.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace env
+{
+	// Stand-in for a CommandQueue without a GPU. Executed work is a duration
+	// that a thread of the queue spins for, in submission order, and fences
+	// are reached once all work executed before them is done. Used to measure
+	// how frames are pipelined on the CPU.
+	class MockQueue : public FenceTimeline
+	{
+	public:
+
+		using Clock = std::chrono::high_resolution_clock;
+
+	private:
+
+		struct Item
+		{
+			float Seconds;
+			uint64_t FenceValue; // Signal once reached if not 0
+		};
+
+		std::thread m_thread;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_itemCondition;
+		std::condition_variable m_fenceCondition;
+		std::deque<Item> m_items;
+		bool m_stop;
+
+		uint64_t m_fenceValue;
+		uint64_t m_completedFenceValue;
+
+		// Indexed by fence value minus one
+		std::vector<Clock::time_point> m_completionTimes;
+
+	public:
+
+		MockQueue();
+		~MockQueue() override;
+
+		MockQueue(const MockQueue& other) = delete;
+		MockQueue(const MockQueue&& other) = delete;
+		MockQueue& operator=(const MockQueue& other) = delete;
+		MockQueue& operator=(const MockQueue&& other) = delete;
+
+	private:
+
+		void Run();
+
+	public:
+
+		// Queues work that keeps the queue busy for the given time
+		void Execute(float seconds);
+
+		uint64_t IncrementFence() override;
+		bool IsFenceReached(uint64_t value);
+		void WaitForFenceCPU(uint64_t value);
+		void WaitForIdle();
+
+		uint64_t GetFenceValue() const;
+		uint64_t GetCompletedFenceValue() const override;
+
+		// Time the fence value was reached, the value has to be reached
+		Clock::time_point GetCompletionTime(uint64_t value);
+	};
+}
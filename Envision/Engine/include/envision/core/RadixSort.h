@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace env
+{
+	// Stable LSD radix sort of 64-bit keys with a 32-bit value per key, eight
+	// bits per pass. Passes where all keys share the same digit are skipped,
+	// so keys that only use their lower bits are cheap to sort.
+	// The scratch arrays need room for count elements. Returns true if the
+	// result ended up in the scratch arrays instead of keys and values.
+	bool RadixSort(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues, size_t count);
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	struct RangeAllocation
+	{
+		static const uint32_t INVALID_OFFSET = ~0u;
+
+		uint32_t Offset = INVALID_OFFSET;
+		uint32_t Size = 0;
+		uint32_t Node = 0; // Used by the allocator to find the range when freed
+
+		bool IsValid() const { return Offset != INVALID_OFFSET; }
+	};
+
+	// Two-level segregated fit (TLSF) allocator of ranges in [0, capacity).
+	// Free ranges are kept in size classes, the first level is the power of
+	// two of the size and the second level splits it linearly, so finding a
+	// fitting range is a couple of bit scans. Freed ranges are merged with
+	// free neighbours right away.
+	//
+	// Only offsets and sizes are tracked, so the allocator is not tied to any
+	// graphics API and can be driven by a fake heap.
+	class RangeAllocator
+	{
+	private:
+
+		static const uint32_t SECOND_LEVEL_LOG2 = 3;
+		static const uint32_t NUM_SECOND_LEVELS = 1 << SECOND_LEVEL_LOG2;
+		static const uint32_t NUM_FIRST_LEVELS = 32 - SECOND_LEVEL_LOG2 + 1;
+		static const uint32_t NO_NODE = ~0u;
+
+		struct Node
+		{
+			uint32_t Offset;
+			uint32_t Size;
+
+			// Neighbours in address order
+			uint32_t PreviousRange;
+			uint32_t NextRange;
+
+			// Neighbours in the free list of the size class, if free
+			uint32_t PreviousFree;
+			uint32_t NextFree;
+
+			bool IsFree;
+		};
+
+		uint32_t m_capacity;
+		uint32_t m_numAllocated;
+		uint32_t m_numAllocations;
+		uint32_t m_numFreeRanges;
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_unusedNodes;
+
+		// A bit per first level with any free range, and per first level a
+		// bit per second level with any free range
+		uint32_t m_firstLevelMask;
+		uint32_t m_secondLevelMasks[NUM_FIRST_LEVELS];
+		uint32_t m_freeLists[NUM_FIRST_LEVELS][NUM_SECOND_LEVELS];
+
+	public:
+
+		RangeAllocator();
+		RangeAllocator(uint32_t capacity);
+		~RangeAllocator() = default;
+
+		void Initialize(uint32_t capacity);
+
+		RangeAllocator(RangeAllocator&& other) = delete;
+		RangeAllocator(const RangeAllocator& other) = delete;
+		RangeAllocator& operator=(RangeAllocator&& other) = delete;
+		RangeAllocator& operator=(const RangeAllocator& other) = delete;
+
+	public:
+
+		// Returns an invalid allocation if there is no free range that fits
+		RangeAllocation Allocate(uint32_t size);
+		void Free(const RangeAllocation& allocation);
+
+		// Frees everything at once
+		void Clear();
+
+		uint32_t GetCapacity() const;
+		uint32_t GetNumAllocated() const;
+		uint32_t GetNumAllocations() const;
+		uint32_t GetNumFreeRanges() const;
+
+		// Walks the free lists, meant for statistics
+		uint32_t GetLargestFreeRange() const;
+
+	private:
+
+		static void GetSizeClass(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+
+		uint32_t CreateNode(uint32_t offset, uint32_t size);
+		void DestroyNode(uint32_t node);
+
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+
+		// First free range in the smallest size class where all ranges fit
+		// size, or a fitting range in the class of size itself
+		uint32_t FindFree(uint32_t size) const;
+	};
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include "envision/core/RangeAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace env
+{
+	struct RenderGraphTextureDesc
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		uint32_t Format = 0; // Opaque to the graph, a DXGI_FORMAT in the engine
+		uint32_t BindFlags = 0; // Opaque as well, TextureBindType in the engine
+
+		// Of the placed texture, as reported by the device
+		uint64_t NumBytes = 0;
+		uint64_t Alignment = 0;
+
+		bool operator==(const RenderGraphTextureDesc& other) const;
+	};
+
+	enum class RenderGraphBarrierType : uint32_t
+	{
+		Transition = 0,
+		Aliasing, // The memory of the resource was used by another transient before
+	};
+
+	struct RenderGraphBarrier
+	{
+		RenderGraphBarrierType Type;
+		uint32_t Resource;
+
+		// Transitions only. The first transition of a transient texture has
+		// no known state before, the state of the texture is used instead.
+		uint32_t StateBefore;
+		uint32_t StateAfter;
+	};
+
+	struct RenderGraphStatistics
+	{
+		uint32_t NumPasses = 0;
+		uint32_t NumCulledPasses = 0;
+		uint32_t NumResources = 0;
+		uint32_t NumTransientTextures = 0; // Used by passes that were not culled
+
+		uint32_t NumTransitions = 0;
+		uint32_t NumAliasingBarriers = 0;
+		uint32_t NumBarrierBatches = 0; // Pass boundaries with any barriers
+
+		uint64_t TransientBytes = 0; // All transient textures on their own
+		uint64_t HeapBytes = 0; // With aliasing
+	};
+
+	// Passes in execution order, each declaring the resources it reads and
+	// writes and the state it needs them in. Compile works out everything
+	// the passes don't have to do themselves:
+	//
+	//	- Passes whose results are never used are culled. A pass is kept if
+	//	  it has side effects, writes an imported resource, or writes a
+	//	  resource a kept pass after it reads or writes. Writes count as uses
+	//	  as well since they may blend or depth test against what is there.
+	//	- The transitions every pass needs are batched in front of it, and
+	//	  imported resources are left in their final state at the end.
+	//	- Transient textures only live from their first to their last use,
+	//	  and are placed in one heap by a RangeAllocator in that order, so
+	//	  textures that are never alive at the same time share memory. The
+	//	  content of a transient texture is undefined at its first use, the
+	//	  first pass using it has to clear or overwrite it.
+	//
+	// States are opaque bit masks, D3D12_RESOURCE_STATES in the engine.
+	// Reads of a resource in one pass are combined, a pass that writes a
+	// resource has it in the state of the write. Nothing here depends on the
+	// graphics API, so the graph can be compiled and measured on its own.
+	class RenderGraph
+	{
+	public:
+
+		static const uint32_t INVALID_INDEX = ~0u;
+		static const uint32_t UNKNOWN_STATE = ~0u;
+		static const uint64_t PAGE_SIZE = 64 * 1024; // Placement granularity in the heap
+
+	private:
+
+		struct Access
+		{
+			uint32_t Resource;
+			uint32_t State;
+			bool IsWrite;
+		};
+
+		struct Pass
+		{
+			std::string Name;
+			bool HasSideEffects;
+			std::vector<Access> Accesses;
+
+			// Compiled
+			bool IsCulled;
+			uint32_t FirstBarrier;
+			uint32_t NumBarriers;
+		};
+
+		struct Resource
+		{
+			std::string Name;
+			bool IsImported;
+			uint32_t InitialState; // Imported only
+			uint32_t FinalState; // Imported only, UNKNOWN_STATE leaves it as the last pass did
+			RenderGraphTextureDesc Desc; // Transient only
+
+			// Compiled
+			bool IsNeeded;
+			uint32_t FirstPass;
+			uint32_t LastPass;
+			uint64_t HeapOffset;
+			bool IsAliased;
+		};
+
+		std::vector<Pass> m_passes;
+		std::vector<Resource> m_resources;
+
+		std::vector<RenderGraphBarrier> m_barriers;
+		uint32_t m_firstFinalBarrier;
+		uint32_t m_numFinalBarriers;
+
+		// Kept between compiles for their memory
+		std::vector<uint32_t> m_states;
+		std::vector<uint32_t> m_accessPasses;
+		std::vector<uint32_t> m_readStates;
+		std::vector<uint32_t> m_writeStates;
+		std::vector<uint32_t> m_transients;
+		std::vector<uint32_t> m_transientEnds;
+		std::vector<RangeAllocation> m_heapRanges;
+		RangeAllocator m_heapAllocator;
+
+		uint64_t m_heapSize;
+		RenderGraphStatistics m_statistics;
+		bool m_isCompiled;
+
+	public:
+
+		RenderGraph();
+		~RenderGraph() = default;
+
+		RenderGraph(RenderGraph&& other) = delete;
+		RenderGraph(const RenderGraph& other) = delete;
+		RenderGraph& operator=(RenderGraph&& other) = delete;
+		RenderGraph& operator=(const RenderGraph& other) = delete;
+
+	public:
+
+		// Starts over with an empty graph
+		void Clear();
+
+		uint32_t ImportResource(const std::string& name, uint32_t initialState, uint32_t finalState = UNKNOWN_STATE);
+		uint32_t CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc);
+
+		// Passes execute in the order they are added
+		uint32_t AddPass(const std::string& name, bool hasSideEffects = false);
+		void Read(uint32_t pass, uint32_t resource, uint32_t state);
+		void Write(uint32_t pass, uint32_t resource, uint32_t state);
+
+		void Compile();
+
+	public:
+
+		uint32_t GetNumPasses() const;
+		const std::string& GetPassName(uint32_t pass) const;
+		bool IsPassCulled(uint32_t pass) const;
+
+		// Barriers to issue right before the pass, as one batch
+		uint32_t GetNumPassBarriers(uint32_t pass) const;
+		const RenderGraphBarrier* GetPassBarriers(uint32_t pass) const;
+
+		// Barriers to issue after the last pass
+		uint32_t GetNumFinalBarriers() const;
+		const RenderGraphBarrier* GetFinalBarriers() const;
+
+		uint32_t GetNumResources() const;
+		const std::string& GetResourceName(uint32_t resource) const;
+		bool IsImported(uint32_t resource) const;
+		bool IsResourceUsed(uint32_t resource) const; // By a pass that was not culled
+
+		const RenderGraphTextureDesc& GetTextureDesc(uint32_t resource) const;
+		uint64_t GetHeapOffset(uint32_t resource) const;
+		uint64_t GetHeapSize() const;
+
+		const RenderGraphStatistics& GetStatistics() const;
+
+	private:
+
+		void CullPasses();
+		void FindLifetimes();
+		void PlaceTransients();
+		void CreateBarriers();
+	};
+}
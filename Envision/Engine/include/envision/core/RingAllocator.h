@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace env
+{
+	// Linear ring allocator where memory is handed back in the order it was
+	// submitted, once the fence value it was submitted with has completed.
+	// Only offsets and fence values are tracked, so the allocator is not tied
+	// to any graphics API and can be driven by a fake fence.
+	class RingAllocator
+	{
+	public:
+
+		static const uint64_t INVALID_OFFSET = ~0ull;
+
+	private:
+
+		struct Submission
+		{
+			uint64_t FenceValue;
+			uint64_t End;
+			uint64_t Size;
+		};
+
+		uint64_t m_capacity;
+		uint64_t m_head;
+		uint64_t m_tail;
+		uint64_t m_used;
+
+		// Bytes allocated (including alignment padding and wrap waste)
+		// since the last call to Submit.
+		uint64_t m_pendingSize;
+
+		std::deque<Submission> m_submissions;
+
+	public:
+
+		RingAllocator();
+		RingAllocator(uint64_t capacity);
+		~RingAllocator() = default;
+
+		void Initialize(uint64_t capacity);
+
+		RingAllocator(RingAllocator&& other) = delete;
+		RingAllocator(const RingAllocator& other) = delete;
+		RingAllocator& operator=(RingAllocator&& other) = delete;
+		RingAllocator& operator=(const RingAllocator& other) = delete;
+
+	public:
+
+		// Returns INVALID_OFFSET if there is no contiguous space left
+		uint64_t Allocate(uint64_t numBytes, uint64_t alignment = 1);
+
+		// Tags all allocations since the last submit with fenceValue.
+		// Fence values are expected to increase between submits.
+		void Submit(uint64_t fenceValue);
+
+		// Frees all submissions with a fence value <= completedFenceValue
+		void Reclaim(uint64_t completedFenceValue);
+
+		uint64_t GetCapacity() const;
+		uint64_t GetUsed() const;
+		uint64_t GetPendingSize() const;
+		size_t GetNumSubmissionsInFlight() const;
+
+		// Fence value of the oldest submission in flight, 0 if there is none
+		uint64_t GetOldestFenceValue() const;
+	};
+}
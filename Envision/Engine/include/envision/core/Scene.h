@@ -2,15 +2,43 @@
 #include "envision/envpch.h"
 #include "envision/core/Time.h"
 #include "envision/core/Component.h"
+#include "envision/core/JobSystem.h"
+#include "envision/core/SceneBVH.h"
+#include "envision/core/SceneCache.h"
+#include "envision/core/SystemAccess.h"
+#include "envision/core/TransformPool.h"
 
 namespace env
 {
+	struct SceneLoadStatistics
+	{
+		bool FromCache = false;
+		float ReadTime = 0.f; // Seconds spent opening the cache, or importing and writing it
+		float ImportTime = 0.f; // Seconds spent in Assimp, zero when loaded from cache
+		float ConvertTime = 0.f; // Seconds spent converting the Assimp meshes
+		float SimplifyTime = 0.f; // Seconds spent generating LODs, zero when loaded from cache
+		float InstantiateTime = 0.f; // Seconds spent creating resources and entities
+	};
+
 	class Scene
 	{
 	private:
 
 		entt::registry m_registry;
 
+		SceneBVH m_bvh;
+		std::vector<uint32_t> m_bvhItems; // BVH item per entity index
+
+		// Increased whenever an entity gets or loses a transform or parent
+		uint64_t m_hierarchyVersion;
+
+		TransformPool m_transformPool;
+
+		SceneLoadStatistics m_loadStatistics;
+
+		// Access of the system updating on this thread
+		static thread_local const SystemAccess* s_systemAccess;
+
 	public:
 
 		Scene();
@@ -30,6 +58,21 @@ namespace env
 
 		int GetEntityCount();
 		bool IsEntity(ID entity);
+
+		// Hierarchy
+
+		// The transform of the child becomes relative to the parent
+		void SetParent(ID child, ID parent);
+		void RemoveParent(ID child);
+		uint64_t GetHierarchyVersion() const;
+
+		// Pooled transforms
+
+		// Stores the transform of the entity in the transform pool, where the
+		// world matrices of all pooled entities are built in one batch
+		void AddPooledTransform(ID entity, const Float3& position, const Quaternion& rotation, const Float3& scale);
+		void RemovePooledTransform(ID entity);
+		TransformPool& GetTransformPool();
 		
 		// Component related
 
@@ -43,7 +86,62 @@ namespace env
 		template <typename... Ts, typename Func>
 		void ForEach(Func func);
 
-		void LoadScene(const std::string& name, const std::string& filePath);
+		template <typename... Ts>
+		auto View();
+
+		// Calls func(entity, components...) for every entity in the view, in
+		// chunks spread over the job system. func may only touch the
+		// components of the entity it is given.
+		template <typename... Ts, typename Func>
+		void ParallelForEach(Func func, size_t chunkSize = 1024);
+
+		// The registry creates the pool of a type the first time it is used,
+		// which is not safe while other systems use the registry on other
+		// threads. The Application creates the pools of all declared types
+		// before systems are updated in parallel.
+		template <typename T>
+		void CreatePool();
+
+		// Set by the Application while a system updates. In debug builds the
+		// system may then only get components of the types it declared.
+		// Returns the previous access, a thread waiting for jobs can update
+		// another system in the middle of one.
+		static const SystemAccess* SetSystemAccess(const SystemAccess* access);
+
+		// Uses the scene cache of the file when it is up to date, otherwise
+		// the file is imported and the cache is written for the next load
+		void LoadScene(const std::string& name, const std::string& filePath, bool useCache = true);
+		const SceneLoadStatistics& GetLoadStatistics() const;
+
+		// Reads the file with Assimp without creating any resources or
+		// entities. The meshes are converted in parallel, maxThreads limits
+		// the number of threads used and 0 uses all of them.
+		static bool ImportScene(const std::string& filePath, CookedScene& scene, SceneLoadStatistics* statistics = nullptr, UINT maxThreads = 0);
+
+		// Spatial queries
+
+		// The BVH holds the world bounds of all entities with a render and
+		// world transform component at the time of the rebuild. Moved entities are
+		// updated with UpdateBVH followed by one RefitBVH.
+		void RebuildBVH();
+		void UpdateBVH(ID entity);
+		void RefitBVH();
+
+		// Updates the entities rendering a mesh whose bounds changed in the
+		// last AssetManager::Update, like finished async loads. Returns the
+		// number of entities updated, they need a RefitBVH as well.
+		UINT UpdateBVHOfChangedMeshes();
+		const SceneBVH& GetBVH() const;
+
+	private:
+
+		void InstantiateScene(const std::string& name, const CookedSceneView& scene);
+		void OnHierarchyChanged(entt::registry& registry, entt::entity entity);
+		void OnRenderableDestroyed(entt::registry& registry, entt::entity entity);
+		void RemoveBVHItem(size_t entityIndex);
+
+		template <typename... Ts>
+		void CheckAccess() const;
 	};
 
 
@@ -67,6 +165,7 @@ namespace env
 	template<typename T>
 	inline T& Scene::GetComponent(ID entity)
 	{
+		CheckAccess<T>();
 		return m_registry.get<T>((entt::entity)entity);
 	}
 
@@ -84,7 +183,54 @@ namespace env
 	template<typename ...Ts, typename Func>
 	inline void Scene::ForEach(Func func)
 	{
+		CheckAccess<Ts...>();
 		auto view = m_registry.view<Ts...>();
 		view.each(func);
 	}
+
+	template<typename ...Ts>
+	inline auto Scene::View()
+	{
+		CheckAccess<Ts...>();
+		return m_registry.view<Ts...>();
+	}
+
+	template<typename ...Ts, typename Func>
+	inline void Scene::ParallelForEach(Func func, size_t chunkSize)
+	{
+		CheckAccess<Ts...>();
+		auto view = m_registry.view<Ts...>();
+		const auto& entities = view.handle();
+		const size_t numEntities = entities.size();
+		const size_t numChunks = (numEntities + chunkSize - 1) / chunkSize;
+
+		JobSystem::Get()->ParallelFor(numChunks, [&](size_t chunkIndex) {
+			const size_t begin = chunkIndex * chunkSize;
+			const size_t end = std::min(numEntities, begin + chunkSize);
+			for (size_t i = begin; i < end; i++) {
+				const entt::entity entity = entities[i];
+				if (view.contains(entity))
+					func(entity, view.template get<Ts>(entity)...);
+			}
+		});
+	}
+
+	template<typename T>
+	inline void Scene::CreatePool()
+	{
+		// Shared state like the TransformPool is declared as well, but can't
+		// be stored as a component
+		if constexpr (std::is_move_constructible_v<T> && std::is_move_assignable_v<T>)
+			(void)m_registry.storage<T>();
+	}
+
+	template<typename ...Ts>
+	inline void Scene::CheckAccess() const
+	{
+#ifdef _DEBUG
+		// Systems that declare nothing are updated alone and may use anything
+		if (s_systemAccess && s_systemAccess->Declared)
+			assert((s_systemAccess->Contains(typeid(Ts)) && ...) && "A system used a component type it did not declare");
+#endif
+	}
 }
\ No newline at end of file
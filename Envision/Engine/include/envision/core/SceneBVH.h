@@ -0,0 +1,89 @@
+#pragma once
+#include "envision/core/Culling.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	struct AABB
+	{
+		float Min[3];
+		float Max[3];
+	};
+
+	// Bounding volume hierarchy over items with an axis aligned box and a
+	// 64-bit value each, e.g. scene entities. Built top down with binned SAH.
+	// Nodes are stored in one array where the two children of a node are
+	// always next to each other, so a node only needs one child index.
+	class SceneBVH
+	{
+	public:
+
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+		static const uint32_t MAX_ITEMS_PER_LEAF = 4;
+		static const int NUM_BINS = 16;
+
+		struct Node
+		{
+			AABB Bounds;
+			uint32_t FirstChildOrItem; // First child for inner nodes, first item reference for leaves
+			uint32_t NumItems; // Zero for inner nodes
+		};
+
+	private:
+
+		std::vector<Node> m_nodes;
+		std::vector<uint32_t> m_parents;
+
+		std::vector<AABB> m_itemBounds;
+		std::vector<uint64_t> m_itemValues;
+		std::vector<uint32_t> m_itemLeaves;
+		std::vector<uint32_t> m_itemReferences; // Item indices in leaf order
+
+		std::vector<uint32_t> m_dirtyLeaves;
+
+	public:
+
+		SceneBVH() = default;
+		~SceneBVH() = default;
+
+		SceneBVH(SceneBVH&& other) = delete;
+		SceneBVH(const SceneBVH& other) = delete;
+		SceneBVH& operator=(SceneBVH&& other) = delete;
+		SceneBVH& operator=(const SceneBVH& other) = delete;
+
+	private:
+
+		uint32_t Split(uint32_t begin, uint32_t end, const std::vector<float>& centroids);
+
+	public:
+
+		// Item i gets bounds[i] and values[i], the index is used to update it later
+		void Build(const AABB* bounds, const uint64_t* values, size_t count);
+		void Clear();
+
+		// Stores the new bounds, the tree is not updated until Refit is called
+		void SetItemBounds(uint32_t item, const AABB& bounds);
+
+		// Gives the item empty bounds so no query returns it. Its slot stays in
+		// the tree until the next Build.
+		void RemoveItem(uint32_t item);
+
+		// Updates the nodes above all items changed since the last refit. The
+		// tree keeps its structure, so its quality drops if items move far.
+		void Refit();
+
+		// Values of all items overlapping the frustum or box are appended to results
+		void QueryFrustum(const Frustum& frustum, std::vector<uint64_t>& results) const;
+		void QueryAABB(const AABB& bounds, std::vector<uint64_t>& results) const;
+
+		// Closest item box hit by the ray within maxDistance, direction does
+		// not need to be normalized. Returns false if nothing is hit.
+		bool Raycast(const float* origin, const float* direction, float maxDistance, uint64_t& hitValue, float& hitDistance) const;
+
+		size_t GetNumNodes() const;
+		size_t GetNumItems() const;
+		uint32_t GetDepth() const;
+	};
+}
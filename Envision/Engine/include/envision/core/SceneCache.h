@@ -0,0 +1,110 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/MappedFile.h"
+#include "envision/graphics/Assets.h"
+#include "envision/resource/ShaderDataType.h"
+
+namespace env
+{
+	struct CookedMaterial
+	{
+		static const int MAX_NAME_SIZE = 64;
+		char Name[MAX_NAME_SIZE];
+		Float3 Ambient;
+		Float3 Diffuse;
+		Float3 Specular;
+		float Shininess;
+	};
+
+	struct CookedSubmesh
+	{
+		static const int MAX_NAME_SIZE = 64;
+		char Name[MAX_NAME_SIZE];
+		UINT OffsetVertices;
+		UINT NumVertices;
+		UINT OffsetIndices;
+		UINT NumIndices;
+		UINT Material; // Index into the materials
+		MeshBounds Bounds;
+		UINT NumLods; // Simplified versions, after all full detail indices
+		MeshLod Lods[MAX_MESH_LODS - 1];
+	};
+
+	// Nodes are stored parents first, meshes are a range in the node meshes
+	struct CookedNode
+	{
+		static constexpr UINT NO_PARENT = ~0u;
+		static const int MAX_NAME_SIZE = 32;
+		char Name[MAX_NAME_SIZE];
+		Float4x4 LocalMatrix;
+		UINT Parent;
+		UINT FirstMesh;
+		UINT NumMeshes;
+	};
+
+	// Imported scene before any resources or entities are created, pointing
+	// either into a CookedScene or into a mapped cache file
+	struct CookedSceneView
+	{
+		const CookedMaterial* Materials = nullptr;
+		UINT NumMaterials = 0;
+		const CookedSubmesh* Submeshes = nullptr;
+		UINT NumSubmeshes = 0;
+		const CookedNode* Nodes = nullptr;
+		UINT NumNodes = 0;
+		const UINT* NodeMeshes = nullptr; // Submesh indices
+		UINT NumNodeMeshes = 0;
+		const VertexType* Vertices = nullptr;
+		UINT NumVertices = 0;
+		const IndexType* Indices = nullptr;
+		UINT NumIndices = 0;
+	};
+
+	struct CookedScene
+	{
+		std::vector<CookedMaterial> Materials;
+		std::vector<CookedSubmesh> Submeshes;
+		std::vector<CookedNode> Nodes;
+		std::vector<UINT> NodeMeshes;
+		std::vector<VertexType> Vertices;
+		std::vector<IndexType> Indices;
+
+		CookedSceneView GetView() const;
+	};
+
+	// Binary cache of an imported scene, stored next to the source file. The
+	// cache is only used if it was written by the same version of the format
+	// from the same source file, compared by size and write time first and
+	// by content hash if those differ.
+	class SceneCache
+	{
+	private:
+
+		static const UINT VERSION = 3;
+
+		MappedFile m_file;
+		CookedSceneView m_view;
+
+	public:
+
+		SceneCache() = default;
+		~SceneCache() = default;
+
+		SceneCache(SceneCache&& other) = delete;
+		SceneCache(const SceneCache& other) = delete;
+		SceneCache& operator=(SceneCache&& other) = delete;
+		SceneCache& operator=(const SceneCache& other) = delete;
+
+	public:
+
+		static std::string GetCachePath(const std::string& sourcePath);
+		static bool Write(const std::string& sourcePath, const CookedScene& scene);
+
+		// Maps the cache of the source file, returns false if there is none
+		// or if it is out of date. The view is valid until Close.
+		bool Open(const std::string& sourcePath);
+		void Close();
+
+		const CookedSceneView& GetView() const;
+	};
+}
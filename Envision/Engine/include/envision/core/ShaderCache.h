@@ -0,0 +1,113 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace env
+{
+	enum class ShaderCacheEntry : uint32_t
+	{
+		Shader = 0, // Compiled bytecode
+		RootSignature, // Serialized root signature
+		Pipeline, // Cached pipeline state blob from the driver
+
+		COUNT,
+	};
+
+	const char* GetShaderCacheEntryName(ShaderCacheEntry entry);
+
+	struct ShaderCacheCounters
+	{
+		uint32_t NumHits = 0;
+		uint32_t NumMisses = 0;
+		uint32_t NumRejected = 0; // Read but not usable, also counted as misses
+	};
+
+	struct ShaderCacheStatistics
+	{
+		ShaderCacheCounters Entries[(uint32_t)ShaderCacheEntry::COUNT];
+		uint32_t NumWrites = 0;
+		uint32_t NumFailedWrites = 0;
+	};
+
+	// FNV-1a, built up from every input that changes the cached result
+	class ShaderCacheKey
+	{
+	private:
+
+		uint64_t m_hash;
+
+	public:
+
+		ShaderCacheKey();
+
+		ShaderCacheKey& AddBytes(const void* data, size_t numBytes);
+
+		// The length is added too, so "ab" + "c" and "a" + "bc" differ
+		ShaderCacheKey& AddString(const std::string& text);
+
+		template <typename T>
+		ShaderCacheKey& AddValue(const T& value)
+		{
+			return AddBytes(&value, sizeof(T));
+		}
+
+		uint64_t Get() const;
+	};
+
+	// Compiled shaders, root signatures and pipeline blobs on disk, a file
+	// per entry named after its key. Keys are built by the caller from
+	// everything the result depends on, so an entry never has to be checked
+	// against its inputs and a stale entry is simply never looked up again.
+	//
+	// Only bytes and keys are handled here, the cache knows nothing of the
+	// graphics API.
+	class ShaderCache
+	{
+	private:
+
+		static const uint32_t VERSION = 1;
+
+		std::string m_directory;
+		bool m_isReadEnabled;
+
+		ShaderCacheStatistics m_statistics;
+
+	public:
+
+		ShaderCache();
+		ShaderCache(const std::string& directory);
+		~ShaderCache() = default;
+
+		void Initialize(const std::string& directory);
+
+		ShaderCache(ShaderCache&& other) = delete;
+		ShaderCache(const ShaderCache& other) = delete;
+		ShaderCache& operator=(ShaderCache&& other) = delete;
+		ShaderCache& operator=(const ShaderCache& other) = delete;
+
+	public:
+
+		// Hash of the file and of every file it includes with #include,
+		// followed recursively relative to the including file. Includes that
+		// can't be found are hashed by name. 0 if the file can't be read.
+		static uint64_t HashSource(const std::string& sourcePath);
+
+		// Entries are still written while reading is disabled, so a run
+		// without the cache refreshes it
+		void SetReadEnabled(bool isEnabled);
+		bool IsReadEnabled() const;
+
+		// Counts a hit or a miss
+		bool Read(ShaderCacheEntry entry, uint64_t key, std::vector<uint8_t>& data);
+		bool Write(ShaderCacheEntry entry, uint64_t key, const void* data, size_t numBytes);
+
+		// An entry that was read but could not be used, like a pipeline blob
+		// from another driver. Turns its hit into a miss.
+		void Reject(ShaderCacheEntry entry);
+
+		std::string GetEntryPath(ShaderCacheEntry entry, uint64_t key) const;
+		const ShaderCacheStatistics& GetStatistics() const;
+	};
+}
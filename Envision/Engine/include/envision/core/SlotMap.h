@@ -0,0 +1,169 @@
+#pragma once
+#include <assert.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	// Values in a dense array, addressed by 64 bit handles:
+	//	[63..56] tag, [55..32] generation, [31..0] slot index
+	//
+	// A slot points at the value in the dense array, so a lookup is two
+	// array reads and a generation compare, and iterating the values walks
+	// one contiguous array. Erasing moves the last value into the hole.
+	// The generation of a slot is bumped when its value is erased, so a
+	// handle to an erased value is detected instead of finding whatever was
+	// inserted in the slot after it.
+	//
+	// The tag tells handles of different maps apart, the owner can use it to
+	// find the map of a handle without asking every map. Tags are 1 to 127,
+	// so a handle is never 0 and stays positive as a signed 64 bit integer.
+	template <typename T>
+	class SlotMap
+	{
+	public:
+
+		static const uint32_t MAX_TAG = 127;
+		static const uint32_t MAX_GENERATION = (1u << 24) - 1;
+
+	private:
+
+		static const uint32_t NO_SLOT = ~0u;
+
+		struct Slot
+		{
+			uint32_t Generation;
+			uint32_t Value; // In the dense array, or the next free slot
+		};
+
+		uint32_t m_tag;
+
+		std::vector<Slot> m_slots;
+		uint32_t m_firstFreeSlot;
+
+		std::vector<T> m_values;
+		std::vector<uint32_t> m_valueSlots; // Slot of each value
+
+	public:
+
+		SlotMap(uint32_t tag) :
+			m_tag(tag),
+			m_firstFreeSlot(NO_SLOT)
+		{
+			assert(tag > 0 && tag <= MAX_TAG);
+		}
+
+		~SlotMap() = default;
+
+		SlotMap(SlotMap&& other) = delete;
+		SlotMap(const SlotMap& other) = delete;
+		SlotMap& operator=(SlotMap&& other) = delete;
+		SlotMap& operator=(const SlotMap& other) = delete;
+
+	public:
+
+		static uint32_t GetTag(uint64_t handle)
+		{
+			return (uint32_t)(handle >> 56);
+		}
+
+		uint64_t Insert(T value)
+		{
+			uint32_t slot = m_firstFreeSlot;
+			if (slot != NO_SLOT) {
+				m_firstFreeSlot = m_slots[slot].Value;
+			}
+			else {
+				slot = (uint32_t)m_slots.size();
+				m_slots.push_back({ 1, 0 });
+			}
+
+			m_slots[slot].Value = (uint32_t)m_values.size();
+			m_values.push_back(std::move(value));
+			m_valueSlots.push_back(slot);
+
+			return ((uint64_t)m_tag << 56) | ((uint64_t)m_slots[slot].Generation << 32) | slot;
+		}
+
+		// Returns false for a stale handle or one of another map
+		bool Erase(uint64_t handle)
+		{
+			uint32_t slot = 0;
+			if (!FindSlot(handle, slot))
+				return false;
+
+			uint32_t value = m_slots[slot].Value;
+			uint32_t lastValue = (uint32_t)m_values.size() - 1;
+			if (value != lastValue) {
+				m_values[value] = std::move(m_values[lastValue]);
+				m_valueSlots[value] = m_valueSlots[lastValue];
+				m_slots[m_valueSlots[value]].Value = value;
+			}
+			m_values.pop_back();
+			m_valueSlots.pop_back();
+
+			// Generations wrap around, a handle kept over 16 million reuses
+			// of its slot is no longer detected
+			Slot& freed = m_slots[slot];
+			freed.Generation = (freed.Generation == MAX_GENERATION) ? 1 : freed.Generation + 1;
+			freed.Value = m_firstFreeSlot;
+			m_firstFreeSlot = slot;
+			return true;
+		}
+
+		// nullptr for a stale handle or one of another map
+		T* Find(uint64_t handle)
+		{
+			uint32_t slot = 0;
+			return FindSlot(handle, slot) ? &m_values[m_slots[slot].Value] : nullptr;
+		}
+
+		const T* Find(uint64_t handle) const
+		{
+			uint32_t slot = 0;
+			return FindSlot(handle, slot) ? &m_values[m_slots[slot].Value] : nullptr;
+		}
+
+		bool Contains(uint64_t handle) const
+		{
+			uint32_t slot = 0;
+			return FindSlot(handle, slot);
+		}
+
+		void Clear()
+		{
+			// Every slot is bumped, so no handle given out so far is found
+			m_firstFreeSlot = NO_SLOT;
+			for (uint32_t slot = (uint32_t)m_slots.size(); slot-- > 0;) {
+				Slot& freed = m_slots[slot];
+				freed.Generation = (freed.Generation == MAX_GENERATION) ? 1 : freed.Generation + 1;
+				freed.Value = m_firstFreeSlot;
+				m_firstFreeSlot = slot;
+			}
+
+			m_values.clear();
+			m_valueSlots.clear();
+		}
+
+		size_t GetSize() const { return m_values.size(); }
+
+		// The values in no particular order, valid until the next insert or erase
+		T* begin() { return m_values.data(); }
+		T* end() { return m_values.data() + m_values.size(); }
+		const T* begin() const { return m_values.data(); }
+		const T* end() const { return m_values.data() + m_values.size(); }
+
+	private:
+
+		bool FindSlot(uint64_t handle, uint32_t& slot) const
+		{
+			slot = (uint32_t)handle;
+			uint32_t generation = (uint32_t)(handle >> 32) & MAX_GENERATION;
+
+			return GetTag(handle) == m_tag &&
+				slot < m_slots.size() &&
+				m_slots[slot].Generation == generation;
+		}
+	};
+}
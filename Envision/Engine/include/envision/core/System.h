@@ -3,12 +3,14 @@
 #include "envision/core/Time.h"
 #include "envision/core/Event.h"
 #include "envision/core/Scene.h"
+#include "envision/core/SystemAccess.h"
 
 namespace env
 {
 	class System
 	{
 		std::string m_name;
+		SystemAccess m_access;
 
 	public:
 
@@ -18,6 +20,28 @@ namespace env
 	public:
 
 		inline const std::string& GetName() const { return m_name; }
+		inline const SystemAccess& GetAccess() const { return m_access; }
+
+	protected:
+
+		// A system that declares its access may be updated on a job at the
+		// same time as systems it doesn't conflict with. Systems declaring
+		// nothing are always updated alone.
+		template <typename... Ts>
+		void DeclareReads()
+		{
+			(m_access.Reads.push_back(typeid(Ts)), ...);
+			(m_access.CreatePools.push_back(&Scene::CreatePool<Ts>), ...);
+			m_access.Declared = true;
+		}
+
+		template <typename... Ts>
+		void DeclareWrites()
+		{
+			(m_access.Writes.push_back(typeid(Ts)), ...);
+			(m_access.CreatePools.push_back(&Scene::CreatePool<Ts>), ...);
+			m_access.Declared = true;
+		}
 
 	public:
 
@@ -0,0 +1,48 @@
+#pragma once
+#include "envision/envpch.h"
+#include <typeindex>
+#include <vector>
+
+namespace env
+{
+	class Scene;
+
+	// Types a system reads and writes in OnUpdate. These are usually
+	// components, but any type can stand for shared state.
+	struct SystemAccess
+	{
+		std::vector<std::type_index> Reads;
+		std::vector<std::type_index> Writes;
+		bool Declared = false;
+
+		// Scene::CreatePool of each declared type
+		std::vector<void (Scene::*)()> CreatePools;
+
+		bool Contains(const std::type_index& type) const
+		{
+			return std::find(Reads.begin(), Reads.end(), type) != Reads.end() ||
+				std::find(Writes.begin(), Writes.end(), type) != Writes.end();
+		}
+
+		// Systems that conflict are never updated at the same time
+		bool ConflictsWith(const SystemAccess& other) const
+		{
+			if (!Declared || !other.Declared)
+				return true;
+
+			auto contains = [](const std::vector<std::type_index>& types, const std::type_index& type) {
+				return std::find(types.begin(), types.end(), type) != types.end();
+			};
+
+			for (const std::type_index& type : Writes) {
+				if (contains(other.Reads, type) || contains(other.Writes, type))
+					return true;
+			}
+			for (const std::type_index& type : other.Writes) {
+				if (contains(Reads, type))
+					return true;
+			}
+			return false;
+		}
+	};
+}
@@ -10,6 +10,10 @@ namespace env
 		Float4x4 m_matrix;
 		bool m_dirty;
 
+		// Unlike m_dirty this is only reset by ClearChanged, so systems can
+		// see a change even after the matrix has been recomputed.
+		bool m_changed;
+
 		Float3 m_position;
 		Quaternion m_rotation;
 		Float3 m_scale;
@@ -65,5 +69,8 @@ namespace env
 		const Float4x4& GetMatrix();
 		Float4x4 GetMatrix() const;
 		Float4x4 GetMatrixTransposed();
+
+		bool HasChanged() const;
+		void ClearChanged();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace env
+{
+	// Pointers to transforms stored as separate arrays of each component
+	struct TransformArrays
+	{
+		const float* PositionsX;
+		const float* PositionsY;
+		const float* PositionsZ;
+		const float* RotationsX;
+		const float* RotationsY;
+		const float* RotationsZ;
+		const float* RotationsW;
+		const float* ScalesX;
+		const float* ScalesY;
+		const float* ScalesZ;
+	};
+
+	// Builds count row-major matrices (row vector convention, translation in
+	// the last row) equal to scale * rotation * translation, the same as
+	// Transform::GetMatrix. Four matrices are built per iteration, the input
+	// arrays must be 16 byte aligned. Rotations are expected to be normalized.
+	void ComposeWorldMatrices(const TransformArrays& transforms, size_t count, float* matrices);
+
+	// Same as above for a single transform, used for the remainder
+	void ComposeWorldMatrix(const TransformArrays& transforms, size_t index, float* matrix);
+
+	// Positions, rotations and scales of many transforms stored as one
+	// aligned array per component, with their world matrices built in one
+	// batch by ComposeWorldMatrices. Slots are kept dense, removing one moves
+	// the last slot into its place. Each slot remembers an owner, so whoever
+	// holds the index of the moved slot can be updated.
+	class TransformPool
+	{
+	private:
+
+		enum Stream
+		{
+			POSITION_X, POSITION_Y, POSITION_Z,
+			ROTATION_X, ROTATION_Y, ROTATION_Z, ROTATION_W,
+			SCALE_X, SCALE_Y, SCALE_Z,
+			NUM_STREAMS
+		};
+
+		float* m_streams[NUM_STREAMS];
+		float* m_matrices; // 16 floats per slot
+		std::vector<uint64_t> m_owners;
+
+		size_t m_size;
+		size_t m_capacity;
+
+		// Set by every change, the matrices are only valid when this is false
+		bool m_changed;
+
+	public:
+
+		TransformPool();
+		~TransformPool();
+
+		TransformPool(TransformPool&& other) = delete;
+		TransformPool(const TransformPool& other) = delete;
+		TransformPool& operator=(TransformPool&& other) = delete;
+		TransformPool& operator=(const TransformPool& other) = delete;
+
+	public:
+
+		void Reserve(size_t capacity);
+		void Clear();
+
+		// New slots hold the identity transform
+		uint32_t Add(uint64_t owner);
+
+		// Returns the owner of the slot that was moved to index, which is the
+		// removed owner itself if it was the last slot
+		uint64_t Remove(uint32_t index);
+
+		void SetPosition(uint32_t index, float x, float y, float z);
+		void SetRotation(uint32_t index, float x, float y, float z, float w);
+		void SetScale(uint32_t index, float x, float y, float z);
+
+		void GetPosition(uint32_t index, float* xyz) const;
+		void GetRotation(uint32_t index, float* xyzw) const;
+		void GetScale(uint32_t index, float* xyz) const;
+
+		// Builds the world matrix of every slot and clears the changed flag
+		void ComposeWorldMatrices();
+
+		bool HasChanged() const;
+		const float* GetWorldMatrix(uint32_t index) const;
+		uint64_t GetOwner(uint32_t index) const;
+		size_t GetSize() const;
+		TransformArrays GetArrays() const;
+	};
+}
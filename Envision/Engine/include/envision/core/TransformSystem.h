@@ -0,0 +1,65 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/System.h"
+
+namespace env
+{
+	// Computes the WorldTransformComponent of every entity with a transform.
+	// Entities are kept sorted by depth, so one linear pass always reaches a
+	// parent before its children. Only entities whose own transform or any
+	// ancestor changed since the last update are recomputed. The order is
+	// rebuilt when the hierarchy version of the scene changes.
+	//
+	// Entities in the scene's transform pool are updated afterwards, all at
+	// once if any of them changed. Changed entities are also updated in the
+	// scene BVH.
+	class TransformSystem : public System
+	{
+	private:
+
+		static constexpr uint32_t NO_PARENT = ~0u;
+
+		struct Node
+		{
+			ID Entity;
+			uint32_t Parent; // Index of the parent node
+		};
+
+		std::vector<Node> m_nodes;
+		std::vector<Float4x4> m_worldMatrices; // Per node
+		std::vector<uint8_t> m_updated; // Per node, non-zero if recomputed in the current update
+
+		uint64_t m_hierarchyVersion;
+		bool m_updateAll;
+
+		UINT m_numUpdated;
+		float m_updateTime;
+
+	public:
+
+		TransformSystem();
+		~TransformSystem() final = default;
+
+		TransformSystem(const TransformSystem& other) = delete;
+		TransformSystem(const TransformSystem&& other) = delete;
+		TransformSystem& operator=(const TransformSystem& other) = delete;
+		TransformSystem& operator=(const TransformSystem&& other) = delete;
+
+	private:
+
+		void RebuildOrder(Scene& scene);
+
+	public:
+
+		void OnAttach(Scene& scene) final;
+		void OnUpdate(Scene& scene, const Duration& delta) final;
+
+		// Can be called directly when world matrices are needed before the
+		// system would be updated
+		void Update(Scene& scene);
+
+		UINT GetNumNodes() const;
+		UINT GetNumUpdated() const; // In the last update
+		float GetUpdateTime() const; // Seconds spent in the last update
+	};
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace env
+{
+	// Encoders for packed vertex attributes. The Pack functions take byte
+	// strides for both the source and the destination, so they read from and
+	// write into interleaved vertices, and encode four elements at a time
+	// with SSE2. Their results are the same as the single value functions.
+
+	// IEEE half, rounded to nearest even. Values too large become infinity,
+	// NaN stays NaN.
+	uint16_t FloatToHalf(float value);
+	float HalfToFloat(uint16_t value);
+
+	// Clamped to [-1, 1] and rounded, read back as value / 32767 by an SNORM format
+	int16_t FloatToSnorm16(float value);
+
+	// A direction folded onto an octahedron and unfolded into the [-1, 1]
+	// square, as two snorm16 values. The zero vector encodes to zero.
+	void EncodeOctahedral(const float* normal, int16_t* encoded);
+	void DecodeOctahedral(const int16_t* encoded, float* normal);
+
+	// Positions as snorm16x4 in a box, position = center + value * extents.
+	// The w component is zero.
+	void PackPositions(const void* positions, size_t positionStride, size_t count,
+		const float* center, const float* extents,
+		void* destination, size_t destinationStride);
+
+	// Normals as snorm16x2, octahedral
+	void PackOctahedralNormals(const void* normals, size_t normalStride, size_t count,
+		void* destination, size_t destinationStride);
+
+	// The first two floats of each element as half2
+	void PackHalf2(const void* values, size_t valueStride, size_t count,
+		void* destination, size_t destinationStride);
+}
@@ -11,14 +11,22 @@ namespace env
 	{
 	private:
 
+#ifdef PLATFORM_DIRECT3D_12
 		static WNDCLASS s_windowClass;
 		static const WCHAR* s_WINDOW_CLASS_NAME;
+#endif
 
 		Application& m_application;
 		HWND m_handle = NULL;
 
+#ifdef PLATFORM_NULL
+		// Headless, there is no native window to ask for its size
+		int m_width;
+		int m_height;
+#endif
+
 		static const UINT NUM_BACK_BUFFERS = 2;
-		UINT m_currentBackbufferindex;
+		UINT m_currentBackbufferindex = 0;
 		IDXGISwapChain1* m_swapchain;
 		Texture2D* m_backbuffers[NUM_BACK_BUFFERS];
 
@@ -29,9 +37,11 @@ namespace env
 		// Dear ImGui
 		bool m_usingImgui = false;
 
+#ifdef PLATFORM_DIRECT3D_12
 		void InitWindowClass();
 		static void SetWindowObject(HWND handle, Window* window);
 		static Window* GetWindowObject(HWND handle);
+#endif
 
 	public:
 
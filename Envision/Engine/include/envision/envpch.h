@@ -1,8 +1,16 @@
 #pragma once
 
+// Define PLATFORM_NULL to build without a GPU or a window, see
+// envision/platform/NullD3D12.h
+#ifndef PLATFORM_NULL
+#define PLATFORM_DIRECT3D_12
+#endif
+
+#ifdef PLATFORM_DIRECT3D_12
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <Windows.h>
+#endif
 
 #include <iostream>
 #include <string>
@@ -15,8 +23,6 @@
 typedef long long ID;
 #define ID_ERROR 0
 
-#define PLATFORM_DIRECT3D_12
-
 #ifdef PLATFORM_DIRECT3D_12
 #include <d3d12.h>
 #include <dxgi1_6.h>
@@ -40,6 +46,17 @@ typedef long long ID;
 	std::to_string(__LINE__) + "\n\n" + std::string(caption)).c_str(),\
 	"Failure",\
 	MB_OK)
+#endif
+
+#ifdef PLATFORM_NULL
+#include "envision/platform/NullD3D12.h"
+
+#define ASSERT_HR(hr, caption) if (FAILED(hr))\
+	std::cerr << "HRESULT failure in file " << __FILE__ << ", line " << __LINE__ << "\n\n" << caption << std::endl
+
+#define ASSERT(condition, caption) if (!condition)\
+	std::cerr << "Failure in file " << __FILE__ << ", line " << __LINE__ << "\n\n" << caption << std::endl
+#endif
 
 #include <DirectXMath.h>
 #include <DirectXTK/SimpleMath.h>
@@ -60,7 +77,8 @@ using Quaternion = DirectX::SimpleMath::Quaternion;
 #include <entt/entt.hpp>
 
 #include <imgui/imgui.h>
+
+#ifdef PLATFORM_DIRECT3D_12
 #include <imgui/imgui_impl_win32.h>
 #include <imgui/imgui_impl_dx12.h>
-
 #endif
\ No newline at end of file
@@ -2,6 +2,11 @@
 #include "envision/core/IDGenerator.h"
 #include "envision/graphics/Assets.h"
 #include "envision/resource/ResourceManager.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace env
 {
@@ -10,6 +15,43 @@ namespace env
 		
 	};
 
+	enum class AssetLoadState
+	{
+		Queued = 0,
+		Loading, // Imported on a loader thread
+		Uploading, // Copied to the GPU a budget at a time
+		Ready,
+		Failed,
+		Cancelled,
+	};
+
+	struct AssetLoadStatistics
+	{
+		// Loads in each state right now
+		UINT NumQueued = 0;
+		UINT NumLoading = 0;
+		UINT NumUploading = 0;
+
+		// Since the start
+		UINT NumReady = 0;
+		UINT NumFailed = 0;
+		UINT NumCancelled = 0;
+		UINT64 TotalUploadedBytes = 0;
+
+		// Seconds from the request until the mesh was ready
+		float LastLatency = 0.f;
+		float MaxLatency = 0.f;
+		float TotalLatency = 0.f;
+
+		// Seconds a loader thread spent importing the last ready mesh
+		float LastImportTime = 0.f;
+
+		// Of the last Update, which runs on the main thread every frame
+		UINT64 UploadedBytes = 0;
+		float UpdateTime = 0.f;
+		float MaxUpdateTime = 0.f;
+	};
+
 	// Singleton
 	class AssetManager
 	{
@@ -20,6 +62,34 @@ namespace env
 		std::unordered_map<ID, Mesh*> m_meshes;
 		std::unordered_map<ID, Material*> m_materials;
 
+		// Asynchronous loads. Files are imported on loader threads of their
+		// own, jobs of the JobSystem could be picked up by a thread waiting
+		// in the middle of a frame. The loader threads take the queued load
+		// with the highest priority, Update uploads the imported meshes and
+		// swaps them in on the main thread.
+		struct MeshLoad;
+
+		static const UINT NUM_LOAD_THREADS = 2;
+		static const UINT64 DEFAULT_UPLOAD_BUDGET = 8 * 1024 * 1024; // Bytes per frame
+
+		std::vector<std::thread> m_loadThreads;
+		std::mutex m_loadMutex;
+		std::condition_variable m_loadCondition;
+		std::vector<std::shared_ptr<MeshLoad>> m_loadQueue; // Guarded by m_loadMutex
+		bool m_stopLoading; // Guarded by m_loadMutex
+		UINT64 m_nextLoadSequence;
+
+		// Main thread only
+		std::unordered_map<ID, std::shared_ptr<MeshLoad>> m_meshLoads; // Kept after they finish
+		std::vector<std::shared_ptr<MeshLoad>> m_activeLoads;
+		UINT64 m_uploadBudget;
+		AssetLoadStatistics m_loadStatistics;
+		std::vector<ID> m_changedBounds; // Meshes that became ready in the last Update
+
+		// Drawn while a mesh is loading, created with the first load
+		ID m_fallbackMesh;
+		ID m_fallbackMaterial;
+
 	public:
 
 		static AssetManager* Initialize(IDGenerator& commonIDGenerator);
@@ -50,8 +120,53 @@ namespace env
 
 		ID CreateMesh(const std::string& name); // Prototype
 		ID CreateMesh(const std::string& name, void* vertices, const BufferLayout& vertexBufferLayout, void* indices, UINT numIndices);
-		ID CreateMesh(const std::string& name, ID vertexBuffer, UINT offsetVertices, UINT numVertices, ID indexBuffer, UINT offsetIndices, UINT numIndices);
+		ID CreateMesh(const std::string& name, ID vertexBuffer, UINT offsetVertices, UINT numVertices, ID indexBuffer, UINT offsetIndices, UINT numIndices, const MeshBounds& bounds = MeshBounds(), const MeshLod* lods = nullptr, UINT numLods = 0);
 		ID LoadMesh(const std::string& name, const std::string& filePath);
+
+		// Returns the mesh right away, it has the geometry of the fallback
+		// mesh until the file is imported and uploaded. Loads with a higher
+		// priority are imported and uploaded first. The bounds of the mesh
+		// change when it is ready, anything holding them needs a refit.
+		ID LoadMeshAsync(const std::string& name, const std::string& filePath, int priority = 0);
+
+		// The mesh keeps the fallback geometry. Returns false once it is too
+		// late, the load is already finished.
+		bool CancelLoad(ID mesh);
+		void SetLoadPriority(ID mesh, int priority);
+
+		// Meshes that were not loaded asynchronously are always Ready
+		AssetLoadState GetLoadState(ID mesh) const;
+
+		// Uploads imported meshes within the budget and swaps in the ready
+		// ones, called by the Application once per frame
+		void Update();
+
+		void SetUploadBudget(UINT64 numBytesPerFrame);
+		UINT64 GetUploadBudget() const;
+		const AssetLoadStatistics& GetLoadStatistics() const;
+
+		// Meshes whose bounds changed in the last Update, spatial structures
+		// holding them have to update the entities that render them
+		const std::vector<ID>& GetMeshesWithChangedBounds() const;
+
+		ID GetFallbackMesh();
+		ID GetFallbackMaterial();
 		ID CreatePhongMaterial(const std::string& name, Float3 ambient, Float3 diffuse, Float3 specular, float shininess);
+
+		// Positions are read as three floats at the start of each vertex
+		static MeshBounds ComputeMeshBounds(const void* vertices, UINT numVertices, UINT vertexStride);
+
+		// Packs float attributes into renderer vertices, the positions into the
+		// box of the bounds. Strides are in bytes, normals and texcoords are
+		// zero if they are nullptr.
+		static void PackVertices(VertexType* destination, UINT numVertices, const MeshBounds& bounds,
+			const void* positions, UINT positionStride,
+			const void* normals, UINT normalStride,
+			const void* texcoords, UINT texcoordStride);
+
+	private:
+
+		void LoadThread();
+		void FinishLoad(MeshLoad& load, AssetLoadState state);
 	};
 }
\ No newline at end of file
@@ -23,6 +23,27 @@ namespace env
 			ResourceID(resourceID), Name(name), Type(type) {}
 	};
 
+	// Object space bounds, a negative radius means the bounds are unknown
+	struct MeshBounds
+	{
+		Float3 Min = Float3::Zero;
+		Float3 Max = Float3::Zero;
+		Float3 Center = Float3::Zero; // Center of the bounding sphere
+		float Radius = -1.f;
+	};
+
+	// Including the full detail mesh
+	static const UINT MAX_MESH_LODS = 4;
+
+	// Simplified version of a mesh, a range in the same index buffer using
+	// the same vertices
+	struct MeshLod
+	{
+		UINT OffsetIndices = 0;
+		UINT NumIndices = 0;
+		float Error = 0.f; // Object space distance the surface moved at most
+	};
+
 	struct Mesh : public Asset
 	{
 		ID VertexBuffer = ID_ERROR;
@@ -34,6 +55,12 @@ namespace env
 		UINT OffsetVertices = 0;
 		UINT OffsetIndices = 0;
 
+		MeshBounds Bounds;
+
+		// Coarser versions after the full detail one, LOD i is Lods[i - 1]
+		MeshLod Lods[MAX_MESH_LODS - 1];
+		UINT NumLods = 0;
+
 		Mesh(const ID resourceID, const std::string& name) :
 			Asset(resourceID, name, AssetType::Mesh) {}
 	};
@@ -29,11 +29,11 @@ namespace env
 	struct MaterialBufferInstanceData
 	{
 		Float3 AmbientFactor;
-		int AmbientMapIndex; // -1 if no map exist
+		int AmbientMapIndex; // Bindless index of the texture, -1 if no map exist
 		Float3 DiffuseFactor;
-		int DiffuseMapIndex; // -1 if no map exist
+		int DiffuseMapIndex; // Bindless index of the texture, -1 if no map exist
 		Float3 SpecularFactor;
-		int SpecularMapIndex; // -1 if no map exist
+		int SpecularMapIndex; // Bindless index of the texture, -1 if no map exist
 		float Shininess;
 		int MaterialID;
 		Float2 Padding;
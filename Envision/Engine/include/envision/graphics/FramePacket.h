@@ -1,5 +1,7 @@
 #pragma once
 #include "envision/envpch.h"
+#include "envision/core/Culling.h"
+#include "envision/graphics/Assets.h"
 #include "envision/graphics/CoreShaderDataStructures.h"
 
 namespace env
@@ -11,11 +13,71 @@ namespace env
 		UINT NumInstances = 0;
 	};
 
+	// Sort key of a submitted instance, most significant bits first:
+	//	[63..60] pipeline, [59..40] mesh index, [39..38] LOD, [37..22] material index, [21..0] depth
+	//
+	// Mesh IDs come from the shared ID generator and grow without bound, so
+	// the key holds the index of the mesh in the frame packet instead.
+	namespace DrawKey
+	{
+		const UINT DEPTH_BITS = 22;
+		const UINT MATERIAL_BITS = 16;
+		const UINT LOD_BITS = 2;
+		const UINT MESH_BITS = 20;
+		const UINT PIPELINE_BITS = 4;
+
+		const UINT MATERIAL_SHIFT = DEPTH_BITS;
+		const UINT LOD_SHIFT = MATERIAL_SHIFT + MATERIAL_BITS;
+		const UINT MESH_SHIFT = LOD_SHIFT + LOD_BITS;
+		const UINT PIPELINE_SHIFT = MESH_SHIFT + MESH_BITS;
+
+		const UINT MAX_MESHES = 1u << MESH_BITS; // Per frame
+		const UINT MAX_MATERIALS = 1u << MATERIAL_BITS;
+
+		static_assert(MAX_MESH_LODS <= (1u << LOD_BITS), "Not enough draw key bits for the mesh LODs");
+
+		inline UINT64 Create(UINT pipeline, UINT meshIndex, UINT lod, UINT materialIndex, UINT depth)
+		{
+			assert(pipeline < (1u << PIPELINE_BITS));
+			assert(meshIndex < MAX_MESHES);
+			assert(lod < (1u << LOD_BITS));
+			assert(materialIndex < MAX_MATERIALS);
+			assert(depth < (1u << DEPTH_BITS));
+
+			return ((UINT64)pipeline << PIPELINE_SHIFT) |
+				((UINT64)meshIndex << MESH_SHIFT) |
+				((UINT64)lod << LOD_SHIFT) |
+				((UINT64)materialIndex << MATERIAL_SHIFT) |
+				(UINT64)depth;
+		}
+
+		inline UINT GetMeshIndex(UINT64 key)
+		{
+			return (UINT)((key >> MESH_SHIFT) & ((1ull << MESH_BITS) - 1));
+		}
+
+		inline UINT GetLod(UINT64 key)
+		{
+			return (UINT)((key >> LOD_SHIFT) & ((1ull << LOD_BITS) - 1));
+		}
+
+		// Pipeline, mesh and LOD, instances with the same batch can be drawn together
+		inline UINT64 GetBatch(UINT64 key)
+		{
+			return key >> LOD_SHIFT;
+		}
+	}
+
+	struct MeshInstanceRange
+	{
+		UINT Offset = 0;
+		UINT NumInstances = 0;
+		UINT NextInstance = 0;
+	};
+
 	struct FramePacket
 	{
 		struct {
-			ID Intermediate;
-			ID Depth;
 			ID Result;
 		} Targets;
 
@@ -28,11 +90,42 @@ namespace env
 		struct {
 			CameraSettings Settings;
 			Transform Transform;
+
+			// Used to quantize the view depth of the draw keys
+			Float3 Position;
+			Float3 Forward;
+
+			Frustum Frustum;
+
+			// Pixels covered by one unit at a distance of one, for the LOD selection
+			float LodScale;
 		} Camera;
 
-		std::unordered_map<ID, std::vector<InstanceBufferElementData>> MeshOpaqueInstances;
+		// Submitted instances in submission order, with one draw key each.
+		// The vectors are cleared but keep their memory between frames.
+		std::vector<InstanceBufferElementData> Instances;
+		std::vector<UINT64> DrawKeys;
+		std::vector<UINT> DrawKeyInstances;
+
+		// Meshes of the draw keys, in the order they were first submitted
+		std::vector<ID> DrawKeyMeshes;
+		std::unordered_map<ID, UINT> DrawKeyMeshIndices;
+		std::vector<UINT64> SortScratchKeys;
+		std::vector<UINT> SortScratchInstances;
+
+		// Instances are written straight into the mapped instance buffer when
+		// the stream is enabled, no draw keys are created in that case. The
+		// ranges are per mesh and LOD, see Renderer::GetStreamKey.
+		struct {
+			bool Enabled = false;
+			UINT NumInstances = 0;
+			InstanceBufferElementData* Data = nullptr;
+			std::unordered_map<ID, MeshInstanceRange> MeshRanges;
+		} InstanceStream;
 
-		std::unordered_map<ID, UINT> MaterialInstanceIndices;
+		// Indexed by material ID, holds the index in MaterialInstances plus one.
+		// Zero means the material has not been added to the packet yet.
+		std::vector<UINT> MaterialIndexLookup;
 		std::vector<MaterialBufferInstanceData> MaterialInstances;
 	};
 }
\ No newline at end of file
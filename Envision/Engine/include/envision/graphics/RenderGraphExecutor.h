@@ -0,0 +1,124 @@
+#pragma once
+#include "envision/envpch.h"
+#include "envision/core/CommandList.h"
+#include "envision/core/CommandQueue.h"
+#include "envision/core/DeferredReleaseQueue.h"
+#include "envision/core/RenderGraph.h"
+#include "envision/resource/Resource.h"
+
+namespace env
+{
+	class RenderGraphExecutor;
+
+	// Given to the pass functions while the graph is recorded
+	class RenderGraphContext
+	{
+	private:
+
+		friend class env::RenderGraphExecutor;
+
+		RenderGraphExecutor& m_executor;
+		CommandQueue& m_queue;
+		DirectList* m_list;
+
+		RenderGraphContext(RenderGraphExecutor& executor, CommandQueue& queue);
+
+	public:
+
+		DirectList* GetList();
+		Resource* GetResource(UINT resource);
+		Texture2D* GetTexture(UINT resource);
+
+		// For lists the pass records itself, on other threads for example.
+		// They run after everything recorded so far, the graph goes on in a
+		// new list after them.
+		void QueueLists(DirectList* const* lists, UINT numLists);
+	};
+
+	typedef std::function<void(RenderGraphContext& context)> RenderGraphPassFunction;
+
+	// Records a RenderGraph on direct lists. The graph is declared again
+	// every frame, Execute then compiles it, places the transient textures
+	// in one heap shared by all of them and records each pass behind the
+	// barriers it needs as one batch.
+	//
+	// Imported resources are tracked by Resource::State, which is updated
+	// as the graph transitions them. Transient textures are kept between
+	// frames and only recreated when the graph places them differently, so
+	// a steady graph creates nothing per frame. The heap is shared by the
+	// frames in flight, which only works as long as they all execute on the
+	// same queue.
+	class RenderGraphExecutor
+	{
+	private:
+
+		struct TransientTexture
+		{
+			RenderGraphTextureDesc Desc;
+			UINT64 HeapOffset;
+			ID Texture;
+			bool IsUsed;
+		};
+
+		RenderGraph m_graph;
+		std::vector<RenderGraphPassFunction> m_passFunctions;
+
+		// Per resource of the graph, transient textures are resolved in Execute
+		std::vector<Resource*> m_resources;
+		std::unordered_map<Resource*, UINT> m_importedResources;
+
+		ID3D12Heap* m_heap;
+		UINT64 m_heapSize;
+		std::vector<TransientTexture> m_transientTextures;
+
+		std::vector<D3D12_RESOURCE_BARRIER> m_barriers;
+
+		// Heaps replaced while frames in flight might still use them
+		DeferredReleaseQueue m_deferredReleases;
+
+		float m_compileTime;
+
+	public:
+
+		RenderGraphExecutor();
+		~RenderGraphExecutor();
+
+		RenderGraphExecutor(const RenderGraphExecutor& other) = delete;
+		RenderGraphExecutor(const RenderGraphExecutor&& other) = delete;
+		RenderGraphExecutor& operator=(const RenderGraphExecutor& other) = delete;
+		RenderGraphExecutor& operator=(const RenderGraphExecutor&& other) = delete;
+
+	public:
+
+		// Starts the declaration of the next graph
+		void Begin();
+
+		// Importing a resource again returns the same index. The final state
+		// is only used the first time, by default the resource is left in
+		// the state of its last use.
+		UINT ImportResource(Resource* resource, D3D12_RESOURCE_STATES finalState = (D3D12_RESOURCE_STATES)RenderGraph::UNKNOWN_STATE);
+
+		// Render targets and depth stencils only, the content is undefined
+		// until the first pass using the texture clears it
+		UINT CreateTexture(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType);
+
+		UINT AddPass(const std::string& name, RenderGraphPassFunction function, bool hasSideEffects = false);
+		void Read(UINT pass, UINT resource, D3D12_RESOURCE_STATES state);
+		void Write(UINT pass, UINT resource, D3D12_RESOURCE_STATES state);
+
+		// Records the passes that were not culled and queues the lists
+		void Execute(CommandQueue& queue);
+
+		Resource* GetResource(UINT resource);
+
+		const RenderGraph& GetGraph() const;
+		float GetCompileTime() const; // Seconds, of the last Execute
+		UINT64 GetHeapSize() const;
+
+	private:
+
+		void PrepareHeap();
+		void PrepareTransientTextures();
+		void RecordBarriers(DirectList* list, UINT numBarriers, const RenderGraphBarrier* barriers);
+	};
+}
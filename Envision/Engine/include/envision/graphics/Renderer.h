@@ -1,16 +1,44 @@
 #pragma once
 #include "envision/envpch.h"
 #include "envision/core/Camera.h"
-#include "envision/core/DescriptorAllocator.h"
+#include "envision/core/FramePipeline.h"
 #include "envision/core/GPU.h"
 #include "envision/core/IDGenerator.h"
+#include "envision/core/Scene.h"
+#include "envision/core/Time.h"
 #include "envision/graphics/Assets.h"
 #include "envision/graphics/CoreShaderDataStructures.h"
 #include "envision/graphics/FramePacket.h"
+#include "envision/graphics/RenderGraphExecutor.h"
 #include "envision/resource/Resource.h"
 
 namespace env
 {
+	struct RendererStatistics
+	{
+		UINT NumInstances = 0;
+		UINT NumDrawCalls = 0;
+		UINT InstanceCapacity = 0;
+		float SubmitTime = 0.f; // Seconds between BeginFrame and EndFrame
+		float SortTime = 0.f; // Seconds spent sorting draw keys in EndFrame
+
+		UINT NumVisible = 0;
+		UINT NumCulled = 0;
+		float CullTime = 0.f; // Seconds spent culling in SubmitParallel
+
+		UINT NumRejected = 0; // Submits that were dropped, see RejectSubmit
+
+		UINT64 NumTriangles = 0; // Drawn, at the selected LODs
+		UINT64 NumFullDetailTriangles = 0; // Had every instance been drawn at full detail
+		UINT NumInstancesPerLod[MAX_MESH_LODS] = {};
+		float LodSelectTime = 0.f; // Seconds spent selecting LODs in SubmitParallel, summed over its threads
+
+		UINT NumCommandLists = 0; // Lists the draws of EndFrame were recorded into
+		float RecordTime = 0.f; // Seconds spent recording the draws in EndFrame
+
+		float FrameWaitTime = 0.f; // Seconds BeginFrame waited for the GPU to free a frame packet
+	};
+
 	// Singleton
 	class Renderer
 	{
@@ -18,18 +46,50 @@ namespace env
 
 		env::IDGenerator& m_commonIDGenerator;
 
-		DirectList* m_directList;
-
-		const UINT ROOT_INDEX_INSTANCE_OFFSET_CONSTANT = 0;
-		const UINT ROOT_INDEX_INSTANCE_TABLE = 1;
-		const UINT ROOT_INDEX_MATERIAL_TABLE = 2;
-		const UINT ROOT_INDEX_CAMERA_BUFFER = 3;
+		const UINT ROOT_INDEX_CONSTANTS = 0;
+		const UINT ROOT_INDEX_BINDLESS_TABLE = 1;
+		const UINT ROOT_INDEX_CAMERA_BUFFER = 2;
+
+		// Offsets of the root constants
+		const UINT ROOT_CONSTANT_INSTANCE_OFFSET = 0;
+		const UINT ROOT_CONSTANT_INSTANCE_BUFFER = 1;
+		const UINT ROOT_CONSTANT_MATERIAL_BUFFER = 2;
+		const UINT ROOT_CONSTANT_POSITION_CENTER = 4; // Float3, packed like the shader constant buffer
+		const UINT ROOT_CONSTANT_POSITION_EXTENTS = 8; // Float3
+		const UINT NUM_ROOT_CONSTANTS = 11;
 		ID m_pipelineState;
 
-		static const int NUM_FRAME_PACKETS = 2;
+		// Entities per task in SubmitParallel. The instance layout only depends
+		// on this, not on the number of threads.
+		static const size_t SUBMIT_CHUNK_SIZE = 2048;
+
+		// Render jobs per list when EndFrame records on several threads, fewer
+		// jobs than this are not worth another list
+		static const size_t RECORD_CHUNK_SIZE = 256;
+		UINT m_maxRecordThreads = 0;
+
+		// Frames are pipelined on the present queue, a packet is reused once
+		// the GPU is done with the frame that used it before
+		static const int NUM_FRAME_PACKETS = FramePipeline<CommandQueue>::MAX_DEPTH;
+		static const UINT DEFAULT_FRAME_PIPELINE_DEPTH = 2;
+		FramePipeline<CommandQueue> m_framePipeline;
 		int m_currentFramePacketIndex = 0;
 		std::array<FramePacket, NUM_FRAME_PACKETS> m_framePackets;
-		std::array<DescriptorAllocator, NUM_FRAME_PACKETS> m_descriptorAllocators;
+
+		// Declared again in every EndFrame. Its transient targets are shared
+		// by all frame packets, the frames execute in order on the present
+		// queue.
+		RenderGraphExecutor m_renderGraph;
+
+		bool m_cullingEnabled = true;
+
+		// The coarsest LOD whose error covers at most this many pixels is drawn
+		static constexpr float DEFAULT_LOD_ERROR_THRESHOLD = 1.f;
+		bool m_lodEnabled = true;
+		float m_lodErrorThreshold = DEFAULT_LOD_ERROR_THRESHOLD;
+
+		Timepoint m_submitBegin;
+		RendererStatistics m_statistics;
 
 	public:
 
@@ -51,17 +111,88 @@ namespace env
 
 	private:
 
-		int StepCurrentFramePacketIndex();
 		void ClearCurrentFramePacket();
 		FramePacket& GetCurrentFramePacket();
+		InstanceBufferElementData* EnsureInstanceCapacity(FramePacket& packet, UINT numInstances);
+		UINT GetMaterialIndex(FramePacket& packet, ID material);
+		UINT GetDrawKeyMeshIndex(FramePacket& packet, ID mesh);
+		static void WriteInstanceData(InstanceBufferElementData& destination, const Float4x4& worldMatrix, ID mesh, UINT materialIndex);
+
+		// Returns false if the bounds are unknown
+		static bool GetWorldBoundingSphere(const Float4x4& world, const MeshBounds& bounds, Float3& center, float& radius);
+
+		// LOD of an instance from its world bounding sphere, 0 is full detail
+		UINT SelectLod(const FramePacket& packet, const Mesh* mesh, const Float3& center, float radius) const;
+
+		// Instance stream ranges are kept per mesh and LOD, the LOD is stored
+		// in the top byte of the mesh ID
+		static ID GetStreamKey(ID mesh, UINT lod);
+		static ID GetStreamKeyMesh(ID key);
+		static UINT GetStreamKeyLod(ID key);
+		void ReserveLodInstances(ID mesh, UINT lod, UINT numInstances);
+
+		// Counts dropped submits, the reason is reported for the first one of
+		// each frame only
+		void RejectSubmit(const char* reason, UINT numRejected = 1);
 
 	public:
 
 		void Initialize();
 
+		// BeginFrame waits until the GPU is done with the frame that last used
+		// the next frame packet. EndFrame queues the frame's lists on the
+		// present queue, and SubmitFrame executes everything queued there
+		// and signals the fence the packet waits for.
 		void BeginFrame(const CameraSettings& cameraSettings, Transform& cameraTransform, ID target);
 		void Submit(Transform& transform, ID mesh, ID material);
+		void Submit(const Float4x4& worldMatrix, ID mesh, ID material);
 		void EndFrame();
+		UINT64 SubmitFrame();
+
+		// Number of frames the CPU can be ahead of the GPU, between 1 and
+		// NUM_FRAME_PACKETS. Waits for all frames in flight when changed.
+		void SetFramePipelineDepth(UINT depth);
+		UINT GetFramePipelineDepth() const;
+		UINT GetNumFramesInFlight();
+
+		// Index of the frame packet since the last BeginFrame, for other
+		// per frame resources
+		UINT GetFramePacketIndex() const;
+		static UINT GetMaxFramesInFlight();
+
+		// Instance stream, the submission is done in two passes. Reserve the
+		// number of instances per mesh first, then call BeginInstanceStream
+		// before submitting them. Submit then writes each instance directly
+		// to GPU visible memory instead of buffering it for EndFrame. The
+		// reserved instances are drawn at full detail.
+		void ReserveInstances(ID mesh, UINT numInstances = 1);
+		void BeginInstanceStream();
+
+		// Submits all entities with a render and world transform component, split in
+		// chunks over the job system. Uses the instance stream, any instances
+		// reserved before the call are placed after the scene's instances.
+		// maxThreads limits the number of threads used, 0 uses all of them.
+		void SubmitParallel(Scene& scene, UINT maxThreads = 0);
+
+		// Instances outside the camera frustum are skipped by Submit and SubmitParallel
+		void SetCullingEnabled(bool enabled);
+
+		// Instances further away are drawn with simplified versions of their
+		// mesh, as long as the simplification error covers at most the given
+		// number of pixels on screen
+		void SetLodEnabled(bool enabled);
+		void SetLodErrorThreshold(float pixels);
+
+		// Limits the threads EndFrame records the draws on, 0 uses all of them
+		void SetMaxRecordThreads(UINT maxThreads);
+
+		const RendererStatistics& GetStatistics() const;
+
+		// Graph of the last EndFrame
+		const RenderGraphExecutor& GetRenderGraph() const;
+
+		// Frustum of the camera given to the last BeginFrame
+		const Frustum& GetCameraFrustum();
 
 	};
 }
\ No newline at end of file
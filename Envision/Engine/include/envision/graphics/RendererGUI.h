@@ -12,7 +12,7 @@ namespace env
 
 		env::IDGenerator& m_commonIDGenerator;
 
-		DirectList* m_directList = nullptr;
+		DirectList* m_directList = nullptr; // Acquired for the current frame
 		ID3D12DescriptorHeap* m_imguiDescriptorHeap = nullptr;
 		ImGuiContext* m_imguiContext = nullptr;
 
@@ -22,8 +22,14 @@
 	TABLE_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, numDescriptors, baseShaderRegister, registerSpace, offsetDescTable)
 #define SAMPLER_RANGE(numDescriptors, baseShaderRegister, registerSpace, offsetDescTable) \
 	TABLE_RANGE(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, numDescriptors, baseShaderRegister, registerSpace, offsetDescTable)
-#define ROOT_TABLE(stages, ranges) \
-	{ ParameterType::Table, stages, { ranges } }
+#define ROOT_TABLE(stages, ...) \
+	{ ParameterType::Table, stages, { __VA_ARGS__ } }
+
+// Covers the whole bindless heap of the ResourceManager from t0 in the given
+// space. Ranges of a table may overlap, so each resource type the shaders
+// index the heap with gets its own space.
+#define BINDLESS_SRV_RANGE(registerSpace) \
+	SRV_RANGE(UINT_MAX, 0, registerSpace, 0)
 
 
 namespace env
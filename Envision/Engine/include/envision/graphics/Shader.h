@@ -26,6 +26,13 @@ namespace env
 	{
 		Unknown = 0,
 		V5_0,
+		V5_1, // Unbounded descriptor arrays, needed for the bindless heap
+	};
+
+	struct ShaderDefine
+	{
+		std::string Name;
+		std::string Value;
 	};
 
 	struct ShaderDesc
@@ -34,6 +41,7 @@ namespace env
 		ShaderModel Model;
 		std::string Path;
 		std::string EntryPoint;
+		std::vector<ShaderDefine> Defines = std::vector<ShaderDefine>(0);
 	};
 
 	std::string GetTargetModelString(ShaderStage stage, ShaderModel model);
@@ -0,0 +1,1412 @@
+#pragma once
+// Included by envpch.h when PLATFORM_NULL is defined, in place of Windows.h,
+// d3d12.h, dxgi1_6.h and d3dcompiler.h. Declares the part of their API that
+// the engine uses, backed by a device that only lives in memory: resources,
+// descriptor heaps, fences and recorded commands are tracked on the CPU and
+// queues complete their work as soon as it is executed. Nothing is drawn.
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// ######################################################################### //
+// ################################ WIN32 ################################## //
+// ######################################################################### //
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned char UINT8;
+typedef unsigned short WORD;
+typedef unsigned short UINT16;
+typedef int INT;
+typedef unsigned int UINT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef uint32_t DWORD;
+typedef int64_t INT64;
+typedef uint64_t UINT64;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t UINT_PTR;
+typedef wchar_t WCHAR;
+typedef const char* LPCSTR;
+typedef const wchar_t* LPCWSTR;
+typedef int32_t HRESULT;
+typedef void* HANDLE;
+typedef void* HWND;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#define INFINITE 0xFFFFFFFF
+#define WAIT_OBJECT_0 0
+
+#define ZeroMemory(destination, length) memset((destination), 0, (length))
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+// Events are signaled by the null fences, waits block like on Windows
+HANDLE CreateEvent(void* attributes, BOOL manualReset, BOOL initialState, const void* name);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+void OutputDebugStringA(LPCSTR text);
+
+inline int memcpy_s(void* destination, size_t destinationSize, const void* source, size_t count)
+{
+	if (count > destinationSize)
+		return 1;
+	memcpy(destination, source, count);
+	return 0;
+}
+
+// Interfaces are not queried, so interface IDs carry no information
+typedef const void* REFIID;
+#define __uuidof(x) nullptr
+#define IID_PPV_ARGS(pp) nullptr, reinterpret_cast<void**>(pp)
+
+// Reference counted like COM objects, deleted on the last Release
+class IUnknown
+{
+private:
+
+	std::atomic<ULONG> m_refCount;
+
+public:
+
+	IUnknown() : m_refCount(1) {}
+	virtual ~IUnknown() = default;
+
+	IUnknown(const IUnknown& other) = delete;
+	IUnknown(const IUnknown&& other) = delete;
+	IUnknown& operator=(const IUnknown& other) = delete;
+	IUnknown& operator=(const IUnknown&& other) = delete;
+
+	ULONG AddRef();
+	ULONG Release();
+};
+
+#define NULL_ENUM_FLAG_OPERATORS(Type) \
+	inline Type operator|(Type a, Type b) { return Type((int)a | (int)b); } \
+	inline Type operator&(Type a, Type b) { return Type((int)a & (int)b); } \
+	inline Type& operator|=(Type& a, Type b) { return a = a | b; } \
+	inline Type& operator&=(Type& a, Type b) { return a = a & b; } \
+	inline Type operator~(Type a) { return Type(~(int)a); }
+
+// ######################################################################### //
+// ################################# DXGI ################################## //
+// ######################################################################### //
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+	DXGI_FORMAT_R32G32B32A32_UINT = 3,
+	DXGI_FORMAT_R32G32B32A32_SINT = 4,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R32G32B32_UINT = 7,
+	DXGI_FORMAT_R32G32B32_SINT = 8,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R16G16B16A16_UINT = 12,
+	DXGI_FORMAT_R16G16B16A16_SNORM = 13,
+	DXGI_FORMAT_R16G16B16A16_SINT = 14,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R32G32_UINT = 17,
+	DXGI_FORMAT_R32G32_SINT = 18,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UINT = 30,
+	DXGI_FORMAT_R8G8B8A8_SNORM = 31,
+	DXGI_FORMAT_R8G8B8A8_SINT = 32,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R16G16_UNORM = 35,
+	DXGI_FORMAT_R16G16_UINT = 36,
+	DXGI_FORMAT_R16G16_SNORM = 37,
+	DXGI_FORMAT_R16G16_SINT = 38,
+	DXGI_FORMAT_D32_FLOAT = 40,
+	DXGI_FORMAT_R32_FLOAT = 41,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R32_SINT = 43,
+	DXGI_FORMAT_R16_UINT = 57,
+};
+
+// Size of one element of the format in bytes, 0 for unknown formats
+UINT NullGetFormatSize(DXGI_FORMAT format);
+
+struct DXGI_SAMPLE_DESC
+{
+	UINT Count;
+	UINT Quality;
+};
+
+typedef UINT DXGI_USAGE;
+#define DXGI_USAGE_RENDER_TARGET_OUTPUT 0x00000020UL
+
+enum DXGI_SCALING
+{
+	DXGI_SCALING_STRETCH = 0,
+	DXGI_SCALING_NONE = 1,
+	DXGI_SCALING_ASPECT_RATIO_STRETCH = 2,
+};
+
+enum DXGI_SWAP_EFFECT
+{
+	DXGI_SWAP_EFFECT_DISCARD = 0,
+	DXGI_SWAP_EFFECT_SEQUENTIAL = 1,
+	DXGI_SWAP_EFFECT_FLIP_SEQUENTIAL = 3,
+	DXGI_SWAP_EFFECT_FLIP_DISCARD = 4,
+};
+
+struct DXGI_SWAP_CHAIN_DESC1
+{
+	UINT Width;
+	UINT Height;
+	DXGI_FORMAT Format;
+	BOOL Stereo;
+	DXGI_SAMPLE_DESC SampleDesc;
+	DXGI_USAGE BufferUsage;
+	UINT BufferCount;
+	DXGI_SCALING Scaling;
+	DXGI_SWAP_EFFECT SwapEffect;
+	UINT AlphaMode;
+	UINT Flags;
+};
+
+struct DXGI_ADAPTER_DESC1
+{
+	WCHAR Description[128];
+	UINT VendorId;
+	UINT DeviceId;
+	UINT SubSysId;
+	UINT Revision;
+	SIZE_T DedicatedVideoMemory;
+	SIZE_T DedicatedSystemMemory;
+	SIZE_T SharedSystemMemory;
+	UINT Flags;
+};
+
+#define DXGI_CREATE_FACTORY_DEBUG 0x01
+#define DXGI_ERROR_NOT_FOUND ((HRESULT)0x887A0002)
+
+// ######################################################################### //
+// ################################# D3D12 ################################# //
+// ######################################################################### //
+
+class ID3D12Device;
+class ID3D12Resource;
+class ID3D12Heap;
+class ID3D12DescriptorHeap;
+class ID3D12RootSignature;
+class ID3D12PipelineState;
+class ID3D12CommandAllocator;
+class ID3D12Fence;
+class ID3D10Blob;
+
+typedef UINT64 D3D12_GPU_VIRTUAL_ADDRESS;
+
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT 65536
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT 256
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES 0xffffffff
+#define D3D12_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D12_DEFAULT_STENCIL_READ_MASK 0xff
+#define D3D12_DEFAULT_STENCIL_WRITE_MASK 0xff
+#define D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING 0x1688
+#define D3D12_ERROR_DRIVER_VERSION_MISMATCH ((HRESULT)0x887E0002)
+
+enum D3D_FEATURE_LEVEL
+{
+	D3D_FEATURE_LEVEL_12_0 = 0xc000,
+	D3D_FEATURE_LEVEL_12_1 = 0xc100,
+};
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+	D3D_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D_PRIMITIVE_TOPOLOGY_LINESTRIP = 3,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5,
+};
+typedef D3D_PRIMITIVE_TOPOLOGY D3D12_PRIMITIVE_TOPOLOGY;
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE
+{
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3,
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH = 4,
+};
+
+enum D3D12_COMMAND_LIST_TYPE
+{
+	D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+	D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+	D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+	D3D12_COMMAND_LIST_TYPE_COPY = 3,
+};
+
+enum D3D12_COMMAND_QUEUE_FLAGS
+{
+	D3D12_COMMAND_QUEUE_FLAG_NONE = 0,
+	D3D12_COMMAND_QUEUE_FLAG_DISABLE_GPU_TIMEOUT = 0x1,
+};
+
+enum D3D12_COMMAND_QUEUE_PRIORITY
+{
+	D3D12_COMMAND_QUEUE_PRIORITY_NORMAL = 0,
+	D3D12_COMMAND_QUEUE_PRIORITY_HIGH = 100,
+};
+
+struct D3D12_COMMAND_QUEUE_DESC
+{
+	D3D12_COMMAND_LIST_TYPE Type;
+	INT Priority;
+	D3D12_COMMAND_QUEUE_FLAGS Flags;
+	UINT NodeMask;
+};
+
+enum D3D12_FENCE_FLAGS
+{
+	D3D12_FENCE_FLAG_NONE = 0,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE
+{
+	D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+	D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER = 1,
+	D3D12_DESCRIPTOR_HEAP_TYPE_RTV = 2,
+	D3D12_DESCRIPTOR_HEAP_TYPE_DSV = 3,
+	D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES = 4,
+};
+
+enum D3D12_DESCRIPTOR_HEAP_FLAGS
+{
+	D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0,
+	D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 0x1,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_DESCRIPTOR_HEAP_FLAGS)
+
+struct D3D12_DESCRIPTOR_HEAP_DESC
+{
+	D3D12_DESCRIPTOR_HEAP_TYPE Type;
+	UINT NumDescriptors;
+	D3D12_DESCRIPTOR_HEAP_FLAGS Flags;
+	UINT NodeMask;
+};
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE
+{
+	SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE
+{
+	UINT64 ptr;
+};
+
+enum D3D12_HEAP_TYPE
+{
+	D3D12_HEAP_TYPE_DEFAULT = 1,
+	D3D12_HEAP_TYPE_UPLOAD = 2,
+	D3D12_HEAP_TYPE_READBACK = 3,
+	D3D12_HEAP_TYPE_CUSTOM = 4,
+};
+
+enum D3D12_CPU_PAGE_PROPERTY
+{
+	D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0,
+	D3D12_CPU_PAGE_PROPERTY_NOT_AVAILABLE = 1,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_COMBINE = 2,
+	D3D12_CPU_PAGE_PROPERTY_WRITE_BACK = 3,
+};
+
+enum D3D12_MEMORY_POOL
+{
+	D3D12_MEMORY_POOL_UNKNOWN = 0,
+	D3D12_MEMORY_POOL_L0 = 1,
+	D3D12_MEMORY_POOL_L1 = 2,
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+	D3D12_HEAP_TYPE Type;
+	D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+	D3D12_MEMORY_POOL MemoryPoolPreference;
+	UINT CreationNodeMask;
+	UINT VisibleNodeMask;
+};
+
+enum D3D12_HEAP_FLAGS
+{
+	D3D12_HEAP_FLAG_NONE = 0,
+	D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+	D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+	D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+	D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+struct D3D12_HEAP_DESC
+{
+	UINT64 SizeInBytes;
+	D3D12_HEAP_PROPERTIES Properties;
+	UINT64 Alignment;
+	D3D12_HEAP_FLAGS Flags;
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO
+{
+	UINT64 SizeInBytes;
+	UINT64 Alignment;
+};
+
+enum D3D12_RESOURCE_DIMENSION
+{
+	D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+	D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+	D3D12_RESOURCE_DIMENSION_TEXTURE1D = 2,
+	D3D12_RESOURCE_DIMENSION_TEXTURE2D = 3,
+	D3D12_RESOURCE_DIMENSION_TEXTURE3D = 4,
+};
+
+enum D3D12_TEXTURE_LAYOUT
+{
+	D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+	D3D12_TEXTURE_LAYOUT_ROW_MAJOR = 1,
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+	D3D12_RESOURCE_FLAG_NONE = 0,
+	D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+	D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+	D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+	D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE = 0x8,
+	D3D12_RESOURCE_FLAG_ALLOW_CROSS_ADAPTER = 0x10,
+	D3D12_RESOURCE_FLAG_ALLOW_SIMULTANEOUS_ACCESS = 0x20,
+	D3D12_RESOURCE_FLAG_VIDEO_DECODE_REFERENCE_ONLY = 0x40,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+struct D3D12_RESOURCE_DESC
+{
+	D3D12_RESOURCE_DIMENSION Dimension;
+	UINT64 Alignment;
+	UINT64 Width;
+	UINT Height;
+	UINT16 DepthOrArraySize;
+	UINT16 MipLevels;
+	DXGI_FORMAT Format;
+	DXGI_SAMPLE_DESC SampleDesc;
+	D3D12_TEXTURE_LAYOUT Layout;
+	D3D12_RESOURCE_FLAGS Flags;
+};
+
+enum D3D12_RESOURCE_STATES
+{
+	D3D12_RESOURCE_STATE_COMMON = 0,
+	D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+	D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+	D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+	D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+	D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+	D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+	D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+	D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+	D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+	D3D12_RESOURCE_STATE_PRESENT = 0,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+struct D3D12_RANGE
+{
+	SIZE_T Begin;
+	SIZE_T End;
+};
+
+struct D3D12_DEPTH_STENCIL_VALUE
+{
+	FLOAT Depth;
+	UINT8 Stencil;
+};
+
+struct D3D12_CLEAR_VALUE
+{
+	DXGI_FORMAT Format;
+	union
+	{
+		FLOAT Color[4];
+		D3D12_DEPTH_STENCIL_VALUE DepthStencil;
+	};
+};
+
+enum D3D12_CLEAR_FLAGS
+{
+	D3D12_CLEAR_FLAG_DEPTH = 0x1,
+	D3D12_CLEAR_FLAG_STENCIL = 0x2,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_CLEAR_FLAGS)
+
+enum D3D12_RESOURCE_BARRIER_TYPE
+{
+	D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+	D3D12_RESOURCE_BARRIER_TYPE_ALIASING = 1,
+	D3D12_RESOURCE_BARRIER_TYPE_UAV = 2,
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS
+{
+	D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+	D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+	D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2,
+};
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER
+{
+	ID3D12Resource* pResource;
+	UINT Subresource;
+	D3D12_RESOURCE_STATES StateBefore;
+	D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER
+{
+	ID3D12Resource* pResourceBefore;
+	ID3D12Resource* pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER
+{
+	ID3D12Resource* pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER
+{
+	D3D12_RESOURCE_BARRIER_TYPE Type;
+	D3D12_RESOURCE_BARRIER_FLAGS Flags;
+	union
+	{
+		D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+		D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+		D3D12_RESOURCE_UAV_BARRIER UAV;
+	};
+};
+
+struct D3D12_SUBRESOURCE_FOOTPRINT
+{
+	DXGI_FORMAT Format;
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT
+{
+	UINT64 Offset;
+	D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+struct D3D12_VERTEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+
+struct D3D12_INDEX_BUFFER_VIEW
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+struct D3D12_VIEWPORT
+{
+	FLOAT TopLeftX;
+	FLOAT TopLeftY;
+	FLOAT Width;
+	FLOAT Height;
+	FLOAT MinDepth;
+	FLOAT MaxDepth;
+};
+
+typedef RECT D3D12_RECT;
+
+// Views
+
+struct D3D12_CONSTANT_BUFFER_VIEW_DESC
+{
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+};
+
+enum D3D12_SRV_DIMENSION
+{
+	D3D12_SRV_DIMENSION_UNKNOWN = 0,
+	D3D12_SRV_DIMENSION_BUFFER = 1,
+	D3D12_SRV_DIMENSION_TEXTURE2D = 4,
+	D3D12_SRV_DIMENSION_TEXTURE2DARRAY = 5,
+};
+
+enum D3D12_BUFFER_SRV_FLAGS
+{
+	D3D12_BUFFER_SRV_FLAG_NONE = 0,
+	D3D12_BUFFER_SRV_FLAG_RAW = 0x1,
+};
+
+struct D3D12_BUFFER_SRV
+{
+	UINT64 FirstElement;
+	UINT NumElements;
+	UINT StructureByteStride;
+	D3D12_BUFFER_SRV_FLAGS Flags;
+};
+
+struct D3D12_TEX2D_SRV
+{
+	UINT MostDetailedMip;
+	UINT MipLevels;
+	UINT PlaneSlice;
+	FLOAT ResourceMinLODClamp;
+};
+
+struct D3D12_TEX2D_ARRAY_SRV
+{
+	UINT MostDetailedMip;
+	UINT MipLevels;
+	UINT FirstArraySlice;
+	UINT ArraySize;
+	UINT PlaneSlice;
+	FLOAT ResourceMinLODClamp;
+};
+
+struct D3D12_SHADER_RESOURCE_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_SRV_DIMENSION ViewDimension;
+	UINT Shader4ComponentMapping;
+	union
+	{
+		D3D12_BUFFER_SRV Buffer;
+		D3D12_TEX2D_SRV Texture2D;
+		D3D12_TEX2D_ARRAY_SRV Texture2DArray;
+	};
+};
+
+enum D3D12_UAV_DIMENSION
+{
+	D3D12_UAV_DIMENSION_UNKNOWN = 0,
+	D3D12_UAV_DIMENSION_BUFFER = 1,
+	D3D12_UAV_DIMENSION_TEXTURE2D = 4,
+};
+
+struct D3D12_BUFFER_UAV
+{
+	UINT64 FirstElement;
+	UINT NumElements;
+	UINT StructureByteStride;
+	UINT64 CounterOffsetInBytes;
+	UINT Flags;
+};
+
+struct D3D12_TEX2D_UAV
+{
+	UINT MipSlice;
+	UINT PlaneSlice;
+};
+
+struct D3D12_UNORDERED_ACCESS_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_UAV_DIMENSION ViewDimension;
+	union
+	{
+		D3D12_BUFFER_UAV Buffer;
+		D3D12_TEX2D_UAV Texture2D;
+	};
+};
+
+enum D3D12_RTV_DIMENSION
+{
+	D3D12_RTV_DIMENSION_UNKNOWN = 0,
+	D3D12_RTV_DIMENSION_BUFFER = 1,
+	D3D12_RTV_DIMENSION_TEXTURE2D = 4,
+};
+
+struct D3D12_TEX2D_RTV
+{
+	UINT MipSlice;
+	UINT PlaneSlice;
+};
+
+struct D3D12_RENDER_TARGET_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_RTV_DIMENSION ViewDimension;
+	union
+	{
+		D3D12_TEX2D_RTV Texture2D;
+	};
+};
+
+enum D3D12_DSV_DIMENSION
+{
+	D3D12_DSV_DIMENSION_UNKNOWN = 0,
+	D3D12_DSV_DIMENSION_TEXTURE2D = 3,
+};
+
+enum D3D12_DSV_FLAGS
+{
+	D3D12_DSV_FLAG_NONE = 0,
+};
+
+struct D3D12_TEX2D_DSV
+{
+	UINT MipSlice;
+};
+
+struct D3D12_DEPTH_STENCIL_VIEW_DESC
+{
+	DXGI_FORMAT Format;
+	D3D12_DSV_DIMENSION ViewDimension;
+	D3D12_DSV_FLAGS Flags;
+	union
+	{
+		D3D12_TEX2D_DSV Texture2D;
+	};
+};
+
+// Root signatures
+
+enum D3D_ROOT_SIGNATURE_VERSION
+{
+	D3D_ROOT_SIGNATURE_VERSION_1 = 0x1,
+	D3D_ROOT_SIGNATURE_VERSION_1_0 = 0x1,
+};
+
+enum D3D12_SHADER_VISIBILITY
+{
+	D3D12_SHADER_VISIBILITY_ALL = 0,
+	D3D12_SHADER_VISIBILITY_VERTEX = 1,
+	D3D12_SHADER_VISIBILITY_HULL = 2,
+	D3D12_SHADER_VISIBILITY_DOMAIN = 3,
+	D3D12_SHADER_VISIBILITY_GEOMETRY = 4,
+	D3D12_SHADER_VISIBILITY_PIXEL = 5,
+};
+
+enum D3D12_DESCRIPTOR_RANGE_TYPE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE_SRV = 0,
+	D3D12_DESCRIPTOR_RANGE_TYPE_UAV = 1,
+	D3D12_DESCRIPTOR_RANGE_TYPE_CBV = 2,
+	D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER = 3,
+};
+
+struct D3D12_DESCRIPTOR_RANGE
+{
+	D3D12_DESCRIPTOR_RANGE_TYPE RangeType;
+	UINT NumDescriptors;
+	UINT BaseShaderRegister;
+	UINT RegisterSpace;
+	UINT OffsetInDescriptorsFromTableStart;
+};
+
+struct D3D12_ROOT_DESCRIPTOR_TABLE
+{
+	UINT NumDescriptorRanges;
+	const D3D12_DESCRIPTOR_RANGE* pDescriptorRanges;
+};
+
+struct D3D12_ROOT_CONSTANTS
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+	UINT Num32BitValues;
+};
+
+struct D3D12_ROOT_DESCRIPTOR
+{
+	UINT ShaderRegister;
+	UINT RegisterSpace;
+};
+
+enum D3D12_ROOT_PARAMETER_TYPE
+{
+	D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE = 0,
+	D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS = 1,
+	D3D12_ROOT_PARAMETER_TYPE_CBV = 2,
+	D3D12_ROOT_PARAMETER_TYPE_SRV = 3,
+	D3D12_ROOT_PARAMETER_TYPE_UAV = 4,
+};
+
+struct D3D12_ROOT_PARAMETER
+{
+	D3D12_ROOT_PARAMETER_TYPE ParameterType;
+	union
+	{
+		D3D12_ROOT_DESCRIPTOR_TABLE DescriptorTable;
+		D3D12_ROOT_CONSTANTS Constants;
+		D3D12_ROOT_DESCRIPTOR Descriptor;
+	};
+	D3D12_SHADER_VISIBILITY ShaderVisibility;
+};
+
+enum D3D12_ROOT_SIGNATURE_FLAGS
+{
+	D3D12_ROOT_SIGNATURE_FLAG_NONE = 0,
+	D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT = 0x1,
+};
+NULL_ENUM_FLAG_OPERATORS(D3D12_ROOT_SIGNATURE_FLAGS)
+
+struct D3D12_STATIC_SAMPLER_DESC;
+
+struct D3D12_ROOT_SIGNATURE_DESC
+{
+	UINT NumParameters;
+	const D3D12_ROOT_PARAMETER* pParameters;
+	UINT NumStaticSamplers;
+	const D3D12_STATIC_SAMPLER_DESC* pStaticSamplers;
+	D3D12_ROOT_SIGNATURE_FLAGS Flags;
+};
+
+// Pipeline states
+
+struct D3D12_SHADER_BYTECODE
+{
+	const void* pShaderBytecode;
+	SIZE_T BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY;
+
+struct D3D12_STREAM_OUTPUT_DESC
+{
+	const D3D12_SO_DECLARATION_ENTRY* pSODeclaration;
+	UINT NumEntries;
+	const UINT* pBufferStrides;
+	UINT NumStrides;
+	UINT RasterizedStream;
+};
+
+enum D3D12_BLEND
+{
+	D3D12_BLEND_ZERO = 1,
+	D3D12_BLEND_ONE = 2,
+	D3D12_BLEND_SRC_ALPHA = 5,
+	D3D12_BLEND_INV_SRC_ALPHA = 6,
+};
+
+enum D3D12_BLEND_OP
+{
+	D3D12_BLEND_OP_ADD = 1,
+};
+
+enum D3D12_LOGIC_OP
+{
+	D3D12_LOGIC_OP_CLEAR = 0,
+	D3D12_LOGIC_OP_NOOP = 4,
+};
+
+enum D3D12_COLOR_WRITE_ENABLE
+{
+	D3D12_COLOR_WRITE_ENABLE_ALL = 15,
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC
+{
+	BOOL BlendEnable;
+	BOOL LogicOpEnable;
+	D3D12_BLEND SrcBlend;
+	D3D12_BLEND DestBlend;
+	D3D12_BLEND_OP BlendOp;
+	D3D12_BLEND SrcBlendAlpha;
+	D3D12_BLEND DestBlendAlpha;
+	D3D12_BLEND_OP BlendOpAlpha;
+	D3D12_LOGIC_OP LogicOp;
+	UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC
+{
+	BOOL AlphaToCoverageEnable;
+	BOOL IndependentBlendEnable;
+	D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+enum D3D12_FILL_MODE
+{
+	D3D12_FILL_MODE_WIREFRAME = 2,
+	D3D12_FILL_MODE_SOLID = 3,
+};
+
+enum D3D12_CULL_MODE
+{
+	D3D12_CULL_MODE_NONE = 1,
+	D3D12_CULL_MODE_FRONT = 2,
+	D3D12_CULL_MODE_BACK = 3,
+};
+
+struct D3D12_RASTERIZER_DESC
+{
+	D3D12_FILL_MODE FillMode;
+	D3D12_CULL_MODE CullMode;
+	BOOL FrontCounterClockwise;
+	INT DepthBias;
+	FLOAT DepthBiasClamp;
+	FLOAT SlopeScaledDepthBias;
+	BOOL DepthClipEnable;
+	BOOL MultisampleEnable;
+	BOOL AntialiasedLineEnable;
+	UINT ForcedSampleCount;
+	UINT ConservativeRaster;
+};
+
+enum D3D12_DEPTH_WRITE_MASK
+{
+	D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+	D3D12_DEPTH_WRITE_MASK_ALL = 1,
+};
+
+enum D3D12_COMPARISON_FUNC
+{
+	D3D12_COMPARISON_FUNC_NEVER = 1,
+	D3D12_COMPARISON_FUNC_LESS = 2,
+	D3D12_COMPARISON_FUNC_EQUAL = 3,
+	D3D12_COMPARISON_FUNC_LESS_EQUAL = 4,
+	D3D12_COMPARISON_FUNC_GREATER = 5,
+	D3D12_COMPARISON_FUNC_NOT_EQUAL = 6,
+	D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+	D3D12_COMPARISON_FUNC_ALWAYS = 8,
+};
+
+enum D3D12_STENCIL_OP
+{
+	D3D12_STENCIL_OP_KEEP = 1,
+	D3D12_STENCIL_OP_ZERO = 2,
+	D3D12_STENCIL_OP_REPLACE = 3,
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC
+{
+	D3D12_STENCIL_OP StencilFailOp;
+	D3D12_STENCIL_OP StencilDepthFailOp;
+	D3D12_STENCIL_OP StencilPassOp;
+	D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC
+{
+	BOOL DepthEnable;
+	D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+	D3D12_COMPARISON_FUNC DepthFunc;
+	BOOL StencilEnable;
+	UINT8 StencilReadMask;
+	UINT8 StencilWriteMask;
+	D3D12_DEPTH_STENCILOP_DESC FrontFace;
+	D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+enum D3D12_INPUT_CLASSIFICATION
+{
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1,
+};
+
+struct D3D12_INPUT_ELEMENT_DESC
+{
+	LPCSTR SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC
+{
+	const D3D12_INPUT_ELEMENT_DESC* pInputElementDescs;
+	UINT NumElements;
+};
+
+struct D3D12_CACHED_PIPELINE_STATE
+{
+	const void* pCachedBlob;
+	SIZE_T CachedBlobSizeInBytes;
+};
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC
+{
+	ID3D12RootSignature* pRootSignature;
+	D3D12_SHADER_BYTECODE VS;
+	D3D12_SHADER_BYTECODE PS;
+	D3D12_SHADER_BYTECODE DS;
+	D3D12_SHADER_BYTECODE HS;
+	D3D12_SHADER_BYTECODE GS;
+	D3D12_STREAM_OUTPUT_DESC StreamOutput;
+	D3D12_BLEND_DESC BlendState;
+	UINT SampleMask;
+	D3D12_RASTERIZER_DESC RasterizerState;
+	D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+	D3D12_INPUT_LAYOUT_DESC InputLayout;
+	UINT IBStripCutValue;
+	D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+	UINT NumRenderTargets;
+	DXGI_FORMAT RTVFormats[8];
+	DXGI_FORMAT DSVFormat;
+	DXGI_SAMPLE_DESC SampleDesc;
+	UINT NodeMask;
+	D3D12_CACHED_PIPELINE_STATE CachedPSO;
+	UINT Flags;
+};
+
+// ######################################################################### //
+// ############################## STATISTICS ############################### //
+// ######################################################################### //
+
+// Commands recorded into null command lists, counted per kind
+struct NullCommandCounts
+{
+	UINT64 Draws = 0;
+	UINT64 Dispatches = 0;
+	UINT64 Barriers = 0;
+	UINT64 Copies = 0;
+	UINT64 CopiedBytes = 0;
+	UINT64 Clears = 0;
+	UINT64 StateSets = 0; // Pipeline states, root signatures, topologies, targets, viewports
+	UINT64 BufferBindings = 0; // Vertex and index buffers
+	UINT64 RootArguments = 0; // Root constants, descriptors and descriptor tables
+	UINT64 DescriptorHeapSets = 0;
+
+	void Add(const NullCommandCounts& other);
+	UINT64 GetTotal() const;
+};
+
+struct NullDeviceStatistics
+{
+	UINT64 NumResources = 0; // Alive
+	UINT64 ResourceBytes = 0; // Alive, as laid out by the device
+	UINT64 NumHeaps = 0; // Alive, placed resources are in these
+	UINT64 HeapBytes = 0;
+	UINT64 MappedBytes = 0; // Host memory backing mapped resources
+	UINT64 NumDescriptorHeaps = 0;
+	UINT64 NumDescriptors = 0; // Capacity of all alive heaps
+	UINT64 NumViewsCreated = 0;
+	UINT64 NumDescriptorsCopied = 0;
+	UINT64 NumCommandAllocators = 0;
+	UINT64 NumCommandLists = 0;
+	UINT64 NumExecutedLists = 0;
+	UINT64 NumFenceSignals = 0;
+	UINT64 NumPresents = 0;
+	NullCommandCounts ExecutedCommands;
+};
+
+// ######################################################################### //
+// ############################### OBJECTS ################################# //
+// ######################################################################### //
+
+// Child objects hold a reference to the device that created them
+class ID3D12DeviceChild : public IUnknown
+{
+protected:
+
+	ID3D12Device* m_device;
+
+public:
+
+	ID3D12DeviceChild(ID3D12Device* device);
+	~ID3D12DeviceChild() override;
+
+	ID3D12Device* GetNullDevice() const;
+};
+
+class ID3D12Resource : public ID3D12DeviceChild
+{
+private:
+
+	D3D12_RESOURCE_DESC m_desc;
+	D3D12_HEAP_TYPE m_heapType;
+	D3D12_GPU_VIRTUAL_ADDRESS m_address;
+	UINT64 m_byteWidth;
+
+	// Allocated on the first Map, only upload and readback heaps are mapped
+	std::vector<BYTE> m_memory;
+
+public:
+
+	ID3D12Resource(ID3D12Device* device, const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, D3D12_GPU_VIRTUAL_ADDRESS address, UINT64 byteWidth);
+	~ID3D12Resource() override;
+
+	HRESULT Map(UINT subresource, const D3D12_RANGE* readRange, void** data);
+	void Unmap(UINT subresource, const D3D12_RANGE* writtenRange);
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress();
+	D3D12_RESOURCE_DESC GetDesc();
+
+	UINT64 GetNullByteWidth() const;
+};
+
+class ID3D12Heap : public ID3D12DeviceChild
+{
+private:
+
+	D3D12_HEAP_DESC m_desc;
+	D3D12_GPU_VIRTUAL_ADDRESS m_address;
+
+public:
+
+	ID3D12Heap(ID3D12Device* device, const D3D12_HEAP_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS address);
+	~ID3D12Heap() override;
+
+	D3D12_HEAP_DESC GetDesc();
+
+	D3D12_GPU_VIRTUAL_ADDRESS GetNullAddress() const;
+};
+
+enum class NullDescriptorType
+{
+	None = 0,
+	CBV,
+	SRV,
+	UAV,
+	RTV,
+	DSV,
+};
+
+// What a descriptor handle points at. Heaps are arrays of these, so views
+// are created and copied like on a GPU.
+struct NullDescriptor
+{
+	NullDescriptorType Type;
+	ID3D12Resource* Resource;
+	D3D12_GPU_VIRTUAL_ADDRESS BufferLocation;
+	UINT SizeInBytes;
+	DXGI_FORMAT Format;
+};
+
+class ID3D12DescriptorHeap : public ID3D12DeviceChild
+{
+private:
+
+	D3D12_DESCRIPTOR_HEAP_DESC m_desc;
+	std::vector<NullDescriptor> m_descriptors;
+	UINT64 m_gpuStart;
+
+public:
+
+	ID3D12DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC& desc, UINT64 gpuStart);
+	~ID3D12DescriptorHeap() override;
+
+	D3D12_DESCRIPTOR_HEAP_DESC GetDesc();
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart();
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart();
+};
+
+class ID3D12RootSignature : public ID3D12DeviceChild
+{
+private:
+
+	UINT m_numParameters;
+
+public:
+
+	ID3D12RootSignature(ID3D12Device* device, UINT numParameters);
+
+	UINT GetNullNumParameters() const;
+};
+
+class ID3D12PipelineState : public ID3D12DeviceChild
+{
+public:
+
+	ID3D12PipelineState(ID3D12Device* device);
+
+	// A marker that CreateGraphicsPipelineState accepts as CachedPSO
+	HRESULT GetCachedBlob(ID3D10Blob** blob);
+};
+
+class ID3D12CommandAllocator : public ID3D12DeviceChild
+{
+private:
+
+	D3D12_COMMAND_LIST_TYPE m_type;
+
+public:
+
+	ID3D12CommandAllocator(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type);
+	~ID3D12CommandAllocator() override;
+
+	HRESULT Reset();
+};
+
+class ID3D12CommandList : public ID3D12DeviceChild
+{
+protected:
+
+	D3D12_COMMAND_LIST_TYPE m_type;
+	bool m_recording;
+	NullCommandCounts m_counts;
+
+public:
+
+	ID3D12CommandList(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type);
+	~ID3D12CommandList() override;
+
+	D3D12_COMMAND_LIST_TYPE GetType();
+
+	bool IsNullRecording() const;
+	const NullCommandCounts& GetNullCounts() const;
+};
+
+class ID3D12GraphicsCommandList : public ID3D12CommandList
+{
+public:
+
+	ID3D12GraphicsCommandList(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type);
+
+	HRESULT Close();
+	HRESULT Reset(ID3D12CommandAllocator* allocator, ID3D12PipelineState* initialState);
+
+	void ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers);
+	void CopyBufferRegion(ID3D12Resource* dest, UINT64 destOffset, ID3D12Resource* src, UINT64 srcOffset, UINT64 numBytes);
+	void CopyResource(ID3D12Resource* dest, ID3D12Resource* src);
+	void Dispatch(UINT numThreadGroupsX, UINT numThreadGroupsY, UINT numThreadGroupsZ);
+
+	void ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE view, const FLOAT color[4], UINT numRects, const D3D12_RECT* rects);
+	void ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE view, D3D12_CLEAR_FLAGS flags, FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* rects);
+	void DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation);
+	void DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation);
+
+	void IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology);
+	void IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view);
+	void IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views);
+	void RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports);
+	void RSSetScissorRects(UINT numRects, const D3D12_RECT* rects);
+	void OMSetRenderTargets(UINT numRenderTargets, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargets, BOOL singleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil);
+
+	void SetPipelineState(ID3D12PipelineState* state);
+	void SetGraphicsRootSignature(ID3D12RootSignature* rootSignature);
+	void SetComputeRootSignature(ID3D12RootSignature* rootSignature);
+	void SetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps);
+	void SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT data, UINT destOffsetIn32BitValues);
+	void SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues, const void* data, UINT destOffsetIn32BitValues);
+	void SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+	void SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+	void SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor);
+};
+
+class ID3D12Fence : public ID3D12DeviceChild
+{
+private:
+
+	std::mutex m_mutex;
+	UINT64 m_completedValue;
+
+	struct PendingEvent
+	{
+		UINT64 Value;
+		HANDLE Event;
+	};
+	std::vector<PendingEvent> m_pendingEvents;
+
+public:
+
+	ID3D12Fence(ID3D12Device* device, UINT64 initialValue);
+
+	UINT64 GetCompletedValue();
+	HRESULT SetEventOnCompletion(UINT64 value, HANDLE event);
+	HRESULT Signal(UINT64 value);
+};
+
+// Executes lists by adding their commands to the statistics of the device.
+// There is no GPU to wait for, so fences are reached as they are signaled.
+class ID3D12CommandQueue : public ID3D12DeviceChild
+{
+private:
+
+	D3D12_COMMAND_QUEUE_DESC m_desc;
+
+public:
+
+	ID3D12CommandQueue(ID3D12Device* device, const D3D12_COMMAND_QUEUE_DESC& desc);
+
+	void ExecuteCommandLists(UINT numLists, ID3D12CommandList* const* lists);
+	HRESULT Signal(ID3D12Fence* fence, UINT64 value);
+	HRESULT Wait(ID3D12Fence* fence, UINT64 value);
+	D3D12_COMMAND_QUEUE_DESC GetDesc();
+};
+
+class ID3D12Debug : public IUnknown
+{
+public:
+
+	void EnableDebugLayer();
+};
+
+class ID3D12Device : public IUnknown
+{
+private:
+
+	mutable std::mutex m_mutex;
+	NullDeviceStatistics m_statistics;
+	D3D12_GPU_VIRTUAL_ADDRESS m_nextVirtualAddress;
+	UINT64 m_nextDescriptorAddress;
+
+	// Child objects report to the device
+	friend class ID3D12Resource;
+	friend class ID3D12Heap;
+	friend class ID3D12DescriptorHeap;
+	friend class ID3D12CommandAllocator;
+	friend class ID3D12CommandList;
+	friend class ID3D12CommandQueue;
+	friend class ID3D12Fence;
+	friend class IDXGISwapChain1;
+
+	template <typename Func>
+	void UpdateStatistics(Func func)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		func(m_statistics);
+	}
+
+public:
+
+	ID3D12Device();
+
+	HRESULT CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** commandQueue);
+	HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** commandAllocator);
+	HRESULT CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* allocator, ID3D12PipelineState* initialState, REFIID riid, void** commandList);
+	HRESULT CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** fence);
+
+	HRESULT CreateCommittedResource(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue, REFIID riid, void** resource);
+	void GetCopyableFootprints(const D3D12_RESOURCE_DESC* desc, UINT firstSubresource, UINT numSubresources, UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows, UINT64* rowSizesInBytes, UINT64* totalBytes);
+	D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC* resourceDescs);
+
+	HRESULT CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** heap);
+	HRESULT CreatePlacedResource(ID3D12Heap* heap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue, REFIID riid, void** resource);
+
+	HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* desc, REFIID riid, void** heap);
+	UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type);
+	void CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+	void CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+	void CreateUnorderedAccessView(ID3D12Resource* resource, ID3D12Resource* counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+	void CreateRenderTargetView(ID3D12Resource* resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+	void CreateDepthStencilView(ID3D12Resource* resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor);
+	void CopyDescriptorsSimple(UINT numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE destStart, D3D12_CPU_DESCRIPTOR_HANDLE srcStart, D3D12_DESCRIPTOR_HEAP_TYPE type);
+
+	HRESULT CreateRootSignature(UINT nodeMask, const void* blob, SIZE_T blobLength, REFIID riid, void** rootSignature);
+	HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState);
+
+	NullDeviceStatistics GetNullStatistics() const;
+};
+
+// ######################################################################### //
+// ############################ DXGI OBJECTS ############################### //
+// ######################################################################### //
+
+class IDXGIAdapter1 : public IUnknown
+{
+public:
+
+	HRESULT GetDesc1(DXGI_ADAPTER_DESC1* desc);
+};
+
+// Backbuffers are plain textures, presenting only flips between them
+class IDXGISwapChain1 : public IUnknown
+{
+private:
+
+	ID3D12Device* m_device;
+	std::vector<ID3D12Resource*> m_buffers;
+	UINT m_currentBuffer;
+
+public:
+
+	IDXGISwapChain1(ID3D12Device* device, const DXGI_SWAP_CHAIN_DESC1& desc);
+	~IDXGISwapChain1() override;
+
+	HRESULT GetBuffer(UINT buffer, REFIID riid, void** surface);
+	HRESULT Present(UINT syncInterval, UINT flags);
+	UINT GetCurrentBackBufferIndex();
+};
+
+class IDXGIFactory7 : public IUnknown
+{
+public:
+
+	HRESULT EnumAdapters1(UINT adapter, IDXGIAdapter1** adapterOut);
+
+	// The device has to be a command queue
+	HRESULT CreateSwapChainForHwnd(IUnknown* device, HWND window, const DXGI_SWAP_CHAIN_DESC1* desc, const void* fullscreenDesc, void* restrictToOutput, IDXGISwapChain1** swapChain);
+};
+
+// ######################################################################### //
+// ############################### FUNCTIONS ############################### //
+// ######################################################################### //
+
+// Holds the bytes of a "compiled" shader or a serialized root signature
+class ID3D10Blob : public IUnknown
+{
+private:
+
+	std::vector<BYTE> m_data;
+
+public:
+
+	ID3D10Blob(std::vector<BYTE> data);
+
+	void* GetBufferPointer();
+	SIZE_T GetBufferSize();
+};
+typedef ID3D10Blob ID3DBlob;
+
+struct D3D_SHADER_MACRO
+{
+	LPCSTR Name;
+	LPCSTR Definition;
+};
+class ID3DInclude;
+
+#define D3D_COMPILE_STANDARD_FILE_INCLUDE ((ID3DInclude*)(UINT_PTR)1)
+#define D3D_COMPILER_VERSION 0
+
+HRESULT D3D12CreateDevice(IUnknown* adapter, D3D_FEATURE_LEVEL minimumFeatureLevel, REFIID riid, void** device);
+HRESULT D3D12GetDebugInterface(REFIID riid, void** debug);
+HRESULT CreateDXGIFactory(REFIID riid, void** factory);
+HRESULT CreateDXGIFactory2(UINT flags, REFIID riid, void** factory);
+
+// Nothing is compiled. The blob holds the source so that reading the file
+// is part of the measured cost, and missing files still fail.
+HRESULT D3DCompileFromFile(LPCWSTR fileName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, LPCSTR entryPoint, LPCSTR target, UINT flags1, UINT flags2, ID3DBlob** code, ID3DBlob** errorMessages);
+HRESULT D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* rootSignature, D3D_ROOT_SIGNATURE_VERSION version, ID3DBlob** blob, ID3DBlob** errorBlob);
@@ -44,6 +44,11 @@ namespace env
 
 		DXGI_FORMAT GetDXGIFormat() const;
 
+		// One element per vertex attribute, using the element names as the
+		// semantics. The names are pointed to, so the layout has to outlive
+		// the descs.
+		void GetInputElements(std::vector<D3D12_INPUT_ELEMENT_DESC>& elements) const;
+
 		std::vector<BufferElement>::const_iterator begin() const { return m_elements.begin(); }
 		std::vector<BufferElement>::const_iterator end() const { return m_elements.end(); }
 
@@ -51,4 +56,7 @@ namespace env
 
 		void CalculateOffsetsAndStrides();
 	};
+
+	// Layout of VertexType, the input layout of the renderer's pipeline
+	BufferLayout GetVertexTypeLayout(UINT numVertices = 1);
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 #include "envision/envpch.h"
+#include "envision/core/BindlessIndexAllocator.h"
+#include "envision/core/DescriptorAllocator.h"
+#include "envision/core/GPUMemoryAllocator.h"
 #include "envision/graphics/Shader.h"
 #include "envision/resource/BufferLayout.h"
 
@@ -66,6 +69,10 @@ namespace env
 		std::string Name;
 		ID3D12Resource* Native = nullptr;
 		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COMMON;
+
+		// Small buffers share their native resource with others
+		GPUAllocation Memory;
+		D3D12_GPU_VIRTUAL_ADDRESS GetGPUAddress() { return Native->GetGPUVirtualAddress() + Memory.Offset; }
 	};
 
 	struct BufferArray : public Resource
@@ -75,9 +82,13 @@ namespace env
 			
 		BufferLayout Layout;
 
+		// Only set for arrays living in an upload heap, which stay mapped
+		void* MappedData = nullptr;
+
+		// CBV/SRV/UAV views are in the bindless heap of the ResourceManager
 		struct {
-			D3D12_CPU_DESCRIPTOR_HANDLE ShaderResource = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE UnorderedAccess = { 0 };
+			BindlessHandle ShaderResource;
+			BindlessHandle UnorderedAccess;
 		} Views;
 	};
 
@@ -89,10 +100,10 @@ namespace env
 		BufferLayout Layout;
 
 		struct {
-			D3D12_CPU_DESCRIPTOR_HANDLE Constant = { 0 };
+			BindlessHandle Constant;
 			D3D12_INDEX_BUFFER_VIEW Index = { 0 };
 			D3D12_VERTEX_BUFFER_VIEW Vertex = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE UnorderedAccess = { 0 };
+			BindlessHandle UnorderedAccess;
 		} Views;
 	};
 
@@ -107,11 +118,13 @@ namespace env
 		UINT64 ByteWidth;
 		DXGI_FORMAT Format;
 
+		// Render target and depth stencil views are from the RTV and DSV
+		// allocators of the ResourceManager
 		struct {
-			D3D12_CPU_DESCRIPTOR_HANDLE RenderTarget = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE ShaderResource = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE UnorderedAccess = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE DepthStencil = { 0 };
+			DescriptorAllocation RenderTarget;
+			BindlessHandle ShaderResource;
+			BindlessHandle UnorderedAccess;
+			DescriptorAllocation DepthStencil;
 		} Views;
 	};
 
@@ -128,7 +141,7 @@ namespace env
 		DXGI_FORMAT Format;
 
 		struct {
-			D3D12_CPU_DESCRIPTOR_HANDLE ShaderResource = { 0 };
+			BindlessHandle ShaderResource;
 		} Views;
 	};
 
@@ -149,7 +162,7 @@ namespace env
 
 		struct {
 			D3D12_CPU_DESCRIPTOR_HANDLE RenderTarget = { 0 };
-			D3D12_CPU_DESCRIPTOR_HANDLE ShaderResource = { 0 };
+			BindlessHandle ShaderResource;
 		} Views;
 
 		Window* AppWindow;
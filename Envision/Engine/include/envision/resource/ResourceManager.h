@@ -1,9 +1,14 @@
 #pragma once
 #include "envision/envpch.h"
 #include "envision/core/Window.h"
-#include "envision/core/IDGenerator.h"
+#include "envision/core/BindlessHeap.h"
 #include "envision/core/DescriptorAllocator.h"
 #include "envision/core/CommandList.h"
+#include "envision/core/DeferredReleaseQueue.h"
+#include "envision/core/GPUMemoryAllocator.h"
+#include "envision/core/RingAllocator.h"
+#include "envision/core/ShaderCache.h"
+#include "envision/core/SlotMap.h"
 #include "envision/graphics/Shader.h"
 #include "envision/graphics/RootSignature.h"
 #include "envision/resource/Resource.h"
@@ -15,30 +20,51 @@ namespace env
 	{
 	private:
 
-		IDGenerator& m_commonIDGenerator;
+		// Resource IDs are handles into these, tagged with the ResourceType
+		// of the map. The resources are kept as pointers, moving them around
+		// in the maps would invalidate every Resource* handed out.
+		SlotMap<BufferArray*> m_buffersArrays;
+		SlotMap<Buffer*> m_buffers;
+		SlotMap<Texture2D*> m_texture2Ds;
+		SlotMap<Texture2DArray*> m_texture2DArrays;
+		SlotMap<PipelineState*> m_pipelineStates;
+		SlotMap<WindowTarget*> m_targets;
 
-		std::unordered_map<ID, BufferArray*> m_buffersArrays;
-		std::unordered_map<ID, Buffer*> m_buffers;
-		std::unordered_map<ID, Texture2D*> m_texture2Ds;
-		std::unordered_map<ID, Texture2DArray*> m_texture2DArrays;
-		std::unordered_map<ID, PipelineState*> m_pipelineStates;
-		std::unordered_map<ID, WindowTarget*> m_targets;
+		// Heaps all created resources are placed in
+		GPUMemoryAllocator m_memory;
+
+		// All CBV/SRV/UAV views, each keeps its index for the lifetime of the view
+		static const UINT BINDLESS_HEAP_SIZE = 16384;
+		BindlessHeap m_bindlessHeap;
 
-		DescriptorAllocator m_CBVAllocator;
-		DescriptorAllocator m_SRVAllocator;
-		DescriptorAllocator m_UAVAllocator;
 		DescriptorAllocator m_SamplerAllocator;
 		DescriptorAllocator m_RTVAllocator;
 		DescriptorAllocator m_DSVAllocator;
 
-		DirectList* m_transitionList;
-		CopyList* m_copyList;
+		// Uploads are sub-allocated from one persistently mapped upload heap
+		// and recorded on a copy list. All copies recorded since the last
+		// flush are submitted together on the copy queue.
+		static const UINT64 UPLOAD_BUFFER_SIZE = 1000000000;
+		static const UINT64 UPLOAD_ALIGNMENT = 16;
 
 		Buffer m_uploadBuffer;
+		char* m_uploadBufferMapped;
+		RingAllocator m_uploadAllocator;
+
+		CopyList* m_uploadList; // Acquired while there are pending uploads
+		bool m_hasPendingUploads;
+
+		// Native resources replaced while the GPU might still use them
+		DeferredReleaseQueue m_deferredReleases;
+
+		// Compiled shaders, root signatures and pipeline blobs from earlier runs
+		static constexpr const char* SHADER_CACHE_DIRECTORY = "shadercache";
+		ShaderCache m_shaderCache;
+		float m_pipelineCreateTime; // Seconds in CreatePipelineState, all calls
 
 	public:
 
-		static ResourceManager* Initialize(IDGenerator& commonIDGenerator);
+		static ResourceManager* Initialize();
 		static ResourceManager* Get();
 		static void Finalize();
 
@@ -46,7 +72,7 @@ namespace env
 
 		static ResourceManager* s_instance;
 
-		ResourceManager(IDGenerator& commonIDGenerator);
+		ResourceManager();
 		~ResourceManager();
 	
 		ResourceManager(const ResourceManager& other) = delete;
@@ -57,21 +83,31 @@ namespace env
 		Resource* GetResourceNonConst(ID resourceID);
 		void AdjustViewportAndScissorRect(WindowTarget& target, const Window& window);
 
-		D3D12_CPU_DESCRIPTOR_HANDLE CreateCBV(Resource* resource);
-		D3D12_CPU_DESCRIPTOR_HANDLE CreateSRV(Resource* resource);
-		D3D12_CPU_DESCRIPTOR_HANDLE CreateUAV(Resource* resource);
+		BindlessHandle CreateCBV(Resource* resource);
+		BindlessHandle CreateSRV(Resource* resource);
+		BindlessHandle CreateUAV(Resource* resource);
 		D3D12_CPU_DESCRIPTOR_HANDLE CreateSampler(Resource* resource);
-		D3D12_CPU_DESCRIPTOR_HANDLE CreateRTV(Resource* resource);
-		D3D12_CPU_DESCRIPTOR_HANDLE CreateDSV(Resource* resource);
+		DescriptorAllocation CreateRTV(Resource* resource);
+		DescriptorAllocation CreateDSV(Resource* resource);
+
+		ID3D12Resource* CreateBufferNative(UINT64 width, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState, GPUAllocation& allocation);
+
+		// Placed at heapOffset in the heap, or by m_memory without a heap
+		ID AddTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType, ID3D12Heap* heap, UINT64 heapOffset);
+
+		CopyList* GetUploadList();
+		UINT64 AllocateUploadMemory(UINT64 numBytes);
 
 	public:
 
 		ID CreateBufferArray(const std::string& name, const BufferLayout& layout, BufferBindType bindType = BufferBindType::Unknown, void* initialData = nullptr);
+		ID CreateMappedBufferArray(const std::string& name, const BufferLayout& layout);
 		ID CreateBuffer(const std::string& name, const BufferLayout& layout, BufferBindType bindType = BufferBindType::Unknown, void* initialData = nullptr);
 		ID CreateTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType = TextureBindType::Unknown, void* initialData = nullptr);
 		ID CreateTexture2D(const std::string& name, TextureBindType bindType, ID3D12Resource* existingTexture);
+		ID CreatePlacedTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType, ID3D12Heap* heap, UINT64 heapOffset);
 		ID CreateTexture2DArray(const std::string& name, int numTextures, int width, int height, DXGI_FORMAT format, void* initialData = nullptr);
-		ID CreatePipelineState(const std::string& name, std::initializer_list<ShaderDesc> shaderDescs, bool useInputLayout, const RootSignature& rootSignature);
+		ID CreatePipelineState(const std::string& name, std::initializer_list<ShaderDesc> shaderDescs, const BufferLayout& vertexLayout, const RootSignature& rootSignature); // Empty vertex layout for no input layout
 		ID CreateWindowTarget(const std::string& name, Window* window, float startXFactor = 0.f, float startYFactor = 0.f, float widthFactor = 1.f, float heightFactor = 1.f);
 
 		BufferArray* GetBufferArray(ID resourceID);
@@ -82,6 +118,31 @@ namespace env
 		WindowTarget* GetTarget(ID resourceID);
 		Resource* GetResource(ID resourceID);
 
+		BindlessHeap& GetBindlessHeap();
+		GPUMemoryStatistics GetMemoryStatistics() const;
+		ShaderCache& GetShaderCache();
+		float GetPipelineCreateTime() const;
+
+		// Size and alignment of a texture created with these arguments, to
+		// place it in a heap of its own
+		D3D12_RESOURCE_ALLOCATION_INFO GetTexture2DAllocationInfo(int width, int height, DXGI_FORMAT format, TextureBindType bindType) const;
+
+		// The native texture and its views are released once the queues are
+		// done with the work executed so far
+		void ReleaseTexture2D(ID resourceID);
+		void ReleaseBuffer(ID resourceID);
+
+		// Recreates the buffer array with room for numElements, the content is not kept
+		void ResizeBufferArray(ID resourceID, UINT numElements);
+
 		void UploadBufferData(ID resourceID, void* data, UINT numBytes = 0, UINT destinationOffset = 0);
+
+		// Submits all uploads recorded since the last flush as one batch on the
+		// copy queue. The direct and present queues wait on the GPU for the
+		// batch to finish, the CPU does not wait.
+		UINT64 FlushUploads();
+
+		// Releases the replaced resources the GPU is done with, call once per frame
+		void ReleaseCompletedResources();
 	};
 }
\ No newline at end of file
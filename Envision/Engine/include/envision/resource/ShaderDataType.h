@@ -3,11 +3,15 @@
 
 namespace env
 {
+	// Vertices of every mesh drawn by the renderer, see GetVertexTypeLayout.
+	// Positions are relative to the bounds of their mesh, so the full range
+	// of the snorm values is used by every mesh and the renderer passes the
+	// bounds to the vertex shader to undo it.
 	struct VertexType
 	{
-		Float3 Position;
-		Float3 Normal;
-		Float2 Texcoord;
+		int16_t Position[4]; // Snorm16x4, center + value * extents of the mesh bounds, w is zero
+		int16_t Normal[2]; // Snorm16x2, octahedral
+		uint16_t Texcoord[2]; // Half2
 	};
 	using IndexType = UINT;
 
@@ -84,7 +88,18 @@ namespace env
 		Double3x4,
 		Double4x2,
 		Double4x3,
-		Double4x4
+		Double4x4,
+
+		// Packed, read as floats by the shaders
+		Half2,
+		Half4,
+		Snorm16x2,
+		Snorm16x4,
+		Unorm16x2,
+		Unorm16x4,
+		Snorm8x4,
+		Unorm8x4,
+		Unorm10x3_2, // R10G10B10A2
 	};
 
 	size_t GetShaderDataTypeSize(ShaderDataType type);
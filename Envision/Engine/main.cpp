@@ -2,6 +2,10 @@
 #include "envision/core/Application.h"
 #include "envision/core/Scene.h"
 #include "envision/core/Component.h"
+#include "envision/core/FrameCapture.h"
+#include "envision/core/JobSystem.h"
+#include "envision/core/RenderGraph.h"
+#include "envision/core/TransformSystem.h"
 
 #include "envision/resource/ResourceManager.h"
 #include "envision/graphics/AssetManager.h"
@@ -41,7 +45,11 @@ private:
 
 public:
 
-	SceneUpdateLayer() : env::System("TestLayer") {}
+	SceneUpdateLayer() : env::System("TestLayer")
+	{
+		DeclareReads<env::CameraControllerComponent, env::CameraComponent>();
+		DeclareWrites<env::TransformComponent>();
+	}
 	~SceneUpdateLayer() final = default;
 
 public:
@@ -153,7 +161,26 @@ class TestApplication : public env::Application
 	ID m_target;
 	ID m_mainCamera;
 
-	env::DirectList* m_presentList;
+	env::TransformSystem* m_transformSystem;
+
+	const char* SCENE_PATH = "assets/Polygon-City Megapolis.fbx";
+
+	float m_bvhBuildTime = 0.0f;
+	float m_bvhRefitTime = 0.0f;
+
+	// -frames N renders N frames unthrottled, prints averages and quits
+	int m_maxFrames = 0;
+	int m_numFrames = 0;
+	env::RendererStatistics m_statisticsSum;
+	env::Timepoint m_runStart;
+
+	// -replay N captures the first frame, replays it N times, prints the
+	// averages and quits
+	env::FrameCapture m_frameCapture;
+	bool m_captureRequested = false;
+	bool m_replayRequested = false;
+	int m_numReplays = 0;
+	env::FrameReplayStatistics m_replayStatistics;
 
 public:
 
@@ -165,7 +192,38 @@ public:
 		//GetActiveScene()->LoadScene("Helicopter", "assets/SM_helicopter_01.fbx");
 		//m_mesh = env::AssetManager::Get()->LoadMesh("City", "assets/city.fbx");
 
-		GetActiveScene()->LoadScene("City", "assets/Polygon-City Megapolis.fbx");
+		// -nocache always imports the scene with Assimp and compiles every
+		// shader, the shader cache is turned off by the Application
+		bool useSceneCache = true;
+		for (int i = 1; i < argc; i++) {
+			if (std::string(argv[i]) == "-nocache")
+				useSceneCache = false;
+			else if (std::string(argv[i]) == "-frames" && i + 1 < argc)
+				m_maxFrames = std::max(std::atoi(argv[++i]), 0);
+			else if (std::string(argv[i]) == "-replay" && i + 1 < argc)
+				m_numReplays = std::max(std::atoi(argv[++i]), 0);
+		}
+		m_captureRequested = m_numReplays > 0;
+
+		GetActiveScene()->LoadScene("City", SCENE_PATH, useSceneCache);
+
+		const env::SceneLoadStatistics& loadStatistics = GetActiveScene()->GetLoadStatistics();
+		std::cout << "Scene loaded " << (loadStatistics.FromCache ? "from cache" : "with Assimp")
+			<< " in " << (loadStatistics.ReadTime + loadStatistics.InstantiateTime) * 1000.f << " ms" << std::endl;
+
+		// The pipelines are created by the Renderer before the application starts
+		const env::ShaderCacheStatistics& shaderCacheStatistics = env::ResourceManager::Get()->GetShaderCache().GetStatistics();
+		std::cout << "Pipelines created in " << env::ResourceManager::Get()->GetPipelineCreateTime() * 1000.f << " ms, from cache:";
+		for (UINT i = 0; i < (UINT)env::ShaderCacheEntry::COUNT; i++) {
+			const env::ShaderCacheCounters& counters = shaderCacheStatistics.Entries[i];
+			std::cout << (i > 0 ? "," : "") << " " << env::GetShaderCacheEntryName((env::ShaderCacheEntry)i) << " "
+				<< counters.NumHits << " of " << counters.NumHits + counters.NumMisses;
+		}
+		std::cout << std::endl;
+
+		env::Timepoint bvhBuildStart = env::Time::Now();
+		GetActiveScene()->RebuildBVH();
+		m_bvhBuildTime = (env::Time::Now() - bvhBuildStart).InSeconds();
 		
 		m_window = new env::Window(1200, 800, "Envision", *this);
 
@@ -196,10 +254,11 @@ public:
 		cameraTransform.Transformation.RotatePitch(2.0f * 3.14f / 12.0f);
 		scene->SetComponent<env::TransformComponent>(m_mainCamera, cameraTransform);
 
+		// Pushed last so world matrices include this frame's changes
+		m_transformSystem = new env::TransformSystem();
 		PushSystem(new SceneUpdateLayer());
+		PushSystem(m_transformSystem);
 		PushWindow(m_window);
-
-		m_presentList = env::GPU::CreateDirectCommandList();
 	}
 
 	void OnUpdate(const env::Duration& delta) override
@@ -208,6 +267,20 @@ public:
 		static float deltaSum = 0.0f;
 		deltaSum += delta.InSeconds();
 
+		// Submits the scene repeatedly until at least this many instances are submitted
+		static const UINT STRESS_INSTANCE_COUNTS[] = { 0, 10000, 100000, 1000000 };
+		static int stressIndex = 0;
+
+		// 0: SubmitParallel, 1: instance stream, 2: sorted draw keys, 3: BVH frustum query
+		static int submitMode = 0;
+		static float bvhQueryTime = 0.0f;
+		static std::vector<uint64_t> bvhVisibleEntities;
+		static bool cullingEnabled = true;
+		static bool lodEnabled = true;
+		static float lodErrorThreshold = 1.f;
+		static int numSubmitThreads = (int)env::JobSystem::Get()->GetNumThreads();
+		static int numRecordThreads = (int)env::JobSystem::Get()->GetNumThreads();
+
 		static float FPS_time = 0.f;
 		static int FPS_numFrames = 0;
 		static float FPS_frameTime = 0.0f;
@@ -215,6 +288,10 @@ public:
 
 		FPS_time += delta.InSeconds();
 
+		// Measured runs are not throttled
+		if (m_maxFrames > 0)
+			deltaSum = std::max(deltaSum, TARGET_FRAME_TIME);
+
 		if (deltaSum >= TARGET_FRAME_TIME) {
 			deltaSum -= TARGET_FRAME_TIME;
 
@@ -224,29 +301,62 @@ public:
 			//env::Transform cameraTransform;
 			env::Transform objectTransform;
 
-			// Set target to state RENDER TARGET
-			env::WindowTarget* target = env::ResourceManager::Get()->GetTarget(m_target);
-			m_presentList->Reset();
-			m_presentList->TransitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
-			m_presentList->Close();
-			env::CommandQueue& presentQueue = env::GPU::GetPresentQueue();
-			presentQueue.QueueList(m_presentList);
-			presentQueue.Execute();
-			presentQueue.WaitForIdle();
-
-			env::Renderer::Get()->BeginFrame(cameraSettings, cameraTransform, m_target);
-
+			// Count pass, the serial submission needs the number of instances
+			// per mesh up front to write them directly into the instance buffer.
 			// <MeshID, count>
 			std::unordered_map<ID, int> instances;
-			scene->ForEach<env::RenderComponent, env::TransformComponent>([&](env::RenderComponent& render, env::TransformComponent& transform) {
-				env::Renderer::Get()->Submit(transform.Transformation, render.Mesh, render.Material);
-				
-				if (instances.count(render.Mesh) == 0)
-					instances[render.Mesh] = 1;
-				else
-					++instances[render.Mesh];
+			UINT numSceneInstances = 0;
+			scene->ForEach<env::RenderComponent, env::WorldTransformComponent>([&](env::RenderComponent& render, env::WorldTransformComponent& transform) {
+				++instances[render.Mesh];
+				++numSceneInstances;
 			});
 
+			// Every list reset from here until the frame is submitted is captured
+			const bool capturing = m_captureRequested;
+			if (capturing) {
+				m_frameCapture.Clear();
+				env::GPU::BeginCapture(&m_frameCapture);
+				m_captureRequested = false;
+			}
+
+			// Waits for the GPU only if it is more frames behind than the pipeline depth
+			env::Renderer::Get()->BeginFrame(cameraSettings, cameraTransform, m_target);
+
+			if (submitMode == 0) {
+				env::Renderer::Get()->SubmitParallel(*scene, (UINT)numSubmitThreads);
+			}
+			else if (submitMode == 3) {
+				env::Timepoint queryStart = env::Time::Now();
+				bvhVisibleEntities.clear();
+				scene->GetBVH().QueryFrustum(env::Renderer::Get()->GetCameraFrustum(), bvhVisibleEntities);
+				bvhQueryTime = (env::Time::Now() - queryStart).InSeconds();
+
+				for (uint64_t entity : bvhVisibleEntities) {
+					env::RenderComponent& render = scene->GetComponent<env::RenderComponent>((ID)entity);
+					env::WorldTransformComponent& transform = scene->GetComponent<env::WorldTransformComponent>((ID)entity);
+					env::Renderer::Get()->Submit(transform.Matrix, render.Mesh, render.Material);
+				}
+			}
+			else {
+				UINT numRepeats = 1;
+				UINT stressInstanceCount = STRESS_INSTANCE_COUNTS[stressIndex];
+				if (stressInstanceCount > 0 && numSceneInstances > 0)
+					numRepeats = (stressInstanceCount + numSceneInstances - 1) / numSceneInstances;
+
+				if (submitMode == 1) {
+					for (auto& instance : instances)
+						env::Renderer::Get()->ReserveInstances(instance.first, instance.second * numRepeats);
+
+					env::Renderer::Get()->BeginInstanceStream();
+				}
+
+				for (UINT i = 0; i < numRepeats; i++) {
+					scene->ForEach<env::RenderComponent, env::WorldTransformComponent>([&](env::RenderComponent& render, env::WorldTransformComponent& transform) {
+						env::Renderer::Get()->Submit(transform.Matrix, render.Mesh, render.Material);
+					});
+				}
+			}
+
 			env::Renderer::Get()->EndFrame();
 			
 			env::RendererGUI::Get()->BeginFrame(m_target);
@@ -276,17 +386,508 @@ public:
 			ImGui::Begin("Frame statistics (100 frames)");
 			ImGui::Text("Frametime: %.0f ms (%i FPS)", FPS_frameTime, FPS_fps);
 			ImGui::End();
+
+			const env::RendererStatistics& rendererStatistics = env::Renderer::Get()->GetStatistics();
+			ImGui::Begin("Renderer statistics");
+			ImGui::Combo("Submit mode", &submitMode, "Parallel\0" "Instance stream\0" "Draw keys\0" "Scene BVH\0");
+			if (submitMode == 0)
+				ImGui::SliderInt("Submit threads", &numSubmitThreads, 1, (int)env::JobSystem::Get()->GetNumThreads());
+			else if (submitMode != 3)
+				ImGui::Combo("Stress instances", &stressIndex, "Scene\0" "10k\0" "100k\0" "1M\0");
+			ImGui::Text("Instances: %u (capacity %u)", rendererStatistics.NumInstances, rendererStatistics.InstanceCapacity);
+			ImGui::Text("Draw calls: %u", rendererStatistics.NumDrawCalls);
+			ImGui::Text("Submit: %.2f ms (%.1f M instances/s)",
+				rendererStatistics.SubmitTime * 1000.f,
+				(rendererStatistics.SubmitTime > 0.f) ? rendererStatistics.NumInstances / rendererStatistics.SubmitTime / 1000000.f : 0.f);
+			ImGui::Text("Sort: %.2f ms", rendererStatistics.SortTime * 1000.f);
+			if (ImGui::SliderInt("Record threads", &numRecordThreads, 1, (int)env::JobSystem::Get()->GetNumThreads()))
+				env::Renderer::Get()->SetMaxRecordThreads((UINT)numRecordThreads);
+			ImGui::Text("Record: %.2f ms into %u lists", rendererStatistics.RecordTime * 1000.f, rendererStatistics.NumCommandLists);
+			if (ImGui::Checkbox("Frustum culling", &cullingEnabled))
+				env::Renderer::Get()->SetCullingEnabled(cullingEnabled);
+			ImGui::Text("Visible: %u, culled: %u (%.2f ms)",
+				rendererStatistics.NumVisible,
+				rendererStatistics.NumCulled,
+				rendererStatistics.CullTime * 1000.f);
+			if (rendererStatistics.NumRejected > 0)
+				ImGui::Text("Rejected submits: %u", rendererStatistics.NumRejected);
+			if (ImGui::Checkbox("Mesh LODs", &lodEnabled))
+				env::Renderer::Get()->SetLodEnabled(lodEnabled);
+			if (ImGui::SliderFloat("LOD error (pixels)", &lodErrorThreshold, 0.25f, 16.f, "%.2f"))
+				env::Renderer::Get()->SetLodErrorThreshold(lodErrorThreshold);
+			ImGui::Text("Triangles: %.2f M of %.2f M at full detail",
+				rendererStatistics.NumTriangles / 1000000.f,
+				rendererStatistics.NumFullDetailTriangles / 1000000.f);
+			ImGui::Text("Instances per LOD: %u, %u, %u, %u (%.2f ms)",
+				rendererStatistics.NumInstancesPerLod[0],
+				rendererStatistics.NumInstancesPerLod[1],
+				rendererStatistics.NumInstancesPerLod[2],
+				rendererStatistics.NumInstancesPerLod[3],
+				rendererStatistics.LodSelectTime * 1000.f);
+			const env::BindlessHeap& bindlessHeap = env::ResourceManager::Get()->GetBindlessHeap();
+			const env::BindlessIndexAllocator& bindlessIndices = bindlessHeap.GetIndices();
+			ImGui::Text("Bindless descriptors: %u of %u", bindlessIndices.GetNumAllocated(), bindlessIndices.GetCapacity());
+			if (bindlessHeap.GetNumFailedAllocations() > 0)
+				ImGui::Text("Failed bindless allocations: %u", bindlessHeap.GetNumFailedAllocations());
+			ImGui::End();
+
+			ImGui::Begin("Frame capture");
+			if (ImGui::Button("Capture frame"))
+				m_captureRequested = true;
+			if (!m_frameCapture.IsEmpty()) {
+				const env::CommandStreamStatistics captureStatistics = m_frameCapture.GetStatistics();
+				ImGui::Text("%zu lists in %zu submissions, %.1f kB",
+					m_frameCapture.GetNumStreams(),
+					m_frameCapture.GetNumSubmissions(),
+					captureStatistics.NumBytes / 1024.f);
+				ImGui::Text("Commands: %u, instances: %llu",
+					captureStatistics.GetNumCommands(),
+					captureStatistics.NumDrawnInstances);
+				for (UINT i = 0; i < (UINT)env::StreamCommand::COUNT; i++) {
+					if (captureStatistics.NumCommands[i] > 0)
+						ImGui::Text("  %s: %u", env::GetStreamCommandName((env::StreamCommand)i), captureStatistics.NumCommands[i]);
+				}
+				if (ImGui::Button("Replay x100"))
+					m_replayRequested = true;
+				ImGui::Text("Replay record: %.3f ms, execute: %.3f ms",
+					m_replayStatistics.RecordTime * 1000.f,
+					m_replayStatistics.ExecuteTime * 1000.f);
+			}
+			ImGui::End();
+
+			ImGui::Begin("Frame pipeline");
+			int pipelineDepth = (int)env::Renderer::Get()->GetFramePipelineDepth();
+			if (ImGui::SliderInt("Depth", &pipelineDepth, 1, (int)env::Renderer::GetMaxFramesInFlight()))
+				env::Renderer::Get()->SetFramePipelineDepth((UINT)pipelineDepth);
+			ImGui::Text("In flight: %u, waited: %.2f ms",
+				env::Renderer::Get()->GetNumFramesInFlight(),
+				rendererStatistics.FrameWaitTime * 1000.f);
+			ImGui::End();
+
+			ImGui::Begin("Scene loading");
+			const env::SceneLoadStatistics& loadStatistics = scene->GetLoadStatistics();
+			ImGui::Text("Loaded %s", loadStatistics.FromCache ? "from cache" : "with Assimp");
+			ImGui::Text("Read: %.1f ms, instantiate: %.1f ms", loadStatistics.ReadTime * 1000.f, loadStatistics.InstantiateTime * 1000.f);
+			if (!loadStatistics.FromCache)
+				ImGui::Text("Assimp: %.1f ms, convert: %.1f ms, LODs: %.1f ms",
+					loadStatistics.ImportTime * 1000.f,
+					loadStatistics.ConvertTime * 1000.f,
+					loadStatistics.SimplifyTime * 1000.f);
+
+			// Reads the scene both ways without creating anything
+			static float importTime = 0.0f;
+			static float cacheOpenTime = 0.0f;
+			static env::SceneLoadStatistics serialImport;
+			static env::SceneLoadStatistics parallelImport;
+			if (ImGui::Button("Compare import and cache")) {
+				env::CookedScene serialImported;
+				env::Scene::ImportScene(SCENE_PATH, serialImported, &serialImport, 1);
+
+				env::Timepoint importStart = env::Time::Now();
+				env::CookedScene imported;
+				env::Scene::ImportScene(SCENE_PATH, imported, &parallelImport);
+				importTime = (env::Time::Now() - importStart).InSeconds();
+
+				env::Timepoint cacheStart = env::Time::Now();
+				env::SceneCache cache;
+				if (cache.Open(SCENE_PATH)) {
+					// Touch every page so the mapping is actually read
+					const env::CookedSceneView& view = cache.GetView();
+					const char* bytes = (const char*)view.Vertices;
+					size_t numBytes = view.NumVertices * sizeof(env::VertexType);
+					volatile char sum = 0;
+					for (size_t i = 0; i < numBytes; i += 4096)
+						sum += bytes[i];
+				}
+				cacheOpenTime = (env::Time::Now() - cacheStart).InSeconds();
+			}
+			ImGui::Text("Assimp import: %.1f ms, cache: %.1f ms", importTime * 1000.f, cacheOpenTime * 1000.f);
+			ImGui::Text("Convert: %.1f ms serial, %.1f ms on %u threads",
+				serialImport.ConvertTime * 1000.f,
+				parallelImport.ConvertTime * 1000.f,
+				env::JobSystem::Get()->GetNumThreads());
+			ImGui::Text("LODs: %.1f ms serial, %.1f ms on %u threads",
+				serialImport.SimplifyTime * 1000.f,
+				parallelImport.SimplifyTime * 1000.f,
+				env::JobSystem::Get()->GetNumThreads());
+			ImGui::End();
+
+			ImGui::Begin("Vertex packing");
+
+			// Vertex memory of the scene, against the float layout of position,
+			// normal and texcoord it was packed from
+			static const size_t FLOAT_VERTEX_SIZE = sizeof(float) * 8;
+			static UINT sceneNumVertices = 0;
+			if (ImGui::Button("Count scene vertices")) {
+				env::SceneCache cache;
+				if (cache.Open(SCENE_PATH))
+					sceneNumVertices = cache.GetView().NumVertices;
+			}
+			ImGui::Text("Vertex: %zu bytes, float layout: %zu bytes", sizeof(env::VertexType), FLOAT_VERTEX_SIZE);
+			ImGui::Text("Scene vertices: %u, %.1f MB packed, %.1f MB as floats",
+				sceneNumVertices,
+				sceneNumVertices * sizeof(env::VertexType) / (1024.f * 1024.f),
+				sceneNumVertices * FLOAT_VERTEX_SIZE / (1024.f * 1024.f));
+			ImGui::End();
+
+			ImGui::Begin("Job system");
+			ImGui::Text("Threads: %u, jobs stolen: %llu",
+				env::JobSystem::Get()->GetNumThreads(),
+				(unsigned long long)env::JobSystem::Get()->GetNumStolen());
+			ImGui::End();
+
+			ImGui::Begin("Transforms");
+			ImGui::Text("Nodes: %u, updated: %u", m_transformSystem->GetNumNodes(), m_transformSystem->GetNumUpdated());
+			ImGui::Text("Update: %.3f ms", m_transformSystem->GetUpdateTime() * 1000.f);
+			ImGui::End();
+
+			ImGui::Begin("Descriptor allocator");
+
+			// Stresses a descriptor allocator of its own on the current device. The
+			// heaps are small, so the allocator has to grow past the first one.
+			// Tables are allocated and a random half freed each round, while a
+			// linear allocator hands out per frame tables from the same heaps.
+			static const UINT STRESS_HEAP_SIZE = 16384;
+			static const UINT STRESS_LINEAR_BLOCK_SIZE = 256;
+			static const int STRESS_BATCH_SIZE = 4096;
+			static const int STRESS_NUM_OPERATIONS = 1000000;
+			static float stressAllocateTime = 0.0f;
+			static float stressFreeTime = 0.0f;
+			static float stressLinearTime = 0.0f;
+			static int stressNumAllocations = 0;
+			static int stressNumFrees = 0;
+			static int stressNumLinear = 0;
+			static env::DescriptorAllocatorStatistics stressStatistics;
+			if (ImGui::Button("Stress 1M operations")) {
+				env::DescriptorAllocator allocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, STRESS_HEAP_SIZE, false);
+				env::LinearDescriptorAllocator linearAllocator(allocator, STRESS_LINEAR_BLOCK_SIZE);
+				std::vector<env::DescriptorAllocation> allocations;
+				allocations.reserve(STRESS_HEAP_SIZE);
+
+				uint32_t random = 12345;
+				auto nextRandom = [&random]() {
+					random ^= random << 13;
+					random ^= random >> 17;
+					random ^= random << 5;
+					return random;
+				};
+
+				stressAllocateTime = 0.0f;
+				stressFreeTime = 0.0f;
+				stressLinearTime = 0.0f;
+				stressNumAllocations = 0;
+				stressNumFrees = 0;
+				stressNumLinear = 0;
+				while (stressNumAllocations + stressNumFrees < STRESS_NUM_OPERATIONS) {
+					env::Timepoint allocateStart = env::Time::Now();
+					for (int i = 0; i < STRESS_BATCH_SIZE; i++) {
+						// Mostly small tables, some large ones
+						UINT size = (nextRandom() % 16 == 0) ? 1 + nextRandom() % 256 : 1 + nextRandom() % 8;
+						allocations.push_back(allocator.Allocate(size));
+					}
+					stressAllocateTime += (env::Time::Now() - allocateStart).InSeconds();
+					stressNumAllocations += STRESS_BATCH_SIZE;
+
+					env::Timepoint freeStart = env::Time::Now();
+					size_t numFrees = allocations.size() / 2;
+					for (size_t i = 0; i < numFrees; i++) {
+						size_t index = nextRandom() % allocations.size();
+						allocator.Free(allocations[index]);
+						allocations[index] = allocations.back();
+						allocations.pop_back();
+					}
+					stressFreeTime += (env::Time::Now() - freeStart).InSeconds();
+					stressNumFrees += (int)numFrees;
+
+					// One frame worth of tables, the blocks are kept for the next one
+					env::Timepoint linearStart = env::Time::Now();
+					for (int i = 0; i < STRESS_BATCH_SIZE; i++)
+						linearAllocator.Allocate(1 + nextRandom() % 8);
+					linearAllocator.Reset();
+					stressLinearTime += (env::Time::Now() - linearStart).InSeconds();
+					stressNumLinear += STRESS_BATCH_SIZE;
+				}
+
+				stressStatistics = allocator.GetStatistics();
+			}
+			ImGui::Text("Allocate: %.1f M/s, free: %.1f M/s, linear: %.1f M/s",
+				(stressAllocateTime > 0.f) ? stressNumAllocations / stressAllocateTime / 1000000.f : 0.f,
+				(stressFreeTime > 0.f) ? stressNumFrees / stressFreeTime / 1000000.f : 0.f,
+				(stressLinearTime > 0.f) ? stressNumLinear / stressLinearTime / 1000000.f : 0.f);
+			ImGui::Text("Used: %u of %u in %u ranges, %u heaps",
+				stressStatistics.NumAllocated,
+				stressStatistics.NumDescriptors,
+				stressStatistics.NumAllocations,
+				stressStatistics.NumHeaps);
+			ImGui::Text("Free ranges: %u, largest: %u of %u free",
+				stressStatistics.NumFreeRanges,
+				stressStatistics.LargestFreeRange,
+				stressStatistics.NumDescriptors - stressStatistics.NumAllocated);
+			ImGui::End();
+
+			ImGui::Begin("GPU memory");
+			const env::GPUMemoryStatistics memoryStatistics = env::ResourceManager::Get()->GetMemoryStatistics();
+			for (UINT i = 0; i < (UINT)env::GPUMemoryPool::COUNT; i++) {
+				const env::GPUMemoryPoolStatistics& pool = memoryStatistics.Pools[i];
+				ImGui::Text("%s: %u in %u blocks, %.1f of %.1f MB",
+					env::GetGPUMemoryPoolName((env::GPUMemoryPool)i),
+					pool.NumAllocations,
+					pool.NumBlocks,
+					pool.AllocatedBytes / (1024.f * 1024.f),
+					pool.BlockBytes / (1024.f * 1024.f));
+			}
+			ImGui::Text("Committed: %u, %.1f MB",
+				memoryStatistics.NumCommitted,
+				memoryStatistics.CommittedBytes / (1024.f * 1024.f));
+			ImGui::Text("Reserved: %.1f of %.1f MB",
+				memoryStatistics.GetReservedBytes() / (1024.f * 1024.f),
+				memoryStatistics.Budget / (1024.f * 1024.f));
+			ImGui::End();
+
+			ImGui::Begin("Shader cache");
+			env::ShaderCache& shaderCache = env::ResourceManager::Get()->GetShaderCache();
+			const env::ShaderCacheStatistics& shaderCacheStatistics = shaderCache.GetStatistics();
+			ImGui::Text("Reading %s", shaderCache.IsReadEnabled() ? "enabled" : "disabled (-nocache)");
+			ImGui::Text("Pipelines created in %.1f ms", env::ResourceManager::Get()->GetPipelineCreateTime() * 1000.f);
+			for (UINT i = 0; i < (UINT)env::ShaderCacheEntry::COUNT; i++) {
+				const env::ShaderCacheCounters& counters = shaderCacheStatistics.Entries[i];
+				ImGui::Text("%s: %u hits, %u misses (%u rejected)",
+					env::GetShaderCacheEntryName((env::ShaderCacheEntry)i),
+					counters.NumHits,
+					counters.NumMisses,
+					counters.NumRejected);
+			}
+			ImGui::Text("Written: %u, failed: %u", shaderCacheStatistics.NumWrites, shaderCacheStatistics.NumFailedWrites);
+			ImGui::End();
+
+			ImGui::Begin("Render graph");
+			const env::RenderGraphExecutor& renderGraph = env::Renderer::Get()->GetRenderGraph();
+			const env::RenderGraphStatistics& graphStatistics = renderGraph.GetGraph().GetStatistics();
+			ImGui::Text("Passes: %u, culled: %u", graphStatistics.NumPasses, graphStatistics.NumCulledPasses);
+			ImGui::Text("Transitions: %u, aliasing: %u, in %u batches",
+				graphStatistics.NumTransitions,
+				graphStatistics.NumAliasingBarriers,
+				graphStatistics.NumBarrierBatches);
+			ImGui::Text("Transient textures: %u, %.1f MB in a %.1f MB heap",
+				graphStatistics.NumTransientTextures,
+				graphStatistics.TransientBytes / (1024.f * 1024.f),
+				renderGraph.GetHeapSize() / (1024.f * 1024.f));
+			ImGui::Text("Compiled in %.3f ms", renderGraph.GetCompileTime() * 1000.f);
+			ImGui::End();
+
+			// Loads the helicopter next to the camera, the fallback cube is
+			// drawn in its place until it is ready
+			ImGui::Begin("Asset streaming");
+			env::AssetManager* assetManager = env::AssetManager::Get();
+			static int loadPriority = 0;
+			static ID lastLoadedMesh = ID_ERROR;
+			ImGui::SliderInt("Priority", &loadPriority, -10, 10);
+			if (ImGui::Button("Load helicopter")) {
+				lastLoadedMesh = assetManager->LoadMeshAsync("Helicopter", "assets/SM_helicopter_01.fbx", loadPriority);
+
+				ID entity = scene->CreateEntity("Helicopter");
+
+				env::TransformComponent transform;
+				transform.Transformation.SetPosition(scene->GetComponent<env::TransformComponent>(m_mainCamera).Transformation.GetPosition());
+				transform.Transformation.Scale(100.f);
+				scene->SetComponent<env::TransformComponent>(entity, transform);
+
+				env::RenderComponent render;
+				render.Mesh = lastLoadedMesh;
+				render.Material = assetManager->GetFallbackMaterial();
+				scene->SetComponent<env::RenderComponent>(entity, render);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Cancel"))
+				assetManager->CancelLoad(lastLoadedMesh);
+			if (lastLoadedMesh != ID_ERROR) {
+				const char* stateNames[] = { "Queued", "Loading", "Uploading", "Ready", "Failed", "Cancelled" };
+				ImGui::Text("Last load: %s", stateNames[(int)assetManager->GetLoadState(lastLoadedMesh)]);
+			}
+
+			int uploadBudget = (int)(assetManager->GetUploadBudget() / (1024 * 1024));
+			if (ImGui::SliderInt("Upload budget (MB per frame)", &uploadBudget, 1, 64))
+				assetManager->SetUploadBudget((UINT64)uploadBudget * 1024 * 1024);
+
+			const env::AssetLoadStatistics& assetLoadStatistics = assetManager->GetLoadStatistics();
+			ImGui::Text("Queued: %u, loading: %u, uploading: %u",
+				assetLoadStatistics.NumQueued,
+				assetLoadStatistics.NumLoading,
+				assetLoadStatistics.NumUploading);
+			ImGui::Text("Ready: %u, failed: %u, cancelled: %u",
+				assetLoadStatistics.NumReady,
+				assetLoadStatistics.NumFailed,
+				assetLoadStatistics.NumCancelled);
+			if (assetLoadStatistics.NumReady > 0) {
+				ImGui::Text("Latency: last %.1f ms, average %.1f ms, max %.1f ms",
+					assetLoadStatistics.LastLatency * 1000.f,
+					assetLoadStatistics.TotalLatency * 1000.f / assetLoadStatistics.NumReady,
+					assetLoadStatistics.MaxLatency * 1000.f);
+				ImGui::Text("Last import: %.1f ms on a loader thread", assetLoadStatistics.LastImportTime * 1000.f);
+			}
+			ImGui::Text("Update: %.3f ms, max %.3f ms, uploaded %.1f MB",
+				assetLoadStatistics.UpdateTime * 1000.f,
+				assetLoadStatistics.MaxUpdateTime * 1000.f,
+				assetLoadStatistics.UploadedBytes / (1024.f * 1024.f));
+			ImGui::End();
+
+			ImGui::Begin("Scene BVH");
+			const env::SceneBVH& bvh = scene->GetBVH();
+			ImGui::Text("Items: %zu, nodes: %zu, depth: %u", bvh.GetNumItems(), bvh.GetNumNodes(), bvh.GetDepth());
+			if (ImGui::Button("Rebuild")) {
+				env::Timepoint buildStart = env::Time::Now();
+				scene->RebuildBVH();
+				m_bvhBuildTime = (env::Time::Now() - buildStart).InSeconds();
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Refit all")) {
+				env::Timepoint refitStart = env::Time::Now();
+				scene->ForEach<env::RenderComponent>([&](entt::entity entity, env::RenderComponent& render) {
+					scene->UpdateBVH((ID)entity);
+				});
+				scene->RefitBVH();
+				m_bvhRefitTime = (env::Time::Now() - refitStart).InSeconds();
+			}
+			ImGui::Text("Build: %.2f ms, refit: %.2f ms", m_bvhBuildTime * 1000.f, m_bvhRefitTime * 1000.f);
+			ImGui::Text("Frustum query: %.3f ms (%zu entities)", bvhQueryTime * 1000.f, bvhVisibleEntities.size());
+
+			// Pick along the camera forward
+			Float3 rayOrigin = cameraTransform.GetPosition();
+			Float3 rayDirection = cameraTransform.GetForward();
+			uint64_t hitEntity = 0;
+			float hitDistance = 0.0f;
+			if (bvh.Raycast(&rayOrigin.x, &rayDirection.x, cameraSettings.DistanceFarPlane, hitEntity, hitDistance)) {
+				env::RenderComponent& render = scene->GetComponent<env::RenderComponent>((ID)hitEntity);
+				env::Mesh* mesh = env::AssetManager::Get()->GetMesh(render.Mesh);
+				ImGui::Text("Center of view: %s (%.0f units)", mesh->Name.c_str(), hitDistance);
+			}
+			else {
+				ImGui::Text("Center of view: nothing");
+			}
+			ImGui::End();
 			
+			// Leaves the target in PRESENT
 			env::RendererGUI::Get()->EndFrame();
 
-			// Set target to state PRESENT
-			m_presentList->Reset();
-			m_presentList->TransitionResource(target, D3D12_RESOURCE_STATE_PRESENT);
-			m_presentList->Close();
-			presentQueue.QueueList(m_presentList);
-			presentQueue.Execute();
-			presentQueue.WaitForIdle();
+			// Executes the whole frame, the CPU goes on with the next one
+			env::Renderer::Get()->SubmitFrame();
+
+			// Replays execute on the same queues, so not while a frame is queued
+			if (capturing) {
+				env::GPU::EndCapture();
+				if (m_numReplays > 0)
+					PrintReplayStatistics();
+			}
+			if (m_replayRequested) {
+				m_replayStatistics = ReplayCapture(100);
+				m_replayRequested = false;
+			}
+
+			if (m_maxFrames > 0)
+				AccumulateRunStatistics();
+		}
+	}
+
+	// Replays the captured frame and returns the average timings
+	env::FrameReplayStatistics ReplayCapture(int numReplays)
+	{
+		env::FrameReplayStatistics average;
+		for (int i = 0; i < numReplays; i++) {
+			env::FrameReplayStatistics statistics = m_frameCapture.Replay();
+			average.NumLists = statistics.NumLists;
+			average.RecordTime += statistics.RecordTime / (float)numReplays;
+			average.ExecuteTime += statistics.ExecuteTime / (float)numReplays;
+		}
+
+		env::GPU::GetCopyQueue().WaitForIdle();
+		env::GPU::GetPresentQueue().WaitForIdle();
+		return average;
+	}
+
+	void PrintReplayStatistics()
+	{
+		const env::CommandStreamStatistics captureStatistics = m_frameCapture.GetStatistics();
+		std::cout << "Captured frame: " << m_frameCapture.GetNumStreams() << " lists in "
+			<< m_frameCapture.GetNumSubmissions() << " submissions" << std::endl;
+		std::cout << "  Stream: " << captureStatistics.NumBytes << " bytes, "
+			<< captureStatistics.GetNumCommands() << " commands" << std::endl;
+		for (UINT i = 0; i < (UINT)env::StreamCommand::COUNT; i++) {
+			if (captureStatistics.NumCommands[i] > 0)
+				std::cout << "    " << env::GetStreamCommandName((env::StreamCommand)i) << ": " << captureStatistics.NumCommands[i] << std::endl;
+		}
+		std::cout << "  Drawn instances: " << captureStatistics.NumDrawnInstances
+			<< ", copied: " << captureStatistics.NumCopiedBytes << " bytes" << std::endl;
+
+		m_replayStatistics = ReplayCapture(m_numReplays);
+		std::cout << "Replayed " << m_numReplays << " times" << std::endl;
+		std::cout << "  Record: " << m_replayStatistics.RecordTime * 1000.f << " ms ("
+			<< captureStatistics.NumBytes / std::max(m_replayStatistics.RecordTime, 1e-9f) / (1024.f * 1024.f) << " MB/s)" << std::endl;
+		std::cout << "  Execute: " << m_replayStatistics.ExecuteTime * 1000.f << " ms" << std::endl;
+
+		Quit();
+	}
+
+	void AccumulateRunStatistics()
+	{
+		if (m_numFrames == 0)
+			m_runStart = env::Time::Now();
+
+		const env::RendererStatistics& statistics = env::Renderer::Get()->GetStatistics();
+		m_statisticsSum.NumInstances += statistics.NumInstances;
+		m_statisticsSum.NumDrawCalls += statistics.NumDrawCalls;
+		m_statisticsSum.NumCommandLists += statistics.NumCommandLists;
+		m_statisticsSum.SubmitTime += statistics.SubmitTime;
+		m_statisticsSum.SortTime += statistics.SortTime;
+		m_statisticsSum.CullTime += statistics.CullTime;
+		m_statisticsSum.LodSelectTime += statistics.LodSelectTime;
+		m_statisticsSum.NumTriangles += statistics.NumTriangles;
+		m_statisticsSum.NumFullDetailTriangles += statistics.NumFullDetailTriangles;
+		m_statisticsSum.RecordTime += statistics.RecordTime;
+		m_statisticsSum.FrameWaitTime += statistics.FrameWaitTime;
+
+		if (++m_numFrames < m_maxFrames)
+			return;
+
+		const float frames = (float)m_numFrames;
+		const float runTime = (env::Time::Now() - m_runStart).InSeconds();
+		std::cout << "Frames: " << m_numFrames << " in " << runTime << " s" << std::endl;
+		std::cout << "  Frame: " << runTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  Submit: " << m_statisticsSum.SubmitTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  Sort: " << m_statisticsSum.SortTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  Cull: " << m_statisticsSum.CullTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  LOD select: " << m_statisticsSum.LodSelectTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  Record: " << m_statisticsSum.RecordTime / frames * 1000.f << " ms into "
+			<< m_statisticsSum.NumCommandLists / frames << " lists" << std::endl;
+		std::cout << "  Frame wait: " << m_statisticsSum.FrameWaitTime / frames * 1000.f << " ms" << std::endl;
+		std::cout << "  Instances: " << m_statisticsSum.NumInstances / frames
+			<< ", draw calls: " << m_statisticsSum.NumDrawCalls / frames << std::endl;
+		std::cout << "  Triangles: " << m_statisticsSum.NumTriangles / frames
+			<< " of " << m_statisticsSum.NumFullDetailTriangles / frames << " at full detail" << std::endl;
+
+		const env::GPUMemoryStatistics memoryStatistics = env::ResourceManager::Get()->GetMemoryStatistics();
+		std::cout << "GPU memory: " << memoryStatistics.GetReservedBytes() / (1024 * 1024) << " of "
+			<< memoryStatistics.Budget / (1024 * 1024) << " MB reserved" << std::endl;
+		for (UINT i = 0; i < (UINT)env::GPUMemoryPool::COUNT; i++) {
+			const env::GPUMemoryPoolStatistics& pool = memoryStatistics.Pools[i];
+			std::cout << "  " << env::GetGPUMemoryPoolName((env::GPUMemoryPool)i) << ": " << pool.NumAllocations
+				<< " in " << pool.NumBlocks << " blocks, " << pool.AllocatedBytes / 1024 << " of " << pool.BlockBytes / 1024 << " kB" << std::endl;
 		}
+		std::cout << "  Committed: " << memoryStatistics.NumCommitted << ", " << memoryStatistics.CommittedBytes / (1024 * 1024) << " MB" << std::endl;
+
+#ifdef PLATFORM_NULL
+		const NullDeviceStatistics deviceStatistics = env::GPU::GetDevice()->GetNullStatistics();
+		std::cout << "Null device" << std::endl;
+		std::cout << "  Resources: " << deviceStatistics.NumResources << " (" << deviceStatistics.ResourceBytes / (1024 * 1024) << " MB)" << std::endl;
+		std::cout << "  Heaps: " << deviceStatistics.NumHeaps << " (" << deviceStatistics.HeapBytes / (1024 * 1024) << " MB)" << std::endl;
+		std::cout << "  Descriptors: " << deviceStatistics.NumDescriptors << " in " << deviceStatistics.NumDescriptorHeaps << " heaps" << std::endl;
+		std::cout << "  Executed lists: " << deviceStatistics.NumExecutedLists << " (" << deviceStatistics.NumExecutedLists / frames << " per frame)" << std::endl;
+		std::cout << "  Draws: " << deviceStatistics.ExecutedCommands.Draws / frames
+			<< ", barriers: " << deviceStatistics.ExecutedCommands.Barriers / frames
+			<< ", copied: " << deviceStatistics.ExecutedCommands.CopiedBytes / frames / 1024.f << " kB per frame" << std::endl;
+		std::cout << "  Commands: " << deviceStatistics.ExecutedCommands.GetTotal() / frames << " per frame" << std::endl;
+#endif
+
+		Quit();
 	}
 
 	~TestApplication() override = default;
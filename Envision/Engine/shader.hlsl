@@ -6,26 +6,19 @@
 ROOT SIGNATURE
 [i] TYPE		STAGE(S)	REGISTER	SPACE		COMMENT
 -------------------------------------------------------------------------------
-[0] CONSTANT	V|P			b0			0			InstanceOffset, 1 constant
-[1] TABLE		V|P									Instance buffer array
-[2] TABLE		P									Material buffer array
-[3] CBV			V|P			b1			0			Camera buffer
+[0] CONSTANT	V|P			b0			0			InstanceOffset, buffer indices and position box, 11 constants
+[1] TABLE		V|P										Bindless heap
+[2] CBV			V|P			b1			0			Camera buffer
 -------------------------------------------------------------------------------
 
 
 
-RANGES IN TABLE INDEX [1] (Instance buffer array)
+RANGES IN TABLE INDEX [1] (Bindless heap)
+Every range covers the whole heap, views are indexed by their bindless index
 [i] TYPE	NUM DESCS	BASE REG	SPACE	COMMENT
 -------------------------------------------------------------------------------
-[0] SRV		1			t0			0		
--------------------------------------------------------------------------------
-
-
-
-RANGES IN TABLE INDEX [2] (Material buffer array)
-[i] TYPE	NUM DESCS	BASE REG	SPACE	COMMENT
--------------------------------------------------------------------------------
-[0] SRV		1			t1			0
+[0] SRV		Unbounded	t0			1		Instance buffer arrays
+[1] SRV		Unbounded	t0			2		Material buffer arrays
 -------------------------------------------------------------------------------
 */
 
@@ -38,6 +31,10 @@ RANGES IN TABLE INDEX [2] (Material buffer array)
 cbuffer RootConstants : register(b0)
 {
 	unsigned int InstanceOffset;
+	unsigned int InstanceBufferIndex;
+	unsigned int MaterialBufferIndex;
+	float3 PositionCenter; // Box the mesh positions are quantized to
+	float3 PositionExtents;
 }
 
 cbuffer CameraBuffer : register(b1)
@@ -66,7 +63,7 @@ struct InstanceData
 	float4x4 WorldMatrix;
 };
 
-StructuredBuffer<InstanceData> InstanceBuffers : register (t0);
+StructuredBuffer<InstanceData> InstanceBuffers[] : register (t0, space1);
 
 
 
@@ -77,17 +74,17 @@ StructuredBuffer<InstanceData> InstanceBuffers : register (t0);
 struct MaterialData
 {
 	float3 AmbientFactor;
-	int AmbientMapIndex; // -1 if no map exist
+	int AmbientMapIndex; // Bindless index, -1 if no map exist
 	float3 DiffuseFactor;
-	int DiffuseMapIndex; // -1 if no map exist
+	int DiffuseMapIndex; // Bindless index, -1 if no map exist
 	float3 SpecularFactor;
-	int SpecularMapIndex; // -1 if no map exist
+	int SpecularMapIndex; // Bindless index, -1 if no map exist
 	float Shininess;
 	int MaterialID;
 	float2 Padding;
 };
 
-StructuredBuffer<MaterialData> MaterialBuffers : register (t1);
+StructuredBuffer<MaterialData> MaterialBuffers[] : register (t0, space2);
 
 
 
@@ -95,10 +92,12 @@ StructuredBuffer<MaterialData> MaterialBuffers : register (t1);
 // ##################### COMMON SHADER DATA STRUCTURES ##################### //
 // ######################################################################### //
 
+// Packed, see VertexType. Position is snorm16x4 in the position box, the
+// normal snorm16x2 octahedral and the texcoord half2.
 struct VS_IN
 {
-	float3 Position : POSITION;
-	float3 Normal : NORMAL;
+	float4 Position : POSITION;
+	float2 Normal : NORMAL;
 	float2 Texcoord : TEXCOORD;
 };
 
@@ -116,17 +115,27 @@ struct VS_OUT
 // ###################### VERTEX SHADER STAGE PROGRAM ###################### //
 // ######################################################################### //
 
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 normal = float3(encoded, 1.f - abs(encoded.x) - abs(encoded.y));
+	float fold = saturate(-normal.z);
+	normal.xy += (normal.xy >= 0.f) ? -fold : fold;
+	return normalize(normal);
+}
+
 VS_OUT VS_main(VS_IN input, uint instanceIndex : SV_InstanceID)
 {
 	VS_OUT output;
 	output.InstanceIndex = InstanceOffset + instanceIndex;
 
-	InstanceData instance = InstanceBuffers[output.InstanceIndex];
+	InstanceData instance = InstanceBuffers[InstanceBufferIndex][output.InstanceIndex];
+
+	float3 position = PositionCenter + input.Position.xyz * PositionExtents;
 
-	output.Position = float4(input.Position, 1.0f);
+	output.Position = float4(position, 1.0f);
 	output.Position = mul(output.Position, instance.WorldMatrix);
 	output.Position = mul(output.Position, Camera.ViewProjectionMatrix);
-	output.Normal = normalize(mul(float4(input.Normal, 0.f), instance.WorldMatrix));
+	output.Normal = normalize(mul(float4(DecodeOctahedral(input.Normal), 0.f), instance.WorldMatrix));
 	output.Texcoord = input.Texcoord;
 
 	return output;
@@ -140,8 +149,8 @@ VS_OUT VS_main(VS_IN input, uint instanceIndex : SV_InstanceID)
 
 float4 PS_main(VS_OUT input) : SV_TARGET
 {
-	InstanceData instance = InstanceBuffers[input.InstanceIndex];
-	MaterialData material = MaterialBuffers[instance.MaterialIndex];
+	InstanceData instance = InstanceBuffers[InstanceBufferIndex][input.InstanceIndex];
+	MaterialData material = MaterialBuffers[MaterialBufferIndex][instance.MaterialIndex];
 
 	float3 dirToSun = -1.f * normalize(float3(-1.0f, -2.f, 0.8f));
 
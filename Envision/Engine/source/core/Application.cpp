@@ -1,6 +1,7 @@
 #include "envision/envpch.h"
 #include "envision/core/Application.h"
 #include "envision/core/GPU.h"
+#include "envision/core/JobSystem.h"
 #include "envision/core/Time.h"
 #include "envision/graphics/AssetManager.h"
 #include "envision/graphics/Renderer.h"
@@ -11,8 +12,17 @@ env::Application::Application(int argc, char** argv, const std::string& name) :
 	m_name(name)
 {
 	GPU::Initialize();
-	ResourceManager::Initialize(m_IDGenerator);
+	JobSystem::Initialize();
+	ResourceManager::Initialize();
 	AssetManager::Initialize(m_IDGenerator);
+
+	// -nocache compiles every shader, the Renderer creates its pipelines
+	// right away so this can't wait for the application
+	for (int i = 1; i < argc; i++) {
+		if (std::string(argv[i]) == "-nocache")
+			ResourceManager::Get()->GetShaderCache().SetReadEnabled(false);
+	}
+
 	Renderer::Initialize(m_IDGenerator);
 	RendererGUI::Initialize(m_IDGenerator);
 
@@ -27,12 +37,15 @@ env::Application::~Application()
 		delete l;
 		l = nullptr;
 	}
+
+	JobSystem::Finalize();
 }
 
 void env::Application::PushSystem(System* layer)
 {
 	m_systemStack.push_back(layer);
 	m_systemStack.back()->OnAttach(*m_activeScene);
+	m_systemStagesDirty = true;
 }
 
 void env::Application::PushWindow(Window* window)
@@ -46,6 +59,11 @@ env::Scene* env::Application::GetActiveScene()
 	return m_activeScene;
 }
 
+void env::Application::Quit()
+{
+	m_running = false;
+}
+
 void env::Application::PublishEvent(Event& event)
 {
 	for (auto& l : m_systemStack)
@@ -58,10 +76,10 @@ void env::Application::PublishEvent(Event& event)
 
 void env::Application::Run()
 {
-	bool running = true;
+	m_running = true;
 	Timepoint past = Time::Now();
 
-	while (running)
+	while (m_running)
 	{
 		for (auto& w : m_windows)
 		{
@@ -73,13 +91,13 @@ void env::Application::Run()
 		Duration delta = now - past;
 		past = now;
 
+		// Loaded meshes are swapped in before anything looks at them
+		AssetManager::Get()->Update();
+
 		// Update application before its layers
 		this->OnUpdate(delta);
 
-		for (auto& l : m_systemStack)
-		{
-			l->OnUpdate(*m_activeScene, delta);
-		}
+		UpdateSystems(delta);
 
 		for (auto& w : m_windows)
 		{
@@ -87,3 +105,61 @@ void env::Application::Run()
 		}
 	}
 }
+
+void env::Application::BuildSystemStages()
+{
+	m_systemStages.clear();
+
+	// Each system goes into the stage after the last one holding a system
+	// it conflicts with
+	std::vector<size_t> systemStages(m_systemStack.size());
+	for (size_t i = 0; i < m_systemStack.size(); i++) {
+		size_t stage = 0;
+		for (size_t j = 0; j < i; j++) {
+			if (m_systemStack[i]->GetAccess().ConflictsWith(m_systemStack[j]->GetAccess()))
+				stage = std::max(stage, systemStages[j] + 1);
+		}
+
+		systemStages[i] = stage;
+		if (stage >= m_systemStages.size())
+			m_systemStages.resize(stage + 1);
+		m_systemStages[stage].push_back(m_systemStack[i]);
+	}
+
+	m_systemStagesDirty = false;
+}
+
+void env::Application::UpdateSystems(const Duration& delta)
+{
+	if (m_systemStagesDirty)
+		BuildSystemStages();
+
+	for (auto& stage : m_systemStages)
+	{
+		if (stage.size() == 1) {
+			UpdateSystem(*stage.front(), delta);
+			continue;
+		}
+
+		// Systems in a stage share the registry, none of them may create a pool
+		for (System* system : stage) {
+			for (auto createPool : system->GetAccess().CreatePools)
+				(m_activeScene->*createPool)();
+		}
+
+		std::vector<JobSystem::JobHandle> jobs;
+		for (System* system : stage) {
+			jobs.push_back(JobSystem::Get()->Schedule([this, system, &delta]() {
+				UpdateSystem(*system, delta);
+			}));
+		}
+		JobSystem::Get()->Wait(jobs);
+	}
+}
+
+void env::Application::UpdateSystem(System& system, const Duration& delta)
+{
+	const SystemAccess* previousAccess = Scene::SetSystemAccess(&system.GetAccess());
+	system.OnUpdate(*m_activeScene, delta);
+	Scene::SetSystemAccess(previousAccess);
+}
@@ -0,0 +1,87 @@
+#include "envision/envpch.h"
+#include "envision/core/BindlessHeap.h"
+#include "envision/core/GPU.h"
+
+env::BindlessHeap::BindlessHeap() :
+	m_heap(nullptr),
+	m_stride(0),
+	m_beginCPU({ 0 }),
+	m_beginGPU({ 0 }),
+	m_numFailedAllocations(0)
+{
+	//
+}
+
+env::BindlessHeap::BindlessHeap(UINT numDescriptors) : BindlessHeap()
+{
+	Initialize(numDescriptors);
+}
+
+env::BindlessHeap::~BindlessHeap()
+{
+	if (m_heap)
+		m_heap->Release();
+}
+
+void env::BindlessHeap::Initialize(UINT numDescriptors)
+{
+	assert(!m_heap);
+
+	m_stride = GPU::GetDevice()->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	D3D12_DESCRIPTOR_HEAP_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	desc.NumDescriptors = numDescriptors;
+	desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+
+	HRESULT hr = GPU::GetDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_heap));
+	ASSERT_HR(hr, "Could not create bindless descriptor heap");
+
+	m_beginCPU = m_heap->GetCPUDescriptorHandleForHeapStart();
+	m_beginGPU = m_heap->GetGPUDescriptorHandleForHeapStart();
+	m_indices.Initialize(numDescriptors);
+}
+
+env::BindlessHandle env::BindlessHeap::Allocate()
+{
+	BindlessHandle handle = m_indices.Allocate();
+	if (!handle.IsValid()) {
+		// Only the first failure is reported, the count is in the statistics
+		if (m_numFailedAllocations == 0)
+			OutputDebugStringA("BindlessHeap: Out of descriptors, increase the heap size\n");
+		m_numFailedAllocations++;
+	}
+	return handle;
+}
+
+void env::BindlessHeap::Free(BindlessHandle handle)
+{
+	m_indices.Free(handle);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE env::BindlessHeap::GetCPUHandle(BindlessHandle handle) const
+{
+	assert(m_indices.IsCurrent(handle));
+	return { m_beginCPU.ptr + (SIZE_T)m_stride * handle.Index };
+}
+
+ID3D12DescriptorHeap* env::BindlessHeap::GetHeap()
+{
+	return m_heap;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE env::BindlessHeap::GetTable() const
+{
+	return m_beginGPU;
+}
+
+const env::BindlessIndexAllocator& env::BindlessHeap::GetIndices() const
+{
+	return m_indices;
+}
+
+UINT env::BindlessHeap::GetNumFailedAllocations() const
+{
+	return m_numFailedAllocations;
+}
@@ -0,0 +1,85 @@
+#include "envision/core/BindlessIndexAllocator.h"
+#include <assert.h>
+
+env::BindlessIndexAllocator::BindlessIndexAllocator() :
+	m_capacity(0),
+	m_nextIndex(0),
+	m_numAllocated(0)
+{
+	//
+}
+
+env::BindlessIndexAllocator::BindlessIndexAllocator(uint32_t capacity) : BindlessIndexAllocator()
+{
+	Initialize(capacity);
+}
+
+void env::BindlessIndexAllocator::Initialize(uint32_t capacity)
+{
+	assert(capacity < BindlessHandle::INVALID_INDEX);
+
+	m_capacity = capacity;
+	m_nextIndex = 0;
+	m_numAllocated = 0;
+	m_generations.clear();
+	m_allocated.clear();
+	m_freeList.clear();
+}
+
+env::BindlessHandle env::BindlessIndexAllocator::Allocate()
+{
+	BindlessHandle handle;
+
+	if (!m_freeList.empty()) {
+		handle.Index = m_freeList.back();
+		m_freeList.pop_back();
+	}
+	else if (m_nextIndex < m_capacity) {
+		handle.Index = m_nextIndex++;
+		m_generations.push_back(0);
+		m_allocated.push_back(false);
+	}
+	else {
+		return handle;
+	}
+
+	assert(!m_allocated[handle.Index]);
+	m_allocated[handle.Index] = true;
+	handle.Generation = m_generations[handle.Index];
+	m_numAllocated++;
+
+	return handle;
+}
+
+void env::BindlessIndexAllocator::Free(BindlessHandle handle)
+{
+	// Also catches freeing the same handle twice
+	assert(IsCurrent(handle));
+
+	m_allocated[handle.Index] = false;
+	m_generations[handle.Index]++;
+	m_freeList.push_back(handle.Index);
+	m_numAllocated--;
+}
+
+bool env::BindlessIndexAllocator::IsCurrent(BindlessHandle handle) const
+{
+	return handle.Index < m_nextIndex &&
+		m_allocated[handle.Index] &&
+		m_generations[handle.Index] == handle.Generation;
+}
+
+uint32_t env::BindlessIndexAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
+uint32_t env::BindlessIndexAllocator::GetNumAllocated() const
+{
+	return m_numAllocated;
+}
+
+uint32_t env::BindlessIndexAllocator::GetHighWaterMark() const
+{
+	return m_nextIndex;
+}
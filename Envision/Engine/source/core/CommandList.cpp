@@ -1,8 +1,10 @@
 #include "envision/envpch.h"
 #include "envision/core/CommandList.h"
+#include "envision/core/GPU.h"
 
 env::CommandList::CommandList(D3D12_COMMAND_LIST_TYPE type) :
 	m_state(ListState::Unknown),
+	m_pooled(false),
 	m_type(type),
 	m_list(nullptr),
 	m_allocator(nullptr)
@@ -14,19 +16,22 @@ void env::CommandList::Initialize(ID3D12Device* device)
 {
 	HRESULT hr = S_OK;
 
-	hr = device->CreateCommandAllocator(m_type, IID_PPV_ARGS(&m_allocator));
-	ASSERT_HR(hr, "Could not create command allocator");
+	m_allocator = GPU::AcquireCommandAllocator(m_type);
 
 	hr = device->CreateCommandList(NULL, m_type, m_allocator, NULL, IID_PPV_ARGS(&m_list));
 	ASSERT_HR(hr, "Could not create command list");
 
 	m_state = ListState::Recording;
+	AttachCapture();
 }
 
 env::CommandList::~CommandList()
 {
 	m_list->Release();
-	m_allocator->Release();
+
+	// Not executed since the last reset, so the GPU can't be using it
+	if (m_allocator)
+		m_allocator->Release();
 }
 
 D3D12_COMMAND_LIST_TYPE env::CommandList::GetType()
@@ -36,12 +41,26 @@ D3D12_COMMAND_LIST_TYPE env::CommandList::GetType()
 
 void env::CommandList::Reset()
 {
-	m_allocator->Reset();
+	// The allocator is handed back to the GPU when the list is executed
+	if (m_allocator)
+		m_allocator->Reset();
+	else
+		m_allocator = GPU::AcquireCommandAllocator(m_type);
+
 	m_list->Reset(m_allocator, NULL);
 	m_state = ListState::Recording;
+	AttachCapture();
 	ResetInherited();
 }
 
+void env::CommandList::AttachCapture()
+{
+	if (GPU::GetCapture())
+		m_stream = std::make_shared<CommandStream>(m_type);
+	else
+		m_stream = nullptr;
+}
+
 void env::CommandList::Close()
 {
 	m_list->Close();
@@ -71,13 +90,27 @@ void env::CommandList::TransitionResource(Resource* resource, D3D12_RESOURCE_STA
 		barrier.Transition.StateAfter = newState;
 
 		m_list->ResourceBarrier(1, &barrier);
+		if (m_stream)
+			m_stream->RecordTransition(resource->Native, resource->State, newState);
 		resource->State = newState;
 	}
 }
 
+void env::CommandList::ResourceBarriers(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers)
+{
+	if (numBarriers == 0)
+		return;
+
+	m_list->ResourceBarrier(numBarriers, barriers);
+	if (m_stream)
+		m_stream->RecordBarriers(numBarriers, barriers);
+}
+
 void env::CommandList::SetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps)
 {
 	m_list->SetDescriptorHeaps(numHeaps, heaps);
+	if (m_stream)
+		m_stream->RecordSetDescriptorHeaps(numHeaps, heaps);
 }
 
 
@@ -108,11 +141,16 @@ void env::CopyList::CopyBufferRegion(Resource* dest, UINT64 destOffset, Resource
 		src->Native,
 		srcOffset,
 		numBytes);
+
+	if (m_stream)
+		m_stream->RecordCopyBufferRegion(dest->Native, destOffset, src->Native, srcOffset, numBytes);
 }
 
 void env::CopyList::CopyResource(Resource* dest, Resource* src)
 {
 	m_list->CopyResource(dest->Native, src->Native);
+	if (m_stream)
+		m_stream->RecordCopyResource(dest->Native, src->Native);
 }
 
 
@@ -139,6 +177,8 @@ env::ComputeList::~ComputeList()
 void env::ComputeList::Dispatch(UINT numThreadGroupsX, UINT numThreadGroupsY, UINT numThreadGroupsZ)
 {
 	m_list->Dispatch(numThreadGroupsX, numThreadGroupsY, numThreadGroupsZ);
+	if (m_stream)
+		m_stream->RecordDispatch(numThreadGroupsX, numThreadGroupsY, numThreadGroupsZ);
 }
 
 
@@ -169,11 +209,15 @@ void env::DirectList::ClearRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, floa
 {
 	const FLOAT clearColor[] = {red, green, blue, alpha};
 	m_list->ClearRenderTargetView(target, clearColor, 0, NULL);
+	if (m_stream)
+		m_stream->RecordClearRenderTarget(target, clearColor);
 }
 
 void env::DirectList::ClearRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, const Float4& color)
 {
 	m_list->ClearRenderTargetView(target, (const FLOAT*)&color, 0, NULL);
+	if (m_stream)
+		m_stream->RecordClearRenderTarget(target, (const FLOAT*)&color);
 }
 
 void env::DirectList::ClearDepthStencil(Texture2D* stencil, bool clearDepth, bool clearStencil, FLOAT depthValue, UINT8 stencilValue)
@@ -183,44 +227,62 @@ void env::DirectList::ClearDepthStencil(Texture2D* stencil, bool clearDepth, boo
 	UINT flags = 0;
 	if (clearDepth) flags |= (UINT)D3D12_CLEAR_FLAG_DEPTH;
 	if (clearStencil) flags |= (UINT)D3D12_CLEAR_FLAG_STENCIL;
-	m_list->ClearDepthStencilView(stencil->Views.DepthStencil, (D3D12_CLEAR_FLAGS)flags, depthValue, stencilValue, 0, nullptr);
+	m_list->ClearDepthStencilView(stencil->Views.DepthStencil.CPUHandle, (D3D12_CLEAR_FLAGS)flags, depthValue, stencilValue, 0, nullptr);
+	if (m_stream)
+		m_stream->RecordClearDepthStencil(stencil->Views.DepthStencil.CPUHandle, (D3D12_CLEAR_FLAGS)flags, depthValue, stencilValue);
 }
 
 void env::DirectList::Draw(UINT numVertices, UINT vertexOffset)
 {
 	m_list->DrawInstanced(numVertices, 1, vertexOffset, 0);
+	if (m_stream)
+		m_stream->RecordDrawInstanced(numVertices, 1, vertexOffset, 0);
 }
 
 void env::DirectList::DrawIndexed(UINT numIndices, UINT indexOffset, UINT vertexOffset)
 {
 	m_list->DrawIndexedInstanced(numIndices, 1, indexOffset, vertexOffset, 0);
+	if (m_stream)
+		m_stream->RecordDrawIndexedInstanced(numIndices, 1, indexOffset, vertexOffset, 0);
 }
 
 void env::DirectList::DrawInstanced(UINT numVertices, UINT numInstanes, UINT vertexOffset, UINT instanceOffset)
 {
 	m_list->DrawInstanced(numVertices, numInstanes, vertexOffset, instanceOffset);
+	if (m_stream)
+		m_stream->RecordDrawInstanced(numVertices, numInstanes, vertexOffset, instanceOffset);
 }
 
 void env::DirectList::DrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT indexOffset, INT vertexOffset, UINT instanceOffset)
 {
 	m_list->DrawIndexedInstanced(numIndices, numInstances, indexOffset, vertexOffset, instanceOffset);
+	if (m_stream)
+		m_stream->RecordDrawIndexedInstanced(numIndices, numInstances, indexOffset, vertexOffset, instanceOffset);
 }
 
 void env::DirectList::SetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
 {
 	m_list->IASetPrimitiveTopology(topology);
+	if (m_stream)
+		m_stream->RecordSetPrimitiveTopology(topology);
 }
 
 void env::DirectList::SetPipelineState(PipelineState* state)
 {
 	m_list->SetGraphicsRootSignature(state->RootSignature);
 	m_list->SetPipelineState(state->State);
+	if (m_stream)
+		m_stream->RecordSetPipelineState(state->RootSignature, state->State);
 }
 
 void env::DirectList::SetTarget(WindowTarget* target, Texture2D* depthStencil)
 {
 	m_list->RSSetViewports(1, &target->Viewport);
 	m_list->RSSetScissorRects(1, &target->ScissorRect);
+	if (m_stream) {
+		m_stream->RecordSetViewport(target->Viewport);
+		m_stream->RecordSetScissorRect(target->ScissorRect);
+	}
 
 	TransitionResource(target, D3D12_RESOURCE_STATE_RENDER_TARGET);
 
@@ -228,10 +290,12 @@ void env::DirectList::SetTarget(WindowTarget* target, Texture2D* depthStencil)
 
 	if (depthStencil) {
 		TransitionResource(depthStencil, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-		depthDescriptor = &depthStencil->Views.DepthStencil;
+		depthDescriptor = &depthStencil->Views.DepthStencil.CPUHandle;
 	}
 
 	m_list->OMSetRenderTargets(1, &target->Views.RenderTarget, FALSE, depthDescriptor);
+	if (m_stream)
+		m_stream->RecordSetRenderTarget(target->Views.RenderTarget, depthDescriptor);
 }
 
 void env::DirectList::SetIndexBuffer(Buffer* buffer)
@@ -242,6 +306,8 @@ void env::DirectList::SetIndexBuffer(Buffer* buffer)
 	if (m_state.IndexBuffer != buffer->Native) {
 		m_list->IASetIndexBuffer(&buffer->Views.Index);
 		m_state.IndexBuffer = buffer->Native;
+		if (m_stream)
+			m_stream->RecordSetIndexBuffer(buffer->Native, buffer->Views.Index);
 	}
 }
 
@@ -249,10 +315,33 @@ void env::DirectList::SetVertexBuffer(Buffer* buffer, UINT slot)
 {
 	assert(buffer->Views.Vertex.StrideInBytes > 0);
 	TransitionResource(buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
-	m_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); // Define this in vertex buffer
+	SetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); // Define this in vertex buffer
 
 	if (m_state.VertexBuffers[slot] != buffer->Native) {
 		m_list->IASetVertexBuffers(slot, 1, &buffer->Views.Vertex);
 		m_state.VertexBuffers[slot] = buffer->Native;
+		if (m_stream)
+			m_stream->RecordSetVertexBuffer(buffer->Native, slot, buffer->Views.Vertex);
 	}
 }
+
+void env::DirectList::SetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	m_list->SetGraphicsRootConstantBufferView(rootIndex, address);
+	if (m_stream)
+		m_stream->RecordSetRootConstantBufferView(rootIndex, address);
+}
+
+void env::DirectList::SetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+	m_list->SetGraphicsRootDescriptorTable(rootIndex, table);
+	if (m_stream)
+		m_stream->RecordSetRootDescriptorTable(rootIndex, table);
+}
+
+void env::DirectList::SetRoot32BitConstant(UINT rootIndex, UINT value, UINT offset)
+{
+	m_list->SetGraphicsRoot32BitConstant(rootIndex, value, offset);
+	if (m_stream)
+		m_stream->RecordSetRoot32BitConstant(rootIndex, value, offset);
+}
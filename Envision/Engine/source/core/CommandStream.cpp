@@ -0,0 +1,619 @@
+#include "envision/envpch.h"
+#include "envision/core/CommandStream.h"
+
+namespace
+{
+	class StreamReader
+	{
+	private:
+
+		const UINT8* m_position;
+		const UINT8* m_end;
+		const std::vector<IUnknown*>& m_objects;
+
+	public:
+
+		StreamReader(const std::vector<UINT8>& data, const std::vector<IUnknown*>& objects) :
+			m_position(data.data()),
+			m_end(data.data() + data.size()),
+			m_objects(objects)
+		{
+			//
+		}
+
+		bool IsEmpty() const
+		{
+			return m_position >= m_end;
+		}
+
+		UINT8 ReadByte()
+		{
+			assert(m_position < m_end);
+			return *m_position++;
+		}
+
+		UINT64 ReadUInt()
+		{
+			UINT64 value = 0;
+			int shift = 0;
+			UINT8 byte;
+			do {
+				byte = ReadByte();
+				value |= (UINT64)(byte & 0x7F) << shift;
+				shift += 7;
+			} while (byte & 0x80);
+			return value;
+		}
+
+		INT64 ReadInt()
+		{
+			// Zigzag, small negative values stay short
+			UINT64 value = ReadUInt();
+			return (INT64)(value >> 1) ^ -(INT64)(value & 1);
+		}
+
+		FLOAT ReadFloat()
+		{
+			assert(m_position + sizeof(FLOAT) <= m_end);
+			FLOAT value;
+			memcpy(&value, m_position, sizeof(FLOAT));
+			m_position += sizeof(FLOAT);
+			return value;
+		}
+
+		template <typename T>
+		T* ReadObject()
+		{
+			UINT64 index = ReadUInt();
+			assert(index < m_objects.size());
+			return static_cast<T*>(m_objects[index]);
+		}
+	};
+}
+
+const char* env::GetStreamCommandName(StreamCommand command)
+{
+	switch (command)
+	{
+	case StreamCommand::Transition: return "Transition";
+	case StreamCommand::SetDescriptorHeaps: return "SetDescriptorHeaps";
+	case StreamCommand::ClearRenderTarget: return "ClearRenderTarget";
+	case StreamCommand::ClearDepthStencil: return "ClearDepthStencil";
+	case StreamCommand::DrawInstanced: return "DrawInstanced";
+	case StreamCommand::DrawIndexedInstanced: return "DrawIndexedInstanced";
+	case StreamCommand::SetPrimitiveTopology: return "SetPrimitiveTopology";
+	case StreamCommand::SetPipelineState: return "SetPipelineState";
+	case StreamCommand::SetViewport: return "SetViewport";
+	case StreamCommand::SetScissorRect: return "SetScissorRect";
+	case StreamCommand::SetRenderTarget: return "SetRenderTarget";
+	case StreamCommand::SetIndexBuffer: return "SetIndexBuffer";
+	case StreamCommand::SetVertexBuffer: return "SetVertexBuffer";
+	case StreamCommand::SetRootConstantBufferView: return "SetRootConstantBufferView";
+	case StreamCommand::SetRootDescriptorTable: return "SetRootDescriptorTable";
+	case StreamCommand::SetRoot32BitConstant: return "SetRoot32BitConstant";
+	case StreamCommand::CopyBufferRegion: return "CopyBufferRegion";
+	case StreamCommand::CopyResource: return "CopyResource";
+	case StreamCommand::Dispatch: return "Dispatch";
+	case StreamCommand::Barriers: return "Barriers";
+	default: return "Unknown";
+	}
+}
+
+void env::CommandStreamStatistics::Add(const CommandStreamStatistics& other)
+{
+	for (UINT i = 0; i < (UINT)StreamCommand::COUNT; i++)
+		NumCommands[i] += other.NumCommands[i];
+
+	NumBytes += other.NumBytes;
+	NumCopiedBytes += other.NumCopiedBytes;
+	NumDrawnInstances += other.NumDrawnInstances;
+}
+
+UINT env::CommandStreamStatistics::GetNumCommands() const
+{
+	UINT numCommands = 0;
+	for (UINT i = 0; i < (UINT)StreamCommand::COUNT; i++)
+		numCommands += NumCommands[i];
+	return numCommands;
+}
+
+env::CommandStream::CommandStream(D3D12_COMMAND_LIST_TYPE type) :
+	m_type(type)
+{
+	//
+}
+
+env::CommandStream::~CommandStream()
+{
+	for (IUnknown* object : m_objects)
+		object->Release();
+}
+
+D3D12_COMMAND_LIST_TYPE env::CommandStream::GetType() const
+{
+	return m_type;
+}
+
+size_t env::CommandStream::GetNumBytes() const
+{
+	return m_data.size();
+}
+
+size_t env::CommandStream::GetNumObjects() const
+{
+	return m_objects.size();
+}
+
+void env::CommandStream::Replay(ID3D12GraphicsCommandList* list, CommandStreamStatistics* statistics) const
+{
+	StreamReader reader(m_data, m_objects);
+
+	if (statistics)
+		statistics->NumBytes += m_data.size();
+
+	while (!reader.IsEmpty()) {
+		StreamCommand command = (StreamCommand)reader.ReadByte();
+		assert(command < StreamCommand::COUNT);
+
+		if (statistics)
+			statistics->NumCommands[(UINT)command]++;
+
+		switch (command)
+		{
+		case StreamCommand::Transition:
+		{
+			D3D12_RESOURCE_BARRIER barrier;
+			ZeroMemory(&barrier, sizeof(barrier));
+			barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			barrier.Transition.pResource = reader.ReadObject<ID3D12Resource>();
+			barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+			barrier.Transition.StateBefore = (D3D12_RESOURCE_STATES)reader.ReadUInt();
+			barrier.Transition.StateAfter = (D3D12_RESOURCE_STATES)reader.ReadUInt();
+			if (list)
+				list->ResourceBarrier(1, &barrier);
+			break;
+		}
+		case StreamCommand::SetDescriptorHeaps:
+		{
+			ID3D12DescriptorHeap* heaps[2] = { nullptr };
+			UINT numHeaps = (UINT)reader.ReadUInt();
+			assert(numHeaps <= 2);
+			for (UINT i = 0; i < numHeaps; i++)
+				heaps[i] = reader.ReadObject<ID3D12DescriptorHeap>();
+			if (list)
+				list->SetDescriptorHeaps(numHeaps, heaps);
+			break;
+		}
+		case StreamCommand::ClearRenderTarget:
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE target = { (SIZE_T)reader.ReadUInt() };
+			FLOAT color[4];
+			for (int i = 0; i < 4; i++)
+				color[i] = reader.ReadFloat();
+			if (list)
+				list->ClearRenderTargetView(target, color, 0, nullptr);
+			break;
+		}
+		case StreamCommand::ClearDepthStencil:
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE target = { (SIZE_T)reader.ReadUInt() };
+			D3D12_CLEAR_FLAGS flags = (D3D12_CLEAR_FLAGS)reader.ReadUInt();
+			FLOAT depth = reader.ReadFloat();
+			UINT8 stencil = reader.ReadByte();
+			if (list)
+				list->ClearDepthStencilView(target, flags, depth, stencil, 0, nullptr);
+			break;
+		}
+		case StreamCommand::DrawInstanced:
+		{
+			UINT numVertices = (UINT)reader.ReadUInt();
+			UINT numInstances = (UINT)reader.ReadUInt();
+			UINT vertexOffset = (UINT)reader.ReadUInt();
+			UINT instanceOffset = (UINT)reader.ReadUInt();
+			if (list)
+				list->DrawInstanced(numVertices, numInstances, vertexOffset, instanceOffset);
+			if (statistics)
+				statistics->NumDrawnInstances += numInstances;
+			break;
+		}
+		case StreamCommand::DrawIndexedInstanced:
+		{
+			UINT numIndices = (UINT)reader.ReadUInt();
+			UINT numInstances = (UINT)reader.ReadUInt();
+			UINT indexOffset = (UINT)reader.ReadUInt();
+			INT vertexOffset = (INT)reader.ReadInt();
+			UINT instanceOffset = (UINT)reader.ReadUInt();
+			if (list)
+				list->DrawIndexedInstanced(numIndices, numInstances, indexOffset, vertexOffset, instanceOffset);
+			if (statistics)
+				statistics->NumDrawnInstances += numInstances;
+			break;
+		}
+		case StreamCommand::SetPrimitiveTopology:
+		{
+			D3D12_PRIMITIVE_TOPOLOGY topology = (D3D12_PRIMITIVE_TOPOLOGY)reader.ReadUInt();
+			if (list)
+				list->IASetPrimitiveTopology(topology);
+			break;
+		}
+		case StreamCommand::SetPipelineState:
+		{
+			ID3D12RootSignature* rootSignature = reader.ReadObject<ID3D12RootSignature>();
+			ID3D12PipelineState* state = reader.ReadObject<ID3D12PipelineState>();
+			if (list) {
+				list->SetGraphicsRootSignature(rootSignature);
+				list->SetPipelineState(state);
+			}
+			break;
+		}
+		case StreamCommand::SetViewport:
+		{
+			D3D12_VIEWPORT viewport;
+			viewport.TopLeftX = reader.ReadFloat();
+			viewport.TopLeftY = reader.ReadFloat();
+			viewport.Width = reader.ReadFloat();
+			viewport.Height = reader.ReadFloat();
+			viewport.MinDepth = reader.ReadFloat();
+			viewport.MaxDepth = reader.ReadFloat();
+			if (list)
+				list->RSSetViewports(1, &viewport);
+			break;
+		}
+		case StreamCommand::SetScissorRect:
+		{
+			D3D12_RECT rect;
+			rect.left = (LONG)reader.ReadInt();
+			rect.top = (LONG)reader.ReadInt();
+			rect.right = (LONG)reader.ReadInt();
+			rect.bottom = (LONG)reader.ReadInt();
+			if (list)
+				list->RSSetScissorRects(1, &rect);
+			break;
+		}
+		case StreamCommand::SetRenderTarget:
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE target = { (SIZE_T)reader.ReadUInt() };
+			D3D12_CPU_DESCRIPTOR_HANDLE depthStencil = { (SIZE_T)reader.ReadUInt() };
+			if (list)
+				list->OMSetRenderTargets(1, &target, FALSE, (depthStencil.ptr != 0) ? &depthStencil : nullptr);
+			break;
+		}
+		case StreamCommand::SetIndexBuffer:
+		{
+			reader.ReadObject<ID3D12Resource>();
+			D3D12_INDEX_BUFFER_VIEW view;
+			view.BufferLocation = reader.ReadUInt();
+			view.SizeInBytes = (UINT)reader.ReadUInt();
+			view.Format = (DXGI_FORMAT)reader.ReadUInt();
+			if (list)
+				list->IASetIndexBuffer(&view);
+			break;
+		}
+		case StreamCommand::SetVertexBuffer:
+		{
+			reader.ReadObject<ID3D12Resource>();
+			UINT slot = (UINT)reader.ReadUInt();
+			D3D12_VERTEX_BUFFER_VIEW view;
+			view.BufferLocation = reader.ReadUInt();
+			view.SizeInBytes = (UINT)reader.ReadUInt();
+			view.StrideInBytes = (UINT)reader.ReadUInt();
+			if (list)
+				list->IASetVertexBuffers(slot, 1, &view);
+			break;
+		}
+		case StreamCommand::SetRootConstantBufferView:
+		{
+			UINT rootIndex = (UINT)reader.ReadUInt();
+			D3D12_GPU_VIRTUAL_ADDRESS address = reader.ReadUInt();
+			if (list)
+				list->SetGraphicsRootConstantBufferView(rootIndex, address);
+			break;
+		}
+		case StreamCommand::SetRootDescriptorTable:
+		{
+			UINT rootIndex = (UINT)reader.ReadUInt();
+			D3D12_GPU_DESCRIPTOR_HANDLE table = { reader.ReadUInt() };
+			if (list)
+				list->SetGraphicsRootDescriptorTable(rootIndex, table);
+			break;
+		}
+		case StreamCommand::SetRoot32BitConstant:
+		{
+			UINT rootIndex = (UINT)reader.ReadUInt();
+			UINT value = (UINT)reader.ReadUInt();
+			UINT offset = (UINT)reader.ReadUInt();
+			if (list)
+				list->SetGraphicsRoot32BitConstant(rootIndex, value, offset);
+			break;
+		}
+		case StreamCommand::CopyBufferRegion:
+		{
+			ID3D12Resource* dest = reader.ReadObject<ID3D12Resource>();
+			UINT64 destOffset = reader.ReadUInt();
+			ID3D12Resource* src = reader.ReadObject<ID3D12Resource>();
+			UINT64 srcOffset = reader.ReadUInt();
+			UINT64 numBytes = reader.ReadUInt();
+			if (list)
+				list->CopyBufferRegion(dest, destOffset, src, srcOffset, numBytes);
+			if (statistics)
+				statistics->NumCopiedBytes += numBytes;
+			break;
+		}
+		case StreamCommand::CopyResource:
+		{
+			ID3D12Resource* dest = reader.ReadObject<ID3D12Resource>();
+			ID3D12Resource* src = reader.ReadObject<ID3D12Resource>();
+			if (list)
+				list->CopyResource(dest, src);
+			break;
+		}
+		case StreamCommand::Dispatch:
+		{
+			UINT x = (UINT)reader.ReadUInt();
+			UINT y = (UINT)reader.ReadUInt();
+			UINT z = (UINT)reader.ReadUInt();
+			if (list)
+				list->Dispatch(x, y, z);
+			break;
+		}
+		case StreamCommand::Barriers:
+		{
+			UINT numBarriers = (UINT)reader.ReadUInt();
+			std::vector<D3D12_RESOURCE_BARRIER> barriers(numBarriers);
+			for (D3D12_RESOURCE_BARRIER& barrier : barriers) {
+				ZeroMemory(&barrier, sizeof(barrier));
+				barrier.Type = (D3D12_RESOURCE_BARRIER_TYPE)reader.ReadUInt();
+
+				if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION) {
+					barrier.Transition.pResource = reader.ReadObject<ID3D12Resource>();
+					barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+					barrier.Transition.StateBefore = (D3D12_RESOURCE_STATES)reader.ReadUInt();
+					barrier.Transition.StateAfter = (D3D12_RESOURCE_STATES)reader.ReadUInt();
+				}
+				else {
+					assert(barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING);
+					if (reader.ReadByte())
+						barrier.Aliasing.pResourceBefore = reader.ReadObject<ID3D12Resource>();
+					barrier.Aliasing.pResourceAfter = reader.ReadObject<ID3D12Resource>();
+				}
+			}
+			if (list)
+				list->ResourceBarrier(numBarriers, barriers.data());
+			break;
+		}
+		default:
+			assert(false);
+			return;
+		}
+	}
+}
+
+void env::CommandStream::RecordTransition(ID3D12Resource* resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+{
+	WriteCommand(StreamCommand::Transition);
+	WriteObject(resource);
+	WriteUInt((UINT64)before);
+	WriteUInt((UINT64)after);
+}
+
+void env::CommandStream::RecordSetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps)
+{
+	// At most one CBV/SRV/UAV and one sampler heap can be set
+	assert(numHeaps <= 2);
+
+	WriteCommand(StreamCommand::SetDescriptorHeaps);
+	WriteUInt(numHeaps);
+	for (UINT i = 0; i < numHeaps; i++)
+		WriteObject(heaps[i]);
+}
+
+void env::CommandStream::RecordClearRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, const FLOAT color[4])
+{
+	WriteCommand(StreamCommand::ClearRenderTarget);
+	WriteUInt(target.ptr);
+	for (int i = 0; i < 4; i++)
+		WriteFloat(color[i]);
+}
+
+void env::CommandStream::RecordClearDepthStencil(D3D12_CPU_DESCRIPTOR_HANDLE target, D3D12_CLEAR_FLAGS flags, FLOAT depth, UINT8 stencil)
+{
+	WriteCommand(StreamCommand::ClearDepthStencil);
+	WriteUInt(target.ptr);
+	WriteUInt((UINT64)flags);
+	WriteFloat(depth);
+	m_data.push_back(stencil);
+}
+
+void env::CommandStream::RecordDrawInstanced(UINT numVertices, UINT numInstances, UINT vertexOffset, UINT instanceOffset)
+{
+	WriteCommand(StreamCommand::DrawInstanced);
+	WriteUInt(numVertices);
+	WriteUInt(numInstances);
+	WriteUInt(vertexOffset);
+	WriteUInt(instanceOffset);
+}
+
+void env::CommandStream::RecordDrawIndexedInstanced(UINT numIndices, UINT numInstances, UINT indexOffset, INT vertexOffset, UINT instanceOffset)
+{
+	WriteCommand(StreamCommand::DrawIndexedInstanced);
+	WriteUInt(numIndices);
+	WriteUInt(numInstances);
+	WriteUInt(indexOffset);
+	WriteInt(vertexOffset);
+	WriteUInt(instanceOffset);
+}
+
+void env::CommandStream::RecordSetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+	WriteCommand(StreamCommand::SetPrimitiveTopology);
+	WriteUInt((UINT64)topology);
+}
+
+void env::CommandStream::RecordSetPipelineState(ID3D12RootSignature* rootSignature, ID3D12PipelineState* state)
+{
+	WriteCommand(StreamCommand::SetPipelineState);
+	WriteObject(rootSignature);
+	WriteObject(state);
+}
+
+void env::CommandStream::RecordSetViewport(const D3D12_VIEWPORT& viewport)
+{
+	WriteCommand(StreamCommand::SetViewport);
+	WriteFloat(viewport.TopLeftX);
+	WriteFloat(viewport.TopLeftY);
+	WriteFloat(viewport.Width);
+	WriteFloat(viewport.Height);
+	WriteFloat(viewport.MinDepth);
+	WriteFloat(viewport.MaxDepth);
+}
+
+void env::CommandStream::RecordSetScissorRect(const D3D12_RECT& rect)
+{
+	WriteCommand(StreamCommand::SetScissorRect);
+	WriteInt(rect.left);
+	WriteInt(rect.top);
+	WriteInt(rect.right);
+	WriteInt(rect.bottom);
+}
+
+void env::CommandStream::RecordSetRenderTarget(D3D12_CPU_DESCRIPTOR_HANDLE target, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil)
+{
+	WriteCommand(StreamCommand::SetRenderTarget);
+	WriteUInt(target.ptr);
+	WriteUInt(depthStencil ? depthStencil->ptr : 0);
+}
+
+void env::CommandStream::RecordSetIndexBuffer(ID3D12Resource* buffer, const D3D12_INDEX_BUFFER_VIEW& view)
+{
+	// The buffer is only kept in the table, so it outlives the stream
+	WriteCommand(StreamCommand::SetIndexBuffer);
+	WriteObject(buffer);
+	WriteUInt(view.BufferLocation);
+	WriteUInt(view.SizeInBytes);
+	WriteUInt((UINT64)view.Format);
+}
+
+void env::CommandStream::RecordSetVertexBuffer(ID3D12Resource* buffer, UINT slot, const D3D12_VERTEX_BUFFER_VIEW& view)
+{
+	WriteCommand(StreamCommand::SetVertexBuffer);
+	WriteObject(buffer);
+	WriteUInt(slot);
+	WriteUInt(view.BufferLocation);
+	WriteUInt(view.SizeInBytes);
+	WriteUInt(view.StrideInBytes);
+}
+
+void env::CommandStream::RecordSetRootConstantBufferView(UINT rootIndex, D3D12_GPU_VIRTUAL_ADDRESS address)
+{
+	WriteCommand(StreamCommand::SetRootConstantBufferView);
+	WriteUInt(rootIndex);
+	WriteUInt(address);
+}
+
+void env::CommandStream::RecordSetRootDescriptorTable(UINT rootIndex, D3D12_GPU_DESCRIPTOR_HANDLE table)
+{
+	WriteCommand(StreamCommand::SetRootDescriptorTable);
+	WriteUInt(rootIndex);
+	WriteUInt(table.ptr);
+}
+
+void env::CommandStream::RecordSetRoot32BitConstant(UINT rootIndex, UINT value, UINT offset)
+{
+	WriteCommand(StreamCommand::SetRoot32BitConstant);
+	WriteUInt(rootIndex);
+	WriteUInt(value);
+	WriteUInt(offset);
+}
+
+void env::CommandStream::RecordCopyBufferRegion(ID3D12Resource* dest, UINT64 destOffset, ID3D12Resource* src, UINT64 srcOffset, UINT64 numBytes)
+{
+	WriteCommand(StreamCommand::CopyBufferRegion);
+	WriteObject(dest);
+	WriteUInt(destOffset);
+	WriteObject(src);
+	WriteUInt(srcOffset);
+	WriteUInt(numBytes);
+}
+
+void env::CommandStream::RecordCopyResource(ID3D12Resource* dest, ID3D12Resource* src)
+{
+	WriteCommand(StreamCommand::CopyResource);
+	WriteObject(dest);
+	WriteObject(src);
+}
+
+void env::CommandStream::RecordDispatch(UINT numThreadGroupsX, UINT numThreadGroupsY, UINT numThreadGroupsZ)
+{
+	WriteCommand(StreamCommand::Dispatch);
+	WriteUInt(numThreadGroupsX);
+	WriteUInt(numThreadGroupsY);
+	WriteUInt(numThreadGroupsZ);
+}
+
+void env::CommandStream::RecordBarriers(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers)
+{
+	WriteCommand(StreamCommand::Barriers);
+	WriteUInt(numBarriers);
+	for (UINT i = 0; i < numBarriers; i++) {
+		const D3D12_RESOURCE_BARRIER& barrier = barriers[i];
+		WriteUInt((UINT64)barrier.Type);
+
+		if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION) {
+			// Only whole resources are transitioned by the engine
+			assert(barrier.Transition.Subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+			WriteObject(barrier.Transition.pResource);
+			WriteUInt((UINT64)barrier.Transition.StateBefore);
+			WriteUInt((UINT64)barrier.Transition.StateAfter);
+		}
+		else {
+			// UAV barriers are not issued by the engine
+			assert(barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING);
+
+			// No resource before means any resource in the same memory
+			m_data.push_back(barrier.Aliasing.pResourceBefore ? 1 : 0);
+			if (barrier.Aliasing.pResourceBefore)
+				WriteObject(barrier.Aliasing.pResourceBefore);
+			WriteObject(barrier.Aliasing.pResourceAfter);
+		}
+	}
+}
+
+void env::CommandStream::WriteCommand(StreamCommand command)
+{
+	m_data.push_back((UINT8)command);
+}
+
+void env::CommandStream::WriteUInt(UINT64 value)
+{
+	while (value >= 0x80) {
+		m_data.push_back((UINT8)(value | 0x80));
+		value >>= 7;
+	}
+	m_data.push_back((UINT8)value);
+}
+
+void env::CommandStream::WriteInt(INT64 value)
+{
+	WriteUInt(((UINT64)value << 1) ^ (UINT64)(value >> 63));
+}
+
+void env::CommandStream::WriteFloat(FLOAT value)
+{
+	const UINT8* bytes = (const UINT8*)&value;
+	m_data.insert(m_data.end(), bytes, bytes + sizeof(FLOAT));
+}
+
+void env::CommandStream::WriteObject(IUnknown* object)
+{
+	auto it = m_objectIndices.find(object);
+	if (it != m_objectIndices.end()) {
+		WriteUInt(it->second);
+		return;
+	}
+
+	UINT index = (UINT)m_objects.size();
+	object->AddRef();
+	m_objects.push_back(object);
+	m_objectIndices[object] = index;
+	WriteUInt(index);
+}
@@ -0,0 +1,99 @@
+#include "envision/core/Culling.h"
+#include <cmath>
+#include <xmmintrin.h>
+
+env::Frustum env::Frustum::FromViewProjection(const float* matrix)
+{
+	// Column j of the matrix produces clip space component j
+	auto column = [&](int j, float* out) {
+		for (int i = 0; i < 4; i++)
+			out[i] = matrix[i * 4 + j];
+	};
+
+	float x[4], y[4], z[4], w[4];
+	column(0, x);
+	column(1, y);
+	column(2, z);
+	column(3, w);
+
+	Frustum frustum;
+	for (int i = 0; i < 4; i++) {
+		frustum.Planes[0][i] = w[i] + x[i];	// Left
+		frustum.Planes[1][i] = w[i] - x[i];	// Right
+		frustum.Planes[2][i] = w[i] + y[i];	// Bottom
+		frustum.Planes[3][i] = w[i] - y[i];	// Top
+		frustum.Planes[4][i] = z[i];		// Near
+		frustum.Planes[5][i] = w[i] - z[i];	// Far
+	}
+
+	for (auto& plane : frustum.Planes) {
+		float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0.0f) {
+			for (int i = 0; i < 4; i++)
+				plane[i] /= length;
+		}
+	}
+
+	return frustum;
+}
+
+bool env::IsSphereVisible(const Frustum& frustum, float centerX, float centerY, float centerZ, float radius)
+{
+	for (const auto& plane : frustum.Planes) {
+		float distance = plane[0] * centerX + plane[1] * centerY + plane[2] * centerZ + plane[3];
+		// Written so a NaN center or radius is culled, as in CullSpheres
+		if (!(distance >= -radius))
+			return false;
+	}
+	return true;
+}
+
+size_t env::CullSpheres(const Frustum& frustum,
+	const float* centersX,
+	const float* centersY,
+	const float* centersZ,
+	const float* radii,
+	size_t count,
+	uint8_t* visible)
+{
+	__m128 planes[6][4];
+	for (int p = 0; p < 6; p++) {
+		for (int i = 0; i < 4; i++)
+			planes[p][i] = _mm_set1_ps(frustum.Planes[p][i]);
+	}
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	size_t numVisible = 0;
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(centersX + i);
+		__m128 y = _mm_loadu_ps(centersY + i);
+		__m128 z = _mm_loadu_ps(centersZ + i);
+		__m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(radii + i), signMask);
+
+		__m128 inside = _mm_cmpeq_ps(x, x); // All bits set, unless x is NaN
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)),
+				_mm_add_ps(_mm_mul_ps(planes[p][2], z), planes[p][3]));
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		for (int k = 0; k < 4; k++) {
+			uint8_t isVisible = (uint8_t)((mask >> k) & 1);
+			visible[i + k] = isVisible;
+			numVisible += isVisible;
+		}
+	}
+
+	for (; i < count; i++) {
+		uint8_t isVisible = IsSphereVisible(frustum, centersX[i], centersY[i], centersZ[i], radii[i]) ? 1 : 0;
+		visible[i] = isVisible;
+		numVisible += isVisible;
+	}
+
+	return numVisible;
+}
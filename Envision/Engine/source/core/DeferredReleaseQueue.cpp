@@ -0,0 +1,45 @@
+#include "envision/core/DeferredReleaseQueue.h"
+#include <algorithm>
+
+void env::DeferredReleaseQueue::Push(std::initializer_list<FenceTimeline*> timelines, std::function<void()> release)
+{
+	Entry entry;
+	entry.Release = std::move(release);
+	for (FenceTimeline* timeline : timelines)
+		entry.Fences.push_back({ timeline, timeline->IncrementFence() });
+
+	m_entries.push_back(std::move(entry));
+}
+
+size_t env::DeferredReleaseQueue::Collect()
+{
+	auto isComplete = [](const Entry& entry) {
+		return std::all_of(entry.Fences.begin(), entry.Fences.end(), [](const Fence& fence) {
+			return fence.Value <= fence.Timeline->GetCompletedFenceValue();
+		});
+	};
+
+	// Completed entries are moved to the end and released from there, the
+	// pending ones keep their order
+	auto firstComplete = std::stable_partition(m_entries.begin(), m_entries.end(),
+		[&](const Entry& entry) { return !isComplete(entry); });
+
+	size_t numReleased = (size_t)(m_entries.end() - firstComplete);
+	for (auto it = firstComplete; it != m_entries.end(); ++it)
+		it->Release();
+	m_entries.erase(firstComplete, m_entries.end());
+
+	return numReleased;
+}
+
+void env::DeferredReleaseQueue::ReleaseAll()
+{
+	for (Entry& entry : m_entries)
+		entry.Release();
+	m_entries.clear();
+}
+
+size_t env::DeferredReleaseQueue::GetNumPending() const
+{
+	return m_entries.size();
+}
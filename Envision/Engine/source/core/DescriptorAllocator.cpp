@@ -5,89 +5,206 @@
 env::DescriptorAllocator::DescriptorAllocator() :
     m_type(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
     m_stride(0),
-    m_heap(nullptr),
-    m_beginCPU({ 0 }),
-    m_beginGPU({ 0 }),
-    m_nextIndex(0),
-    m_endIndex(0)
+    m_heapSize(0),
+    m_isShaderVisible(false)
 {
     //
 }
 
 env::DescriptorAllocator::DescriptorAllocator(D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptors, bool isShaderVisible) :
-    m_type(type),
-    m_nextIndex(0),
-    m_endIndex(numDescriptors)
+    DescriptorAllocator()
 {
     Initialize(type, numDescriptors, isShaderVisible);
 }
 
 env::DescriptorAllocator::~DescriptorAllocator()
 {
+    ReleaseHeaps();
 }
 
 void env::DescriptorAllocator::Initialize(D3D12_DESCRIPTOR_HEAP_TYPE type, UINT numDescriptors, bool isShaderVisible)
 {
+    assert(numDescriptors > 0);
+
+    ReleaseHeaps();
+
     m_type = type;
-    m_nextIndex = 0;
-    m_endIndex = numDescriptors;
+    m_heapSize = numDescriptors;
+    m_isShaderVisible = isShaderVisible;
     m_stride = GPU::GetDevice()->GetDescriptorHandleIncrementSize(m_type);
 
+    AddHeap(m_heapSize);
+}
+
+ID3D12DescriptorHeap* env::DescriptorAllocator::GetHeap(const DescriptorAllocation& allocation)
+{
+    assert(allocation.HeapIndex < m_heaps.size());
+    return m_heaps[allocation.HeapIndex]->Native;
+}
+
+UINT env::DescriptorAllocator::GetStride() const
+{
+    return m_stride;
+}
+
+env::DescriptorAllocation env::DescriptorAllocator::Allocate(UINT numDescriptors)
+{
+    assert(numDescriptors > 0);
+
+    DescriptorAllocation allocation;
+
+    // Earlier heaps first, so later heaps empty out when usage drops
+    for (UINT i = 0; i < (UINT)m_heaps.size() && !allocation.Range.IsValid(); i++) {
+        allocation.Range = m_heaps[i]->Ranges.Allocate(numDescriptors);
+        allocation.HeapIndex = i;
+    }
+
+    if (!allocation.Range.IsValid()) {
+        AddHeap(std::max(m_heapSize, numDescriptors));
+        allocation.HeapIndex = (UINT)m_heaps.size() - 1;
+        allocation.Range = m_heaps.back()->Ranges.Allocate(numDescriptors);
+        assert(allocation.Range.IsValid());
+    }
+
+    const Heap& heap = *m_heaps[allocation.HeapIndex];
+    allocation.CPUHandle = { heap.BeginCPU.ptr + (SIZE_T)m_stride * allocation.Range.Offset };
+    allocation.GPUHandle = { heap.BeginGPU.ptr + (UINT64)m_stride * allocation.Range.Offset };
+    allocation.NumDescriptors = numDescriptors;
+
+    return allocation;
+}
+
+void env::DescriptorAllocator::Free(const DescriptorAllocation& allocation)
+{
+    // Sub-ranges of a LinearDescriptorAllocator block are not freed one by one
+    assert(allocation.HeapIndex < m_heaps.size() && allocation.Range.IsValid());
+    m_heaps[allocation.HeapIndex]->Ranges.Free(allocation.Range);
+}
+
+void env::DescriptorAllocator::Clear()
+{
+    for (Heap* heap : m_heaps)
+        heap->Ranges.Clear();
+}
+
+env::DescriptorAllocatorStatistics env::DescriptorAllocator::GetStatistics() const
+{
+    DescriptorAllocatorStatistics statistics;
+    statistics.NumHeaps = (UINT)m_heaps.size();
+
+    for (const Heap* heap : m_heaps) {
+        statistics.NumDescriptors += heap->Ranges.GetCapacity();
+        statistics.NumAllocated += heap->Ranges.GetNumAllocated();
+        statistics.NumAllocations += heap->Ranges.GetNumAllocations();
+        statistics.NumFreeRanges += heap->Ranges.GetNumFreeRanges();
+        statistics.LargestFreeRange = std::max(statistics.LargestFreeRange, heap->Ranges.GetLargestFreeRange());
+    }
+
+    return statistics;
+}
+
+void env::DescriptorAllocator::AddHeap(UINT numDescriptors)
+{
     D3D12_DESCRIPTOR_HEAP_DESC desc;
     ZeroMemory(&desc, sizeof(desc));
     desc.Type = m_type;
     desc.NumDescriptors = numDescriptors;
-    desc.Flags = (isShaderVisible) ?
+    desc.Flags = (m_isShaderVisible) ?
         D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE :
         D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 
-    HRESULT hr = GPU::GetDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&m_heap));
+    Heap* heap = new Heap();
+
+    HRESULT hr = GPU::GetDevice()->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&heap->Native));
     ASSERT_HR(hr, "Could not create descriptor heap");
 
-    m_beginCPU = m_heap->GetCPUDescriptorHandleForHeapStart();
-    m_beginGPU = m_heap->GetGPUDescriptorHandleForHeapStart();
+    heap->BeginCPU = heap->Native->GetCPUDescriptorHandleForHeapStart();
+    heap->BeginGPU = (m_isShaderVisible) ?
+        heap->Native->GetGPUDescriptorHandleForHeapStart() :
+        D3D12_GPU_DESCRIPTOR_HANDLE{ 0 };
+    heap->Ranges.Initialize(numDescriptors);
+
+    m_heaps.push_back(heap);
 }
 
-ID3D12DescriptorHeap* env::DescriptorAllocator::GetHeap()
+void env::DescriptorAllocator::ReleaseHeaps()
 {
-    return m_heap;
+    for (Heap* heap : m_heaps) {
+        heap->Native->Release();
+        delete heap;
+    }
+    m_heaps.clear();
 }
 
-env::DescriptorAllocation env::DescriptorAllocator::Allocate(UINT numDescriptors)
+env::LinearDescriptorAllocator::LinearDescriptorAllocator() :
+    m_parent(nullptr),
+    m_blockSize(0),
+    m_currentBlock(0),
+    m_nextOffset(0)
+{
+    //
+}
+
+env::LinearDescriptorAllocator::LinearDescriptorAllocator(DescriptorAllocator& parent, UINT blockSize) :
+    LinearDescriptorAllocator()
 {
-    // TODO: smartify this allocator. It makes the boat float for now. :)
+    Initialize(parent, blockSize);
+}
 
-    DescriptorAllocation handle = { 0 };
+env::LinearDescriptorAllocator::~LinearDescriptorAllocator()
+{
+    Release();
+}
 
-    if (numDescriptors == 1 && m_freeList.size() > 0) {
-        UINT freeIndex = m_freeList.back();
-        m_freeList.pop_back();
+void env::LinearDescriptorAllocator::Initialize(DescriptorAllocator& parent, UINT blockSize)
+{
+    assert(blockSize > 0);
 
-        handle.CPUHandle = { m_beginCPU.ptr + m_stride * freeIndex };
-        handle.GPUHandle = { m_beginGPU.ptr + m_stride * freeIndex };
+    Release();
+    m_parent = &parent;
+    m_blockSize = blockSize;
+}
+
+env::DescriptorAllocation env::LinearDescriptorAllocator::Allocate(UINT numDescriptors)
+{
+    assert(m_parent && numDescriptors > 0);
 
-        return handle;
+    // Moves on to the next block that fits, blocks are only added at the end
+    while (m_currentBlock < m_blocks.size() &&
+        m_nextOffset + numDescriptors > m_blocks[m_currentBlock].NumDescriptors) {
+        m_currentBlock++;
+        m_nextOffset = 0;
     }
 
-    assert((m_nextIndex + numDescriptors) < m_endIndex); // TODO: Increase heap size
+    if (m_currentBlock == m_blocks.size()) {
+        m_blocks.push_back(m_parent->Allocate(std::max(m_blockSize, numDescriptors)));
+        m_nextOffset = 0;
+    }
+
+    const DescriptorAllocation& block = m_blocks[m_currentBlock];
+    UINT stride = m_parent->GetStride();
 
-    handle.CPUHandle = { m_beginCPU.ptr + m_stride * m_nextIndex };
-    handle.GPUHandle = { m_beginGPU.ptr + m_stride * m_nextIndex };
+    DescriptorAllocation allocation;
+    allocation.CPUHandle = { block.CPUHandle.ptr + (SIZE_T)stride * m_nextOffset };
+    allocation.GPUHandle = { block.GPUHandle.ptr + (UINT64)stride * m_nextOffset };
+    allocation.NumDescriptors = numDescriptors;
+    allocation.HeapIndex = block.HeapIndex;
 
-    m_nextIndex += numDescriptors;
+    m_nextOffset += numDescriptors;
 
-    return handle;
+    return allocation;
 }
 
-void env::DescriptorAllocator::Free(DescriptorAllocation handle)
+void env::LinearDescriptorAllocator::Reset()
 {
-    // TODO: Check if handle is actually allocated
-    UINT index = (UINT)((handle.CPUHandle.ptr - m_beginCPU.ptr) / m_stride);
-    m_freeList.push_back(index);
+    m_currentBlock = 0;
+    m_nextOffset = 0;
 }
 
-void env::DescriptorAllocator::Clear()
+void env::LinearDescriptorAllocator::Release()
 {
-    m_freeList.clear();
-    m_nextIndex = 0;
+    for (const DescriptorAllocation& block : m_blocks)
+        m_parent->Free(block);
+    m_blocks.clear();
+    Reset();
 }
@@ -0,0 +1,98 @@
+#include "envision/envpch.h"
+#include "envision/core/FrameCapture.h"
+#include "envision/core/GPU.h"
+#include "envision/core/Time.h"
+
+namespace
+{
+	env::CommandList* AcquireList(D3D12_COMMAND_LIST_TYPE type)
+	{
+		switch (type)
+		{
+		case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+			return env::GPU::AcquireComputeList();
+		case D3D12_COMMAND_LIST_TYPE_COPY:
+			return env::GPU::AcquireCopyList();
+		default:
+			return env::GPU::AcquireDirectList();
+		}
+	}
+}
+
+void env::FrameCapture::AddSubmission(CommandQueue* queue, std::vector<std::shared_ptr<CommandStream>>&& streams)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_submissions.push_back({ queue, std::move(streams) });
+}
+
+void env::FrameCapture::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_submissions.clear();
+}
+
+bool env::FrameCapture::IsEmpty()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_submissions.empty();
+}
+
+size_t env::FrameCapture::GetNumSubmissions()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_submissions.size();
+}
+
+size_t env::FrameCapture::GetNumStreams()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	size_t numStreams = 0;
+	for (const Submission& submission : m_submissions)
+		numStreams += submission.Streams.size();
+	return numStreams;
+}
+
+env::CommandStreamStatistics env::FrameCapture::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	CommandStreamStatistics statistics;
+	for (const Submission& submission : m_submissions) {
+		for (const std::shared_ptr<CommandStream>& stream : submission.Streams)
+			stream->Replay(nullptr, &statistics);
+	}
+	return statistics;
+}
+
+env::FrameReplayStatistics env::FrameCapture::Replay()
+{
+	assert(!GPU::GetCapture());
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	FrameReplayStatistics statistics;
+	CommandQueue* previousQueue = nullptr;
+	UINT64 previousFenceValue = 0;
+
+	for (const Submission& submission : m_submissions) {
+		Timepoint recordBegin = Time::Now();
+		for (const std::shared_ptr<CommandStream>& stream : submission.Streams) {
+			CommandList* list = AcquireList(stream->GetType());
+			stream->Replay(list->GetNative());
+			list->Close();
+			submission.Queue->QueueList(list);
+		}
+		statistics.RecordTime += (Time::Now() - recordBegin).InSeconds();
+		statistics.NumLists += (UINT)submission.Streams.size();
+
+		if (previousQueue && previousQueue != submission.Queue)
+			submission.Queue->WaitForQueue(previousQueue, previousFenceValue);
+
+		Timepoint executeBegin = Time::Now();
+		previousFenceValue = submission.Queue->Execute();
+		previousQueue = submission.Queue;
+		statistics.ExecuteTime += (Time::Now() - executeBegin).InSeconds();
+	}
+
+	return statistics;
+}
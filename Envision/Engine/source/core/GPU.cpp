@@ -28,7 +28,11 @@ env::GPU::GPU() : m_device(nullptr),
 	m_directQueue(D3D12_COMMAND_LIST_TYPE_DIRECT),
 	m_computeQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE),
 	m_copyQueue(D3D12_COMMAND_LIST_TYPE_COPY),
-	m_presentQueue(D3D12_COMMAND_LIST_TYPE_DIRECT)
+	m_presentQueue(D3D12_COMMAND_LIST_TYPE_DIRECT),
+	m_directListPool([]() { return CreateDirectCommandList(); }),
+	m_computeListPool([]() { return CreateComputeCommandList(); }),
+	m_copyListPool([]() { return CreateCopyCommandList(); }),
+	m_capture(nullptr)
 {
 	InitDevice();
 	m_directQueue.Initialize(m_device);
@@ -39,6 +43,20 @@ env::GPU::GPU() : m_device(nullptr),
 
 env::GPU::~GPU()
 {
+	m_presentQueue.WaitForIdle();
+	m_copyQueue.WaitForIdle();
+	m_computeQueue.WaitForIdle();
+	m_directQueue.WaitForIdle();
+
+	m_directListPool.Clear();
+	m_computeListPool.Clear();
+	m_copyListPool.Clear();
+
+	auto release = [](ID3D12CommandAllocator* allocator) { allocator->Release(); };
+	m_directAllocators.Clear(release);
+	m_computeAllocators.Clear(release);
+	m_copyAllocators.Clear(release);
+
 	m_device->Release();
 }
 
@@ -47,6 +65,11 @@ ID3D12Device* env::GPU::GetDevice()
 	return Get()->m_device;
 }
 
+size_t env::GPU::GetMaxVideoMemory()
+{
+	return Get()->m_maxVideoMemory;
+}
+
 env::CommandQueue& env::GPU::GetDirectQueue()
 {
 	return Get()->m_directQueue;
@@ -100,6 +123,102 @@ env::CopyList* env::GPU::CreateCopyCommandList(bool recordDirectly)
 	return list;
 }
 
+env::DirectList* env::GPU::AcquireDirectList()
+{
+	DirectList* list = Get()->m_directListPool.Acquire();
+	list->m_pooled = true;
+	list->Reset();
+	return list;
+}
+
+env::ComputeList* env::GPU::AcquireComputeList()
+{
+	ComputeList* list = Get()->m_computeListPool.Acquire();
+	list->m_pooled = true;
+	list->Reset();
+	return list;
+}
+
+env::CopyList* env::GPU::AcquireCopyList()
+{
+	CopyList* list = Get()->m_copyListPool.Acquire();
+	list->m_pooled = true;
+	list->Reset();
+	return list;
+}
+
+void env::GPU::ReleaseCommandList(CommandList* list)
+{
+	assert(list->m_pooled);
+
+	switch (list->GetType())
+	{
+	case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+		Get()->m_computeListPool.Release(static_cast<ComputeList*>(list));
+		break;
+	case D3D12_COMMAND_LIST_TYPE_COPY:
+		Get()->m_copyListPool.Release(static_cast<CopyList*>(list));
+		break;
+	default:
+		Get()->m_directListPool.Release(static_cast<DirectList*>(list));
+		break;
+	}
+}
+
+ID3D12CommandAllocator* env::GPU::AcquireCommandAllocator(D3D12_COMMAND_LIST_TYPE type)
+{
+	ID3D12CommandAllocator* allocator = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(Get()->m_allocatorMutex);
+		if (!Get()->GetAllocatorPool(type).Acquire(allocator))
+			allocator = nullptr;
+	}
+
+	if (allocator) {
+		allocator->Reset();
+		return allocator;
+	}
+
+	HRESULT hr = Get()->m_device->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator));
+	ASSERT_HR(hr, "Could not create command allocator");
+	return allocator;
+}
+
+void env::GPU::RetireCommandAllocator(D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* allocator, const FenceTimeline& timeline, UINT64 fenceValue)
+{
+	std::lock_guard<std::mutex> lock(Get()->m_allocatorMutex);
+	Get()->GetAllocatorPool(type).Retire(allocator, timeline, fenceValue);
+}
+
+void env::GPU::BeginCapture(FrameCapture* capture)
+{
+	assert(capture && !Get()->m_capture);
+	Get()->m_capture = capture;
+}
+
+void env::GPU::EndCapture()
+{
+	Get()->m_capture = nullptr;
+}
+
+env::FrameCapture* env::GPU::GetCapture()
+{
+	return Get()->m_capture;
+}
+
+env::FencedPool<ID3D12CommandAllocator*>& env::GPU::GetAllocatorPool(D3D12_COMMAND_LIST_TYPE type)
+{
+	switch (type)
+	{
+	case D3D12_COMMAND_LIST_TYPE_COMPUTE:
+		return m_computeAllocators;
+	case D3D12_COMMAND_LIST_TYPE_COPY:
+		return m_copyAllocators;
+	default:
+		return m_directAllocators;
+	}
+}
+
 void env::GPU::InitDevice()
 {
 	IDXGIFactory7* factory = nullptr;
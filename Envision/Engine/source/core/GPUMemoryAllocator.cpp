@@ -0,0 +1,161 @@
+#include "envision/envpch.h"
+#include "envision/core/GPUMemoryAllocator.h"
+#include "envision/core/GPU.h"
+
+namespace
+{
+	static_assert(env::GPUMemoryPools::PAGE_SIZE == D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, "Pages are placement aligned");
+	static_assert(env::GPUMemoryPools::SMALL_BUFFER_ALIGNMENT == D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, "Small buffers are constant buffer aligned");
+
+	D3D12_RESOURCE_DESC GetBufferDesc(UINT64 numBytes)
+	{
+		D3D12_RESOURCE_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Width = numBytes;
+		desc.Height = 1;
+		desc.DepthOrArraySize = 1;
+		desc.MipLevels = 1;
+		desc.Format = DXGI_FORMAT_UNKNOWN;
+		desc.SampleDesc.Count = 1;
+		desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		return desc;
+	}
+
+	D3D12_HEAP_FLAGS GetHeapFlags(env::GPUMemoryPool pool)
+	{
+		switch (pool)
+		{
+		case env::GPUMemoryPool::DefaultTextures: return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		case env::GPUMemoryPool::DefaultTargets: return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		default: return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		}
+	}
+}
+
+env::GPUMemoryAllocator::GPUMemoryAllocator() :
+	m_pools(*this)
+{
+	//
+}
+
+env::GPUMemoryAllocator::~GPUMemoryAllocator()
+{
+	// Placed resources hold a reference to their heap, so resources that
+	// are still alive keep their memory
+	for (std::vector<Block>& blocks : m_blocks) {
+		for (Block& block : blocks) {
+			if (block.Heap)
+				block.Heap->Release();
+			if (block.Buffer)
+				block.Buffer->Release();
+		}
+		blocks.clear();
+	}
+}
+
+ID3D12Resource* env::GPUMemoryAllocator::CreateResource(const D3D12_RESOURCE_DESC& desc,
+	D3D12_HEAP_TYPE heapType,
+	D3D12_RESOURCE_STATES initialState,
+	const D3D12_CLEAR_VALUE* clearValue,
+	GPUAllocation& allocation)
+{
+	ID3D12Resource* native = nullptr;
+	HRESULT hr = S_OK;
+
+	D3D12_RESOURCE_ALLOCATION_INFO info = GPU::GetDevice()->GetResourceAllocationInfo(0, 1, &desc);
+	allocation = m_pools.Allocate(GetPool(desc, heapType), info.SizeInBytes, info.Alignment);
+
+	if (allocation.Pool != GPUMemoryPool::Committed) {
+		const Block& block = m_blocks[(UINT)allocation.Pool][allocation.BlockIndex];
+
+		hr = GPU::GetDevice()->CreatePlacedResource(block.Heap,
+			(UINT64)allocation.Range.Offset * GPUMemoryPools::PAGE_SIZE,
+			&desc,
+			initialState,
+			clearValue,
+			IID_PPV_ARGS(&native));
+
+		ASSERT_HR(hr, "Could not create placed resource");
+		return native;
+	}
+
+	D3D12_HEAP_PROPERTIES heapProperties;
+	ZeroMemory(&heapProperties, sizeof(heapProperties));
+	heapProperties.Type = heapType;
+	heapProperties.CreationNodeMask = 1;
+	heapProperties.VisibleNodeMask = 1;
+
+	hr = GPU::GetDevice()->CreateCommittedResource(&heapProperties,
+		D3D12_HEAP_FLAG_NONE,
+		&desc,
+		initialState,
+		clearValue,
+		IID_PPV_ARGS(&native));
+
+	ASSERT_HR(hr, "Could not create committed resource");
+	return native;
+}
+
+ID3D12Resource* env::GPUMemoryAllocator::CreateSmallBuffer(UINT64 numBytes, GPUAllocation& allocation)
+{
+	allocation = m_pools.AllocateSmallBuffer(numBytes);
+
+	ID3D12Resource* buffer = m_blocks[(UINT)GPUMemoryPool::SmallBuffers][allocation.BlockIndex].Buffer;
+	buffer->AddRef();
+	return buffer;
+}
+
+void env::GPUMemoryAllocator::Free(const GPUAllocation& allocation)
+{
+	m_pools.Free(allocation);
+}
+
+env::GPUMemoryStatistics env::GPUMemoryAllocator::GetStatistics() const
+{
+	GPUMemoryStatistics statistics = m_pools.GetStatistics();
+	statistics.Budget = GPU::GetMaxVideoMemory();
+	return statistics;
+}
+
+env::GPUMemoryPool env::GPUMemoryAllocator::GetPool(const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType) const
+{
+	if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		return (heapType == D3D12_HEAP_TYPE_UPLOAD) ? GPUMemoryPool::UploadBuffers : GPUMemoryPool::DefaultBuffers;
+
+	assert(heapType == D3D12_HEAP_TYPE_DEFAULT); // Textures are uploaded through buffers
+
+	bool isTarget = (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0;
+	return isTarget ? GPUMemoryPool::DefaultTargets : GPUMemoryPool::DefaultTextures;
+}
+
+void env::GPUMemoryAllocator::CreateBlock(GPUMemoryPool pool, uint64_t numBytes)
+{
+	Block block;
+
+	if (pool == GPUMemoryPool::SmallBuffers) {
+		// A page of the buffer pool, small buffers are always in COMMON and
+		// are promoted to whatever state they are read in
+		block.Buffer = CreateResource(GetBufferDesc(numBytes),
+			D3D12_HEAP_TYPE_DEFAULT,
+			D3D12_RESOURCE_STATE_COMMON,
+			nullptr,
+			block.BufferAllocation);
+	}
+	else {
+		D3D12_HEAP_DESC desc;
+		ZeroMemory(&desc, sizeof(desc));
+		desc.SizeInBytes = numBytes;
+		desc.Properties.Type = (pool == GPUMemoryPool::UploadBuffers) ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+		desc.Properties.CreationNodeMask = 1;
+		desc.Properties.VisibleNodeMask = 1;
+		desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		desc.Flags = GetHeapFlags(pool);
+
+		HRESULT hr = GPU::GetDevice()->CreateHeap(&desc, IID_PPV_ARGS(&block.Heap));
+		ASSERT_HR(hr, "Could not create heap");
+	}
+
+	m_blocks[(UINT)pool].push_back(block);
+}
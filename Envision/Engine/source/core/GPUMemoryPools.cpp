@@ -0,0 +1,144 @@
+#include "envision/core/GPUMemoryPools.h"
+#include <assert.h>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+const char* env::GetGPUMemoryPoolName(GPUMemoryPool pool)
+{
+	switch (pool)
+	{
+	case GPUMemoryPool::DefaultBuffers: return "Buffers";
+	case GPUMemoryPool::DefaultTextures: return "Textures";
+	case GPUMemoryPool::DefaultTargets: return "Targets";
+	case GPUMemoryPool::UploadBuffers: return "Upload buffers";
+	case GPUMemoryPool::SmallBuffers: return "Small buffers";
+	case GPUMemoryPool::Committed: return "Committed";
+	default: return "Unknown";
+	}
+}
+
+uint64_t env::GPUMemoryStatistics::GetReservedBytes() const
+{
+	uint64_t numBytes = CommittedBytes;
+	for (uint32_t i = 0; i < (uint32_t)GPUMemoryPool::COUNT; i++) {
+		if ((GPUMemoryPool)i != GPUMemoryPool::SmallBuffers)
+			numBytes += Pools[i].BlockBytes;
+	}
+	return numBytes;
+}
+
+env::GPUMemoryPools::GPUMemoryPools(GPUMemoryBlockFactory& factory) :
+	m_factory(factory),
+	m_numCommitted(0),
+	m_committedBytes(0)
+{
+	for (Pool& pool : m_pools) {
+		pool.PageSize = PAGE_SIZE;
+		pool.BlockSize = BLOCK_SIZE;
+	}
+
+	// Each block of small buffers is a page of the buffer pool
+	Pool& smallBuffers = m_pools[(uint32_t)GPUMemoryPool::SmallBuffers];
+	smallBuffers.PageSize = SMALL_BUFFER_ALIGNMENT;
+	smallBuffers.BlockSize = PAGE_SIZE;
+}
+
+env::GPUAllocation env::GPUMemoryPools::Allocate(GPUMemoryPool pool, uint64_t numBytes, uint64_t alignment)
+{
+	assert(pool != GPUMemoryPool::SmallBuffers && pool != GPUMemoryPool::Committed);
+
+	bool isPlaced = alignment <= PAGE_SIZE && numBytes < BLOCK_SIZE / 2;
+	if (isPlaced)
+		return AllocatePages(pool, numBytes);
+
+	GPUAllocation allocation;
+	allocation.NumBytes = numBytes;
+	m_numCommitted++;
+	m_committedBytes += numBytes;
+	return allocation;
+}
+
+env::GPUAllocation env::GPUMemoryPools::AllocateSmallBuffer(uint64_t numBytes)
+{
+	assert(numBytes > 0 && numBytes <= SMALL_BUFFER_MAX_SIZE);
+
+	GPUAllocation allocation = AllocatePages(GPUMemoryPool::SmallBuffers, numBytes);
+	allocation.Offset = (uint64_t)allocation.Range.Offset * SMALL_BUFFER_ALIGNMENT;
+	return allocation;
+}
+
+void env::GPUMemoryPools::Free(const GPUAllocation& allocation)
+{
+	if (allocation.Pool == GPUMemoryPool::Committed) {
+		assert(m_numCommitted > 0 && m_committedBytes >= allocation.NumBytes);
+		m_numCommitted--;
+		m_committedBytes -= allocation.NumBytes;
+		return;
+	}
+
+	Pool& pool = m_pools[(uint32_t)allocation.Pool];
+	assert(allocation.BlockIndex < pool.Blocks.size());
+	pool.Blocks[allocation.BlockIndex]->Free(allocation.Range);
+}
+
+env::GPUMemoryStatistics env::GPUMemoryPools::GetStatistics() const
+{
+	GPUMemoryStatistics statistics;
+
+	for (uint32_t i = 0; i < (uint32_t)GPUMemoryPool::COUNT; i++) {
+		const Pool& pool = m_pools[i];
+		GPUMemoryPoolStatistics& poolStatistics = statistics.Pools[i];
+
+		for (const std::unique_ptr<RangeAllocator>& block : pool.Blocks) {
+			poolStatistics.NumBlocks++;
+			poolStatistics.BlockBytes += block->GetCapacity() * pool.PageSize;
+			poolStatistics.NumAllocations += block->GetNumAllocations();
+			poolStatistics.AllocatedBytes += block->GetNumAllocated() * pool.PageSize;
+		}
+	}
+
+	statistics.NumCommitted = m_numCommitted;
+	statistics.CommittedBytes = m_committedBytes;
+
+	return statistics;
+}
+
+uint32_t env::GPUMemoryPools::GetNumBlocks(GPUMemoryPool pool) const
+{
+	return (uint32_t)m_pools[(uint32_t)pool].Blocks.size();
+}
+
+env::GPUAllocation env::GPUMemoryPools::AllocatePages(GPUMemoryPool poolType, uint64_t numBytes)
+{
+	Pool& pool = m_pools[(uint32_t)poolType];
+	uint32_t numPages = (uint32_t)(AlignUp(numBytes, pool.PageSize) / pool.PageSize);
+
+	GPUAllocation allocation;
+	allocation.Pool = poolType;
+	allocation.NumBytes = (uint64_t)numPages * pool.PageSize;
+
+	for (uint32_t i = 0; i < (uint32_t)pool.Blocks.size(); i++) {
+		allocation.Range = pool.Blocks[i]->Allocate(numPages);
+		if (allocation.Range.IsValid()) {
+			allocation.BlockIndex = i;
+			return allocation;
+		}
+	}
+
+	// The native block is created first, creating the buffer of a small
+	// buffer block allocates from DefaultBuffers
+	m_factory.CreateBlock(poolType, pool.BlockSize);
+	pool.Blocks.push_back(std::make_unique<RangeAllocator>((uint32_t)(pool.BlockSize / pool.PageSize)));
+
+	allocation.BlockIndex = (uint32_t)pool.Blocks.size() - 1;
+	allocation.Range = pool.Blocks.back()->Allocate(numPages);
+	assert(allocation.Range.IsValid());
+
+	return allocation;
+}
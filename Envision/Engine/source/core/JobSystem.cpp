@@ -0,0 +1,254 @@
+#include "envision/core/JobSystem.h"
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+	const size_t NO_WORKER = ~size_t(0);
+
+	// Index of the worker owning the calling thread
+	thread_local size_t t_workerIndex = NO_WORKER;
+}
+
+env::JobSystem* env::JobSystem::s_instance = nullptr;
+
+env::JobSystem* env::JobSystem::Initialize(unsigned int numThreads)
+{
+	if (!s_instance)
+		s_instance = new JobSystem(numThreads);
+	return s_instance;
+}
+
+env::JobSystem* env::JobSystem::Get()
+{
+	assert(s_instance);
+	return s_instance;
+}
+
+void env::JobSystem::Finalize()
+{
+	delete s_instance;
+	s_instance = nullptr;
+}
+
+env::JobSystem::JobSystem(unsigned int numThreads) :
+	m_numQueued(0),
+	m_stop(false),
+	m_numStolen(0)
+{
+	if (numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	// The waiting thread is one of the threads
+	for (unsigned int i = 0; i < numThreads - 1; i++)
+		m_workers.push_back(std::make_unique<Worker>());
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+		m_threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+env::JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_wakeCondition.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+}
+
+void env::JobSystem::WorkerLoop(size_t workerIndex)
+{
+	t_workerIndex = workerIndex;
+
+	while (true) {
+		JobHandle job = Pop(workerIndex);
+		if (job) {
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeCondition.wait(lock, [&]() { return m_stop || m_numQueued > 0; });
+		if (m_stop)
+			return;
+	}
+}
+
+void env::JobSystem::Push(const JobHandle& job)
+{
+	Worker& queue = (t_workerIndex != NO_WORKER) ? *m_workers[t_workerIndex] : m_sharedQueue;
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(job);
+	}
+
+	// Counted after the job is visible, so a woken worker always finds it
+	m_numQueued++;
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeCondition.notify_one();
+}
+
+env::JobSystem::JobHandle env::JobSystem::Pop(size_t workerIndex)
+{
+	JobHandle job;
+
+	// Newest job of the own deque, it is the most likely to be in cache
+	if (workerIndex != NO_WORKER) {
+		Worker& own = *m_workers[workerIndex];
+		std::lock_guard<std::mutex> lock(own.Mutex);
+		if (!own.Jobs.empty()) {
+			job = std::move(own.Jobs.back());
+			own.Jobs.pop_back();
+		}
+	}
+
+	if (!job) {
+		std::lock_guard<std::mutex> lock(m_sharedQueue.Mutex);
+		if (!m_sharedQueue.Jobs.empty()) {
+			job = std::move(m_sharedQueue.Jobs.front());
+			m_sharedQueue.Jobs.pop_front();
+		}
+	}
+
+	// Oldest job of another worker, starting with the next one
+	const size_t numWorkers = m_workers.size();
+	const size_t firstVictim = (workerIndex != NO_WORKER) ? workerIndex + 1 : 0;
+	for (size_t i = 0; !job && i < numWorkers; i++) {
+		size_t victimIndex = (firstVictim + i) % numWorkers;
+		if (victimIndex == workerIndex)
+			continue;
+
+		Worker& victim = *m_workers[victimIndex];
+		std::lock_guard<std::mutex> lock(victim.Mutex);
+		if (!victim.Jobs.empty()) {
+			job = std::move(victim.Jobs.front());
+			victim.Jobs.pop_front();
+			m_numStolen++;
+		}
+	}
+
+	if (job)
+		m_numQueued--;
+
+	return job;
+}
+
+void env::JobSystem::Execute(const JobHandle& job)
+{
+	job->Function();
+
+	std::vector<JobHandle> continuations;
+	{
+		std::lock_guard<std::mutex> lock(job->Mutex);
+		job->Done = true;
+		continuations.swap(job->Continuations);
+	}
+
+	for (const JobHandle& continuation : continuations) {
+		if (continuation->NumPending.fetch_sub(1) == 1)
+			Push(continuation);
+	}
+}
+
+unsigned int env::JobSystem::GetNumThreads() const
+{
+	return (unsigned int)m_workers.size() + 1;
+}
+
+uint64_t env::JobSystem::GetNumStolen() const
+{
+	return m_numStolen;
+}
+
+env::JobSystem::JobHandle env::JobSystem::Schedule(std::function<void()> function, std::initializer_list<JobHandle> dependencies)
+{
+	return Schedule(std::move(function), std::vector<JobHandle>(dependencies));
+}
+
+env::JobSystem::JobHandle env::JobSystem::Schedule(std::function<void()> function, const std::vector<JobHandle>& dependencies)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->Function = std::move(function);
+	job->NumPending = (int)dependencies.size() + 1;
+	job->Done = false;
+
+	for (const JobHandle& dependency : dependencies) {
+		if (!dependency) {
+			job->NumPending--;
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(dependency->Mutex);
+		if (dependency->Done)
+			job->NumPending--;
+		else
+			dependency->Continuations.push_back(job);
+	}
+
+	if (job->NumPending.fetch_sub(1) == 1)
+		Push(job);
+
+	return job;
+}
+
+void env::JobSystem::Wait(const JobHandle& job)
+{
+	while (!job->Done) {
+		if (!RunOne())
+			std::this_thread::yield();
+	}
+}
+
+void env::JobSystem::Wait(const std::vector<JobHandle>& jobs)
+{
+	for (const JobHandle& job : jobs)
+		Wait(job);
+}
+
+bool env::JobSystem::RunOne()
+{
+	JobHandle job = Pop(t_workerIndex);
+	if (!job)
+		return false;
+
+	Execute(job);
+	return true;
+}
+
+void env::JobSystem::ParallelFor(size_t numTasks, const std::function<void(size_t)>& task, unsigned int maxThreads)
+{
+	if (numTasks == 0)
+		return;
+
+	size_t numRunners = std::min((size_t)GetNumThreads(), numTasks);
+	if (maxThreads > 0)
+		numRunners = std::min(numRunners, (size_t)maxThreads);
+
+	if (numRunners <= 1) {
+		for (size_t i = 0; i < numTasks; i++)
+			task(i);
+		return;
+	}
+
+	// Every runner takes the next index until there are none left. Runners
+	// that start late find nothing left and return right away.
+	std::atomic<size_t> nextTask(0);
+	auto run = [&]() {
+		size_t taskIndex;
+		while ((taskIndex = nextTask.fetch_add(1)) < numTasks)
+			task(taskIndex);
+	};
+
+	std::vector<JobHandle> runners;
+	runners.reserve(numRunners - 1);
+	for (size_t i = 0; i < numRunners - 1; i++)
+		runners.push_back(Schedule(run));
+
+	run();
+	Wait(runners);
+}
@@ -0,0 +1,139 @@
+#include "envision/envpch.h"
+#include "envision/core/MappedFile.h"
+
+#ifdef PLATFORM_NULL
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+env::MappedFile::MappedFile() :
+	m_file(-1),
+	m_data(nullptr),
+	m_size(0)
+{
+	//
+}
+#else
+env::MappedFile::MappedFile() :
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(NULL),
+	m_data(nullptr),
+	m_size(0)
+{
+	//
+}
+#endif
+
+env::MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef PLATFORM_NULL
+bool env::MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_file = open(filePath.c_str(), O_RDONLY);
+	if (m_file == -1)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(m_file, &fileStat) != 0 || fileStat.st_size == 0) {
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if (data == MAP_FAILED) {
+		Close();
+		return false;
+	}
+
+	// Read front to back, like FILE_FLAG_SEQUENTIAL_SCAN
+	madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+	m_data = data;
+	m_size = (size_t)fileStat.st_size;
+	return true;
+}
+
+void env::MappedFile::Close()
+{
+	if (m_data)
+		munmap((void*)m_data, m_size);
+	if (m_file != -1)
+		close(m_file);
+
+	m_file = -1;
+	m_data = nullptr;
+	m_size = 0;
+}
+#else
+bool env::MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_file = CreateFileA(filePath.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		NULL,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		NULL);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL) {
+		Close();
+		return false;
+	}
+
+	m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data) {
+		Close();
+		return false;
+	}
+
+	m_size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void env::MappedFile::Close()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	if (m_mapping != NULL)
+		CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+	m_data = nullptr;
+	m_size = 0;
+}
+#endif
+
+bool env::MappedFile::IsOpen() const
+{
+	return m_data != nullptr;
+}
+
+const void* env::MappedFile::GetData() const
+{
+	return m_data;
+}
+
+size_t env::MappedFile::GetSize() const
+{
+	return m_size;
+}
@@ -0,0 +1,469 @@
+#include "envision/core/MeshSimplifier.h"
+#include <algorithm>
+#include <assert.h>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+
+namespace
+{
+	struct Vector
+	{
+		double X, Y, Z;
+
+		Vector operator-(const Vector& other) const { return { X - other.X, Y - other.Y, Z - other.Z }; }
+		double Dot(const Vector& other) const { return X * other.X + Y * other.Y + Z * other.Z; }
+		Vector Cross(const Vector& other) const { return { Y * other.Z - Z * other.Y, Z * other.X - X * other.Z, X * other.Y - Y * other.X }; }
+		double Length() const { return std::sqrt(Dot(*this)); }
+	};
+
+	// Sum of squared distances to planes as a symmetric 4x4 matrix, and the
+	// area of the triangles whose planes were added
+	struct Quadric
+	{
+		double A00 = 0.0, A01 = 0.0, A02 = 0.0, A03 = 0.0;
+		double A11 = 0.0, A12 = 0.0, A13 = 0.0;
+		double A22 = 0.0, A23 = 0.0;
+		double A33 = 0.0;
+		double Area = 0.0;
+
+		void AddPlane(const Vector& normal, double distance, double weight)
+		{
+			A00 += weight * normal.X * normal.X;
+			A01 += weight * normal.X * normal.Y;
+			A02 += weight * normal.X * normal.Z;
+			A03 += weight * normal.X * distance;
+			A11 += weight * normal.Y * normal.Y;
+			A12 += weight * normal.Y * normal.Z;
+			A13 += weight * normal.Y * distance;
+			A22 += weight * normal.Z * normal.Z;
+			A23 += weight * normal.Z * distance;
+			A33 += weight * distance * distance;
+		}
+
+		void Add(const Quadric& other)
+		{
+			A00 += other.A00; A01 += other.A01; A02 += other.A02; A03 += other.A03;
+			A11 += other.A11; A12 += other.A12; A13 += other.A13;
+			A22 += other.A22; A23 += other.A23;
+			A33 += other.A33;
+			Area += other.Area;
+		}
+
+		double Evaluate(const Vector& p) const
+		{
+			return A00 * p.X * p.X + 2.0 * A01 * p.X * p.Y + 2.0 * A02 * p.X * p.Z + 2.0 * A03 * p.X
+				+ A11 * p.Y * p.Y + 2.0 * A12 * p.Y * p.Z + 2.0 * A13 * p.Y
+				+ A22 * p.Z * p.Z + 2.0 * A23 * p.Z
+				+ A33;
+		}
+	};
+
+	struct Collapse
+	{
+		float Cost; // Squared distance
+		uint32_t From;
+		uint32_t To;
+		uint32_t FromVersion;
+		uint32_t ToVersion;
+
+		bool operator>(const Collapse& other) const { return Cost > other.Cost; }
+	};
+
+	// Planes along border edges count this much more than the surface
+	const double BORDER_WEIGHT = 10.0;
+
+	// Triangles may turn by up to about 75 degrees in a collapse
+	const double MIN_FLIP_COSINE = 0.25;
+
+	struct PositionKey
+	{
+		float X, Y, Z;
+
+		bool operator==(const PositionKey& other) const { return memcmp(this, &other, sizeof(PositionKey)) == 0; }
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			uint32_t bits[3];
+			memcpy(bits, &key, sizeof(bits));
+			return ((size_t)bits[0] * 73856093) ^ ((size_t)bits[1] * 19349663) ^ ((size_t)bits[2] * 83492791);
+		}
+	};
+
+	uint64_t GetEdgeKey(uint32_t a, uint32_t b)
+	{
+		return (a < b) ? (((uint64_t)a << 32) | b) : (((uint64_t)b << 32) | a);
+	}
+
+	class Simplifier
+	{
+	private:
+
+		const char* m_vertices;
+		size_t m_vertexStride;
+		size_t m_numVertexFloats;
+
+		// Vertices at the same position are welded into one
+		std::vector<uint32_t> m_welded; // Per vertex
+		std::vector<Vector> m_positions; // Per welded vertex
+		std::vector<std::vector<uint32_t>> m_weldedVertices;
+
+		// Per triangle, three each
+		const uint32_t* m_indices;
+		std::vector<uint32_t> m_corners; // Welded vertices
+		std::vector<uint8_t> m_isAlive;
+		size_t m_numAlive;
+
+		// Per welded vertex
+		std::vector<std::vector<uint32_t>> m_triangles; // May hold triangles that no longer use the vertex
+		std::vector<Quadric> m_quadrics;
+		std::vector<uint32_t> m_versions; // Changed when the quadric or the triangles change
+		std::vector<uint8_t> m_isRemoved;
+
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> m_collapses;
+		double m_error; // Squared
+
+		std::vector<uint32_t> m_neighborsFrom;
+		std::vector<uint32_t> m_neighborsTo;
+
+	public:
+
+		Simplifier(const float* vertices, size_t vertexStride, size_t numVertices, const uint32_t* indices, size_t numIndices) :
+			m_vertices((const char*)vertices),
+			m_vertexStride(vertexStride),
+			m_numVertexFloats(vertexStride / sizeof(float)),
+			m_indices(indices),
+			m_numAlive(0),
+			m_error(0.0)
+		{
+			Weld(numVertices);
+			AddTriangles(numIndices / 3);
+
+			for (uint32_t vertex = 0; vertex < (uint32_t)m_positions.size(); vertex++)
+				PushCollapses(vertex);
+		}
+
+		size_t GetNumIndices() const
+		{
+			return m_numAlive * 3;
+		}
+
+		// Collapses until there are no more than the target number of
+		// indices, returns false if no valid collapse is left before that
+		bool Reduce(size_t targetNumIndices)
+		{
+			while (m_numAlive * 3 > targetNumIndices) {
+				if (m_collapses.empty())
+					return false;
+
+				Collapse collapse = m_collapses.top();
+				m_collapses.pop();
+
+				if (m_isRemoved[collapse.From] || m_isRemoved[collapse.To] ||
+					m_versions[collapse.From] != collapse.FromVersion ||
+					m_versions[collapse.To] != collapse.ToVersion ||
+					!IsValid(collapse.From, collapse.To))
+					continue;
+
+				m_error = std::max(m_error, (double)collapse.Cost);
+				Apply(collapse.From, collapse.To);
+			}
+
+			return true;
+		}
+
+		void Write(env::SimplifiedMesh& result) const
+		{
+			result.Error = (float)std::sqrt(m_error);
+			result.Indices.clear();
+			result.Indices.reserve(m_numAlive * 3);
+
+			for (size_t triangle = 0; triangle < m_isAlive.size(); triangle++) {
+				if (!m_isAlive[triangle])
+					continue;
+
+				for (size_t corner = triangle * 3; corner < triangle * 3 + 3; corner++) {
+					uint32_t vertex = m_indices[corner];
+					if (m_welded[vertex] != m_corners[corner])
+						vertex = FindClosestVertex(m_corners[corner], vertex);
+					result.Indices.push_back(vertex);
+				}
+			}
+		}
+
+	private:
+
+		const float* GetVertex(uint32_t vertex) const
+		{
+			return (const float*)(m_vertices + vertex * m_vertexStride);
+		}
+
+		void Weld(size_t numVertices)
+		{
+			std::unordered_map<PositionKey, uint32_t, PositionKeyHash> weldedByPosition;
+			m_welded.resize(numVertices);
+
+			for (uint32_t vertex = 0; vertex < (uint32_t)numVertices; vertex++) {
+				const float* position = GetVertex(vertex);
+
+				// Adding zero turns -0 into 0, both are the same position
+				PositionKey key = { position[0] + 0.f, position[1] + 0.f, position[2] + 0.f };
+				auto inserted = weldedByPosition.insert({ key, (uint32_t)m_positions.size() });
+				if (inserted.second) {
+					m_positions.push_back({ position[0], position[1], position[2] });
+					m_weldedVertices.emplace_back();
+				}
+
+				m_welded[vertex] = inserted.first->second;
+				m_weldedVertices[inserted.first->second].push_back(vertex);
+			}
+
+			m_triangles.resize(m_positions.size());
+			m_quadrics.resize(m_positions.size());
+			m_versions.resize(m_positions.size(), 0);
+			m_isRemoved.resize(m_positions.size(), 0);
+		}
+
+		void AddTriangles(size_t numTriangles)
+		{
+			m_corners.resize(numTriangles * 3);
+			m_isAlive.resize(numTriangles, 0);
+
+			// Triangles using each edge, borders have one
+			std::unordered_map<uint64_t, uint32_t> edgeCounts;
+
+			for (uint32_t triangle = 0; triangle < (uint32_t)numTriangles; triangle++) {
+				uint32_t* corners = &m_corners[triangle * 3];
+				for (int i = 0; i < 3; i++)
+					corners[i] = m_welded[m_indices[triangle * 3 + i]];
+
+				// Triangles that are already degenerate are dropped
+				if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+					continue;
+
+				m_isAlive[triangle] = 1;
+				m_numAlive++;
+
+				Vector normal = GetNormal(triangle);
+				double length = normal.Length();
+				if (length > 0.0) {
+					Quadric quadric;
+					Vector unitNormal = { normal.X / length, normal.Y / length, normal.Z / length };
+					quadric.AddPlane(unitNormal, -unitNormal.Dot(m_positions[corners[0]]), length * 0.5);
+					quadric.Area = length * 0.5;
+
+					for (int i = 0; i < 3; i++)
+						m_quadrics[corners[i]].Add(quadric);
+				}
+
+				for (int i = 0; i < 3; i++) {
+					m_triangles[corners[i]].push_back(triangle);
+					edgeCounts[GetEdgeKey(corners[i], corners[(i + 1) % 3])]++;
+				}
+			}
+
+			// A plane through each border edge, perpendicular to its triangle
+			for (uint32_t triangle = 0; triangle < (uint32_t)numTriangles; triangle++) {
+				if (!m_isAlive[triangle])
+					continue;
+
+				const uint32_t* corners = &m_corners[triangle * 3];
+				for (int i = 0; i < 3; i++) {
+					uint32_t a = corners[i];
+					uint32_t b = corners[(i + 1) % 3];
+					if (edgeCounts[GetEdgeKey(a, b)] != 1)
+						continue;
+
+					Vector edge = m_positions[b] - m_positions[a];
+					Vector normal = edge.Cross(GetNormal(triangle));
+					double length = normal.Length();
+					if (length == 0.0)
+						continue;
+
+					Quadric quadric;
+					Vector unitNormal = { normal.X / length, normal.Y / length, normal.Z / length };
+					quadric.AddPlane(unitNormal, -unitNormal.Dot(m_positions[a]), edge.Dot(edge) * BORDER_WEIGHT);
+					m_quadrics[a].Add(quadric);
+					m_quadrics[b].Add(quadric);
+				}
+			}
+		}
+
+		Vector GetNormal(uint32_t triangle) const
+		{
+			const uint32_t* corners = &m_corners[triangle * 3];
+			const Vector& p0 = m_positions[corners[0]];
+			return (m_positions[corners[1]] - p0).Cross(m_positions[corners[2]] - p0);
+		}
+
+		bool UsesVertex(uint32_t triangle, uint32_t vertex) const
+		{
+			const uint32_t* corners = &m_corners[triangle * 3];
+			return m_isAlive[triangle] && (corners[0] == vertex || corners[1] == vertex || corners[2] == vertex);
+		}
+
+		void GetNeighbors(uint32_t vertex, std::vector<uint32_t>& neighbors) const
+		{
+			neighbors.clear();
+			for (uint32_t triangle : m_triangles[vertex]) {
+				if (!UsesVertex(triangle, vertex))
+					continue;
+
+				for (int i = 0; i < 3; i++) {
+					uint32_t corner = m_corners[triangle * 3 + i];
+					if (corner != vertex)
+						neighbors.push_back(corner);
+				}
+			}
+
+			std::sort(neighbors.begin(), neighbors.end());
+			neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+		}
+
+		float GetCost(uint32_t from, uint32_t to) const
+		{
+			// Averaged over the area, so the cost is a squared distance
+			Quadric quadric = m_quadrics[from];
+			quadric.Add(m_quadrics[to]);
+			double area = std::max(quadric.Area, 1e-12);
+			return (float)std::max(quadric.Evaluate(m_positions[to]) / area, 0.0);
+		}
+
+		void PushCollapses(uint32_t vertex)
+		{
+			GetNeighbors(vertex, m_neighborsFrom);
+			for (uint32_t neighbor : m_neighborsFrom) {
+				m_collapses.push({ GetCost(vertex, neighbor), vertex, neighbor, m_versions[vertex], m_versions[neighbor] });
+				m_collapses.push({ GetCost(neighbor, vertex), neighbor, vertex, m_versions[neighbor], m_versions[vertex] });
+			}
+		}
+
+		bool IsValid(uint32_t from, uint32_t to)
+		{
+			// The only vertices next to both may be the ones across the
+			// triangles on the edge, anything else pinches the surface
+			size_t numEdgeTriangles = 0;
+			for (uint32_t triangle : m_triangles[from]) {
+				if (UsesVertex(triangle, from) && UsesVertex(triangle, to))
+					numEdgeTriangles++;
+			}
+			if (numEdgeTriangles == 0)
+				return false;
+
+			GetNeighbors(from, m_neighborsFrom);
+			GetNeighbors(to, m_neighborsTo);
+			size_t numShared = 0;
+			for (uint32_t neighbor : m_neighborsFrom)
+				numShared += std::binary_search(m_neighborsTo.begin(), m_neighborsTo.end(), neighbor) ? 1 : 0;
+			if (numShared > numEdgeTriangles)
+				return false;
+
+			// No remaining triangle may fold over or become degenerate
+			for (uint32_t triangle : m_triangles[from]) {
+				if (!UsesVertex(triangle, from) || UsesVertex(triangle, to))
+					continue;
+
+				Vector before = GetNormal(triangle);
+
+				Vector p[3];
+				for (int i = 0; i < 3; i++) {
+					uint32_t corner = m_corners[triangle * 3 + i];
+					p[i] = m_positions[(corner == from) ? to : corner];
+				}
+				Vector after = (p[1] - p[0]).Cross(p[2] - p[0]);
+
+				double lengths = before.Length() * after.Length();
+				if (lengths == 0.0 || before.Dot(after) < MIN_FLIP_COSINE * lengths)
+					return false;
+			}
+
+			return true;
+		}
+
+		void Apply(uint32_t from, uint32_t to)
+		{
+			for (uint32_t triangle : m_triangles[from]) {
+				if (!UsesVertex(triangle, from))
+					continue;
+
+				if (UsesVertex(triangle, to)) {
+					m_isAlive[triangle] = 0;
+					m_numAlive--;
+					continue;
+				}
+
+				for (int i = 0; i < 3; i++) {
+					if (m_corners[triangle * 3 + i] == from)
+						m_corners[triangle * 3 + i] = to;
+				}
+				m_triangles[to].push_back(triangle);
+			}
+
+			m_quadrics[to].Add(m_quadrics[from]);
+			m_isRemoved[from] = 1;
+			std::vector<uint32_t>().swap(m_triangles[from]);
+
+			// Drop the triangles that were removed from the list
+			std::vector<uint32_t>& triangles = m_triangles[to];
+			triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [&](uint32_t triangle) {
+				return !UsesVertex(triangle, to);
+			}), triangles.end());
+
+			m_versions[to]++;
+			PushCollapses(to);
+		}
+
+		uint32_t FindClosestVertex(uint32_t welded, uint32_t original) const
+		{
+			const float* originalFloats = GetVertex(original);
+
+			uint32_t closest = m_weldedVertices[welded].front();
+			float closestDistance = -1.f;
+			for (uint32_t vertex : m_weldedVertices[welded]) {
+				const float* floats = GetVertex(vertex);
+
+				float distance = 0.f;
+				for (size_t i = 3; i < m_numVertexFloats; i++)
+					distance += (floats[i] - originalFloats[i]) * (floats[i] - originalFloats[i]);
+
+				if (closestDistance < 0.f || distance < closestDistance) {
+					closest = vertex;
+					closestDistance = distance;
+				}
+			}
+
+			return closest;
+		}
+	};
+}
+
+void env::SimplifyMesh(const float* vertices, size_t vertexStride, size_t numVertices,
+	const uint32_t* indices, size_t numIndices,
+	const size_t* targetNumIndices, size_t numTargets,
+	std::vector<SimplifiedMesh>& results)
+{
+	assert(vertexStride >= 3 * sizeof(float));
+	results.clear();
+
+	Simplifier simplifier(vertices, vertexStride, numVertices, indices, numIndices);
+
+	size_t numIndicesBefore = numIndices;
+	for (size_t target = 0; target < numTargets; target++) {
+		assert(target == 0 || targetNumIndices[target] < targetNumIndices[target - 1]);
+
+		bool isReached = simplifier.Reduce(targetNumIndices[target]);
+		if (simplifier.GetNumIndices() < numIndicesBefore) {
+			results.emplace_back();
+			simplifier.Write(results.back());
+			numIndicesBefore = simplifier.GetNumIndices();
+		}
+
+		if (!isReached)
+			break;
+	}
+}
@@ -0,0 +1,105 @@
+#include "envision/core/MockQueue.h"
+#include <assert.h>
+
+env::MockQueue::MockQueue() :
+	m_stop(false),
+	m_fenceValue(0),
+	m_completedFenceValue(0)
+{
+	m_thread = std::thread(&MockQueue::Run, this);
+}
+
+env::MockQueue::~MockQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_itemCondition.notify_all();
+	m_thread.join();
+}
+
+void env::MockQueue::Run()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_itemCondition.wait(lock, [&]() { return m_stop || !m_items.empty(); });
+		if (m_stop)
+			return;
+
+		Item item = m_items.front();
+		m_items.pop_front();
+
+		if (item.FenceValue != 0) {
+			m_completedFenceValue = item.FenceValue;
+			m_completionTimes.push_back(Clock::now());
+			m_fenceCondition.notify_all();
+			continue;
+		}
+
+		// Spins instead of sleeping, sleeps are far too coarse on some platforms
+		lock.unlock();
+		Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(item.Seconds));
+		while (Clock::now() < end)
+			std::this_thread::yield();
+		lock.lock();
+	}
+}
+
+void env::MockQueue::Execute(float seconds)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_items.push_back({ seconds, 0 });
+	}
+	m_itemCondition.notify_one();
+}
+
+uint64_t env::MockQueue::IncrementFence()
+{
+	uint64_t value;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		value = ++m_fenceValue;
+		m_items.push_back({ 0.f, value });
+	}
+	m_itemCondition.notify_one();
+	return value;
+}
+
+bool env::MockQueue::IsFenceReached(uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return value <= m_completedFenceValue;
+}
+
+void env::MockQueue::WaitForFenceCPU(uint64_t value)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	assert(value <= m_fenceValue);
+	m_fenceCondition.wait(lock, [&]() { return value <= m_completedFenceValue; });
+}
+
+void env::MockQueue::WaitForIdle()
+{
+	WaitForFenceCPU(IncrementFence());
+}
+
+uint64_t env::MockQueue::GetFenceValue() const
+{
+	return m_fenceValue;
+}
+
+uint64_t env::MockQueue::GetCompletedFenceValue() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_completedFenceValue;
+}
+
+env::MockQueue::Clock::time_point env::MockQueue::GetCompletionTime(uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	assert(value >= 1 && value <= m_completedFenceValue);
+	return m_completionTimes[value - 1];
+}
@@ -0,0 +1,54 @@
+#include "envision/core/RadixSort.h"
+#include <cstring>
+#include <utility>
+
+bool env::RadixSort(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues, size_t count)
+{
+	const int NUM_PASSES = 8;
+	const int NUM_BUCKETS = 256;
+
+	// Histograms of all passes are built in a single read of the keys
+	size_t histograms[NUM_PASSES][NUM_BUCKETS];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t key = keys[i];
+		for (int pass = 0; pass < NUM_PASSES; pass++)
+			histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+	}
+
+	uint64_t* sourceKeys = keys;
+	uint32_t* sourceValues = values;
+	uint64_t* destinationKeys = scratchKeys;
+	uint32_t* destinationValues = scratchValues;
+	bool inScratch = false;
+
+	for (int pass = 0; pass < NUM_PASSES; pass++) {
+		size_t* histogram = histograms[pass];
+		const int shift = pass * 8;
+
+		// All keys in one bucket, the pass would not change the order
+		if (count == 0 || histogram[(sourceKeys[0] >> shift) & 0xFF] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+			size_t bucketSize = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketSize;
+		}
+
+		for (size_t i = 0; i < count; i++) {
+			uint64_t key = sourceKeys[i];
+			size_t destination = histogram[(key >> shift) & 0xFF]++;
+			destinationKeys[destination] = key;
+			destinationValues[destination] = sourceValues[i];
+		}
+
+		std::swap(sourceKeys, destinationKeys);
+		std::swap(sourceValues, destinationValues);
+		inScratch = !inScratch;
+	}
+
+	return inScratch;
+}
@@ -0,0 +1,298 @@
+#include "envision/core/RangeAllocator.h"
+#include <assert.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	// Index of the lowest set bit, mask must not be zero
+	uint32_t LowestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (uint32_t)index;
+#else
+		return (uint32_t)__builtin_ctz(mask);
+#endif
+	}
+
+	// Index of the highest set bit, mask must not be zero
+	uint32_t HighestBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return (uint32_t)index;
+#else
+		return 31 - (uint32_t)__builtin_clz(mask);
+#endif
+	}
+}
+
+env::RangeAllocator::RangeAllocator() :
+	m_capacity(0),
+	m_numAllocated(0),
+	m_numAllocations(0),
+	m_numFreeRanges(0),
+	m_firstLevelMask(0),
+	m_secondLevelMasks{ 0 }
+{
+	//
+}
+
+env::RangeAllocator::RangeAllocator(uint32_t capacity) : RangeAllocator()
+{
+	Initialize(capacity);
+}
+
+void env::RangeAllocator::Initialize(uint32_t capacity)
+{
+	// Sizes are rounded up to their size class when searching, which has to fit in 32 bits
+	assert(capacity < (1u << 31));
+
+	m_capacity = capacity;
+	Clear();
+}
+
+env::RangeAllocation env::RangeAllocator::Allocate(uint32_t size)
+{
+	RangeAllocation allocation;
+	if (size == 0 || size > m_capacity)
+		return allocation;
+
+	uint32_t node = FindFree(size);
+	if (node == NO_NODE)
+		return allocation;
+
+	RemoveFree(node);
+
+	// The rest of the range stays free, after the allocation
+	if (m_nodes[node].Size > size) {
+		uint32_t rest = CreateNode(m_nodes[node].Offset + size, m_nodes[node].Size - size);
+		uint32_t next = m_nodes[node].NextRange;
+
+		m_nodes[rest].PreviousRange = node;
+		m_nodes[rest].NextRange = next;
+		if (next != NO_NODE)
+			m_nodes[next].PreviousRange = rest;
+		m_nodes[node].NextRange = rest;
+		m_nodes[node].Size = size;
+
+		InsertFree(rest);
+	}
+
+	m_nodes[node].IsFree = false;
+	m_numAllocated += size;
+	m_numAllocations++;
+
+	allocation.Offset = m_nodes[node].Offset;
+	allocation.Size = size;
+	allocation.Node = node;
+	return allocation;
+}
+
+void env::RangeAllocator::Free(const RangeAllocation& allocation)
+{
+	uint32_t node = allocation.Node;
+
+	// Also catches freeing the same allocation twice
+	assert(allocation.IsValid() && node < m_nodes.size());
+	assert(!m_nodes[node].IsFree && m_nodes[node].Offset == allocation.Offset && m_nodes[node].Size == allocation.Size);
+
+	m_numAllocated -= m_nodes[node].Size;
+	m_numAllocations--;
+
+	uint32_t next = m_nodes[node].NextRange;
+	if (next != NO_NODE && m_nodes[next].IsFree) {
+		RemoveFree(next);
+		m_nodes[node].Size += m_nodes[next].Size;
+		m_nodes[node].NextRange = m_nodes[next].NextRange;
+		if (m_nodes[node].NextRange != NO_NODE)
+			m_nodes[m_nodes[node].NextRange].PreviousRange = node;
+		DestroyNode(next);
+	}
+
+	uint32_t previous = m_nodes[node].PreviousRange;
+	if (previous != NO_NODE && m_nodes[previous].IsFree) {
+		RemoveFree(previous);
+		m_nodes[previous].Size += m_nodes[node].Size;
+		m_nodes[previous].NextRange = m_nodes[node].NextRange;
+		if (m_nodes[previous].NextRange != NO_NODE)
+			m_nodes[m_nodes[previous].NextRange].PreviousRange = previous;
+		DestroyNode(node);
+		node = previous;
+	}
+
+	InsertFree(node);
+}
+
+void env::RangeAllocator::Clear()
+{
+	m_numAllocated = 0;
+	m_numAllocations = 0;
+	m_numFreeRanges = 0;
+	m_nodes.clear();
+	m_unusedNodes.clear();
+
+	m_firstLevelMask = 0;
+	for (uint32_t i = 0; i < NUM_FIRST_LEVELS; i++) {
+		m_secondLevelMasks[i] = 0;
+		for (uint32_t j = 0; j < NUM_SECOND_LEVELS; j++)
+			m_freeLists[i][j] = NO_NODE;
+	}
+
+	if (m_capacity > 0) {
+		uint32_t node = CreateNode(0, m_capacity);
+		InsertFree(node);
+	}
+}
+
+uint32_t env::RangeAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
+uint32_t env::RangeAllocator::GetNumAllocated() const
+{
+	return m_numAllocated;
+}
+
+uint32_t env::RangeAllocator::GetNumAllocations() const
+{
+	return m_numAllocations;
+}
+
+uint32_t env::RangeAllocator::GetNumFreeRanges() const
+{
+	return m_numFreeRanges;
+}
+
+uint32_t env::RangeAllocator::GetLargestFreeRange() const
+{
+	if (m_firstLevelMask == 0)
+		return 0;
+
+	// Ranges in a size class differ in size, so the highest class is walked
+	uint32_t firstLevel = HighestBit(m_firstLevelMask);
+	uint32_t secondLevel = HighestBit(m_secondLevelMasks[firstLevel]);
+
+	uint32_t largest = 0;
+	for (uint32_t node = m_freeLists[firstLevel][secondLevel]; node != NO_NODE; node = m_nodes[node].NextFree) {
+		if (m_nodes[node].Size > largest)
+			largest = m_nodes[node].Size;
+	}
+	return largest;
+}
+
+void env::RangeAllocator::GetSizeClass(uint32_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	// Sizes below NUM_SECOND_LEVELS get a class each in the first level
+	if (size < NUM_SECOND_LEVELS) {
+		firstLevel = 0;
+		secondLevel = size;
+		return;
+	}
+
+	uint32_t highestBit = HighestBit(size);
+	firstLevel = highestBit - SECOND_LEVEL_LOG2 + 1;
+	secondLevel = (size >> (highestBit - SECOND_LEVEL_LOG2)) ^ NUM_SECOND_LEVELS;
+}
+
+uint32_t env::RangeAllocator::CreateNode(uint32_t offset, uint32_t size)
+{
+	uint32_t node;
+	if (!m_unusedNodes.empty()) {
+		node = m_unusedNodes.back();
+		m_unusedNodes.pop_back();
+	}
+	else {
+		node = (uint32_t)m_nodes.size();
+		m_nodes.emplace_back();
+	}
+
+	m_nodes[node] = { offset, size, NO_NODE, NO_NODE, NO_NODE, NO_NODE, false };
+	return node;
+}
+
+void env::RangeAllocator::DestroyNode(uint32_t node)
+{
+	m_unusedNodes.push_back(node);
+}
+
+void env::RangeAllocator::InsertFree(uint32_t node)
+{
+	uint32_t firstLevel, secondLevel;
+	GetSizeClass(m_nodes[node].Size, firstLevel, secondLevel);
+
+	uint32_t head = m_freeLists[firstLevel][secondLevel];
+	m_nodes[node].IsFree = true;
+	m_nodes[node].PreviousFree = NO_NODE;
+	m_nodes[node].NextFree = head;
+	if (head != NO_NODE)
+		m_nodes[head].PreviousFree = node;
+
+	m_freeLists[firstLevel][secondLevel] = node;
+	m_secondLevelMasks[firstLevel] |= 1u << secondLevel;
+	m_firstLevelMask |= 1u << firstLevel;
+	m_numFreeRanges++;
+}
+
+void env::RangeAllocator::RemoveFree(uint32_t node)
+{
+	uint32_t firstLevel, secondLevel;
+	GetSizeClass(m_nodes[node].Size, firstLevel, secondLevel);
+
+	uint32_t previous = m_nodes[node].PreviousFree;
+	uint32_t next = m_nodes[node].NextFree;
+	if (previous != NO_NODE)
+		m_nodes[previous].NextFree = next;
+	else
+		m_freeLists[firstLevel][secondLevel] = next;
+	if (next != NO_NODE)
+		m_nodes[next].PreviousFree = previous;
+
+	if (m_freeLists[firstLevel][secondLevel] == NO_NODE) {
+		m_secondLevelMasks[firstLevel] &= ~(1u << secondLevel);
+		if (m_secondLevelMasks[firstLevel] == 0)
+			m_firstLevelMask &= ~(1u << firstLevel);
+	}
+
+	m_nodes[node].IsFree = false;
+	m_numFreeRanges--;
+}
+
+uint32_t env::RangeAllocator::FindFree(uint32_t size) const
+{
+	// Rounds up to the next size class, every range in it is at least size
+	uint32_t roundedSize = size;
+	if (size >= NUM_SECOND_LEVELS)
+		roundedSize += (1u << (HighestBit(size) - SECOND_LEVEL_LOG2)) - 1;
+
+	uint32_t firstLevel, secondLevel;
+	GetSizeClass(roundedSize, firstLevel, secondLevel);
+
+	uint32_t secondLevelMask = m_secondLevelMasks[firstLevel] & (~0u << secondLevel);
+	if (secondLevelMask == 0) {
+		uint32_t firstLevelMask = m_firstLevelMask & (~0u << (firstLevel + 1));
+		if (firstLevelMask != 0) {
+			firstLevel = LowestBit(firstLevelMask);
+			secondLevelMask = m_secondLevelMasks[firstLevel];
+		}
+	}
+
+	if (secondLevelMask != 0) {
+		secondLevel = LowestBit(secondLevelMask);
+		return m_freeLists[firstLevel][secondLevel];
+	}
+
+	// Nearly full, a range in the class of size itself might still fit
+	GetSizeClass(size, firstLevel, secondLevel);
+	for (uint32_t node = m_freeLists[firstLevel][secondLevel]; node != NO_NODE; node = m_nodes[node].NextFree) {
+		if (m_nodes[node].Size >= size)
+			return node;
+	}
+	return NO_NODE;
+}
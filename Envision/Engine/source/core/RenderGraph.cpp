@@ -0,0 +1,417 @@
+#include "envision/core/RenderGraph.h"
+#include <algorithm>
+#include <assert.h>
+
+bool env::RenderGraphTextureDesc::operator==(const RenderGraphTextureDesc& other) const
+{
+	return Width == other.Width &&
+		Height == other.Height &&
+		Format == other.Format &&
+		BindFlags == other.BindFlags &&
+		NumBytes == other.NumBytes &&
+		Alignment == other.Alignment;
+}
+
+env::RenderGraph::RenderGraph() :
+	m_firstFinalBarrier(0),
+	m_numFinalBarriers(0),
+	m_heapSize(0),
+	m_isCompiled(false)
+{
+	//
+}
+
+void env::RenderGraph::Clear()
+{
+	m_passes.clear();
+	m_resources.clear();
+	m_barriers.clear();
+	m_firstFinalBarrier = 0;
+	m_numFinalBarriers = 0;
+	m_heapSize = 0;
+	m_statistics = RenderGraphStatistics();
+	m_isCompiled = false;
+}
+
+uint32_t env::RenderGraph::ImportResource(const std::string& name, uint32_t initialState, uint32_t finalState)
+{
+	assert(initialState != UNKNOWN_STATE);
+
+	Resource resource = {};
+	resource.Name = name;
+	resource.IsImported = true;
+	resource.InitialState = initialState;
+	resource.FinalState = finalState;
+
+	m_resources.push_back(resource);
+	m_isCompiled = false;
+	return (uint32_t)m_resources.size() - 1;
+}
+
+uint32_t env::RenderGraph::CreateTexture(const std::string& name, const RenderGraphTextureDesc& desc)
+{
+	assert(desc.NumBytes > 0);
+	assert(desc.Alignment <= PAGE_SIZE);
+
+	Resource resource = {};
+	resource.Name = name;
+	resource.IsImported = false;
+	resource.InitialState = UNKNOWN_STATE;
+	resource.FinalState = UNKNOWN_STATE;
+	resource.Desc = desc;
+
+	m_resources.push_back(resource);
+	m_isCompiled = false;
+	return (uint32_t)m_resources.size() - 1;
+}
+
+uint32_t env::RenderGraph::AddPass(const std::string& name, bool hasSideEffects)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.HasSideEffects = hasSideEffects;
+	pass.IsCulled = false;
+	pass.FirstBarrier = 0;
+	pass.NumBarriers = 0;
+
+	m_passes.push_back(pass);
+	m_isCompiled = false;
+	return (uint32_t)m_passes.size() - 1;
+}
+
+void env::RenderGraph::Read(uint32_t pass, uint32_t resource, uint32_t state)
+{
+	assert(pass < m_passes.size());
+	assert(resource < m_resources.size());
+	assert(state != UNKNOWN_STATE);
+
+	m_passes[pass].Accesses.push_back({ resource, state, false });
+	m_isCompiled = false;
+}
+
+void env::RenderGraph::Write(uint32_t pass, uint32_t resource, uint32_t state)
+{
+	assert(pass < m_passes.size());
+	assert(resource < m_resources.size());
+	assert(state != UNKNOWN_STATE);
+
+	m_passes[pass].Accesses.push_back({ resource, state, true });
+	m_isCompiled = false;
+}
+
+void env::RenderGraph::Compile()
+{
+	m_barriers.clear();
+	m_statistics = RenderGraphStatistics();
+	m_statistics.NumPasses = (uint32_t)m_passes.size();
+	m_statistics.NumResources = (uint32_t)m_resources.size();
+
+	for (Resource& resource : m_resources) {
+		resource.IsNeeded = false;
+		resource.FirstPass = INVALID_INDEX;
+		resource.LastPass = INVALID_INDEX;
+		resource.HeapOffset = 0;
+		resource.IsAliased = false;
+	}
+
+	CullPasses();
+	FindLifetimes();
+	PlaceTransients();
+	CreateBarriers();
+
+	m_isCompiled = true;
+}
+
+uint32_t env::RenderGraph::GetNumPasses() const
+{
+	return (uint32_t)m_passes.size();
+}
+
+const std::string& env::RenderGraph::GetPassName(uint32_t pass) const
+{
+	assert(pass < m_passes.size());
+	return m_passes[pass].Name;
+}
+
+bool env::RenderGraph::IsPassCulled(uint32_t pass) const
+{
+	assert(m_isCompiled);
+	assert(pass < m_passes.size());
+	return m_passes[pass].IsCulled;
+}
+
+uint32_t env::RenderGraph::GetNumPassBarriers(uint32_t pass) const
+{
+	assert(m_isCompiled);
+	assert(pass < m_passes.size());
+	return m_passes[pass].NumBarriers;
+}
+
+const env::RenderGraphBarrier* env::RenderGraph::GetPassBarriers(uint32_t pass) const
+{
+	assert(m_isCompiled);
+	assert(pass < m_passes.size());
+	return m_barriers.data() + m_passes[pass].FirstBarrier;
+}
+
+uint32_t env::RenderGraph::GetNumFinalBarriers() const
+{
+	assert(m_isCompiled);
+	return m_numFinalBarriers;
+}
+
+const env::RenderGraphBarrier* env::RenderGraph::GetFinalBarriers() const
+{
+	assert(m_isCompiled);
+	return m_barriers.data() + m_firstFinalBarrier;
+}
+
+uint32_t env::RenderGraph::GetNumResources() const
+{
+	return (uint32_t)m_resources.size();
+}
+
+const std::string& env::RenderGraph::GetResourceName(uint32_t resource) const
+{
+	assert(resource < m_resources.size());
+	return m_resources[resource].Name;
+}
+
+bool env::RenderGraph::IsImported(uint32_t resource) const
+{
+	assert(resource < m_resources.size());
+	return m_resources[resource].IsImported;
+}
+
+bool env::RenderGraph::IsResourceUsed(uint32_t resource) const
+{
+	assert(m_isCompiled);
+	assert(resource < m_resources.size());
+	return m_resources[resource].FirstPass != INVALID_INDEX;
+}
+
+const env::RenderGraphTextureDesc& env::RenderGraph::GetTextureDesc(uint32_t resource) const
+{
+	assert(resource < m_resources.size());
+	assert(!m_resources[resource].IsImported);
+	return m_resources[resource].Desc;
+}
+
+uint64_t env::RenderGraph::GetHeapOffset(uint32_t resource) const
+{
+	assert(m_isCompiled);
+	assert(resource < m_resources.size());
+	assert(!m_resources[resource].IsImported);
+	return m_resources[resource].HeapOffset;
+}
+
+uint64_t env::RenderGraph::GetHeapSize() const
+{
+	assert(m_isCompiled);
+	return m_heapSize;
+}
+
+const env::RenderGraphStatistics& env::RenderGraph::GetStatistics() const
+{
+	return m_statistics;
+}
+
+void env::RenderGraph::CullPasses()
+{
+	for (uint32_t p = (uint32_t)m_passes.size(); p-- > 0;) {
+		Pass& pass = m_passes[p];
+
+		bool isUsed = pass.HasSideEffects;
+		for (const Access& access : pass.Accesses) {
+			const Resource& resource = m_resources[access.Resource];
+			if (access.IsWrite && (resource.IsImported || resource.IsNeeded))
+				isUsed = true;
+		}
+
+		pass.IsCulled = !isUsed;
+		if (pass.IsCulled) {
+			m_statistics.NumCulledPasses++;
+			continue;
+		}
+
+		for (const Access& access : pass.Accesses)
+			m_resources[access.Resource].IsNeeded = true;
+	}
+}
+
+void env::RenderGraph::FindLifetimes()
+{
+	for (uint32_t p = 0; p < (uint32_t)m_passes.size(); p++) {
+		if (m_passes[p].IsCulled)
+			continue;
+
+		for (const Access& access : m_passes[p].Accesses) {
+			Resource& resource = m_resources[access.Resource];
+			if (resource.FirstPass == INVALID_INDEX)
+				resource.FirstPass = p;
+			resource.LastPass = p;
+		}
+	}
+}
+
+void env::RenderGraph::PlaceTransients()
+{
+	m_transients.clear();
+	m_heapRanges.assign(m_resources.size(), RangeAllocation());
+
+	uint64_t numPages = 0;
+	for (uint32_t r = 0; r < (uint32_t)m_resources.size(); r++) {
+		const Resource& resource = m_resources[r];
+		if (resource.IsImported || resource.FirstPass == INVALID_INDEX)
+			continue;
+
+		m_transients.push_back(r);
+		numPages += (resource.Desc.NumBytes + PAGE_SIZE - 1) / PAGE_SIZE;
+		m_statistics.TransientBytes += resource.Desc.NumBytes;
+	}
+
+	m_statistics.NumTransientTextures = (uint32_t)m_transients.size();
+	m_heapSize = 0;
+	if (m_transients.empty())
+		return;
+
+	// Enough for all of them side by side, so allocations never fail
+	assert(numPages < UINT32_MAX);
+	m_heapAllocator.Initialize((uint32_t)numPages);
+
+	auto byFirstPass = [this](uint32_t a, uint32_t b) { return m_resources[a].FirstPass < m_resources[b].FirstPass; };
+	auto byLastPass = [this](uint32_t a, uint32_t b) { return m_resources[a].LastPass < m_resources[b].LastPass; };
+	std::stable_sort(m_transients.begin(), m_transients.end(), byFirstPass);
+	m_transientEnds = m_transients;
+	std::stable_sort(m_transientEnds.begin(), m_transientEnds.end(), byLastPass);
+
+	// Textures are placed at their first pass and freed after their last,
+	// so the ones starting at a pass can take the memory of the ones that
+	// ended before it
+	size_t nextStart = 0;
+	size_t nextEnd = 0;
+	uint64_t heapPages = 0;
+	while (nextStart < m_transients.size()) {
+		uint32_t pass = m_resources[m_transients[nextStart]].FirstPass;
+
+		while (nextEnd < m_transientEnds.size() && m_resources[m_transientEnds[nextEnd]].LastPass < pass) {
+			m_heapAllocator.Free(m_heapRanges[m_transientEnds[nextEnd]]);
+			nextEnd++;
+		}
+
+		while (nextStart < m_transients.size() && m_resources[m_transients[nextStart]].FirstPass == pass) {
+			uint32_t r = m_transients[nextStart++];
+			Resource& resource = m_resources[r];
+
+			RangeAllocation& range = m_heapRanges[r];
+			range = m_heapAllocator.Allocate((uint32_t)((resource.Desc.NumBytes + PAGE_SIZE - 1) / PAGE_SIZE));
+			assert(range.IsValid());
+
+			resource.HeapOffset = (uint64_t)range.Offset * PAGE_SIZE;
+			heapPages = std::max(heapPages, (uint64_t)range.Offset + range.Size);
+		}
+	}
+
+	m_heapSize = heapPages * PAGE_SIZE;
+	m_statistics.HeapBytes = m_heapSize;
+
+	// A texture whose memory overlaps any other one needs an aliasing
+	// barrier at its first use. Sorted by offset, a texture overlaps one
+	// before it if it starts before the furthest end so far, and one after
+	// it if the closest start after it is before its end.
+	auto byOffset = [this](uint32_t a, uint32_t b) { return m_resources[a].HeapOffset < m_resources[b].HeapOffset; };
+	std::sort(m_transients.begin(), m_transients.end(), byOffset);
+
+	uint64_t furthestEnd = 0;
+	for (uint32_t r : m_transients) {
+		Resource& resource = m_resources[r];
+		if (resource.HeapOffset < furthestEnd)
+			resource.IsAliased = true;
+		furthestEnd = std::max(furthestEnd, resource.HeapOffset + (uint64_t)m_heapRanges[r].Size * PAGE_SIZE);
+	}
+
+	uint64_t closestStart = UINT64_MAX;
+	for (size_t i = m_transients.size(); i-- > 0;) {
+		Resource& resource = m_resources[m_transients[i]];
+		if (closestStart < resource.HeapOffset + (uint64_t)m_heapRanges[m_transients[i]].Size * PAGE_SIZE)
+			resource.IsAliased = true;
+		closestStart = resource.HeapOffset;
+	}
+}
+
+void env::RenderGraph::CreateBarriers()
+{
+	m_states.resize(m_resources.size());
+	m_accessPasses.assign(m_resources.size(), (uint32_t)INVALID_INDEX);
+	m_readStates.resize(m_resources.size());
+	m_writeStates.resize(m_resources.size());
+	for (uint32_t r = 0; r < (uint32_t)m_resources.size(); r++)
+		m_states[r] = m_resources[r].InitialState;
+
+	for (uint32_t p = 0; p < (uint32_t)m_passes.size(); p++) {
+		Pass& pass = m_passes[p];
+		pass.FirstBarrier = (uint32_t)m_barriers.size();
+		pass.NumBarriers = 0;
+		if (pass.IsCulled)
+			continue;
+
+		// A resource can be accessed many times in a pass, all accesses are
+		// combined first
+		for (const Access& access : pass.Accesses) {
+			uint32_t r = access.Resource;
+			if (m_accessPasses[r] != p) {
+				m_accessPasses[r] = p;
+				m_readStates[r] = 0;
+				m_writeStates[r] = UNKNOWN_STATE;
+			}
+
+			if (!access.IsWrite)
+				m_readStates[r] |= access.State;
+			else {
+				assert(m_writeStates[r] == UNKNOWN_STATE || m_writeStates[r] == access.State);
+				m_writeStates[r] = access.State;
+			}
+		}
+
+		// Then each resource gets its barriers at its first access
+		for (const Access& access : pass.Accesses) {
+			uint32_t r = access.Resource;
+			if (m_accessPasses[r] != p)
+				continue;
+			m_accessPasses[r] = INVALID_INDEX;
+
+			uint32_t readState = m_readStates[r];
+			uint32_t writeState = m_writeStates[r];
+
+			const Resource& resource = m_resources[r];
+			if (!resource.IsImported && resource.FirstPass == p && resource.IsAliased) {
+				m_barriers.push_back({ RenderGraphBarrierType::Aliasing, r, UNKNOWN_STATE, UNKNOWN_STATE });
+				m_statistics.NumAliasingBarriers++;
+			}
+
+			uint32_t state = (writeState != UNKNOWN_STATE) ? writeState : readState;
+			if (m_states[r] != state) {
+				m_barriers.push_back({ RenderGraphBarrierType::Transition, r, m_states[r], state });
+				m_statistics.NumTransitions++;
+				m_states[r] = state;
+			}
+		}
+
+		pass.NumBarriers = (uint32_t)m_barriers.size() - pass.FirstBarrier;
+		if (pass.NumBarriers > 0)
+			m_statistics.NumBarrierBatches++;
+	}
+
+	m_firstFinalBarrier = (uint32_t)m_barriers.size();
+	for (uint32_t r = 0; r < (uint32_t)m_resources.size(); r++) {
+		const Resource& resource = m_resources[r];
+		if (resource.IsImported && resource.FinalState != UNKNOWN_STATE && m_states[r] != resource.FinalState) {
+			m_barriers.push_back({ RenderGraphBarrierType::Transition, r, m_states[r], resource.FinalState });
+			m_statistics.NumTransitions++;
+		}
+	}
+
+	m_numFinalBarriers = (uint32_t)m_barriers.size() - m_firstFinalBarrier;
+	if (m_numFinalBarriers > 0)
+		m_statistics.NumBarrierBatches++;
+}
@@ -0,0 +1,122 @@
+#include "envision/core/RingAllocator.h"
+#include <assert.h>
+
+env::RingAllocator::RingAllocator() :
+	m_capacity(0),
+	m_head(0),
+	m_tail(0),
+	m_used(0),
+	m_pendingSize(0)
+{
+	//
+}
+
+env::RingAllocator::RingAllocator(uint64_t capacity) : RingAllocator()
+{
+	Initialize(capacity);
+}
+
+void env::RingAllocator::Initialize(uint64_t capacity)
+{
+	m_capacity = capacity;
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_pendingSize = 0;
+	m_submissions.clear();
+}
+
+uint64_t env::RingAllocator::Allocate(uint64_t numBytes, uint64_t alignment)
+{
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	if (numBytes == 0 || numBytes > m_capacity || m_used == m_capacity)
+		return INVALID_OFFSET;
+
+	// Start over from the beginning when nothing is in use, this gives
+	// the largest possible contiguous range.
+	if (m_used == 0) {
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	uint64_t aligned = (m_head + alignment - 1) & ~(alignment - 1);
+
+	if (m_head >= m_tail) {
+		// Free space is [head, capacity) followed by [0, tail)
+		if (aligned + numBytes <= m_capacity) {
+			uint64_t size = (aligned - m_head) + numBytes;
+			m_head = (aligned + numBytes) % m_capacity;
+			m_used += size;
+			m_pendingSize += size;
+			return aligned;
+		}
+
+		// Wrap around, the end of the ring is wasted until reclaimed
+		if (numBytes <= m_tail) {
+			uint64_t size = (m_capacity - m_head) + numBytes;
+			m_head = numBytes;
+			m_used += size;
+			m_pendingSize += size;
+			return 0;
+		}
+	}
+	else {
+		// Free space is [head, tail)
+		if (aligned + numBytes <= m_tail) {
+			uint64_t size = (aligned - m_head) + numBytes;
+			m_head = aligned + numBytes;
+			m_used += size;
+			m_pendingSize += size;
+			return aligned;
+		}
+	}
+
+	return INVALID_OFFSET;
+}
+
+void env::RingAllocator::Submit(uint64_t fenceValue)
+{
+	if (m_pendingSize == 0)
+		return;
+
+	assert(m_submissions.empty() || m_submissions.back().FenceValue <= fenceValue);
+
+	m_submissions.push_back({ fenceValue, m_head, m_pendingSize });
+	m_pendingSize = 0;
+}
+
+void env::RingAllocator::Reclaim(uint64_t completedFenceValue)
+{
+	while (!m_submissions.empty() && m_submissions.front().FenceValue <= completedFenceValue) {
+		const Submission& submission = m_submissions.front();
+		m_tail = submission.End;
+		m_used -= submission.Size;
+		m_submissions.pop_front();
+	}
+}
+
+uint64_t env::RingAllocator::GetCapacity() const
+{
+	return m_capacity;
+}
+
+uint64_t env::RingAllocator::GetUsed() const
+{
+	return m_used;
+}
+
+uint64_t env::RingAllocator::GetPendingSize() const
+{
+	return m_pendingSize;
+}
+
+size_t env::RingAllocator::GetNumSubmissionsInFlight() const
+{
+	return m_submissions.size();
+}
+
+uint64_t env::RingAllocator::GetOldestFenceValue() const
+{
+	return m_submissions.empty() ? 0 : m_submissions.front().FenceValue;
+}
@@ -1,11 +1,51 @@
 #include "envision/envpch.h"
 #include "envision/core/Scene.h"
+#include "envision/core/JobSystem.h"
+#include "envision/core/MeshSimplifier.h"
 #include "envision/graphics/AssetManager.h"
 #include "envision/resource/ShaderDataType.h"
+#include <unordered_set>
 
-env::Scene::Scene()
+namespace
 {
+	// Copies as much of the name as fits, always null terminated
+	void CopyName(char* destination, size_t destinationSize, const std::string& name)
+	{
+		size_t size = std::min(name.size(), destinationSize - 1);
+		memset(destination, '\0', destinationSize);
+		memcpy_s(destination, destinationSize, name.c_str(), size);
+	}
 
+	// World space box around the transformed mesh box
+	env::AABB GetWorldBounds(const Float4x4& world, const env::MeshBounds& bounds)
+	{
+		Float3 center = Float3::Transform((bounds.Min + bounds.Max) * 0.5f, world);
+		Float3 extents = (bounds.Max - bounds.Min) * 0.5f;
+
+		// Each world axis gets the extents projected by the absolute rotation and scale
+		Float3 worldExtents;
+		worldExtents.x = std::abs(world._11) * extents.x + std::abs(world._21) * extents.y + std::abs(world._31) * extents.z;
+		worldExtents.y = std::abs(world._12) * extents.x + std::abs(world._22) * extents.y + std::abs(world._32) * extents.z;
+		worldExtents.z = std::abs(world._13) * extents.x + std::abs(world._23) * extents.y + std::abs(world._33) * extents.z;
+
+		return {
+			{ center.x - worldExtents.x, center.y - worldExtents.y, center.z - worldExtents.z },
+			{ center.x + worldExtents.x, center.y + worldExtents.y, center.z + worldExtents.z } };
+	}
+}
+
+thread_local const env::SystemAccess* env::Scene::s_systemAccess = nullptr;
+
+env::Scene::Scene() :
+	m_hierarchyVersion(0)
+{
+	m_registry.on_construct<TransformComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+	m_registry.on_destroy<TransformComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+	m_registry.on_construct<ParentComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+	m_registry.on_update<ParentComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+	m_registry.on_destroy<ParentComponent>().connect<&Scene::OnHierarchyChanged>(*this);
+	m_registry.on_destroy<RenderComponent>().connect<&Scene::OnRenderableDestroyed>(*this);
+	m_registry.on_destroy<WorldTransformComponent>().connect<&Scene::OnRenderableDestroyed>(*this);
 }
 
 env::Scene::~Scene()
@@ -23,6 +63,9 @@ ID env::Scene::CreateEntity(const std::string& name)
 
 void env::Scene::RemoveEntity(ID entity)
 {
+	if (HasComponent<PooledTransformComponent>(entity))
+		RemovePooledTransform(entity);
+
 	m_registry.destroy((entt::entity)entity);
 }
 
@@ -36,12 +79,126 @@ bool env::Scene::IsEntity(ID entity)
 	return m_registry.valid((entt::entity)entity);
 }
 
-void env::Scene::LoadScene(const std::string& name, const std::string& filePath)
+void env::Scene::SetParent(ID child, ID parent)
+{
+	assert(IsEntity(child) && IsEntity(parent));
+
+#ifdef _DEBUG
+	// The child can't be an ancestor of its new parent
+	for (ID ancestor = parent; ; ancestor = GetComponent<ParentComponent>(ancestor).Parent) {
+		assert(ancestor != child);
+		if (!IsEntity(ancestor) || !HasComponent<ParentComponent>(ancestor))
+			break;
+	}
+#endif
+
+	m_registry.emplace_or_replace<ParentComponent>((entt::entity)child, parent);
+}
+
+void env::Scene::RemoveParent(ID child)
+{
+	m_registry.remove<ParentComponent>((entt::entity)child);
+}
+
+uint64_t env::Scene::GetHierarchyVersion() const
+{
+	return m_hierarchyVersion;
+}
+
+void env::Scene::AddPooledTransform(ID entity, const Float3& position, const Quaternion& rotation, const Float3& scale)
+{
+	assert(!HasComponent<PooledTransformComponent>(entity));
+
+	uint32_t index = m_transformPool.Add((uint64_t)entity);
+	m_transformPool.SetPosition(index, position.x, position.y, position.z);
+	m_transformPool.SetRotation(index, rotation.x, rotation.y, rotation.z, rotation.w);
+	m_transformPool.SetScale(index, scale.x, scale.y, scale.z);
+
+	m_registry.emplace<PooledTransformComponent>((entt::entity)entity, index);
+	m_registry.emplace_or_replace<WorldTransformComponent>((entt::entity)entity);
+}
+
+void env::Scene::RemovePooledTransform(ID entity)
+{
+	uint32_t index = GetComponent<PooledTransformComponent>(entity).Index;
+	ID moved = (ID)m_transformPool.Remove(index);
+	if (moved != entity)
+		GetComponent<PooledTransformComponent>(moved).Index = index;
+
+	m_registry.remove<PooledTransformComponent>((entt::entity)entity);
+}
+
+env::TransformPool& env::Scene::GetTransformPool()
+{
+	return m_transformPool;
+}
+
+const env::SystemAccess* env::Scene::SetSystemAccess(const SystemAccess* access)
+{
+	const SystemAccess* previous = s_systemAccess;
+	s_systemAccess = access;
+	return previous;
+}
+
+void env::Scene::OnHierarchyChanged(entt::registry& registry, entt::entity entity)
+{
+	m_hierarchyVersion++;
+}
+
+void env::Scene::OnRenderableDestroyed(entt::registry& registry, entt::entity entity)
 {
+	RemoveBVHItem(entt::to_entity(entity));
+}
+
+void env::Scene::LoadScene(const std::string& name, const std::string& filePath, bool useCache)
+{
+	Timepoint readStart = Time::Now();
+	m_loadStatistics = SceneLoadStatistics();
+
+	SceneCache cache;
+	CookedScene imported;
+	CookedSceneView view;
+
+	m_loadStatistics.FromCache = useCache && cache.Open(filePath);
+	if (m_loadStatistics.FromCache) {
+		view = cache.GetView();
+	}
+	else {
+		if (!ImportScene(filePath, imported, &m_loadStatistics)) {
+			std::cout << "Failed to load scene " << filePath << std::endl;
+			return;
+		}
+
+		view = imported.GetView();
+		if (useCache && !SceneCache::Write(filePath, imported))
+			std::cout << "Failed to write scene cache for " << filePath << std::endl;
+	}
+
+	Timepoint instantiateStart = Time::Now();
+	InstantiateScene(name, view);
+
+	m_loadStatistics.ReadTime = (instantiateStart - readStart).InSeconds();
+	m_loadStatistics.InstantiateTime = (Time::Now() - instantiateStart).InSeconds();
+}
+
+const env::SceneLoadStatistics& env::Scene::GetLoadStatistics() const
+{
+	return m_loadStatistics;
+}
+
+bool env::Scene::ImportScene(const std::string& filePath, CookedScene& cooked, SceneLoadStatistics* statistics, UINT maxThreads)
+{
+	Timepoint importStart = Time::Now();
+
 	Assimp::Importer importer;
 
 	const aiScene* scene = importer.ReadFile(filePath,
 		aiProcess_ConvertToLeftHanded);
+	if (!scene || !scene->mRootNode)
+		return false;
+
+	if (statistics)
+		statistics->ImportTime = (Time::Now() - importStart).InSeconds();
 
 	struct MaterialInfo
 	{
@@ -52,7 +209,7 @@ void env::Scene::LoadScene(const std::string& name, const std::string& filePath)
 		float Shininess = 1.f;
 	};
 
-	std::vector<ID> materialIDs(scene->mNumMaterials);
+	cooked.Materials.resize(scene->mNumMaterials);
 	for (unsigned int materialIndex = 0; materialIndex < scene->mNumMaterials; materialIndex++) {
 		aiMaterial* material = scene->mMaterials[materialIndex];
 
@@ -141,142 +298,365 @@ void env::Scene::LoadScene(const std::string& name, const std::string& filePath)
 		std::cout << "\tCOLOR diffuse: (" << diffuse.r << ", " << diffuse.g << ", " << diffuse.b << ")\n";
 		std::cout << "\tCOLOR specular: (" << specular.r << ", " << specular.g << ", " << specular.b << ")\n";
 
-		materialIDs[materialIndex] = AssetManager::Get()->CreatePhongMaterial(info.Name,
-			info.Ambient,
-			info.Diffuse,
-			info.Specular,
-			info.Shininess);
+		CookedMaterial& cookedMaterial = cooked.Materials[materialIndex];
+		CopyName(cookedMaterial.Name, CookedMaterial::MAX_NAME_SIZE, info.Name);
+		cookedMaterial.Ambient = info.Ambient;
+		cookedMaterial.Diffuse = info.Diffuse;
+		cookedMaterial.Specular = info.Specular;
+		cookedMaterial.Shininess = info.Shininess;
 	}
 
-	struct Submesh {
-		std::string Name = "Unknown";
-		ID VertexBuffer = ID_ERROR;
-		UINT OffsetVertices = 0;
-		UINT NumVertices = 0;
-		ID IndexBuffer = ID_ERROR;
-		UINT OffsetIndices = 0;
-		UINT NumIndices = 0;
-	};
+	Timepoint convertStart = Time::Now();
 
 	// All of the loaded meshes will share the same vertex- and index buffer.
 	// This vector will store offset and counts per "sub mesh" within these buffers.
-	std::vector<Submesh> submeshes(scene->mNumMeshes);
+	cooked.Submeshes.resize(scene->mNumMeshes);
 
-	// Query size of vertex buffer and index buffer
-	int numVerticesTotal = 0;
-	int numIndicesTotal = 0;
-	for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++) {
+	// Query size of each mesh, then give each one its range of the vertex
+	// and index buffer with a prefix sum
+	JobSystem::Get()->ParallelFor(scene->mNumMeshes, [&](size_t meshIndex) {
 		aiMesh* mesh = scene->mMeshes[meshIndex];
 
-		Submesh& submesh = submeshes[meshIndex];
+		CookedSubmesh& submesh = cooked.Submeshes[meshIndex];
 
-		submesh.Name = mesh->mName.C_Str();
+		CopyName(submesh.Name, CookedSubmesh::MAX_NAME_SIZE, mesh->mName.C_Str());
+		submesh.Material = mesh->mMaterialIndex;
 		submesh.NumVertices = mesh->mNumVertices;
-		submesh.OffsetVertices = numVerticesTotal;
-		submesh.OffsetIndices = numIndicesTotal;
-
-		numVerticesTotal += submesh.NumVertices;
 
-		int numIndices = 0;
+		UINT numIndices = 0;
 		for (unsigned int faceIndex = 0; faceIndex < mesh->mNumFaces; faceIndex++) {
 			aiFace& face = mesh->mFaces[faceIndex];
 			numIndices += face.mNumIndices;
 		}
 
 		submesh.NumIndices = numIndices;
-		numIndicesTotal += numIndices;
+	}, maxThreads);
+
+	UINT numVerticesTotal = 0;
+	UINT numIndicesTotal = 0;
+	for (CookedSubmesh& submesh : cooked.Submeshes) {
+		submesh.OffsetVertices = numVerticesTotal;
+		submesh.OffsetIndices = numIndicesTotal;
+		numVerticesTotal += submesh.NumVertices;
+		numIndicesTotal += submesh.NumIndices;
 	}
 
 	// Construct the intermediate buffer data for the buffers
-	std::vector<VertexType> vertexData(numVerticesTotal);
-	std::vector<IndexType> indexData(numIndicesTotal);
+	cooked.Vertices.resize(numVerticesTotal);
+	cooked.Indices.resize(numIndicesTotal);
 
-	// Create all meshes
-	for (unsigned int meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++) {
+	// Convert all meshes, each one only writes to its own ranges
+	JobSystem::Get()->ParallelFor(scene->mNumMeshes, [&](size_t meshIndex) {
 
 		aiMesh* mesh = scene->mMeshes[meshIndex];	
-		Submesh& submesh = submeshes[meshIndex];
-
-		// Query vertices and indices to the intermediate buffers
-		for (unsigned int vertexIndex = 0; vertexIndex < mesh->mNumVertices; vertexIndex++) {
-			const aiVector3D& position = mesh->mVertices[vertexIndex];
-			const aiVector3D& normal = mesh->mNormals[vertexIndex];
-			const aiVector3D& texCoord = mesh->mTextureCoords[0][vertexIndex];
-
-			VertexType& vertex = vertexData[submesh.OffsetVertices + vertexIndex];
-			vertex.Position = { position.x, position.y, position.z };
-			vertex.Normal = { normal.x, normal.y, normal.z };
-			vertex.Texcoord = { texCoord.x, texCoord.y };
-		}
+		CookedSubmesh& submesh = cooked.Submeshes[meshIndex];
+
+		// Positions are packed relative to the bounds of the mesh, so those
+		// come first
+		submesh.Bounds = AssetManager::ComputeMeshBounds(mesh->mVertices,
+			submesh.NumVertices,
+			sizeof(aiVector3D));
+
+		AssetManager::PackVertices(&cooked.Vertices[submesh.OffsetVertices],
+			submesh.NumVertices,
+			submesh.Bounds,
+			mesh->mVertices, sizeof(aiVector3D),
+			mesh->HasNormals() ? mesh->mNormals : nullptr, sizeof(aiVector3D),
+			mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0] : nullptr, sizeof(aiVector3D));
 
 		int nextIndex = 0;
 		for (unsigned int faceIndex = 0; faceIndex < mesh->mNumFaces; faceIndex++) {
 			const aiFace& face = mesh->mFaces[faceIndex];
 			for (unsigned int indexIndex = 0; indexIndex < face.mNumIndices; indexIndex++) {
-				indexData[submesh.OffsetIndices + (nextIndex++)] = face.mIndices[indexIndex];
+				cooked.Indices[submesh.OffsetIndices + (nextIndex++)] = face.mIndices[indexIndex];
 			}
 		}
+	}, maxThreads);
+
+	if (statistics)
+		statistics->ConvertTime = (Time::Now() - convertStart).InSeconds();
+
+	Timepoint simplifyStart = Time::Now();
+
+	// Simplified versions of each mesh at 1/2, 1/4 and 1/8 of the triangles,
+	// using the vertices of the full detail mesh. The simplifier reads the
+	// float attributes of the imported mesh, not the packed vertices.
+	std::vector<std::vector<SimplifiedMesh>> simplified(scene->mNumMeshes);
+	JobSystem::Get()->ParallelFor(scene->mNumMeshes, [&](size_t meshIndex) {
+
+		// The scene is not triangulated on import, other meshes keep full detail only
+		const CookedSubmesh& submesh = cooked.Submeshes[meshIndex];
+		if (submesh.NumIndices == 0 || scene->mMeshes[meshIndex]->mPrimitiveTypes != aiPrimitiveType_TRIANGLE)
+			return;
+
+		size_t targetNumIndices[MAX_MESH_LODS - 1];
+		size_t numTargets = 0;
+		for (UINT lod = 1; lod < MAX_MESH_LODS; lod++) {
+			size_t target = (submesh.NumIndices >> lod) / 3 * 3;
+			if (target == 0)
+				break;
+			targetNumIndices[numTargets++] = target;
+		}
+
+		const aiMesh* mesh = scene->mMeshes[meshIndex];
+		const UINT NUM_FLOATS = 8;
+		std::vector<float> vertices((size_t)submesh.NumVertices * NUM_FLOATS, 0.f);
+		for (UINT vertexIndex = 0; vertexIndex < submesh.NumVertices; vertexIndex++) {
+			float* vertex = &vertices[(size_t)vertexIndex * NUM_FLOATS];
+			memcpy(vertex, &mesh->mVertices[vertexIndex], sizeof(float) * 3);
+			if (mesh->HasNormals())
+				memcpy(vertex + 3, &mesh->mNormals[vertexIndex], sizeof(float) * 3);
+			if (mesh->HasTextureCoords(0))
+				memcpy(vertex + 6, &mesh->mTextureCoords[0][vertexIndex], sizeof(float) * 2);
+		}
+
+		SimplifyMesh(vertices.data(),
+			sizeof(float) * NUM_FLOATS,
+			submesh.NumVertices,
+			&cooked.Indices[submesh.OffsetIndices],
+			submesh.NumIndices,
+			targetNumIndices,
+			numTargets,
+			simplified[meshIndex]);
+	}, maxThreads);
+
+	// The LODs go after all full detail indices, so those keep their ranges
+	for (UINT meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++) {
+		CookedSubmesh& submesh = cooked.Submeshes[meshIndex];
+		submesh.NumLods = (UINT)simplified[meshIndex].size();
+
+		for (UINT lod = 0; lod < submesh.NumLods; lod++) {
+			const SimplifiedMesh& simplifiedMesh = simplified[meshIndex][lod];
+			submesh.Lods[lod].OffsetIndices = (UINT)cooked.Indices.size();
+			submesh.Lods[lod].NumIndices = (UINT)simplifiedMesh.Indices.size();
+			submesh.Lods[lod].Error = simplifiedMesh.Error;
+			cooked.Indices.insert(cooked.Indices.end(), simplifiedMesh.Indices.begin(), simplifiedMesh.Indices.end());
+		}
 	}
 
+	if (statistics)
+		statistics->SimplifyTime = (Time::Now() - simplifyStart).InSeconds();
+
+	// Flatten the node tree, parents are always added before their children
+	auto nodeFactory = [&](aiNode* node, UINT parent, auto&& nodeFactory) -> void {
+
+		UINT nodeIndex = (UINT)cooked.Nodes.size();
+		CookedNode& cookedNode = cooked.Nodes.emplace_back();
+
+		CopyName(cookedNode.Name, CookedNode::MAX_NAME_SIZE, node->mName.C_Str());
+		memcpy_s(&cookedNode.LocalMatrix, sizeof(Float4x4), &node->mTransformation, sizeof(node->mTransformation));
+		cookedNode.LocalMatrix = cookedNode.LocalMatrix.Transpose();
+		cookedNode.Parent = parent;
+		cookedNode.FirstMesh = (UINT)cooked.NodeMeshes.size();
+		cookedNode.NumMeshes = node->mNumMeshes;
+
+		for (unsigned int meshIndex = 0; meshIndex < node->mNumMeshes; meshIndex++)
+			cooked.NodeMeshes.push_back(node->mMeshes[meshIndex]);
+
+		for (unsigned int childIndex = 0; childIndex < node->mNumChildren; childIndex++) {
+			nodeFactory(node->mChildren[childIndex], nodeIndex, nodeFactory);
+		}
+	};
+
+	nodeFactory(scene->mRootNode, CookedNode::NO_PARENT, nodeFactory);
+
+	return true;
+}
+
+void env::Scene::InstantiateScene(const std::string& name, const CookedSceneView& scene)
+{
+	std::vector<ID> materialIDs(scene.NumMaterials);
+	for (UINT materialIndex = 0; materialIndex < scene.NumMaterials; materialIndex++) {
+		const CookedMaterial& material = scene.Materials[materialIndex];
+		materialIDs[materialIndex] = AssetManager::Get()->CreatePhongMaterial(material.Name,
+			material.Ambient,
+			material.Diffuse,
+			material.Specular,
+			material.Shininess);
+	}
+
+	// The buffers are uploaded straight from the view, which may point into
+	// the mapped cache file
 	ID vertexBuffer = ResourceManager::Get()->CreateBuffer(name + "_vertexBuffer",
-		BufferLayout({
-			{ "POSITION", ShaderDataType::Float3},
-			{ "NORMAL", ShaderDataType::Float3},
-			{ "TEXCOORD", ShaderDataType::Float2} },
-			numVerticesTotal),
+		GetVertexTypeLayout(scene.NumVertices),
 		BufferBindType::Vertex,
-		vertexData.data());
+		(void*)scene.Vertices);
 
 	ID indexBuffer = ResourceManager::Get()->CreateBuffer(name + "_indexBuffer",
 		BufferLayout(
 			{{ "index", ShaderDataType::Uint }},
-			numIndicesTotal),
+			scene.NumIndices),
 		BufferBindType::Index,
-		indexData.data());
+		(void*)scene.Indices);
 
-	std::vector<ID> meshes(scene->mNumMeshes);
-	for (UINT meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++) {
-		Submesh& submesh = submeshes[meshIndex];
+	std::vector<ID> meshes(scene.NumSubmeshes);
+	for (UINT meshIndex = 0; meshIndex < scene.NumSubmeshes; meshIndex++) {
+		const CookedSubmesh& submesh = scene.Submeshes[meshIndex];
 		meshes[meshIndex] = AssetManager::Get()->CreateMesh(submesh.Name,
 			vertexBuffer,
 			submesh.OffsetVertices,
 			submesh.NumVertices,
 			indexBuffer,
 			submesh.OffsetIndices,
-			submesh.NumIndices);
+			submesh.NumIndices,
+			submesh.Bounds,
+			submesh.Lods,
+			submesh.NumLods);
 	}
 
-	// Create all entities
-	int numEntities = 0;
-	auto entityFactory = [&](aiNode* node, const Float4x4& parentTransform, auto&& entityFactory) -> void {
+	// Create all entities, one per node with the node's local transform. A
+	// node with a single mesh renders it itself, multiple meshes get one
+	// child entity each. The world matrices are set here as well so the
+	// scene can be rendered before the TransformSystem has run.
+	//
+	// All entities are created up front and the components are gathered per
+	// type, so each type is added to all of its entities in one insert.
+	UINT numMeshEntities = 0;
+	for (UINT nodeIndex = 0; nodeIndex < scene.NumNodes; nodeIndex++) {
+		if (scene.Nodes[nodeIndex].NumMeshes > 1)
+			numMeshEntities += scene.Nodes[nodeIndex].NumMeshes;
+	}
 
-		Float4x4 transformMatrix;
-		memcpy_s(&transformMatrix, sizeof(Float4x4), &node->mTransformation, sizeof(node->mTransformation));
-		transformMatrix = transformMatrix.Transpose();
-		transformMatrix *= parentTransform;
+	std::vector<entt::entity> nodeEntities(scene.NumNodes);
+	std::vector<entt::entity> meshEntities(numMeshEntities);
+	m_registry.create(nodeEntities.begin(), nodeEntities.end());
+	m_registry.create(meshEntities.begin(), meshEntities.end());
+
+	std::vector<DebugInfoComponent> nodeNames;
+	std::vector<TransformComponent> nodeTransforms(scene.NumNodes);
+	std::vector<WorldTransformComponent> nodeWorldTransforms(scene.NumNodes);
+	std::vector<WorldTransformComponent> meshWorldTransforms;
+	nodeNames.reserve(scene.NumNodes);
+	meshWorldTransforms.reserve(numMeshEntities);
+
+	std::vector<entt::entity> childEntities;
+	std::vector<ParentComponent> childParents;
+	std::vector<entt::entity> renderEntities;
+	std::vector<RenderComponent> renderComponents;
+
+	UINT nextMeshEntity = 0;
+	for (UINT nodeIndex = 0; nodeIndex < scene.NumNodes; nodeIndex++) {
+		const CookedNode& node = scene.Nodes[nodeIndex];
+		const entt::entity nodeEntity = nodeEntities[nodeIndex];
+
+		Float4x4 worldMatrix = node.LocalMatrix;
+		if (node.Parent != CookedNode::NO_PARENT) {
+			worldMatrix *= nodeWorldTransforms[node.Parent].Matrix;
+			childEntities.push_back(nodeEntity);
+			childParents.emplace_back((ID)nodeEntities[node.Parent]);
+		}
 
-		TransformComponent transformInfo;
-		transformInfo.Transformation = Transform(transformMatrix);
+		nodeNames.emplace_back(std::string(node.Name));
+		nodeTransforms[nodeIndex].Transformation = Transform(node.LocalMatrix);
+		nodeWorldTransforms[nodeIndex].Matrix = worldMatrix;
 
-		for (unsigned int meshIndex = 0; meshIndex < node->mNumMeshes; meshIndex++) {
+		for (UINT meshIndex = node.FirstMesh; meshIndex < node.FirstMesh + node.NumMeshes; meshIndex++) {
 
-			ID meshID = meshes[node->mMeshes[meshIndex]];
-			UINT materialIndex = scene->mMeshes[node->mMeshes[meshIndex]]->mMaterialIndex;
+			const UINT submeshIndex = scene.NodeMeshes[meshIndex];
 
 			RenderComponent renderInfo;
-			renderInfo.Mesh = meshID;
-			renderInfo.Material = materialIDs[materialIndex];
+			renderInfo.Mesh = meshes[submeshIndex];
+			renderInfo.Material = materialIDs[scene.Submeshes[submeshIndex].Material];
 
-			entt::entity entity = m_registry.create();
-			m_registry.emplace<TransformComponent>(entity, transformInfo);
-			m_registry.emplace<RenderComponent>(entity, renderInfo);
-			numEntities++;
-		}
+			if (node.NumMeshes == 1) {
+				renderEntities.push_back(nodeEntity);
+				renderComponents.push_back(renderInfo);
+				break;
+			}
 
-		for (unsigned int childIndex = 0; childIndex < node->mNumChildren; childIndex++) {
-			entityFactory(node->mChildren[childIndex], transformMatrix, entityFactory);
+			const entt::entity entity = meshEntities[nextMeshEntity++];
+			meshWorldTransforms.emplace_back(worldMatrix);
+			childEntities.push_back(entity);
+			childParents.emplace_back((ID)nodeEntity);
+			renderEntities.push_back(entity);
+			renderComponents.push_back(renderInfo);
 		}
-	};
+	}
+
+	m_registry.insert<DebugInfoComponent>(nodeEntities.begin(), nodeEntities.end(), nodeNames.begin());
+	m_registry.insert<TransformComponent>(nodeEntities.begin(), nodeEntities.end(), nodeTransforms.begin());
+	m_registry.insert<WorldTransformComponent>(nodeEntities.begin(), nodeEntities.end(), nodeWorldTransforms.begin());
+	m_registry.insert<TransformComponent>(meshEntities.begin(), meshEntities.end());
+	m_registry.insert<WorldTransformComponent>(meshEntities.begin(), meshEntities.end(), meshWorldTransforms.begin());
+	m_registry.insert<ParentComponent>(childEntities.begin(), childEntities.end(), childParents.begin());
+	m_registry.insert<RenderComponent>(renderEntities.begin(), renderEntities.end(), renderComponents.begin());
+}
+
+void env::Scene::RebuildBVH()
+{
+	std::vector<AABB> bounds;
+	std::vector<uint64_t> entities;
+
+	m_bvhItems.assign(m_registry.size(), SceneBVH::INVALID_INDEX);
+
+	auto view = m_registry.view<RenderComponent, WorldTransformComponent>();
+	view.each([&](entt::entity entity, RenderComponent& render, WorldTransformComponent& transform) {
+		const Mesh* mesh = AssetManager::Get()->GetMesh(render.Mesh);
+		if (!mesh || mesh->Bounds.Radius < 0.f)
+			return;
+
+		m_bvhItems[entt::to_entity(entity)] = (uint32_t)entities.size();
+		bounds.push_back(GetWorldBounds(transform.Matrix, mesh->Bounds));
+		entities.push_back((uint64_t)entity);
+	});
+
+	m_bvh.Build(bounds.data(), entities.data(), entities.size());
+}
+
+void env::Scene::UpdateBVH(ID entity)
+{
+	size_t entityIndex = entt::to_entity((entt::entity)entity);
+	if (entityIndex >= m_bvhItems.size() || m_bvhItems[entityIndex] == SceneBVH::INVALID_INDEX)
+		return;
+
+	const RenderComponent& render = m_registry.get<RenderComponent>((entt::entity)entity);
+	const WorldTransformComponent& transform = m_registry.get<WorldTransformComponent>((entt::entity)entity);
+	const Mesh* mesh = AssetManager::Get()->GetMesh(render.Mesh);
+	if (!mesh) {
+		RemoveBVHItem(entityIndex);
+		return;
+	}
+	if (mesh->Bounds.Radius < 0.f)
+		return;
+
+	m_bvh.SetItemBounds(m_bvhItems[entityIndex], GetWorldBounds(transform.Matrix, mesh->Bounds));
+}
+
+UINT env::Scene::UpdateBVHOfChangedMeshes()
+{
+	const std::vector<ID>& changedMeshes = AssetManager::Get()->GetMeshesWithChangedBounds();
+	if (changedMeshes.empty())
+		return 0;
+
+	std::unordered_set<ID> meshes(changedMeshes.begin(), changedMeshes.end());
+
+	UINT numUpdated = 0;
+	auto view = m_registry.view<RenderComponent, WorldTransformComponent>();
+	for (entt::entity entity : view) {
+		if (meshes.count(view.get<RenderComponent>(entity).Mesh) == 0)
+			continue;
+
+		UpdateBVH((ID)entity);
+		numUpdated++;
+	}
+	return numUpdated;
+}
 
-	entityFactory(scene->mRootNode, Float4x4::Identity, entityFactory);
+void env::Scene::RemoveBVHItem(size_t entityIndex)
+{
+	if (entityIndex >= m_bvhItems.size() || m_bvhItems[entityIndex] == SceneBVH::INVALID_INDEX)
+		return;
+
+	m_bvh.RemoveItem(m_bvhItems[entityIndex]);
+	m_bvhItems[entityIndex] = SceneBVH::INVALID_INDEX;
+}
+
+void env::Scene::RefitBVH()
+{
+	m_bvh.Refit();
+}
+
+const env::SceneBVH& env::Scene::GetBVH() const
+{
+	return m_bvh;
 }
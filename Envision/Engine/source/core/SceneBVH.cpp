@@ -0,0 +1,442 @@
+#include "envision/core/SceneBVH.h"
+#include <algorithm>
+#include <assert.h>
+#include <cfloat>
+
+namespace
+{
+	env::AABB EmptyAABB()
+	{
+		return { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+	}
+
+	// Removed items have the inverted bounds of EmptyAABB
+	bool IsEmpty(const env::AABB& bounds)
+	{
+		return bounds.Min[0] > bounds.Max[0];
+	}
+
+	void Grow(env::AABB& bounds, const env::AABB& other)
+	{
+		for (int i = 0; i < 3; i++) {
+			bounds.Min[i] = std::min(bounds.Min[i], other.Min[i]);
+			bounds.Max[i] = std::max(bounds.Max[i], other.Max[i]);
+		}
+	}
+
+	float HalfArea(const env::AABB& bounds)
+	{
+		float x = bounds.Max[0] - bounds.Min[0];
+		float y = bounds.Max[1] - bounds.Min[1];
+		float z = bounds.Max[2] - bounds.Min[2];
+		return (x < 0.f) ? 0.f : x * y + y * z + z * x;
+	}
+
+	bool Equal(const env::AABB& a, const env::AABB& b)
+	{
+		for (int i = 0; i < 3; i++) {
+			if (a.Min[i] != b.Min[i] || a.Max[i] != b.Max[i])
+				return false;
+		}
+		return true;
+	}
+
+	bool Overlaps(const env::AABB& a, const env::AABB& b)
+	{
+		for (int i = 0; i < 3; i++) {
+			if (a.Max[i] < b.Min[i] || a.Min[i] > b.Max[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Entry distance of the ray into the box, or FLT_MAX if it misses within maxDistance
+	float IntersectRay(const env::AABB& bounds, const float* origin, const float* inverseDirection, float maxDistance)
+	{
+		// Empty boxes would otherwise span the whole ray
+		if (IsEmpty(bounds))
+			return FLT_MAX;
+
+		float tMin = 0.f;
+		float tMax = maxDistance;
+		for (int i = 0; i < 3; i++) {
+			float t0 = (bounds.Min[i] - origin[i]) * inverseDirection[i];
+			float t1 = (bounds.Max[i] - origin[i]) * inverseDirection[i];
+			if (t0 > t1)
+				std::swap(t0, t1);
+			tMin = std::max(tMin, t0);
+			tMax = std::min(tMax, t1);
+		}
+		return (tMin <= tMax) ? tMin : FLT_MAX;
+	}
+
+	enum class FrustumTest { Outside, Intersecting, Inside };
+
+	FrustumTest TestFrustum(const env::Frustum& frustum, const env::AABB& bounds)
+	{
+		FrustumTest result = FrustumTest::Inside;
+		for (const auto& plane : frustum.Planes) {
+			// Corners furthest along and against the plane normal
+			float distanceFar = plane[3];
+			float distanceNear = plane[3];
+			for (int i = 0; i < 3; i++) {
+				distanceFar += plane[i] * ((plane[i] > 0.f) ? bounds.Max[i] : bounds.Min[i]);
+				distanceNear += plane[i] * ((plane[i] > 0.f) ? bounds.Min[i] : bounds.Max[i]);
+			}
+
+			if (distanceFar < 0.f)
+				return FrustumTest::Outside;
+			if (distanceNear < 0.f)
+				result = FrustumTest::Intersecting;
+		}
+		return result;
+	}
+}
+
+void env::SceneBVH::Build(const AABB* bounds, const uint64_t* values, size_t count)
+{
+	Clear();
+
+	if (count == 0)
+		return;
+
+	m_itemBounds.assign(bounds, bounds + count);
+	m_itemValues.assign(values, values + count);
+	m_itemLeaves.resize(count, INVALID_INDEX);
+	m_itemReferences.resize(count);
+	for (size_t i = 0; i < count; i++)
+		m_itemReferences[i] = (uint32_t)i;
+
+	std::vector<float> centroids(count * 3);
+	for (size_t i = 0; i < count; i++) {
+		for (int axis = 0; axis < 3; axis++)
+			centroids[i * 3 + axis] = (bounds[i].Min[axis] + bounds[i].Max[axis]) * 0.5f;
+	}
+
+	// A binary tree with at least one item per leaf has at most 2n - 1 nodes
+	m_nodes.reserve(count * 2 - 1);
+	m_parents.reserve(count * 2 - 1);
+
+	m_nodes.push_back({ EmptyAABB(), 0, (uint32_t)count });
+	m_parents.push_back(INVALID_INDEX);
+
+	std::vector<uint32_t> stack = { 0 };
+	while (!stack.empty()) {
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		Node& node = m_nodes[nodeIndex];
+		uint32_t begin = node.FirstChildOrItem;
+		uint32_t end = begin + node.NumItems;
+
+		node.Bounds = EmptyAABB();
+		for (uint32_t i = begin; i < end; i++)
+			Grow(node.Bounds, m_itemBounds[m_itemReferences[i]]);
+
+		if (node.NumItems <= MAX_ITEMS_PER_LEAF) {
+			for (uint32_t i = begin; i < end; i++)
+				m_itemLeaves[m_itemReferences[i]] = nodeIndex;
+			continue;
+		}
+
+		uint32_t middle = Split(begin, end, centroids);
+
+		// No split along any axis, all centroids are in the same spot
+		if (middle == INVALID_INDEX)
+			middle = begin + (end - begin) / 2;
+
+		uint32_t leftIndex = (uint32_t)m_nodes.size();
+		node.FirstChildOrItem = leftIndex;
+		node.NumItems = 0;
+
+		m_nodes.push_back({ EmptyAABB(), begin, middle - begin });
+		m_nodes.push_back({ EmptyAABB(), middle, end - middle });
+		m_parents.push_back(nodeIndex);
+		m_parents.push_back(nodeIndex);
+
+		stack.push_back(leftIndex + 1);
+		stack.push_back(leftIndex);
+	}
+}
+
+uint32_t env::SceneBVH::Split(uint32_t begin, uint32_t end, const std::vector<float>& centroids)
+{
+	AABB centroidBounds = EmptyAABB();
+	for (uint32_t i = begin; i < end; i++) {
+		const float* centroid = &centroids[m_itemReferences[i] * 3];
+		AABB point = { { centroid[0], centroid[1], centroid[2] }, { centroid[0], centroid[1], centroid[2] } };
+		Grow(centroidBounds, point);
+	}
+
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	int bestBin = 0;
+
+	for (int axis = 0; axis < 3; axis++) {
+		const float extent = centroidBounds.Max[axis] - centroidBounds.Min[axis];
+		if (extent <= 0.f)
+			continue;
+
+		const float binScale = NUM_BINS / extent;
+
+		AABB binBounds[NUM_BINS];
+		uint32_t binCounts[NUM_BINS] = { 0 };
+		for (int bin = 0; bin < NUM_BINS; bin++)
+			binBounds[bin] = EmptyAABB();
+
+		for (uint32_t i = begin; i < end; i++) {
+			uint32_t item = m_itemReferences[i];
+			int bin = std::min(NUM_BINS - 1, (int)((centroids[item * 3 + axis] - centroidBounds.Min[axis]) * binScale));
+			binCounts[bin]++;
+			Grow(binBounds[bin], m_itemBounds[item]);
+		}
+
+		// Sweep from the right to get the cost of everything right of each split
+		float rightAreas[NUM_BINS];
+		uint32_t rightCounts[NUM_BINS];
+		AABB accumulated = EmptyAABB();
+		uint32_t count = 0;
+		for (int bin = NUM_BINS - 1; bin > 0; bin--) {
+			Grow(accumulated, binBounds[bin]);
+			count += binCounts[bin];
+			rightAreas[bin] = HalfArea(accumulated);
+			rightCounts[bin] = count;
+		}
+
+		accumulated = EmptyAABB();
+		count = 0;
+		for (int bin = 0; bin < NUM_BINS - 1; bin++) {
+			Grow(accumulated, binBounds[bin]);
+			count += binCounts[bin];
+
+			// Split between bin and bin + 1
+			if (count == 0 || rightCounts[bin + 1] == 0)
+				continue;
+
+			float cost = HalfArea(accumulated) * count + rightAreas[bin + 1] * rightCounts[bin + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = bin;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+		return INVALID_INDEX;
+
+	const float binScale = NUM_BINS / (centroidBounds.Max[bestAxis] - centroidBounds.Min[bestAxis]);
+	auto middle = std::partition(m_itemReferences.begin() + begin, m_itemReferences.begin() + end, [&](uint32_t item) {
+		int bin = std::min(NUM_BINS - 1, (int)((centroids[item * 3 + bestAxis] - centroidBounds.Min[bestAxis]) * binScale));
+		return bin <= bestBin;
+	});
+
+	return (uint32_t)(middle - m_itemReferences.begin());
+}
+
+void env::SceneBVH::Clear()
+{
+	m_nodes.clear();
+	m_parents.clear();
+	m_itemBounds.clear();
+	m_itemValues.clear();
+	m_itemLeaves.clear();
+	m_itemReferences.clear();
+	m_dirtyLeaves.clear();
+}
+
+void env::SceneBVH::SetItemBounds(uint32_t item, const AABB& bounds)
+{
+	assert(item < m_itemBounds.size());
+
+	m_itemBounds[item] = bounds;
+	m_dirtyLeaves.push_back(m_itemLeaves[item]);
+}
+
+void env::SceneBVH::RemoveItem(uint32_t item)
+{
+	SetItemBounds(item, EmptyAABB());
+}
+
+void env::SceneBVH::Refit()
+{
+	for (uint32_t leafIndex : m_dirtyLeaves) {
+		Node& leaf = m_nodes[leafIndex];
+
+		AABB bounds = EmptyAABB();
+		for (uint32_t i = leaf.FirstChildOrItem; i < leaf.FirstChildOrItem + leaf.NumItems; i++)
+			Grow(bounds, m_itemBounds[m_itemReferences[i]]);
+
+		if (Equal(bounds, leaf.Bounds))
+			continue;
+		leaf.Bounds = bounds;
+
+		// Walk up until a node does not change, the nodes above it are then up to date
+		uint32_t nodeIndex = m_parents[leafIndex];
+		while (nodeIndex != INVALID_INDEX) {
+			Node& node = m_nodes[nodeIndex];
+
+			AABB nodeBounds = m_nodes[node.FirstChildOrItem].Bounds;
+			Grow(nodeBounds, m_nodes[node.FirstChildOrItem + 1].Bounds);
+
+			if (Equal(nodeBounds, node.Bounds))
+				break;
+
+			node.Bounds = nodeBounds;
+			nodeIndex = m_parents[nodeIndex];
+		}
+	}
+
+	m_dirtyLeaves.clear();
+}
+
+void env::SceneBVH::QueryFrustum(const Frustum& frustum, std::vector<uint64_t>& results) const
+{
+	if (m_nodes.empty())
+		return;
+
+	// The top bit marks nodes that are known to be fully inside
+	const uint32_t INSIDE_BIT = 1u << 31;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		uint32_t entry = stack.back();
+		stack.pop_back();
+		const Node& node = m_nodes[entry & ~INSIDE_BIT];
+		bool isInside = (entry & INSIDE_BIT) != 0;
+
+		if (!isInside) {
+			FrustumTest test = TestFrustum(frustum, node.Bounds);
+			if (test == FrustumTest::Outside)
+				continue;
+			isInside = (test == FrustumTest::Inside);
+		}
+
+		if (node.NumItems > 0) {
+			for (uint32_t i = node.FirstChildOrItem; i < node.FirstChildOrItem + node.NumItems; i++) {
+				uint32_t item = m_itemReferences[i];
+				if (IsEmpty(m_itemBounds[item]))
+					continue;
+				if (isInside || TestFrustum(frustum, m_itemBounds[item]) != FrustumTest::Outside)
+					results.push_back(m_itemValues[item]);
+			}
+			continue;
+		}
+
+		uint32_t flag = isInside ? INSIDE_BIT : 0;
+		stack.push_back((node.FirstChildOrItem + 1) | flag);
+		stack.push_back(node.FirstChildOrItem | flag);
+	}
+}
+
+void env::SceneBVH::QueryAABB(const AABB& bounds, std::vector<uint64_t>& results) const
+{
+	if (m_nodes.empty())
+		return;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	stack.push_back(0);
+
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+		if (!Overlaps(node.Bounds, bounds))
+			continue;
+
+		if (node.NumItems > 0) {
+			for (uint32_t i = node.FirstChildOrItem; i < node.FirstChildOrItem + node.NumItems; i++) {
+				uint32_t item = m_itemReferences[i];
+				if (Overlaps(m_itemBounds[item], bounds))
+					results.push_back(m_itemValues[item]);
+			}
+			continue;
+		}
+
+		stack.push_back(node.FirstChildOrItem + 1);
+		stack.push_back(node.FirstChildOrItem);
+	}
+}
+
+bool env::SceneBVH::Raycast(const float* origin, const float* direction, float maxDistance, uint64_t& hitValue, float& hitDistance) const
+{
+	if (m_nodes.empty())
+		return false;
+
+	float inverseDirection[3];
+	for (int i = 0; i < 3; i++)
+		inverseDirection[i] = (direction[i] != 0.f) ? 1.f / direction[i] : FLT_MAX;
+
+	float closest = maxDistance;
+	bool hasHit = false;
+
+	std::vector<uint32_t> stack;
+	stack.reserve(64);
+	if (IntersectRay(m_nodes[0].Bounds, origin, inverseDirection, closest) != FLT_MAX)
+		stack.push_back(0);
+
+	while (!stack.empty()) {
+		const Node& node = m_nodes[stack.back()];
+		stack.pop_back();
+
+		if (node.NumItems > 0) {
+			for (uint32_t i = node.FirstChildOrItem; i < node.FirstChildOrItem + node.NumItems; i++) {
+				uint32_t item = m_itemReferences[i];
+				float distance = IntersectRay(m_itemBounds[item], origin, inverseDirection, closest);
+				if (distance != FLT_MAX && distance <= closest) {
+					closest = distance;
+					hitValue = m_itemValues[item];
+					hasHit = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the closer child first, so the far one is more likely to be skipped
+		uint32_t nearIndex = node.FirstChildOrItem;
+		uint32_t farIndex = node.FirstChildOrItem + 1;
+		float nearDistance = IntersectRay(m_nodes[nearIndex].Bounds, origin, inverseDirection, closest);
+		float farDistance = IntersectRay(m_nodes[farIndex].Bounds, origin, inverseDirection, closest);
+		if (farDistance < nearDistance) {
+			std::swap(nearIndex, farIndex);
+			std::swap(nearDistance, farDistance);
+		}
+
+		if (farDistance != FLT_MAX)
+			stack.push_back(farIndex);
+		if (nearDistance != FLT_MAX)
+			stack.push_back(nearIndex);
+	}
+
+	if (hasHit)
+		hitDistance = closest;
+	return hasHit;
+}
+
+size_t env::SceneBVH::GetNumNodes() const
+{
+	return m_nodes.size();
+}
+
+size_t env::SceneBVH::GetNumItems() const
+{
+	return m_itemValues.size();
+}
+
+uint32_t env::SceneBVH::GetDepth() const
+{
+	if (m_nodes.empty())
+		return 0;
+
+	// Children are always stored after their parent
+	std::vector<uint32_t> depths(m_nodes.size(), 1);
+	uint32_t maxDepth = 1;
+	for (size_t i = 1; i < m_nodes.size(); i++) {
+		depths[i] = depths[m_parents[i]] + 1;
+		maxDepth = std::max(maxDepth, depths[i]);
+	}
+	return maxDepth;
+}
@@ -0,0 +1,264 @@
+#include "envision/envpch.h"
+#include "envision/core/SceneCache.h"
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+	struct Section
+	{
+		uint64_t Offset;
+		uint64_t Count;
+	};
+
+	struct Header
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t VertexSize;
+		uint32_t IndexSize;
+
+		uint64_t SourceSize;
+		int64_t SourceWriteTime;
+		uint64_t SourceHash;
+
+		Section Materials;
+		Section Submeshes;
+		Section Nodes;
+		Section NodeMeshes;
+		Section Vertices;
+		Section Indices;
+	};
+
+	const char MAGIC[4] = { 'E', 'N', 'V', 'S' };
+	const uint64_t SECTION_ALIGNMENT = 16;
+
+	struct SourceInfo
+	{
+		uint64_t Size = 0;
+		int64_t WriteTime = 0;
+	};
+
+	bool GetSourceInfo(const std::string& filePath, SourceInfo& info)
+	{
+		std::error_code error;
+		info.Size = (uint64_t)std::filesystem::file_size(filePath, error);
+		if (error)
+			return false;
+
+		info.WriteTime = (int64_t)std::filesystem::last_write_time(filePath, error).time_since_epoch().count();
+		return !error;
+	}
+
+	// FNV-1a over the whole file, 0 if it can't be read
+	uint64_t HashFile(const std::string& filePath)
+	{
+		env::MappedFile file;
+		if (!file.Open(filePath))
+			return 0;
+
+		uint64_t hash = 14695981039346656037ull;
+		const uint8_t* bytes = (const uint8_t*)file.GetData();
+		for (size_t i = 0; i < file.GetSize(); i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+
+	template <typename T>
+	bool GetSection(const env::MappedFile& file, const Section& section, const T*& data, UINT& count)
+	{
+		if (section.Offset % alignof(T) != 0 || section.Offset > file.GetSize() ||
+			section.Count > (file.GetSize() - section.Offset) / sizeof(T))
+			return false;
+
+		data = (const T*)((const char*)file.GetData() + section.Offset);
+		count = (UINT)section.Count;
+		return true;
+	}
+
+	bool IsInRange(uint64_t offset, uint64_t count, uint64_t size)
+	{
+		return offset <= size && count <= size - offset;
+	}
+
+	// Checks every index stored in the sections against the section it
+	// points into, so a damaged cache can't make the loader read past them
+	bool IsConsistent(const env::CookedSceneView& view)
+	{
+		for (UINT i = 0; i < view.NumSubmeshes; i++) {
+			const env::CookedSubmesh& submesh = view.Submeshes[i];
+			if (submesh.Material >= view.NumMaterials ||
+				!IsInRange(submesh.OffsetVertices, submesh.NumVertices, view.NumVertices) ||
+				!IsInRange(submesh.OffsetIndices, submesh.NumIndices, view.NumIndices) ||
+				submesh.NumLods > env::MAX_MESH_LODS - 1)
+				return false;
+
+			for (UINT lod = 0; lod < submesh.NumLods; lod++) {
+				if (!IsInRange(submesh.Lods[lod].OffsetIndices, submesh.Lods[lod].NumIndices, view.NumIndices))
+					return false;
+			}
+		}
+
+		// Parents are stored before their children
+		for (UINT i = 0; i < view.NumNodes; i++) {
+			const env::CookedNode& node = view.Nodes[i];
+			if ((node.Parent != env::CookedNode::NO_PARENT && node.Parent >= i) ||
+				!IsInRange(node.FirstMesh, node.NumMeshes, view.NumNodeMeshes))
+				return false;
+		}
+
+		for (UINT i = 0; i < view.NumNodeMeshes; i++) {
+			if (view.NodeMeshes[i] >= view.NumSubmeshes)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+env::CookedSceneView env::CookedScene::GetView() const
+{
+	CookedSceneView view;
+	view.Materials = Materials.data();
+	view.NumMaterials = (UINT)Materials.size();
+	view.Submeshes = Submeshes.data();
+	view.NumSubmeshes = (UINT)Submeshes.size();
+	view.Nodes = Nodes.data();
+	view.NumNodes = (UINT)Nodes.size();
+	view.NodeMeshes = NodeMeshes.data();
+	view.NumNodeMeshes = (UINT)NodeMeshes.size();
+	view.Vertices = Vertices.data();
+	view.NumVertices = (UINT)Vertices.size();
+	view.Indices = Indices.data();
+	view.NumIndices = (UINT)Indices.size();
+	return view;
+}
+
+std::string env::SceneCache::GetCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".envscene";
+}
+
+bool env::SceneCache::Write(const std::string& sourcePath, const CookedScene& scene)
+{
+	SourceInfo source;
+	if (!GetSourceInfo(sourcePath, source))
+		return false;
+
+	Header header = {};
+	memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+	header.Version = VERSION;
+	header.VertexSize = sizeof(VertexType);
+	header.IndexSize = sizeof(IndexType);
+	header.SourceSize = source.Size;
+	header.SourceWriteTime = source.WriteTime;
+	header.SourceHash = HashFile(sourcePath);
+
+	// Sections follow the header in this order, each one aligned
+	struct SectionData
+	{
+		Section& Target;
+		const void* Data;
+		uint64_t Count;
+		uint64_t ElementSize;
+	};
+	SectionData sections[] = {
+		{ header.Materials, scene.Materials.data(), scene.Materials.size(), sizeof(CookedMaterial) },
+		{ header.Submeshes, scene.Submeshes.data(), scene.Submeshes.size(), sizeof(CookedSubmesh) },
+		{ header.Nodes, scene.Nodes.data(), scene.Nodes.size(), sizeof(CookedNode) },
+		{ header.NodeMeshes, scene.NodeMeshes.data(), scene.NodeMeshes.size(), sizeof(UINT) },
+		{ header.Vertices, scene.Vertices.data(), scene.Vertices.size(), sizeof(VertexType) },
+		{ header.Indices, scene.Indices.data(), scene.Indices.size(), sizeof(IndexType) },
+	};
+
+	uint64_t offset = sizeof(Header);
+	for (SectionData& section : sections) {
+		offset = (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+		section.Target = { offset, section.Count };
+		offset += section.Count * section.ElementSize;
+	}
+
+	// Written to a temporary file first so a failed write never leaves a
+	// cache that looks valid
+	std::string cachePath = GetCachePath(sourcePath);
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write((const char*)&header, sizeof(Header));
+
+		const char padding[SECTION_ALIGNMENT] = { 0 };
+		uint64_t written = sizeof(Header);
+		for (SectionData& section : sections) {
+			file.write(padding, section.Target.Offset - written);
+			file.write((const char*)section.Data, section.Count * section.ElementSize);
+			written = section.Target.Offset + section.Count * section.ElementSize;
+		}
+
+		if (!file)
+			return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporaryPath, cachePath, error);
+	return !error;
+}
+
+bool env::SceneCache::Open(const std::string& sourcePath)
+{
+	Close();
+
+	if (!m_file.Open(GetCachePath(sourcePath)) || m_file.GetSize() < sizeof(Header))
+		return false;
+
+	const Header& header = *(const Header*)m_file.GetData();
+	if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 ||
+		header.Version != VERSION ||
+		header.VertexSize != sizeof(VertexType) ||
+		header.IndexSize != sizeof(IndexType)) {
+		Close();
+		return false;
+	}
+
+	// A cache without its source is still used. A changed write time alone,
+	// like after a fresh checkout, only costs hashing the source.
+	SourceInfo source;
+	if (GetSourceInfo(sourcePath, source)) {
+		bool upToDate = source.Size == header.SourceSize &&
+			(source.WriteTime == header.SourceWriteTime || HashFile(sourcePath) == header.SourceHash);
+		if (!upToDate) {
+			Close();
+			return false;
+		}
+	}
+
+	bool valid =
+		GetSection(m_file, header.Materials, m_view.Materials, m_view.NumMaterials) &&
+		GetSection(m_file, header.Submeshes, m_view.Submeshes, m_view.NumSubmeshes) &&
+		GetSection(m_file, header.Nodes, m_view.Nodes, m_view.NumNodes) &&
+		GetSection(m_file, header.NodeMeshes, m_view.NodeMeshes, m_view.NumNodeMeshes) &&
+		GetSection(m_file, header.Vertices, m_view.Vertices, m_view.NumVertices) &&
+		GetSection(m_file, header.Indices, m_view.Indices, m_view.NumIndices) &&
+		IsConsistent(m_view);
+	if (!valid) {
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void env::SceneCache::Close()
+{
+	m_file.Close();
+	m_view = CookedSceneView();
+}
+
+const env::CookedSceneView& env::SceneCache::GetView() const
+{
+	return m_view;
+}
@@ -0,0 +1,287 @@
+#include "envision/core/ShaderCache.h"
+#include <assert.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+
+namespace
+{
+	struct Header
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t Entry;
+		uint32_t Reserved;
+
+		uint64_t Key;
+		uint64_t NumBytes;
+		uint64_t DataHash; // Catches truncated or otherwise broken files
+	};
+
+	const char MAGIC[4] = { 'E', 'N', 'V', 'C' };
+
+	const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	const uint64_t FNV_PRIME = 1099511628211ull;
+
+	uint64_t HashBytes(uint64_t hash, const void* data, size_t numBytes)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < numBytes; i++) {
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+		return hash;
+	}
+
+	bool ReadFile(const std::filesystem::path& path, std::string& text)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+
+		text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return !file.bad();
+	}
+
+	// Names of all #include "name" and #include <name> directives. Includes
+	// in comments or inactive #if blocks are found too, which only means the
+	// key changes more often than it has to.
+	std::vector<std::string> FindIncludes(const std::string& text)
+	{
+		std::vector<std::string> includes;
+
+		size_t lineStart = 0;
+		while (lineStart < text.size()) {
+			size_t lineEnd = text.find('\n', lineStart);
+			if (lineEnd == std::string::npos)
+				lineEnd = text.size();
+
+			size_t i = text.find_first_not_of(" \t", lineStart);
+			if (i < lineEnd && text[i] == '#') {
+				i = text.find_first_not_of(" \t", i + 1);
+				if (i < lineEnd && text.compare(i, 7, "include") == 0) {
+					i = text.find_first_not_of(" \t", i + 7);
+					if (i < lineEnd && (text[i] == '"' || text[i] == '<')) {
+						char close = (text[i] == '"') ? '"' : '>';
+						size_t nameEnd = text.find(close, i + 1);
+						if (nameEnd < lineEnd)
+							includes.push_back(text.substr(i + 1, nameEnd - i - 1));
+					}
+				}
+			}
+
+			lineStart = lineEnd + 1;
+		}
+
+		return includes;
+	}
+
+	uint64_t HashSourceRecursive(uint64_t hash, const std::filesystem::path& path, std::set<std::filesystem::path>& visited)
+	{
+		std::string text;
+		if (!ReadFile(path, text))
+			return 0;
+
+		hash = HashBytes(hash, text.data(), text.size());
+
+		for (const std::string& include : FindIncludes(text)) {
+			hash = HashBytes(hash, include.data(), include.size() + 1);
+
+			std::error_code error;
+			std::filesystem::path includePath = std::filesystem::weakly_canonical(path.parent_path() / include, error);
+			if (error || !visited.insert(includePath).second)
+				continue;
+
+			uint64_t includeHash = HashSourceRecursive(hash, includePath, visited);
+			if (includeHash != 0)
+				hash = includeHash;
+		}
+
+		return hash;
+	}
+}
+
+const char* env::GetShaderCacheEntryName(ShaderCacheEntry entry)
+{
+	switch (entry)
+	{
+	case ShaderCacheEntry::Shader: return "Shaders";
+	case ShaderCacheEntry::RootSignature: return "Root signatures";
+	case ShaderCacheEntry::Pipeline: return "Pipelines";
+	default: return "Unknown";
+	}
+}
+
+env::ShaderCacheKey::ShaderCacheKey() :
+	m_hash(FNV_OFFSET_BASIS)
+{
+	//
+}
+
+env::ShaderCacheKey& env::ShaderCacheKey::AddBytes(const void* data, size_t numBytes)
+{
+	m_hash = HashBytes(m_hash, data, numBytes);
+	return *this;
+}
+
+env::ShaderCacheKey& env::ShaderCacheKey::AddString(const std::string& text)
+{
+	uint64_t length = text.size();
+	AddValue(length);
+	return AddBytes(text.data(), text.size());
+}
+
+uint64_t env::ShaderCacheKey::Get() const
+{
+	return m_hash;
+}
+
+env::ShaderCache::ShaderCache() :
+	m_isReadEnabled(true)
+{
+	//
+}
+
+env::ShaderCache::ShaderCache(const std::string& directory) : ShaderCache()
+{
+	Initialize(directory);
+}
+
+void env::ShaderCache::Initialize(const std::string& directory)
+{
+	m_directory = directory;
+}
+
+uint64_t env::ShaderCache::HashSource(const std::string& sourcePath)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(sourcePath, error);
+	if (error)
+		return 0;
+
+	std::set<std::filesystem::path> visited = { path };
+	return HashSourceRecursive(FNV_OFFSET_BASIS, path, visited);
+}
+
+void env::ShaderCache::SetReadEnabled(bool isEnabled)
+{
+	m_isReadEnabled = isEnabled;
+}
+
+bool env::ShaderCache::IsReadEnabled() const
+{
+	return m_isReadEnabled;
+}
+
+bool env::ShaderCache::Read(ShaderCacheEntry entry, uint64_t key, std::vector<uint8_t>& data)
+{
+	assert(entry < ShaderCacheEntry::COUNT);
+	ShaderCacheCounters& counters = m_statistics.Entries[(uint32_t)entry];
+
+	bool isValid = false;
+	if (m_isReadEnabled) {
+		std::string entryPath = GetEntryPath(entry, key);
+		std::ifstream file(entryPath, std::ios::binary);
+
+		// The data is the rest of the file, so a truncated or damaged entry
+		// is a miss before anything is allocated for it
+		std::error_code error;
+		uint64_t fileSize = (uint64_t)std::filesystem::file_size(entryPath, error);
+
+		Header header;
+		if (file && !error && file.read((char*)&header, sizeof(Header))) {
+			isValid = memcmp(header.Magic, MAGIC, sizeof(MAGIC)) == 0 &&
+				header.Version == VERSION &&
+				header.Entry == (uint32_t)entry &&
+				header.Key == key &&
+				header.NumBytes == fileSize - sizeof(Header);
+
+			if (isValid) {
+				data.resize((size_t)header.NumBytes);
+				isValid = file.read((char*)data.data(), data.size()) &&
+					HashBytes(FNV_OFFSET_BASIS, data.data(), data.size()) == header.DataHash;
+			}
+		}
+	}
+
+	if (isValid)
+		counters.NumHits++;
+	else {
+		counters.NumMisses++;
+		data.clear();
+	}
+	return isValid;
+}
+
+bool env::ShaderCache::Write(ShaderCacheEntry entry, uint64_t key, const void* data, size_t numBytes)
+{
+	assert(entry < ShaderCacheEntry::COUNT);
+
+	Header header = {};
+	memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+	header.Version = VERSION;
+	header.Entry = (uint32_t)entry;
+	header.Key = key;
+	header.NumBytes = numBytes;
+	header.DataHash = HashBytes(FNV_OFFSET_BASIS, data, numBytes);
+
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+
+	// Written to a temporary file first so a failed write never leaves an
+	// entry that looks valid
+	std::string entryPath = GetEntryPath(entry, key);
+	std::string temporaryPath = entryPath + ".tmp";
+	bool isWritten = false;
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (file) {
+			file.write((const char*)&header, sizeof(Header));
+			file.write((const char*)data, numBytes);
+			isWritten = (bool)file;
+		}
+	}
+
+	if (isWritten) {
+		std::filesystem::rename(temporaryPath, entryPath, error);
+		isWritten = !error;
+	}
+
+	if (isWritten)
+		m_statistics.NumWrites++;
+	else {
+		m_statistics.NumFailedWrites++;
+		std::filesystem::remove(temporaryPath, error);
+	}
+	return isWritten;
+}
+
+void env::ShaderCache::Reject(ShaderCacheEntry entry)
+{
+	assert(entry < ShaderCacheEntry::COUNT);
+	ShaderCacheCounters& counters = m_statistics.Entries[(uint32_t)entry];
+
+	assert(counters.NumHits > 0);
+	counters.NumHits--;
+	counters.NumMisses++;
+	counters.NumRejected++;
+}
+
+std::string env::ShaderCache::GetEntryPath(ShaderCacheEntry entry, uint64_t key) const
+{
+	static const char* EXTENSIONS[] = { ".envshader", ".envroot", ".envpipeline" };
+	static_assert(sizeof(EXTENSIONS) / sizeof(EXTENSIONS[0]) == (size_t)ShaderCacheEntry::COUNT, "An extension per entry type");
+
+	char name[17];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+
+	return (std::filesystem::path(m_directory) / name).string() + EXTENSIONS[(uint32_t)entry];
+}
+
+const env::ShaderCacheStatistics& env::ShaderCache::GetStatistics() const
+{
+	return m_statistics;
+}
@@ -4,6 +4,7 @@
 env::Transform::Transform() :
 	m_matrix(Float4x4::Identity),
 	m_dirty(true),
+	m_changed(true),
 	m_position(Float3::Zero),
 	m_rotation(Quaternion::Identity),
 	m_scale(Float3::One)
@@ -14,6 +15,7 @@ env::Transform::Transform() :
 env::Transform::Transform(const Float4x4& matrix) :
 	m_matrix(Float4x4::Identity),
 	m_dirty(true),
+	m_changed(true),
 	m_position(Float3::Zero),
 	m_rotation(Quaternion::Identity),
 	m_scale(Float3::One)
@@ -37,12 +39,14 @@ void env::Transform::SetPosition(const Float3& position)
 {
 	m_position = position;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::Translate(const Float3& offset)
 {
 	m_position += offset;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::TranslateRight(float distance)
@@ -50,6 +54,7 @@ void env::Transform::TranslateRight(float distance)
 	Float3 right = GetRight();
 	m_position += right * distance;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::TranslateUp(float distance)
@@ -57,6 +62,7 @@ void env::Transform::TranslateUp(float distance)
 	Float3 up = GetUp();
 	m_position += up * distance;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::TranslateForward(float distance)
@@ -64,6 +70,7 @@ void env::Transform::TranslateForward(float distance)
 	Float3 forward = GetForward();
 	m_position += forward * distance;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::TranslateDirection(const Float3& direction, float distance)
@@ -72,6 +79,7 @@ void env::Transform::TranslateDirection(const Float3& direction, float distance)
 	directionNormalized.Normalize();
 	m_position += directionNormalized * distance;
 	m_dirty = true;
+	m_changed = true;
 }
 
 const Float3& env::Transform::GetPosition()
@@ -88,12 +96,14 @@ void env::Transform::SetRotation(const Quaternion& rotation)
 {
 	m_rotation = rotation;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::Rotate(const Quaternion& offset)
 {
 	m_rotation *= offset;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateRoll(float radians)
@@ -101,6 +111,7 @@ void env::Transform::RotateRoll(float radians)
 	Quaternion roll = DirectX::XMQuaternionRotationAxis(GetForward(), radians);
 	m_rotation *= roll;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotatePitch(float radians)
@@ -108,6 +119,7 @@ void env::Transform::RotatePitch(float radians)
 	Quaternion pitch = DirectX::XMQuaternionRotationAxis(GetRight(), radians);
 	m_rotation *= pitch;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateYaw(float radians)
@@ -115,6 +127,7 @@ void env::Transform::RotateYaw(float radians)
 	Quaternion yaw = DirectX::XMQuaternionRotationAxis(GetUp(), radians);
 	m_rotation *= yaw;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateRollPitchYaw(float roll, float pitch, float yaw)
@@ -125,26 +138,39 @@ void env::Transform::RotateRollPitchYaw(float roll, float pitch, float yaw)
 	m_rotation *= qRoll * qYaw * qPitch;
 
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateAxisX(float radians)
 {
 	m_rotation *= DirectX::XMQuaternionRotationAxis({ 1.0f, 0.0f, 0.0f }, radians);
+
+	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateAxisY(float radians)
 {
 	m_rotation *= DirectX::XMQuaternionRotationAxis({ 0.0f, 1.0f, 0.0f }, radians);
+
+	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateAxisZ(float radians)
 {
 	m_rotation *= DirectX::XMQuaternionRotationAxis({ 0.0f, 0.0f, 1.0f }, radians);
+
+	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::RotateAxisXYZ(float x, float y, float z)
 {
 	m_rotation *= DirectX::XMQuaternionRotationRollPitchYaw(x, y, z);
+
+	m_dirty = true;
+	m_changed = true;
 }
 
 const Quaternion& env::Transform::GetRotation()
@@ -180,16 +206,21 @@ void env::Transform::SetScale(const Float3& scale)
 {
 	m_scale = scale;
 	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::Scale(const Float3& factors)
 {
 	m_scale = DirectX::XMVectorMultiply(m_scale, factors);
+	m_dirty = true;
+	m_changed = true;
 }
 
 void env::Transform::Scale(float factor)
 {
 	m_scale *= factor;
+	m_dirty = true;
+	m_changed = true;
 }
 
 const Float3& env::Transform::GetScale()
@@ -234,3 +265,13 @@ Float4x4 env::Transform::GetMatrixTransposed()
 	Float4x4 transposed = GetMatrix();
 	return transposed.Transpose();
 }
+
+bool env::Transform::HasChanged() const
+{
+	return m_changed;
+}
+
+void env::Transform::ClearChanged()
+{
+	m_changed = false;
+}
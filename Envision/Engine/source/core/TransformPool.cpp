@@ -0,0 +1,297 @@
+#include "envision/core/TransformPool.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <xmmintrin.h>
+
+void env::ComposeWorldMatrices(const TransformArrays& t, size_t count, float* matrices)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 x = _mm_load_ps(t.RotationsX + i);
+		const __m128 y = _mm_load_ps(t.RotationsY + i);
+		const __m128 z = _mm_load_ps(t.RotationsZ + i);
+		const __m128 w = _mm_load_ps(t.RotationsW + i);
+
+		const __m128 x2 = _mm_mul_ps(x, two);
+		const __m128 y2 = _mm_mul_ps(y, two);
+		const __m128 z2 = _mm_mul_ps(z, two);
+
+		const __m128 xx = _mm_mul_ps(x, x2);
+		const __m128 yy = _mm_mul_ps(y, y2);
+		const __m128 zz = _mm_mul_ps(z, z2);
+		const __m128 xy = _mm_mul_ps(x, y2);
+		const __m128 xz = _mm_mul_ps(x, z2);
+		const __m128 yz = _mm_mul_ps(y, z2);
+		const __m128 wx = _mm_mul_ps(w, x2);
+		const __m128 wy = _mm_mul_ps(w, y2);
+		const __m128 wz = _mm_mul_ps(w, z2);
+
+		const __m128 scaleX = _mm_load_ps(t.ScalesX + i);
+		const __m128 scaleY = _mm_load_ps(t.ScalesY + i);
+		const __m128 scaleZ = _mm_load_ps(t.ScalesZ + i);
+
+		// Rotation rows scaled by the scale of that axis, one lane per matrix
+		__m128 m00 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX);
+		__m128 m01 = _mm_mul_ps(_mm_add_ps(xy, wz), scaleX);
+		__m128 m02 = _mm_mul_ps(_mm_sub_ps(xz, wy), scaleX);
+		__m128 m03 = zero;
+
+		__m128 m10 = _mm_mul_ps(_mm_sub_ps(xy, wz), scaleY);
+		__m128 m11 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY);
+		__m128 m12 = _mm_mul_ps(_mm_add_ps(yz, wx), scaleY);
+		__m128 m13 = zero;
+
+		__m128 m20 = _mm_mul_ps(_mm_add_ps(xz, wy), scaleZ);
+		__m128 m21 = _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ);
+		__m128 m22 = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ);
+		__m128 m23 = zero;
+
+		__m128 m30 = _mm_load_ps(t.PositionsX + i);
+		__m128 m31 = _mm_load_ps(t.PositionsY + i);
+		__m128 m32 = _mm_load_ps(t.PositionsZ + i);
+		__m128 m33 = one;
+
+		// Turn each row from one lane per matrix into one register per matrix
+		_MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+		_MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+		_MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+		_MM_TRANSPOSE4_PS(m30, m31, m32, m33);
+
+		float* out = matrices + i * 16;
+		_mm_storeu_ps(out + 0, m00);
+		_mm_storeu_ps(out + 4, m10);
+		_mm_storeu_ps(out + 8, m20);
+		_mm_storeu_ps(out + 12, m30);
+		_mm_storeu_ps(out + 16, m01);
+		_mm_storeu_ps(out + 20, m11);
+		_mm_storeu_ps(out + 24, m21);
+		_mm_storeu_ps(out + 28, m31);
+		_mm_storeu_ps(out + 32, m02);
+		_mm_storeu_ps(out + 36, m12);
+		_mm_storeu_ps(out + 40, m22);
+		_mm_storeu_ps(out + 44, m32);
+		_mm_storeu_ps(out + 48, m03);
+		_mm_storeu_ps(out + 52, m13);
+		_mm_storeu_ps(out + 56, m23);
+		_mm_storeu_ps(out + 60, m33);
+	}
+
+	for (; i < count; i++)
+		ComposeWorldMatrix(t, i, matrices + i * 16);
+}
+
+void env::ComposeWorldMatrix(const TransformArrays& t, size_t index, float* matrix)
+{
+	const float x = t.RotationsX[index];
+	const float y = t.RotationsY[index];
+	const float z = t.RotationsZ[index];
+	const float w = t.RotationsW[index];
+
+	const float xx = x * x * 2.0f, yy = y * y * 2.0f, zz = z * z * 2.0f;
+	const float xy = x * y * 2.0f, xz = x * z * 2.0f, yz = y * z * 2.0f;
+	const float wx = w * x * 2.0f, wy = w * y * 2.0f, wz = w * z * 2.0f;
+
+	const float scaleX = t.ScalesX[index];
+	const float scaleY = t.ScalesY[index];
+	const float scaleZ = t.ScalesZ[index];
+
+	matrix[0] = (1.0f - (yy + zz)) * scaleX;
+	matrix[1] = (xy + wz) * scaleX;
+	matrix[2] = (xz - wy) * scaleX;
+	matrix[3] = 0.0f;
+
+	matrix[4] = (xy - wz) * scaleY;
+	matrix[5] = (1.0f - (xx + zz)) * scaleY;
+	matrix[6] = (yz + wx) * scaleY;
+	matrix[7] = 0.0f;
+
+	matrix[8] = (xz + wy) * scaleZ;
+	matrix[9] = (yz - wx) * scaleZ;
+	matrix[10] = (1.0f - (xx + yy)) * scaleZ;
+	matrix[11] = 0.0f;
+
+	matrix[12] = t.PositionsX[index];
+	matrix[13] = t.PositionsY[index];
+	matrix[14] = t.PositionsZ[index];
+	matrix[15] = 1.0f;
+}
+
+env::TransformPool::TransformPool() :
+	m_matrices(nullptr),
+	m_size(0),
+	m_capacity(0),
+	m_changed(false)
+{
+	for (float*& stream : m_streams)
+		stream = nullptr;
+}
+
+env::TransformPool::~TransformPool()
+{
+	for (float* stream : m_streams)
+		_mm_free(stream);
+	_mm_free(m_matrices);
+}
+
+void env::TransformPool::Reserve(size_t capacity)
+{
+	if (capacity <= m_capacity)
+		return;
+
+	// Whole groups of four, so the last group is always inside the arrays
+	capacity = (capacity + 3) & ~size_t(3);
+
+	for (float*& stream : m_streams) {
+		float* grown = (float*)_mm_malloc(capacity * sizeof(float), 16);
+		if (stream) {
+			memcpy(grown, stream, m_size * sizeof(float));
+			_mm_free(stream);
+		}
+		stream = grown;
+	}
+
+	float* grownMatrices = (float*)_mm_malloc(capacity * 16 * sizeof(float), 16);
+	if (m_matrices) {
+		memcpy(grownMatrices, m_matrices, m_size * 16 * sizeof(float));
+		_mm_free(m_matrices);
+	}
+	m_matrices = grownMatrices;
+
+	m_owners.reserve(capacity);
+	m_capacity = capacity;
+}
+
+void env::TransformPool::Clear()
+{
+	m_size = 0;
+	m_owners.clear();
+	m_changed = false;
+}
+
+uint32_t env::TransformPool::Add(uint64_t owner)
+{
+	if (m_size == m_capacity)
+		Reserve(std::max<size_t>(64, m_capacity * 2));
+
+	uint32_t index = (uint32_t)m_size++;
+	m_owners.push_back(owner);
+
+	SetPosition(index, 0.0f, 0.0f, 0.0f);
+	SetRotation(index, 0.0f, 0.0f, 0.0f, 1.0f);
+	SetScale(index, 1.0f, 1.0f, 1.0f);
+
+	return index;
+}
+
+uint64_t env::TransformPool::Remove(uint32_t index)
+{
+	assert(index < m_size);
+
+	size_t last = m_size - 1;
+	if (index != last) {
+		for (float* stream : m_streams)
+			stream[index] = stream[last];
+		memcpy(m_matrices + index * 16, m_matrices + last * 16, 16 * sizeof(float));
+		m_owners[index] = m_owners[last];
+	}
+
+	uint64_t moved = m_owners[index];
+	m_owners.pop_back();
+	m_size--;
+
+	return moved;
+}
+
+void env::TransformPool::SetPosition(uint32_t index, float x, float y, float z)
+{
+	assert(index < m_size);
+	m_streams[POSITION_X][index] = x;
+	m_streams[POSITION_Y][index] = y;
+	m_streams[POSITION_Z][index] = z;
+	m_changed = true;
+}
+
+void env::TransformPool::SetRotation(uint32_t index, float x, float y, float z, float w)
+{
+	assert(index < m_size);
+	m_streams[ROTATION_X][index] = x;
+	m_streams[ROTATION_Y][index] = y;
+	m_streams[ROTATION_Z][index] = z;
+	m_streams[ROTATION_W][index] = w;
+	m_changed = true;
+}
+
+void env::TransformPool::SetScale(uint32_t index, float x, float y, float z)
+{
+	assert(index < m_size);
+	m_streams[SCALE_X][index] = x;
+	m_streams[SCALE_Y][index] = y;
+	m_streams[SCALE_Z][index] = z;
+	m_changed = true;
+}
+
+void env::TransformPool::GetPosition(uint32_t index, float* xyz) const
+{
+	assert(index < m_size);
+	xyz[0] = m_streams[POSITION_X][index];
+	xyz[1] = m_streams[POSITION_Y][index];
+	xyz[2] = m_streams[POSITION_Z][index];
+}
+
+void env::TransformPool::GetRotation(uint32_t index, float* xyzw) const
+{
+	assert(index < m_size);
+	xyzw[0] = m_streams[ROTATION_X][index];
+	xyzw[1] = m_streams[ROTATION_Y][index];
+	xyzw[2] = m_streams[ROTATION_Z][index];
+	xyzw[3] = m_streams[ROTATION_W][index];
+}
+
+void env::TransformPool::GetScale(uint32_t index, float* xyz) const
+{
+	assert(index < m_size);
+	xyz[0] = m_streams[SCALE_X][index];
+	xyz[1] = m_streams[SCALE_Y][index];
+	xyz[2] = m_streams[SCALE_Z][index];
+}
+
+void env::TransformPool::ComposeWorldMatrices()
+{
+	env::ComposeWorldMatrices(GetArrays(), m_size, m_matrices);
+	m_changed = false;
+}
+
+bool env::TransformPool::HasChanged() const
+{
+	return m_changed;
+}
+
+const float* env::TransformPool::GetWorldMatrix(uint32_t index) const
+{
+	assert(index < m_size);
+	return m_matrices + index * 16;
+}
+
+uint64_t env::TransformPool::GetOwner(uint32_t index) const
+{
+	assert(index < m_size);
+	return m_owners[index];
+}
+
+size_t env::TransformPool::GetSize() const
+{
+	return m_size;
+}
+
+env::TransformArrays env::TransformPool::GetArrays() const
+{
+	return {
+		m_streams[POSITION_X], m_streams[POSITION_Y], m_streams[POSITION_Z],
+		m_streams[ROTATION_X], m_streams[ROTATION_Y], m_streams[ROTATION_Z], m_streams[ROTATION_W],
+		m_streams[SCALE_X], m_streams[SCALE_Y], m_streams[SCALE_Z] };
+}
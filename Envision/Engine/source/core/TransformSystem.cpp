@@ -0,0 +1,171 @@
+#include "envision/envpch.h"
+#include "envision/core/TransformSystem.h"
+
+env::TransformSystem::TransformSystem() :
+	System("TransformSystem"),
+	m_hierarchyVersion(0),
+	m_updateAll(true),
+	m_numUpdated(0),
+	m_updateTime(0.f)
+{
+	DeclareReads<ParentComponent, PooledTransformComponent, RenderComponent>();
+	DeclareWrites<TransformComponent, WorldTransformComponent, TransformPool, SceneBVH>();
+}
+
+void env::TransformSystem::RebuildOrder(Scene& scene)
+{
+	auto view = scene.View<TransformComponent>();
+
+	// Depth of each entity, found by walking up until an entity with a known
+	// depth or a root. Entities whose parent is gone or has no transform are
+	// treated as roots.
+	std::unordered_map<ID, uint32_t> depths;
+	depths.reserve(view.size());
+
+	uint32_t maxDepth = 0;
+	std::vector<ID> chain;
+	for (entt::entity entity : view) {
+		chain.clear();
+
+		ID current = (ID)entity;
+		uint32_t depth = 0;
+		while (true) {
+			auto known = depths.find(current);
+			if (known != depths.end()) {
+				depth = known->second + 1;
+				break;
+			}
+
+			chain.push_back(current);
+
+			if (!scene.HasComponent<ParentComponent>(current))
+				break;
+
+			ID parent = scene.GetComponent<ParentComponent>(current).Parent;
+			if (!scene.IsEntity(parent) || !view.contains((entt::entity)parent))
+				break;
+
+			current = parent;
+		}
+
+		// The chain goes from the entity up, the last one gets the found depth
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			depths[*it] = depth++;
+
+		if (!chain.empty())
+			maxDepth = std::max(maxDepth, depth - 1);
+	}
+
+	// Counting sort on depth, keeps the view order within each depth
+	std::vector<uint32_t> depthOffsets(maxDepth + 2, 0);
+	for (auto& [entity, depth] : depths)
+		depthOffsets[depth + 1]++;
+	for (size_t i = 1; i < depthOffsets.size(); i++)
+		depthOffsets[i] += depthOffsets[i - 1];
+
+	m_nodes.resize(depths.size());
+	for (entt::entity entity : view) {
+		uint32_t& depth = depths[(ID)entity];
+		uint32_t nodeIndex = depthOffsets[depth]++;
+		m_nodes[nodeIndex] = { (ID)entity, NO_PARENT };
+
+		// The map is reused as entity to node index from here on
+		depth = nodeIndex;
+	}
+
+	for (Node& node : m_nodes) {
+		if (scene.HasComponent<ParentComponent>(node.Entity)) {
+			auto parent = depths.find(scene.GetComponent<ParentComponent>(node.Entity).Parent);
+			if (parent != depths.end())
+				node.Parent = parent->second;
+		}
+
+		if (!scene.HasComponent<WorldTransformComponent>(node.Entity))
+			scene.SetComponent<WorldTransformComponent>(node.Entity, WorldTransformComponent());
+	}
+
+	m_worldMatrices.resize(m_nodes.size());
+	m_updated.resize(m_nodes.size());
+
+	m_hierarchyVersion = scene.GetHierarchyVersion();
+	m_updateAll = true;
+}
+
+void env::TransformSystem::OnAttach(Scene& scene)
+{
+	RebuildOrder(scene);
+}
+
+void env::TransformSystem::OnUpdate(Scene& scene, const Duration& delta)
+{
+	Update(scene);
+}
+
+void env::TransformSystem::Update(Scene& scene)
+{
+	Timepoint updateBegin = Time::Now();
+
+	if (scene.GetHierarchyVersion() != m_hierarchyVersion)
+		RebuildOrder(scene);
+
+	m_numUpdated = 0;
+
+	for (size_t i = 0; i < m_nodes.size(); i++) {
+		const Node& node = m_nodes[i];
+		Transform& transform = scene.GetComponent<TransformComponent>(node.Entity).Transformation;
+
+		bool parentUpdated = node.Parent != NO_PARENT && m_updated[node.Parent];
+		m_updated[i] = m_updateAll || parentUpdated || transform.HasChanged();
+		if (!m_updated[i])
+			continue;
+
+		Float4x4 world = transform.GetMatrix();
+		if (node.Parent != NO_PARENT)
+			world *= m_worldMatrices[node.Parent];
+
+		m_worldMatrices[i] = world;
+		scene.GetComponent<WorldTransformComponent>(node.Entity).Matrix = world;
+		transform.ClearChanged();
+
+		scene.UpdateBVH(node.Entity);
+		m_numUpdated++;
+	}
+
+	// Pooled transforms have no parent, the whole pool is rebuilt in one
+	// batch when any of them changed
+	TransformPool& pool = scene.GetTransformPool();
+	if (pool.HasChanged() || m_updateAll) {
+		pool.ComposeWorldMatrices();
+
+		for (uint32_t i = 0; i < (uint32_t)pool.GetSize(); i++) {
+			ID entity = (ID)pool.GetOwner(i);
+			memcpy(&scene.GetComponent<WorldTransformComponent>(entity).Matrix, pool.GetWorldMatrix(i), sizeof(Float4x4));
+			scene.UpdateBVH(entity);
+		}
+		m_numUpdated += (UINT)pool.GetSize();
+	}
+
+	// Finished loads change the mesh bounds without moving anything
+	UINT numBoundsChanged = scene.UpdateBVHOfChangedMeshes();
+
+	if (m_numUpdated > 0 || numBoundsChanged > 0)
+		scene.RefitBVH();
+
+	m_updateAll = false;
+	m_updateTime = (Time::Now() - updateBegin).InSeconds();
+}
+
+UINT env::TransformSystem::GetNumNodes() const
+{
+	return (UINT)m_nodes.size();
+}
+
+UINT env::TransformSystem::GetNumUpdated() const
+{
+	return m_numUpdated;
+}
+
+float env::TransformSystem::GetUpdateTime() const
+{
+	return m_updateTime;
+}
@@ -0,0 +1,286 @@
+#include "envision/core/VertexPacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace
+{
+	// Float bit patterns used by the half conversion
+	const uint32_t FLOAT_INFINITY = 255u << 23;
+	const uint32_t HALF_OVERFLOW = (127u + 16u) << 23; // Smallest float that becomes infinity
+	const uint32_t HALF_MIN_NORMAL = 113u << 23; // Smallest float that is a normal half
+	const uint32_t HALF_DENORMAL_MAGIC = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+	const uint32_t HALF_EXPONENT_ADJUST = ((uint32_t)(15 - 127) << 23) + 0xfff; // Rebias, plus most of the rounding
+
+	// Smallest sum of the normal components that is divided by
+	const float MIN_NORMAL_SUM = 1e-30f;
+
+	uint32_t GetBits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	float FromBits(uint32_t bits)
+	{
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	const float* GetFloats(const void* base, size_t stride, size_t index)
+	{
+		return (const float*)((const char*)base + index * stride);
+	}
+
+	char* GetElement(void* base, size_t stride, size_t index)
+	{
+		return (char*)base + index * stride;
+	}
+
+	// Component i of four elements in one register
+	__m128 LoadComponent(const void* base, size_t stride, size_t first, int i)
+	{
+		return _mm_setr_ps(
+			GetFloats(base, stride, first)[i],
+			GetFloats(base, stride, first + 1)[i],
+			GetFloats(base, stride, first + 2)[i],
+			GetFloats(base, stride, first + 3)[i]);
+	}
+
+	// Writes each 32 bit lane to its own element
+	void StoreLanes(__m128i lanes, void* destination, size_t destinationStride, size_t first)
+	{
+		alignas(16) uint32_t values[4];
+		_mm_store_si128((__m128i*)values, lanes);
+		for (size_t i = 0; i < 4; i++)
+			memcpy(GetElement(destination, destinationStride, first + i), &values[i], sizeof(uint32_t));
+	}
+
+	// Clamps like FloatToSnorm16, NaN becomes -1 in both
+	__m128i ToSnorm16(__m128 value)
+	{
+		value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.f)), _mm_set1_ps(1.f));
+		return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(32767.f)));
+	}
+
+	// Both branches of FloatToHalf are computed and selected per lane
+	__m128i ToHalf(__m128 value)
+	{
+		const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+
+		__m128i bits = _mm_castps_si128(value);
+		__m128i sign = _mm_and_si128(bits, signMask);
+		bits = _mm_xor_si128(bits, sign);
+
+		__m128i denormal = _mm_sub_epi32(
+			_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(_mm_set1_epi32((int)HALF_DENORMAL_MAGIC)))),
+			_mm_set1_epi32((int)HALF_DENORMAL_MAGIC));
+
+		__m128i isOdd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+		__m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32((int)HALF_EXPONENT_ADJUST)), isOdd), 13);
+
+		__m128i isNaN = _mm_cmpgt_epi32(bits, _mm_set1_epi32((int)FLOAT_INFINITY));
+		__m128i special = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(isNaN, _mm_set1_epi32(0x0200)));
+
+		// The sign is cleared, so the signed compares work on the bit patterns
+		__m128i isDenormal = _mm_cmpgt_epi32(_mm_set1_epi32((int)HALF_MIN_NORMAL), bits);
+		__m128i isSpecial = _mm_cmpgt_epi32(bits, _mm_set1_epi32((int)HALF_OVERFLOW - 1));
+
+		__m128i result = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, normal));
+		result = _mm_or_si128(_mm_and_si128(isSpecial, special), _mm_andnot_si128(isSpecial, result));
+		return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+	}
+
+	// Low 16 bits of a and b, a in the low half of each lane
+	__m128i Interleave16(__m128i a, __m128i b)
+	{
+		return _mm_or_si128(_mm_and_si128(a, _mm_set1_epi32(0xffff)), _mm_slli_epi32(b, 16));
+	}
+
+	__m128 Abs(__m128 value)
+	{
+		return _mm_andnot_ps(_mm_set1_ps(-0.f), value);
+	}
+
+	// One with the sign of the value, like std::copysign(1, value)
+	__m128 Sign(__m128 value)
+	{
+		return _mm_or_ps(_mm_and_ps(value, _mm_set1_ps(-0.f)), _mm_set1_ps(1.f));
+	}
+}
+
+uint16_t env::FloatToHalf(float value)
+{
+	uint32_t bits = GetBits(value);
+	uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint32_t half = 0;
+	if (bits >= HALF_OVERFLOW) {
+		half = (bits > FLOAT_INFINITY) ? 0x7e00 : 0x7c00;
+	}
+	else if (bits < HALF_MIN_NORMAL) {
+		// Adding the magic value lines the mantissa up at the bottom, the
+		// float addition does the rounding
+		half = GetBits(FromBits(bits) + FromBits(HALF_DENORMAL_MAGIC)) - HALF_DENORMAL_MAGIC;
+	}
+	else {
+		uint32_t isOdd = (bits >> 13) & 1;
+		half = (bits + HALF_EXPONENT_ADJUST + isOdd) >> 13;
+	}
+
+	return (uint16_t)(half | (sign >> 16));
+}
+
+float env::HalfToFloat(uint16_t value)
+{
+	const uint32_t shiftedExponent = 0x7c00u << 13;
+
+	uint32_t bits = (value & 0x7fffu) << 13;
+	uint32_t exponent = bits & shiftedExponent;
+	bits += (127u - 15u) << 23;
+
+	if (exponent == shiftedExponent) {
+		bits += (128u - 16u) << 23; // Infinity or NaN
+	}
+	else if (exponent == 0) {
+		bits = GetBits(FromBits(bits + (1u << 23)) - FromBits(113u << 23)); // Zero or denormal
+	}
+
+	return FromBits(bits | ((uint32_t)(value & 0x8000u) << 16));
+}
+
+int16_t env::FloatToSnorm16(float value)
+{
+	value = (value > -1.f) ? value : -1.f;
+	value = (value < 1.f) ? value : 1.f;
+	return (int16_t)std::lrint(value * 32767.f);
+}
+
+void env::EncodeOctahedral(const float* normal, int16_t* encoded)
+{
+	float sum = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+	float scale = 1.f / ((sum > MIN_NORMAL_SUM) ? sum : MIN_NORMAL_SUM);
+
+	float x = normal[0] * scale;
+	float y = normal[1] * scale;
+	float z = normal[2] * scale;
+
+	// The lower half is folded over the diagonals
+	if (z < 0.f) {
+		float foldedX = (1.f - std::abs(y)) * std::copysign(1.f, x);
+		float foldedY = (1.f - std::abs(x)) * std::copysign(1.f, y);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = FloatToSnorm16(x);
+	encoded[1] = FloatToSnorm16(y);
+}
+
+void env::DecodeOctahedral(const int16_t* encoded, float* normal)
+{
+	float x = std::max(encoded[0] / 32767.f, -1.f);
+	float y = std::max(encoded[1] / 32767.f, -1.f);
+	float z = 1.f - std::abs(x) - std::abs(y);
+
+	float fold = std::max(-z, 0.f);
+	x += (x >= 0.f) ? -fold : fold;
+	y += (y >= 0.f) ? -fold : fold;
+
+	float length = std::sqrt(x * x + y * y + z * z);
+	float scale = (length > 0.f) ? 1.f / length : 0.f;
+	normal[0] = x * scale;
+	normal[1] = y * scale;
+	normal[2] = z * scale;
+}
+
+void env::PackPositions(const void* positions, size_t positionStride, size_t count,
+	const float* center, const float* extents,
+	void* destination, size_t destinationStride)
+{
+	// A flat axis has every value at the center
+	float scale[3];
+	for (int i = 0; i < 3; i++)
+		scale[i] = (extents[i] > 0.f) ? 1.f / extents[i] : 0.f;
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = ToSnorm16(_mm_mul_ps(_mm_sub_ps(LoadComponent(positions, positionStride, i, 0), _mm_set1_ps(center[0])), _mm_set1_ps(scale[0])));
+		__m128i y = ToSnorm16(_mm_mul_ps(_mm_sub_ps(LoadComponent(positions, positionStride, i, 1), _mm_set1_ps(center[1])), _mm_set1_ps(scale[1])));
+		__m128i z = ToSnorm16(_mm_mul_ps(_mm_sub_ps(LoadComponent(positions, positionStride, i, 2), _mm_set1_ps(center[2])), _mm_set1_ps(scale[2])));
+
+		// xy and z0 of each element, eight bytes each
+		__m128i xy = Interleave16(x, y);
+		__m128i zw = _mm_and_si128(z, _mm_set1_epi32(0xffff));
+		__m128i low = _mm_unpacklo_epi32(xy, zw);
+		__m128i high = _mm_unpackhi_epi32(xy, zw);
+
+		alignas(16) uint64_t values[4];
+		_mm_store_si128((__m128i*)&values[0], low);
+		_mm_store_si128((__m128i*)&values[2], high);
+		for (size_t k = 0; k < 4; k++)
+			memcpy(GetElement(destination, destinationStride, i + k), &values[k], sizeof(uint64_t));
+	}
+
+	for (; i < count; i++) {
+		const float* position = GetFloats(positions, positionStride, i);
+		int16_t packed[4] = {
+			FloatToSnorm16((position[0] - center[0]) * scale[0]),
+			FloatToSnorm16((position[1] - center[1]) * scale[1]),
+			FloatToSnorm16((position[2] - center[2]) * scale[2]),
+			0 };
+		memcpy(GetElement(destination, destinationStride, i), packed, sizeof(packed));
+	}
+}
+
+void env::PackOctahedralNormals(const void* normals, size_t normalStride, size_t count,
+	void* destination, size_t destinationStride)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = LoadComponent(normals, normalStride, i, 0);
+		__m128 y = LoadComponent(normals, normalStride, i, 1);
+		__m128 z = LoadComponent(normals, normalStride, i, 2);
+
+		__m128 sum = _mm_add_ps(_mm_add_ps(Abs(x), Abs(y)), Abs(z));
+		__m128 scale = _mm_div_ps(_mm_set1_ps(1.f), _mm_max_ps(sum, _mm_set1_ps(MIN_NORMAL_SUM)));
+		x = _mm_mul_ps(x, scale);
+		y = _mm_mul_ps(y, scale);
+		z = _mm_mul_ps(z, scale);
+
+		__m128 foldedX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), Abs(y)), Sign(x));
+		__m128 foldedY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.f), Abs(x)), Sign(y));
+		__m128 isLower = _mm_cmplt_ps(z, _mm_setzero_ps());
+		x = _mm_or_ps(_mm_and_ps(isLower, foldedX), _mm_andnot_ps(isLower, x));
+		y = _mm_or_ps(_mm_and_ps(isLower, foldedY), _mm_andnot_ps(isLower, y));
+
+		StoreLanes(Interleave16(ToSnorm16(x), ToSnorm16(y)), destination, destinationStride, i);
+	}
+
+	for (; i < count; i++) {
+		int16_t packed[2];
+		EncodeOctahedral(GetFloats(normals, normalStride, i), packed);
+		memcpy(GetElement(destination, destinationStride, i), packed, sizeof(packed));
+	}
+}
+
+void env::PackHalf2(const void* values, size_t valueStride, size_t count,
+	void* destination, size_t destinationStride)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128i x = ToHalf(LoadComponent(values, valueStride, i, 0));
+		__m128i y = ToHalf(LoadComponent(values, valueStride, i, 1));
+		StoreLanes(Interleave16(x, y), destination, destinationStride, i);
+	}
+
+	for (; i < count; i++) {
+		const float* value = GetFloats(values, valueStride, i);
+		uint16_t packed[2] = { FloatToHalf(value[0]), FloatToHalf(value[1]) };
+		memcpy(GetElement(destination, destinationStride, i), packed, sizeof(packed));
+	}
+}
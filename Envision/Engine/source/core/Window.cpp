@@ -7,6 +7,7 @@
 #include "envision/core/GPU.h"
 #include "envision/resource/ResourceManager.h"
 
+#ifdef PLATFORM_DIRECT3D_12
 WNDCLASS env::Window::s_windowClass = { 0 };
 const WCHAR* env::Window::s_WINDOW_CLASS_NAME = L"ENV_WINDOW_CLASS";
 
@@ -147,10 +148,15 @@ env::Window* env::Window::GetWindowObject(HWND handle)
 {
 	return (Window*)GetWindowLongPtrA(handle, GWLP_USERDATA);
 }
+#endif
 
 env::Window::Window(int width, int height, const std::string& title, Application& application) :
 	m_application(application)
 {
+#ifdef PLATFORM_NULL
+	m_width = width;
+	m_height = height;
+#else
 	{ // Init Win32
 		if (!s_windowClass.lpfnWndProc)
 		{
@@ -177,6 +183,7 @@ env::Window::Window(int width, int height, const std::string& title, Application
 		SetWindowObject(m_handle, this);
 		ShowWindow(m_handle, SW_SHOW);
 	}
+#endif
 
 	HRESULT hr = S_OK;
 
@@ -242,27 +249,39 @@ HWND env::Window::GetHandle()
 
 int env::Window::GetWidth() const
 {
+#ifdef PLATFORM_NULL
+	return m_width;
+#else
 	RECT rect;
 	GetWindowRect(m_handle, &rect);
 	int width = (int)(rect.right - rect.left);
 	return width;
+#endif
 }
 
 int env::Window::GetHeight() const
 {
+#ifdef PLATFORM_NULL
+	return m_height;
+#else
 	RECT rect;
 	GetWindowRect(m_handle, &rect);
 	int height = (int)(rect.bottom - rect.top);
 	return height;
+#endif
 }
 
 float env::Window::GetAspectRatio()
 {
+#ifdef PLATFORM_NULL
+	return (float)m_width / (float)m_height;
+#else
 	RECT rect;
 	GetWindowRect(m_handle, &rect);
 	float height = (float)(rect.bottom - rect.top);
 	float width = (float)(rect.right - rect.left);
 	return width / height;
+#endif
 }
 
 env::Texture2D* env::Window::GetCurrentBackbuffer()
@@ -284,7 +303,7 @@ void env::Window::PushTarget(WindowTarget* target)
 {
 	Texture2D* backbuffer = m_backbuffers[m_currentBackbufferindex];
 	target->Native = backbuffer->Native;
-	target->Views.RenderTarget = backbuffer->Views.RenderTarget;
+	target->Views.RenderTarget = backbuffer->Views.RenderTarget.CPUHandle;
 	target->Views.ShaderResource = backbuffer->Views.ShaderResource;
 
 	m_targets.push_back(target);
@@ -298,16 +317,19 @@ void env::Window::Present()
 	Texture2D* backbuffer = m_backbuffers[m_currentBackbufferindex];
 	for (auto& t : m_targets) {
 		t->Native = backbuffer->Native;
-		t->Views.RenderTarget = backbuffer->Views.RenderTarget;
+		t->Views.RenderTarget = backbuffer->Views.RenderTarget.CPUHandle;
 		t->Views.ShaderResource = backbuffer->Views.ShaderResource;
 	}
 }
 
 void env::Window::OnEventUpdate()
 {
+	// No input without a window
+#ifdef PLATFORM_DIRECT3D_12
 	MSG msg = { 0 };
 	while (PeekMessageA(&msg, m_handle, NULL, NULL, PM_REMOVE)) {
 		TranslateMessage(&msg);
 		DispatchMessageA(&msg);
 	}
+#endif
 }
@@ -1,6 +1,164 @@
 #include "envision/envpch.h"
+#include "envision/core/Time.h"
+#include "envision/core/VertexPacking.h"
 #include "envision/graphics/Assets.h"
 #include "envision/graphics/AssetManager.h"
+#include <assimp/ProgressHandler.hpp>
+
+namespace
+{
+	struct MeshVertex
+	{
+		struct {
+			float x, y, z;
+		} Position;
+
+		struct {
+			float x, y, z;
+		} Normal;
+
+		struct {
+			float u, v;
+		} Texcoord;
+	};
+
+	// Meshes are imported as floats and packed before the upload
+	std::vector<env::VertexType> PackMeshVertices(const std::vector<MeshVertex>& vertices, const env::MeshBounds& bounds)
+	{
+		std::vector<env::VertexType> packed(vertices.size());
+		env::AssetManager::PackVertices(packed.data(), (UINT)vertices.size(), bounds,
+			&vertices[0].Position, sizeof(MeshVertex),
+			&vertices[0].Normal, sizeof(MeshVertex),
+			&vertices[0].Texcoord, sizeof(MeshVertex));
+		return packed;
+	}
+
+	env::BufferLayout GetMeshIndexLayout(UINT numIndices)
+	{
+		return env::BufferLayout({
+			{ "INDEX", env::ShaderDataType::Uint } },
+			numIndices);
+	}
+
+	// Aborts the import once the load is cancelled, the importers check it
+	// between their steps
+	class CancelProgressHandler : public Assimp::ProgressHandler
+	{
+	private:
+
+		const std::atomic<bool>& m_isCancelled;
+
+	public:
+
+		CancelProgressHandler(const std::atomic<bool>& isCancelled) :
+			m_isCancelled(isCancelled)
+		{
+			//
+		}
+
+		bool Update(float percentage) override
+		{
+			return !m_isCancelled;
+		}
+	};
+
+	// All meshes of the file in one vertex and index buffer. The importer
+	// takes ownership of the progress handler.
+	bool ImportMesh(const std::string& filePath, std::vector<MeshVertex>& vertices, std::vector<UINT>& indices, Assimp::ProgressHandler* progressHandler = nullptr)
+	{
+		Assimp::Importer importer;
+		if (progressHandler)
+			importer.SetProgressHandler(progressHandler);
+
+		//const aiScene* scene = importer.ReadFile(filePath, 
+		//	aiProcess_MakeLeftHanded
+		//	| aiProcess_GenUVCoords
+		//	| aiProcess_FlipUVs);
+
+		const aiScene* scene = importer.ReadFile(filePath,
+			aiProcess_ConvertToLeftHanded);
+
+		if (!scene || !scene->HasMeshes())
+			return false;
+
+		size_t numVertices = 0;
+		size_t numIndices = 0;
+
+		for (size_t i = 0; i < scene->mNumMeshes; i++) {
+			numVertices += scene->mMeshes[i]->mNumVertices;
+			const aiMesh* mesh = scene->mMeshes[i];
+			for (size_t j = 0; j < mesh->mNumFaces; j++) {
+				numIndices += mesh->mFaces[j].mNumIndices;
+			}
+		}
+
+		if (numVertices == 0 || numIndices == 0)
+			return false;
+
+		vertices.resize(numVertices);
+		indices.resize(numIndices);
+
+		int nextVertex = 0;
+		int nextIndex = 0;
+
+		int meshVertexOffset = 0;
+
+		// Meshes without normals or texture coordinates get zeros
+		const aiVector3D zero(0.f, 0.f, 0.f);
+
+		for (size_t i = 0; i < scene->mNumMeshes; i++) {
+			const aiMesh* mesh = scene->mMeshes[i];
+
+			for (size_t j = 0; j < mesh->mNumVertices; j++) {
+				const aiVector3D& position = mesh->mVertices[j];
+				const aiVector3D& normal = mesh->HasNormals() ? mesh->mNormals[j] : zero;
+				const aiVector3D& texCoord = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][j] : zero;
+
+				MeshVertex& vertex = vertices[nextVertex++];
+				vertex.Position = { position.x, position.y, position.z };
+				vertex.Normal = { normal.x, normal.y, normal.z };
+				vertex.Texcoord = { texCoord.x, texCoord.y };
+			}
+
+			for (size_t j = 0; j < mesh->mNumFaces; j++) {
+				const aiFace& face = mesh->mFaces[j];
+				for (size_t k = 0; k < face.mNumIndices; k++) {
+					indices[nextIndex++] = face.mIndices[k] + meshVertexOffset;
+				}
+			}
+
+			meshVertexOffset += mesh->mNumVertices;
+		}
+
+		return true;
+	}
+}
+
+struct env::AssetManager::MeshLoad
+{
+	ID Mesh = ID_ERROR;
+	std::string Name;
+	std::string FilePath;
+	int Priority = 0; // Written under m_loadMutex
+	UINT64 Sequence = 0; // Request order, among loads of the same priority
+	Timepoint RequestTime;
+
+	// The loader thread hands the load back to the main thread by leaving
+	// the Loading state
+	std::atomic<AssetLoadState> State{ AssetLoadState::Queued };
+	std::atomic<bool> IsCancelled{ false };
+
+	// Written by the loader thread
+	std::vector<VertexType> Vertices;
+	std::vector<UINT> Indices;
+	MeshBounds Bounds;
+	float ImportTime = 0.f;
+
+	// Main thread, vertices are uploaded before indices
+	ID VertexBuffer = ID_ERROR;
+	ID IndexBuffer = ID_ERROR;
+	UINT64 NumUploadedBytes = 0;
+};
 
 env::AssetManager* env::AssetManager::s_instance = nullptr;
 
@@ -24,21 +182,39 @@ void env::AssetManager::Finalize()
 }
 
 env::AssetManager::AssetManager(env::IDGenerator& commonIDGenerator) :
-	m_commonIDGenerator(commonIDGenerator)
+	m_commonIDGenerator(commonIDGenerator),
+	m_stopLoading(false),
+	m_nextLoadSequence(0),
+	m_uploadBudget(DEFAULT_UPLOAD_BUDGET),
+	m_fallbackMesh(ID_ERROR),
+	m_fallbackMaterial(ID_ERROR)
 {
 	//
 }
 
 env::AssetManager::~AssetManager()
 {
-	//
+	// Imports in progress are aborted as well
+	for (std::shared_ptr<MeshLoad>& load : m_activeLoads)
+		load->IsCancelled = true;
+
+	{
+		std::lock_guard<std::mutex> lock(m_loadMutex);
+		m_stopLoading = true;
+	}
+	m_loadCondition.notify_all();
+
+	for (std::thread& thread : m_loadThreads)
+		thread.join();
 }
 
 env::Mesh* env::AssetManager::GetMesh(ID resourceID)
 {
-	if (!m_meshes.count(resourceID))
+	// Only find is used, the renderer looks up meshes from several threads
+	auto it = m_meshes.find(resourceID);
+	if (it == m_meshes.end())
 		return nullptr;
-	return m_meshes[resourceID];
+	return it->second;
 }
 
 env::Material* env::AssetManager::GetMaterial(ID resourceID)
@@ -112,13 +288,23 @@ ID env::AssetManager::CreateMesh(const std::string& name, void* vertices, const
 	mesh->NumVertices = vertexBufferLayout.GetNumRepetitions();
 	mesh->IndexBuffer = indexBuffer;
 	mesh->NumIndices = (int)numIndices;
+
+	// Assume the position comes first if the first element can hold one
+	if (vertices && vertexBufferLayout.GetNumElements() > 0 && vertexBufferLayout.begin()->Type == ShaderDataType::Float3) {
+		mesh->Bounds = ComputeMeshBounds(vertices,
+			vertexBufferLayout.GetNumRepetitions(),
+			vertexBufferLayout.GetByteWidth());
+	}
+
 	m_meshes[meshID] = mesh;
 
 	return meshID;
 }
 
-ID env::AssetManager::CreateMesh(const std::string& name, ID vertexBuffer, UINT offsetVertices, UINT numVertices, ID indexBuffer, UINT offsetIndices, UINT numIndices)
+ID env::AssetManager::CreateMesh(const std::string& name, ID vertexBuffer, UINT offsetVertices, UINT numVertices, ID indexBuffer, UINT offsetIndices, UINT numIndices, const MeshBounds& bounds, const MeshLod* lods, UINT numLods)
 {
+	assert(numLods < MAX_MESH_LODS);
+
 	ID meshID = m_commonIDGenerator.GenerateUnique();
 	Mesh* mesh = new Mesh(meshID, name);
 	mesh->VertexBuffer = vertexBuffer;
@@ -127,6 +313,10 @@ ID env::AssetManager::CreateMesh(const std::string& name, ID vertexBuffer, UINT
 	mesh->OffsetIndices = offsetIndices;
 	mesh->NumVertices = numVertices;
 	mesh->NumIndices = (int)numIndices;
+	mesh->Bounds = bounds;
+	mesh->NumLods = numLods;
+	for (UINT lod = 0; lod < numLods; lod++)
+		mesh->Lods[lod] = lods[lod];
 	
 	m_meshes[meshID] = mesh;
 
@@ -149,99 +339,431 @@ ID env::AssetManager::CreatePhongMaterial(const std::string& name, Float3 ambien
 
 ID env::AssetManager::LoadMesh(const std::string& name, const std::string& filePath)
 {
-	Assimp::Importer importer;
+	std::vector<MeshVertex> vertices;
+	std::vector<UINT> indices;
+	if (!ImportMesh(filePath, vertices, indices))
+		return ID_ERROR;
 
-	//const aiScene* scene = importer.ReadFile(filePath, 
-	//	aiProcess_MakeLeftHanded
-	//	| aiProcess_GenUVCoords
-	//	| aiProcess_FlipUVs);
+	MeshBounds bounds = ComputeMeshBounds(vertices.data(), (UINT)vertices.size(), sizeof(MeshVertex));
+	std::vector<VertexType> packedVertices = PackMeshVertices(vertices, bounds);
 
-	const aiScene* scene = importer.ReadFile(filePath,
-		aiProcess_ConvertToLeftHanded);
+	ID vertexBuffer = ResourceManager::Get()->CreateBuffer(name + "_vertexBuffer",
+		GetVertexTypeLayout((UINT)packedVertices.size()),
+		BufferBindType::Vertex,
+		packedVertices.data());
 
-	if (!scene && scene->HasMeshes())
-		return ID_ERROR;
+	ID indexBuffer = ResourceManager::Get()->CreateBuffer(name + "_indexBuffer",
+		GetMeshIndexLayout((UINT)indices.size()),
+		BufferBindType::Index,
+		indices.data());
+
+	ID meshID = m_commonIDGenerator.GenerateUnique();
+	Mesh* mesh = new Mesh(meshID, name);
+	mesh->VertexBuffer = vertexBuffer;
+	mesh->NumVertices = (int)vertices.size();
+	mesh->IndexBuffer = indexBuffer;
+	mesh->NumIndices = (int)indices.size();
+	mesh->Bounds = bounds;
+	m_meshes[meshID] = mesh;
 
-	int numVertices = 0;
-	int numIndices = 0;
+	return meshID;
+}
 
-	for (size_t i = 0; i < scene->mNumMeshes; i++) {
-		numVertices += scene->mMeshes[i]->mNumVertices;
-		const aiMesh* mesh = scene->mMeshes[i];
-		for (size_t j = 0; j < mesh->mNumFaces; j++) {
-			numIndices += mesh->mFaces[j].mNumIndices;
-		}
+ID env::AssetManager::LoadMeshAsync(const std::string& name, const std::string& filePath, int priority)
+{
+	// The threads are started with the first load
+	if (m_loadThreads.empty()) {
+		for (UINT i = 0; i < NUM_LOAD_THREADS; i++)
+			m_loadThreads.emplace_back(&AssetManager::LoadThread, this);
 	}
 
-	struct Vertex
+	const Mesh* fallback = GetMesh(GetFallbackMesh());
+
+	ID meshID = m_commonIDGenerator.GenerateUnique();
+	Mesh* mesh = new Mesh(meshID, name);
+	mesh->VertexBuffer = fallback->VertexBuffer;
+	mesh->IndexBuffer = fallback->IndexBuffer;
+	mesh->NumVertices = fallback->NumVertices;
+	mesh->NumIndices = fallback->NumIndices;
+	mesh->OffsetVertices = fallback->OffsetVertices;
+	mesh->OffsetIndices = fallback->OffsetIndices;
+	mesh->Bounds = fallback->Bounds;
+	m_meshes[meshID] = mesh;
+
+	std::shared_ptr<MeshLoad> load = std::make_shared<MeshLoad>();
+	load->Mesh = meshID;
+	load->Name = name;
+	load->FilePath = filePath;
+	load->Priority = priority;
+	load->RequestTime = Time::Now();
+
+	m_meshLoads[meshID] = load;
+	m_activeLoads.push_back(load);
+
 	{
-		struct {
-			float x, y, z;
-		} Position;
+		std::lock_guard<std::mutex> lock(m_loadMutex);
+		load->Sequence = m_nextLoadSequence++;
+		m_loadQueue.push_back(load);
+	}
+	m_loadCondition.notify_one();
 
-		struct {
-			float x, y, z;
-			
-		} Normal;
+	return meshID;
+}
 
-		struct {
-			float u, v;
-		} Texcoord;
-	};
+bool env::AssetManager::CancelLoad(ID mesh)
+{
+	auto it = m_meshLoads.find(mesh);
+	if (it == m_meshLoads.end())
+		return false;
+
+	MeshLoad& load = *it->second;
+	AssetLoadState state = load.State;
+	if (state == AssetLoadState::Ready || state == AssetLoadState::Failed || state == AssetLoadState::Cancelled || load.IsCancelled)
+		return false;
+
+	// Loads past the queue are finished by Update, or by the loader thread
+	// once the import stops
+	std::lock_guard<std::mutex> lock(m_loadMutex);
+	load.IsCancelled = true;
+
+	auto queued = std::find(m_loadQueue.begin(), m_loadQueue.end(), it->second);
+	if (queued != m_loadQueue.end()) {
+		m_loadQueue.erase(queued);
+		load.State = AssetLoadState::Cancelled;
+	}
 
-	std::vector<Vertex> vertices(numVertices);
-	std::vector<UINT> indices(numIndices);
+	return true;
+}
 
-	int nextVertex = 0;
-	int nextIndex = 0;
+void env::AssetManager::SetLoadPriority(ID mesh, int priority)
+{
+	auto it = m_meshLoads.find(mesh);
+	if (it == m_meshLoads.end())
+		return;
 
-	int meshVertexOffset = 0;
+	std::lock_guard<std::mutex> lock(m_loadMutex);
+	it->second->Priority = priority;
+}
 
-	for (size_t i = 0; i < scene->mNumMeshes; i++) {
-		const aiMesh* mesh = scene->mMeshes[i];
+env::AssetLoadState env::AssetManager::GetLoadState(ID mesh) const
+{
+	auto it = m_meshLoads.find(mesh);
+	if (it == m_meshLoads.end())
+		return AssetLoadState::Ready;
+	return it->second->State;
+}
 
-		for (size_t j = 0; j < mesh->mNumVertices; j++) {
-			const aiVector3D& position = mesh->mVertices[j];
-			const aiVector3D& normal = mesh->mNormals[j];
-			const aiVector3D& texCoord = mesh->mTextureCoords[0][j];
+void env::AssetManager::Update()
+{
+	Timepoint updateStart = Time::Now();
+	ResourceManager* resourceManager = ResourceManager::Get();
+	m_changedBounds.clear();
+
+	// Highest priority first, in request order within a priority
+	std::sort(m_activeLoads.begin(), m_activeLoads.end(), [](const std::shared_ptr<MeshLoad>& a, const std::shared_ptr<MeshLoad>& b) {
+		return (a->Priority != b->Priority) ? (a->Priority > b->Priority) : (a->Sequence < b->Sequence);
+	});
+
+	// Imported meshes are uploaded a part at a time, continuing where the
+	// last frame stopped
+	UINT64 budget = m_uploadBudget;
+	for (std::shared_ptr<MeshLoad>& load : m_activeLoads) {
+		if (budget == 0)
+			break;
+		if (load->State != AssetLoadState::Uploading || load->IsCancelled)
+			continue;
+
+		if (load->VertexBuffer == ID_ERROR) {
+			load->VertexBuffer = resourceManager->CreateBuffer(load->Name + "_vertexBuffer",
+				GetVertexTypeLayout((UINT)load->Vertices.size()),
+				BufferBindType::Vertex);
+			load->IndexBuffer = resourceManager->CreateBuffer(load->Name + "_indexBuffer",
+				GetMeshIndexLayout((UINT)load->Indices.size()),
+				BufferBindType::Index);
+		}
 
-			Vertex& vertex = vertices[nextVertex++];
-			vertex.Position = { position.x, position.y, position.z };
-			vertex.Normal = { normal.x, normal.y, normal.z };
-			vertex.Texcoord = { texCoord.x, texCoord.y };
+		UINT64 numVertexBytes = load->Vertices.size() * sizeof(VertexType);
+		UINT64 numIndexBytes = load->Indices.size() * sizeof(UINT);
+		while (budget > 0 && load->NumUploadedBytes < numVertexBytes + numIndexBytes) {
+			bool isVertices = (load->NumUploadedBytes < numVertexBytes);
+			UINT64 offset = isVertices ? load->NumUploadedBytes : load->NumUploadedBytes - numVertexBytes;
+			UINT64 numBytes = std::min((isVertices ? numVertexBytes : numIndexBytes) - offset, budget);
+			char* data = isVertices ? (char*)load->Vertices.data() : (char*)load->Indices.data();
+
+			resourceManager->UploadBufferData(isVertices ? load->VertexBuffer : load->IndexBuffer,
+				data + offset,
+				(UINT)numBytes,
+				(UINT)offset);
+
+			load->NumUploadedBytes += numBytes;
+			budget -= numBytes;
 		}
+	}
 
-		for (size_t j = 0; j < mesh->mNumFaces; j++) {
-			const aiFace& face = mesh->mFaces[j];
-			for (size_t k = 0; k < face.mNumIndices; k++) {
-				indices[nextIndex++] = face.mIndices[k] + meshVertexOffset;
+	// Submitted right away, the queues wait for the copies before anything
+	// drawing the meshes swapped in below
+	m_loadStatistics.UploadedBytes = m_uploadBudget - budget;
+	m_loadStatistics.TotalUploadedBytes += m_loadStatistics.UploadedBytes;
+	if (m_loadStatistics.UploadedBytes > 0)
+		resourceManager->FlushUploads();
+
+	m_loadStatistics.NumQueued = 0;
+	m_loadStatistics.NumLoading = 0;
+	m_loadStatistics.NumUploading = 0;
+
+	for (size_t i = 0; i < m_activeLoads.size();) {
+		MeshLoad& load = *m_activeLoads[i];
+		AssetLoadState state = load.State;
+
+		if (state == AssetLoadState::Uploading && load.IsCancelled) {
+			if (load.VertexBuffer != ID_ERROR) {
+				resourceManager->ReleaseBuffer(load.VertexBuffer);
+				resourceManager->ReleaseBuffer(load.IndexBuffer);
 			}
+			state = AssetLoadState::Cancelled;
+		}
+		else if (state == AssetLoadState::Uploading && load.NumUploadedBytes == load.Vertices.size() * sizeof(VertexType) + load.Indices.size() * sizeof(UINT)) {
+			Mesh* mesh = GetMesh(load.Mesh);
+			mesh->VertexBuffer = load.VertexBuffer;
+			mesh->IndexBuffer = load.IndexBuffer;
+			mesh->NumVertices = (UINT)load.Vertices.size();
+			mesh->NumIndices = (UINT)load.Indices.size();
+			mesh->OffsetVertices = 0;
+			mesh->OffsetIndices = 0;
+			mesh->Bounds = load.Bounds;
+			m_changedBounds.push_back(load.Mesh);
+			state = AssetLoadState::Ready;
+		}
+
+		switch (state)
+		{
+		case AssetLoadState::Queued:	m_loadStatistics.NumQueued++; i++; continue;
+		case AssetLoadState::Loading:	m_loadStatistics.NumLoading++; i++; continue;
+		case AssetLoadState::Uploading:	m_loadStatistics.NumUploading++; i++; continue;
+		default:						break;
 		}
 
-		meshVertexOffset += mesh->mNumVertices;
+		FinishLoad(load, state);
+		m_activeLoads[i] = m_activeLoads.back();
+		m_activeLoads.pop_back();
 	}
 
-	ID vertexBuffer = ResourceManager::Get()->CreateBuffer(name + "_vertexBuffer", BufferLayout({
-		{ "POSITION", ShaderDataType::Float3 },
-		{ "NORMAL", ShaderDataType::Float3 },
-		{ "TEXCOORD", ShaderDataType::Float2 } },
-		(UINT)vertices.size()),
-		BufferBindType::Vertex,
-		vertices.data());
+	m_loadStatistics.UpdateTime = (Time::Now() - updateStart).InSeconds();
+	m_loadStatistics.MaxUpdateTime = std::max(m_loadStatistics.MaxUpdateTime, m_loadStatistics.UpdateTime);
+}
 
-	ID indexBuffer = ResourceManager::Get()->CreateBuffer(name + "_indexBuffer", BufferLayout({
-		{ "INDEX", ShaderDataType::Uint }},
-		(UINT)indices.size()),
-		BufferBindType::Index,
-		indices.data());
+void env::AssetManager::SetUploadBudget(UINT64 numBytesPerFrame)
+{
+	assert(numBytesPerFrame > 0);
+	m_uploadBudget = numBytesPerFrame;
+}
 
-	ID meshID = m_commonIDGenerator.GenerateUnique();
-	Mesh* mesh = new Mesh(meshID, name);
-	mesh->VertexBuffer = vertexBuffer;
-	mesh->NumVertices = (int)vertices.size();
-	mesh->IndexBuffer = indexBuffer;
-	mesh->NumIndices = (int)indices.size();
-	m_meshes[meshID] = mesh;
+UINT64 env::AssetManager::GetUploadBudget() const
+{
+	return m_uploadBudget;
+}
 
-	return meshID;
+const env::AssetLoadStatistics& env::AssetManager::GetLoadStatistics() const
+{
+	return m_loadStatistics;
+}
+
+const std::vector<ID>& env::AssetManager::GetMeshesWithChangedBounds() const
+{
+	return m_changedBounds;
+}
+
+ID env::AssetManager::GetFallbackMesh()
+{
+	if (m_fallbackMesh != ID_ERROR)
+		return m_fallbackMesh;
+
+	// A unit cube, each face has vertices of its own for its normal
+	const Float3 axes[3] = { Float3(1.f, 0.f, 0.f), Float3(0.f, 1.f, 0.f), Float3(0.f, 0.f, 1.f) };
+
+	std::vector<MeshVertex> vertices;
+	std::vector<UINT> indices;
+	for (int axis = 0; axis < 3; axis++) {
+		for (float sign : { -1.f, 1.f }) {
+			Float3 normal = axes[axis] * sign;
+			Float3 u = axes[(axis + 1) % 3];
+			Float3 v = axes[(axis + 2) % 3];
+
+			UINT firstVertex = (UINT)vertices.size();
+			for (int corner = 0; corner < 4; corner++) {
+				float cornerU = (corner & 1) ? 1.f : 0.f;
+				float cornerV = (corner & 2) ? 1.f : 0.f;
+				Float3 position = normal * 0.5f + u * (cornerU - 0.5f) + v * (cornerV - 0.5f);
+
+				MeshVertex vertex;
+				vertex.Position = { position.x, position.y, position.z };
+				vertex.Normal = { normal.x, normal.y, normal.z };
+				vertex.Texcoord = { cornerU, cornerV };
+				vertices.push_back(vertex);
+			}
+
+			// Clockwise seen from outside. u x v is the positive axis, the
+			// faces on the negative side are wound the other way.
+			std::array<UINT, 6> quad = { 0, 1, 2, 1, 3, 2 };
+			if (sign < 0.f)
+				quad = { 0, 2, 1, 1, 2, 3 };
+			for (UINT index : quad)
+				indices.push_back(firstVertex + index);
+		}
+	}
+
+	MeshBounds bounds = ComputeMeshBounds(vertices.data(), (UINT)vertices.size(), sizeof(MeshVertex));
+	std::vector<VertexType> packedVertices = PackMeshVertices(vertices, bounds);
+
+	m_fallbackMesh = CreateMesh("Fallback",
+		packedVertices.data(),
+		GetVertexTypeLayout((UINT)packedVertices.size()),
+		indices.data(),
+		(UINT)indices.size());
+
+	// Packed positions can't be read back, the box they were packed to is
+	// needed to draw them
+	GetMesh(m_fallbackMesh)->Bounds = bounds;
+
+	return m_fallbackMesh;
+}
+
+ID env::AssetManager::GetFallbackMaterial()
+{
+	if (m_fallbackMaterial == ID_ERROR) {
+		m_fallbackMaterial = CreatePhongMaterial("Fallback",
+			Float3(0.2f, 0.2f, 0.2f),
+			Float3(0.5f, 0.5f, 0.5f),
+			Float3::Zero,
+			1.f);
+	}
+
+	return m_fallbackMaterial;
+}
+
+void env::AssetManager::LoadThread()
+{
+	while (true) {
+		std::shared_ptr<MeshLoad> load;
+		{
+			std::unique_lock<std::mutex> lock(m_loadMutex);
+			m_loadCondition.wait(lock, [this]() { return m_stopLoading || !m_loadQueue.empty(); });
+			if (m_stopLoading)
+				return;
+
+			auto next = m_loadQueue.begin();
+			for (auto it = m_loadQueue.begin(); it != m_loadQueue.end(); it++) {
+				const MeshLoad& other = **it;
+				if (other.Priority > (*next)->Priority || (other.Priority == (*next)->Priority && other.Sequence < (*next)->Sequence))
+					next = it;
+			}
+
+			load = *next;
+			m_loadQueue.erase(next);
+			load->State = AssetLoadState::Loading;
+		}
+
+		Timepoint importStart = Time::Now();
+		std::vector<MeshVertex> vertices;
+		bool isImported = ImportMesh(load->FilePath, vertices, load->Indices, new CancelProgressHandler(load->IsCancelled));
+		if (isImported) {
+			load->Bounds = ComputeMeshBounds(vertices.data(), (UINT)vertices.size(), sizeof(MeshVertex));
+			load->Vertices = PackMeshVertices(vertices, load->Bounds);
+		}
+		load->ImportTime = (Time::Now() - importStart).InSeconds();
+
+		if (load->IsCancelled)
+			load->State = AssetLoadState::Cancelled;
+		else
+			load->State = isImported ? AssetLoadState::Uploading : AssetLoadState::Failed;
+	}
+}
+
+void env::AssetManager::FinishLoad(MeshLoad& load, AssetLoadState state)
+{
+	load.State = state;
+
+	// Only the state is kept
+	std::vector<VertexType>().swap(load.Vertices);
+	std::vector<UINT>().swap(load.Indices);
+
+	if (state == AssetLoadState::Ready) {
+		float latency = (Time::Now() - load.RequestTime).InSeconds();
+		m_loadStatistics.NumReady++;
+		m_loadStatistics.LastLatency = latency;
+		m_loadStatistics.MaxLatency = std::max(m_loadStatistics.MaxLatency, latency);
+		m_loadStatistics.TotalLatency += latency;
+		m_loadStatistics.LastImportTime = load.ImportTime;
+	}
+	else if (state == AssetLoadState::Failed) {
+		OutputDebugStringA(("AssetManager: Failed to load mesh " + load.FilePath + "\n").c_str());
+		m_loadStatistics.NumFailed++;
+	}
+	else {
+		m_loadStatistics.NumCancelled++;
+	}
+}
+
+env::MeshBounds env::AssetManager::ComputeMeshBounds(const void* vertices, UINT numVertices, UINT vertexStride)
+{
+	MeshBounds bounds;
+	if (numVertices == 0)
+		return bounds;
+
+	auto getPosition = [&](UINT vertexIndex) {
+		const float* position = (const float*)((const char*)vertices + (size_t)vertexIndex * vertexStride);
+		return Float3(position[0], position[1], position[2]);
+	};
+
+	bounds.Min = getPosition(0);
+	bounds.Max = bounds.Min;
+	for (UINT i = 1; i < numVertices; i++) {
+		Float3 position = getPosition(i);
+		bounds.Min = Float3::Min(bounds.Min, position);
+		bounds.Max = Float3::Max(bounds.Max, position);
+	}
+
+	// Sphere around the box center, tighter than the half box diagonal
+	bounds.Center = (bounds.Min + bounds.Max) * 0.5f;
+	float radiusSquared = 0.f;
+	for (UINT i = 0; i < numVertices; i++)
+		radiusSquared = std::max(radiusSquared, Float3::DistanceSquared(bounds.Center, getPosition(i)));
+	bounds.Radius = std::sqrt(radiusSquared);
+
+	return bounds;
+}
+
+void env::AssetManager::PackVertices(VertexType* destination, UINT numVertices, const MeshBounds& bounds,
+	const void* positions, UINT positionStride,
+	const void* normals, UINT normalStride,
+	const void* texcoords, UINT texcoordStride)
+{
+	const float center[3] = {
+		(bounds.Min.x + bounds.Max.x) * 0.5f,
+		(bounds.Min.y + bounds.Max.y) * 0.5f,
+		(bounds.Min.z + bounds.Max.z) * 0.5f };
+	const float extents[3] = {
+		(bounds.Max.x - bounds.Min.x) * 0.5f,
+		(bounds.Max.y - bounds.Min.y) * 0.5f,
+		(bounds.Max.z - bounds.Min.z) * 0.5f };
+
+	PackPositions(positions, positionStride, numVertices, center, extents,
+		destination->Position, sizeof(VertexType));
+
+	if (normals) {
+		PackOctahedralNormals(normals, normalStride, numVertices,
+			destination->Normal, sizeof(VertexType));
+	}
+
+	if (texcoords) {
+		PackHalf2(texcoords, texcoordStride, numVertices,
+			destination->Texcoord, sizeof(VertexType));
+	}
+
+	for (UINT i = 0; i < numVertices; i++) {
+		if (!normals)
+			destination[i].Normal[0] = destination[i].Normal[1] = 0;
+		if (!texcoords)
+			destination[i].Texcoord[0] = destination[i].Texcoord[1] = 0;
+	}
 }
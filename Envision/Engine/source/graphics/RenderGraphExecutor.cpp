@@ -0,0 +1,309 @@
+#include "envision/envpch.h"
+#include "envision/graphics/RenderGraphExecutor.h"
+#include "envision/core/GPU.h"
+#include "envision/core/Time.h"
+#include "envision/resource/ResourceManager.h"
+
+env::RenderGraphContext::RenderGraphContext(RenderGraphExecutor& executor, CommandQueue& queue) :
+	m_executor(executor),
+	m_queue(queue),
+	m_list(nullptr)
+{
+	//
+}
+
+env::DirectList* env::RenderGraphContext::GetList()
+{
+	return m_list;
+}
+
+env::Resource* env::RenderGraphContext::GetResource(UINT resource)
+{
+	return m_executor.GetResource(resource);
+}
+
+env::Texture2D* env::RenderGraphContext::GetTexture(UINT resource)
+{
+	Resource* texture = m_executor.GetResource(resource);
+	assert(texture->GetType() == ResourceType::Texture2D);
+	return (Texture2D*)texture;
+}
+
+void env::RenderGraphContext::QueueLists(DirectList* const* lists, UINT numLists)
+{
+	m_list->Close();
+	m_queue.QueueList(m_list);
+
+	for (UINT i = 0; i < numLists; i++)
+		m_queue.QueueList(lists[i]);
+
+	m_list = GPU::AcquireDirectList();
+}
+
+env::RenderGraphExecutor::RenderGraphExecutor() :
+	m_heap(nullptr),
+	m_heapSize(0),
+	m_compileTime(0.f)
+{
+	//
+}
+
+env::RenderGraphExecutor::~RenderGraphExecutor()
+{
+	// Only destroyed once the queues are idle
+	m_deferredReleases.ReleaseAll();
+
+	if (m_heap)
+		m_heap->Release();
+}
+
+void env::RenderGraphExecutor::Begin()
+{
+	m_graph.Clear();
+	m_passFunctions.clear();
+	m_resources.clear();
+	m_importedResources.clear();
+}
+
+UINT env::RenderGraphExecutor::ImportResource(Resource* resource, D3D12_RESOURCE_STATES finalState)
+{
+	auto it = m_importedResources.find(resource);
+	if (it != m_importedResources.end())
+		return it->second;
+
+	UINT index = m_graph.ImportResource(resource->Name, (uint32_t)resource->State, (uint32_t)finalState);
+	m_resources.push_back(resource);
+	m_importedResources[resource] = index;
+	return index;
+}
+
+UINT env::RenderGraphExecutor::CreateTexture(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType)
+{
+	// The heap only holds targets, tier 1 heaps can't mix them with other textures
+	assert(any(bindType & (TextureBindType::RenderTarget | TextureBindType::DepthStencil)));
+
+	RenderGraphTextureDesc desc;
+	desc.Width = (uint32_t)width;
+	desc.Height = (uint32_t)height;
+	desc.Format = (uint32_t)format;
+	desc.BindFlags = (uint32_t)bindType;
+
+	// The size only changes with the arguments, ask the device once
+	for (const TransientTexture& texture : m_transientTextures) {
+		const RenderGraphTextureDesc& other = texture.Desc;
+		if (other.Width == desc.Width && other.Height == desc.Height && other.Format == desc.Format && other.BindFlags == desc.BindFlags) {
+			desc.NumBytes = other.NumBytes;
+			desc.Alignment = other.Alignment;
+			break;
+		}
+	}
+
+	if (desc.NumBytes == 0) {
+		D3D12_RESOURCE_ALLOCATION_INFO info = ResourceManager::Get()->GetTexture2DAllocationInfo(width, height, format, bindType);
+		desc.NumBytes = info.SizeInBytes;
+		desc.Alignment = info.Alignment;
+	}
+
+	UINT index = m_graph.CreateTexture(name, desc);
+	m_resources.push_back(nullptr);
+	return index;
+}
+
+UINT env::RenderGraphExecutor::AddPass(const std::string& name, RenderGraphPassFunction function, bool hasSideEffects)
+{
+	m_passFunctions.push_back(std::move(function));
+	return m_graph.AddPass(name, hasSideEffects);
+}
+
+void env::RenderGraphExecutor::Read(UINT pass, UINT resource, D3D12_RESOURCE_STATES state)
+{
+	m_graph.Read(pass, resource, (uint32_t)state);
+}
+
+void env::RenderGraphExecutor::Write(UINT pass, UINT resource, D3D12_RESOURCE_STATES state)
+{
+	m_graph.Write(pass, resource, (uint32_t)state);
+}
+
+void env::RenderGraphExecutor::Execute(CommandQueue& queue)
+{
+	m_deferredReleases.Collect();
+
+	Timepoint compileBegin = Time::Now();
+	m_graph.Compile();
+	m_compileTime = (Time::Now() - compileBegin).InSeconds();
+
+	PrepareHeap();
+	PrepareTransientTextures();
+
+	RenderGraphContext context(*this, queue);
+	context.m_list = GPU::AcquireDirectList();
+
+	for (UINT pass = 0; pass < m_graph.GetNumPasses(); pass++) {
+		if (m_graph.IsPassCulled(pass))
+			continue;
+
+		RecordBarriers(context.m_list, m_graph.GetNumPassBarriers(pass), m_graph.GetPassBarriers(pass));
+		m_passFunctions[pass](context);
+	}
+
+	RecordBarriers(context.m_list, m_graph.GetNumFinalBarriers(), m_graph.GetFinalBarriers());
+
+	context.m_list->Close();
+	queue.QueueList(context.m_list);
+}
+
+env::Resource* env::RenderGraphExecutor::GetResource(UINT resource)
+{
+	assert(resource < m_resources.size());
+	assert(m_resources[resource]);
+	return m_resources[resource];
+}
+
+const env::RenderGraph& env::RenderGraphExecutor::GetGraph() const
+{
+	return m_graph;
+}
+
+float env::RenderGraphExecutor::GetCompileTime() const
+{
+	return m_compileTime;
+}
+
+UINT64 env::RenderGraphExecutor::GetHeapSize() const
+{
+	return m_heapSize;
+}
+
+void env::RenderGraphExecutor::PrepareHeap()
+{
+	UINT64 heapSize = m_graph.GetHeapSize();
+	if (heapSize <= m_heapSize)
+		return;
+
+	// The textures in the old heap are released with it, frames in flight
+	// might still use them
+	for (const TransientTexture& texture : m_transientTextures)
+		ResourceManager::Get()->ReleaseTexture2D(texture.Texture);
+	m_transientTextures.clear();
+
+	if (m_heap) {
+		ID3D12Heap* oldHeap = m_heap;
+		m_deferredReleases.Push({ &GPU::GetDirectQueue(), &GPU::GetPresentQueue() },
+			[oldHeap]() { oldHeap->Release(); });
+	}
+
+	D3D12_HEAP_DESC desc;
+	ZeroMemory(&desc, sizeof(desc));
+	desc.SizeInBytes = heapSize;
+	desc.Properties.Type = D3D12_HEAP_TYPE_DEFAULT;
+	desc.Properties.CreationNodeMask = 1;
+	desc.Properties.VisibleNodeMask = 1;
+	desc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	desc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+	HRESULT hr = GPU::GetDevice()->CreateHeap(&desc, IID_PPV_ARGS(&m_heap));
+	ASSERT_HR(hr, "Could not create render graph heap");
+	m_heapSize = heapSize;
+}
+
+void env::RenderGraphExecutor::PrepareTransientTextures()
+{
+	ResourceManager* resourceManager = ResourceManager::Get();
+
+	for (TransientTexture& texture : m_transientTextures)
+		texture.IsUsed = false;
+
+	for (UINT resource = 0; resource < m_graph.GetNumResources(); resource++) {
+		if (m_graph.IsImported(resource))
+			continue;
+
+		m_resources[resource] = nullptr;
+		if (!m_graph.IsResourceUsed(resource))
+			continue;
+
+		const RenderGraphTextureDesc& desc = m_graph.GetTextureDesc(resource);
+		UINT64 heapOffset = m_graph.GetHeapOffset(resource);
+
+		TransientTexture* match = nullptr;
+		for (TransientTexture& texture : m_transientTextures) {
+			if (!texture.IsUsed && texture.HeapOffset == heapOffset && texture.Desc == desc) {
+				match = &texture;
+				break;
+			}
+		}
+
+		if (!match) {
+			TransientTexture texture;
+			texture.Desc = desc;
+			texture.HeapOffset = heapOffset;
+			texture.Texture = resourceManager->CreatePlacedTexture2D(m_graph.GetResourceName(resource),
+				(int)desc.Width,
+				(int)desc.Height,
+				(DXGI_FORMAT)desc.Format,
+				(TextureBindType)desc.BindFlags,
+				m_heap,
+				heapOffset);
+
+			m_transientTextures.push_back(texture);
+			match = &m_transientTextures.back();
+		}
+
+		match->IsUsed = true;
+		m_resources[resource] = resourceManager->GetTexture2D(match->Texture);
+	}
+
+	// Textures the graph no longer places are released, a steady graph
+	// keeps all of them
+	for (size_t i = 0; i < m_transientTextures.size();) {
+		if (m_transientTextures[i].IsUsed) {
+			i++;
+			continue;
+		}
+
+		resourceManager->ReleaseTexture2D(m_transientTextures[i].Texture);
+		m_transientTextures[i] = m_transientTextures.back();
+		m_transientTextures.pop_back();
+	}
+}
+
+void env::RenderGraphExecutor::RecordBarriers(DirectList* list, UINT numBarriers, const RenderGraphBarrier* barriers)
+{
+	m_barriers.clear();
+
+	for (UINT i = 0; i < numBarriers; i++) {
+		const RenderGraphBarrier& graphBarrier = barriers[i];
+		Resource* resource = m_resources[graphBarrier.Resource];
+
+		D3D12_RESOURCE_BARRIER barrier;
+		ZeroMemory(&barrier, sizeof(barrier));
+
+		if (graphBarrier.Type == RenderGraphBarrierType::Aliasing) {
+			// Any texture that used the memory before
+			barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+			barrier.Aliasing.pResourceBefore = nullptr;
+			barrier.Aliasing.pResourceAfter = resource->Native;
+			m_barriers.push_back(barrier);
+			continue;
+		}
+
+		// Transient textures start in the state they were left in, and
+		// passes may still transition resources themselves, so the tracked
+		// state is used instead of the one the graph expects
+		D3D12_RESOURCE_STATES before = resource->State;
+		D3D12_RESOURCE_STATES after = (D3D12_RESOURCE_STATES)graphBarrier.StateAfter;
+
+		resource->State = after;
+		if (before == after)
+			continue;
+
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrier.Transition.pResource = resource->Native;
+		barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		barrier.Transition.StateBefore = before;
+		barrier.Transition.StateAfter = after;
+		m_barriers.push_back(barrier);
+	}
+
+	list->ResourceBarriers((UINT)m_barriers.size(), m_barriers.data());
+}
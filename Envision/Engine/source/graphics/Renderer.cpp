@@ -1,9 +1,40 @@
 #include "envision/envpch.h"
 #include "envision/graphics/Renderer.h"
+#include "envision/core/RadixSort.h"
+#include "envision/core/JobSystem.h"
 #include "envision/graphics/AssetManager.h"
 #include "envision/resource/ResourceManager.h"
 
 #include "DirectXMath.h"
+#include <unordered_set>
+
+namespace
+{
+	// Bindless index of a material map, -1 if there is no map
+	int GetMapIndex(ID texture)
+	{
+		if (texture == ID_ERROR)
+			return -1;
+
+		env::Texture2D* map = env::ResourceManager::Get()->GetTexture2D(texture);
+		if (!map || !map->Views.ShaderResource.IsValid())
+			return -1;
+		return (int)map->Views.ShaderResource.Index;
+	}
+
+	// Index range of a LOD, full detail for LODs the mesh doesn't have
+	void GetLodIndices(const env::Mesh* mesh, UINT lod, UINT& offsetIndices, UINT& numIndices)
+	{
+		if (lod == 0 || lod > mesh->NumLods) {
+			offsetIndices = mesh->OffsetIndices;
+			numIndices = mesh->NumIndices;
+			return;
+		}
+
+		offsetIndices = mesh->Lods[lod - 1].OffsetIndices;
+		numIndices = mesh->Lods[lod - 1].NumIndices;
+	}
+}
 
 env::Renderer* env::Renderer::s_instance = nullptr;
 
@@ -27,25 +58,24 @@ void env::Renderer::Finalize()
 }
 
 env::Renderer::Renderer(env::IDGenerator& commonIDGenerator) :
-	m_commonIDGenerator(commonIDGenerator)
+	m_commonIDGenerator(commonIDGenerator),
+	m_framePipeline(GPU::GetPresentQueue(), DEFAULT_FRAME_PIPELINE_DEPTH)
 {
-	m_directList = GPU::CreateDirectCommandList();
 
 	m_pipelineState = ResourceManager::Get()->CreatePipelineState("PipelineState",
 		{
-			{ ShaderStage::Vertex, ShaderModel::V5_0, "shader.hlsl", "VS_main" },
-			{ ShaderStage::Pixel, ShaderModel::V5_0, "shader.hlsl", "PS_main" }
+			{ ShaderStage::Vertex, ShaderModel::V5_1, "shader.hlsl", "VS_main" },
+			{ ShaderStage::Pixel, ShaderModel::V5_1, "shader.hlsl", "PS_main" }
 		},
-		true,
+		GetVertexTypeLayout(),
 		{
-			ROOT_CONSTANTS(ShaderStage::Vertex | ShaderStage::Pixel, 0, 0, 1),			// Instance offset
-			ROOT_TABLE(ShaderStage::Vertex | ShaderStage::Pixel, SRV_RANGE(1, 0, 0)),	// Instance buffer array
-			ROOT_TABLE(ShaderStage::Pixel, SRV_RANGE(1, 1, 0)),							// Material buffer array
+			ROOT_CONSTANTS(ShaderStage::Vertex | ShaderStage::Pixel, 0, 0, NUM_ROOT_CONSTANTS),	// Instance offset, buffer indices, position box
+			ROOT_TABLE(ShaderStage::Vertex | ShaderStage::Pixel,
+				BINDLESS_SRV_RANGE(1),													// Instance buffer arrays
+				BINDLESS_SRV_RANGE(2)),													// Material buffer arrays
 			ROOT_CBV_DESCRIPTOR(ShaderStage::Vertex | ShaderStage::Pixel, 1, 0),		// Camera buffer
 		});
 
-	const int DEFAULT_TARGET_WIDTH = 1200;
-	const int DEFAULT_TARGET_HEIGHT = 800;
 	const UINT DEFAULT_INSTANCE_CAPACITY = 6000;
 	const UINT DEFAULT_MATERIAL_CAPACITY = 50;
 
@@ -54,18 +84,6 @@ env::Renderer::Renderer(env::IDGenerator& commonIDGenerator) :
 	for (int i = 0; i < NUM_FRAME_PACKETS; i++) {
 		FramePacket& packet = m_framePackets[i];
 
-		// Frame targets
-		packet.Targets.Intermediate = ResourceManager::Get()->CreateTexture2D("IntermediateTarget",
-			DEFAULT_TARGET_WIDTH,
-			DEFAULT_TARGET_HEIGHT,
-			DXGI_FORMAT_R8G8B8A8_UNORM,
-			TextureBindType::RenderTarget);
-		packet.Targets.Depth = ResourceManager::Get()->CreateTexture2D("DepthStencil",
-			DEFAULT_TARGET_WIDTH,
-			DEFAULT_TARGET_HEIGHT,
-			DXGI_FORMAT_D32_FLOAT,
-			TextureBindType::DepthStencil);
-
 		// Frame buffers
 		packet.Buffers.Camera = ResourceManager::Get()->CreateBuffer("CameraBuffer",
 			BufferLayout({
@@ -80,7 +98,8 @@ env::Renderer::Renderer(env::IDGenerator& commonIDGenerator) :
 				{ "ViewProjectionMatrix", ShaderDataType::Float4x4 }
 			}),
 			BufferBindType::Constant);
-		packet.Buffers.Instance = ResourceManager::Get()->CreateBufferArray("InstanceBuffer",
+		// The instance buffer lives in an upload heap and is written directly by the CPU
+		packet.Buffers.Instance = ResourceManager::Get()->CreateMappedBufferArray("InstanceBuffer",
 			BufferLayout({
 				{ "Position", ShaderDataType::Float3 },
 				{ "ID", ShaderDataType::Float },
@@ -89,8 +108,7 @@ env::Renderer::Renderer(env::IDGenerator& commonIDGenerator) :
 				{ "UpDirection", ShaderDataType::Float3 },
 				{ "Pad", ShaderDataType::Float },
 				{ "WorldMatrix", ShaderDataType::Float4x4 } },
-				DEFAULT_INSTANCE_CAPACITY),
-			BufferBindType::ShaderResource);
+				DEFAULT_INSTANCE_CAPACITY));
 		packet.Buffers.Material = ResourceManager::Get()->CreateBufferArray("MaterialBuffer", 
 			BufferLayout({
 				{ "AmbientFactor", ShaderDataType::Float3 },
@@ -104,22 +122,12 @@ env::Renderer::Renderer(env::IDGenerator& commonIDGenerator) :
 				{ "Padding", ShaderDataType::Float2 }},
 				DEFAULT_MATERIAL_CAPACITY),
 			BufferBindType::ShaderResource);
-
-		// Init a descriptor heap allocator for the frame packet
-		DescriptorAllocator& allocator = m_descriptorAllocators[i];
-		allocator.Initialize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 32, true);
 	}
 }
 
 env::Renderer::~Renderer()
 {
-	//
-}
-
-int env::Renderer::StepCurrentFramePacketIndex()
-{
-	m_currentFramePacketIndex = (m_currentFramePacketIndex + 1) % NUM_FRAME_PACKETS;
-	return m_currentFramePacketIndex;
+	m_framePipeline.Flush();
 }
 
 void env::Renderer::ClearCurrentFramePacket()
@@ -130,12 +138,22 @@ void env::Renderer::ClearCurrentFramePacket()
 	packet.Camera.Settings.DistanceFarPlane = 100.0f;
 	packet.Camera.Settings.FieldOfView = 3.14f / 2.0f;
 	packet.Camera.Settings.Orthographic = false;
+	packet.Camera.LodScale = 0.f;
 
 	packet.Camera.Transform.SetPosition(Float3::Zero);
 	packet.Camera.Transform.SetRotation(Quaternion::Identity);
 	packet.Camera.Transform.SetScale(Float3::One);
 
-	packet.MeshOpaqueInstances.clear();
+	packet.Instances.clear();
+	packet.DrawKeys.clear();
+	packet.DrawKeyInstances.clear();
+	packet.DrawKeyMeshes.clear();
+	packet.DrawKeyMeshIndices.clear();
+
+	packet.InstanceStream.Enabled = false;
+	packet.InstanceStream.NumInstances = 0;
+	packet.InstanceStream.Data = nullptr;
+	packet.InstanceStream.MeshRanges.clear();
 }
 
 env::FramePacket& env::Renderer::GetCurrentFramePacket()
@@ -143,6 +161,23 @@ env::FramePacket& env::Renderer::GetCurrentFramePacket()
 	return m_framePackets[m_currentFramePacketIndex];
 }
 
+env::InstanceBufferElementData* env::Renderer::EnsureInstanceCapacity(FramePacket& packet, UINT numInstances)
+{
+	BufferArray* instanceBuffer = ResourceManager::Get()->GetBufferArray(packet.Buffers.Instance);
+	UINT capacity = instanceBuffer->Layout.GetNumRepetitions();
+
+	if (numInstances > capacity) {
+		// Grow geometrically to not resize every time a few instances are added
+		UINT newCapacity = (capacity > 0) ? capacity : 1;
+		while (newCapacity < numInstances)
+			newCapacity *= 2;
+
+		ResourceManager::Get()->ResizeBufferArray(packet.Buffers.Instance, newCapacity);
+	}
+
+	return (InstanceBufferElementData*)instanceBuffer->MappedData;
+}
+
 void env::Renderer::Initialize()
 {
 	//
@@ -150,7 +185,8 @@ void env::Renderer::Initialize()
 
 void env::Renderer::BeginFrame(const CameraSettings& cameraSettings, Transform& cameraTransform, ID target)
 {
-	StepCurrentFramePacketIndex();
+	m_currentFramePacketIndex = (int)m_framePipeline.BeginFrame();
+	m_statistics.FrameWaitTime = m_framePipeline.GetWaitTime();
 	ClearCurrentFramePacket();
 
 	FramePacket& packet = GetCurrentFramePacket();
@@ -158,79 +194,491 @@ void env::Renderer::BeginFrame(const CameraSettings& cameraSettings, Transform&
 	// Initialize camera
 	packet.Camera.Settings = cameraSettings;
 	packet.Camera.Transform = cameraTransform;
+	packet.Camera.Position = cameraTransform.GetPosition();
+	packet.Camera.Forward = cameraTransform.GetForward();
+
+	{ // Culling frustum
+		using namespace DirectX;
+
+		WindowTarget* windowTarget = ResourceManager::Get()->GetTarget(target);
+
+		Float4x4 cameraView = XMMatrixLookToLH(
+			packet.Camera.Position,
+			packet.Camera.Forward,
+			cameraTransform.GetUp());
+
+		Float4x4 cameraProjection = XMMatrixPerspectiveFovLH(
+			cameraSettings.FieldOfView,
+			windowTarget->Viewport.Width / windowTarget->Viewport.Height,
+			cameraSettings.DistanceNearPlane,
+			cameraSettings.DistanceFarPlane);
+
+		Float4x4 cameraViewProjection = cameraView * cameraProjection;
+		packet.Camera.Frustum = Frustum::FromViewProjection(&cameraViewProjection.m[0][0]);
+
+		packet.Camera.LodScale = windowTarget->Viewport.Height / (2.f * std::tan(cameraSettings.FieldOfView * 0.5f));
+	}
 
 	// Initialize targets
 	packet.Targets.Result = target;
+
+	m_statistics.NumVisible = 0;
+	m_statistics.NumCulled = 0;
+	m_statistics.CullTime = 0.f;
+	m_statistics.NumRejected = 0;
+	m_statistics.LodSelectTime = 0.f;
+
+	m_submitBegin = Time::Now();
 }
 
-void env::Renderer::Submit(Transform& transform, ID mesh, ID material)
+UINT env::Renderer::GetDrawKeyMeshIndex(FramePacket& packet, ID mesh)
 {
-	FramePacket& packet = GetCurrentFramePacket();
+	auto [it, isNew] = packet.DrawKeyMeshIndices.try_emplace(mesh, (UINT)packet.DrawKeyMeshes.size());
+	if (isNew)
+		packet.DrawKeyMeshes.push_back(mesh);
+	return it->second;
+}
 
-	UINT materialIndex = 0;
-	if (packet.MaterialInstanceIndices.count(material)) {
-		materialIndex = packet.MaterialInstanceIndices[material];
-	}
-	else {
+UINT env::Renderer::GetMaterialIndex(FramePacket& packet, ID material)
+{
+	assert(material > 0);
+
+	if ((size_t)material >= packet.MaterialIndexLookup.size())
+		packet.MaterialIndexLookup.resize((size_t)material + 1, 0);
+
+	UINT& lookup = packet.MaterialIndexLookup[(size_t)material];
+	if (lookup == 0) {
 		Material* materialData = AssetManager::Get()->GetMaterial(material);
 
 		MaterialBufferInstanceData instanceData;
 		instanceData.AmbientFactor = materialData->AmbientFactor;
-		instanceData.AmbientMapIndex = materialData->AmbientMap;
+		instanceData.AmbientMapIndex = GetMapIndex(materialData->AmbientMap);
 		instanceData.DiffuseFactor = materialData->DiffuseFactor;
-		instanceData.DiffuseMapIndex = materialData->DiffuseMap;
+		instanceData.DiffuseMapIndex = GetMapIndex(materialData->DiffuseMap);
 		instanceData.SpecularFactor = materialData->SpecularFactor;
-		instanceData.SpecularMapIndex = materialData->SpecularMap;
+		instanceData.SpecularMapIndex = GetMapIndex(materialData->SpecularMap);
 		instanceData.Shininess = materialData->Shininess;
 		instanceData.MaterialID = (int)material;
 		instanceData.Padding = Float2::Zero;
 
-		materialIndex = (UINT)packet.MaterialInstanceIndices.size();
 		packet.MaterialInstances.push_back(instanceData);
-		packet.MaterialInstanceIndices[material] = materialIndex;
+		lookup = (UINT)packet.MaterialInstances.size();
+	}
+
+	return lookup - 1;
+}
+
+void env::Renderer::WriteInstanceData(InstanceBufferElementData& destination, const Float4x4& worldMatrix, ID mesh, UINT materialIndex)
+{
+	// Directions are the normalized axes of the world matrix, so any parent
+	// rotation is included
+	Float3 forward(worldMatrix._31, worldMatrix._32, worldMatrix._33);
+	Float3 up(worldMatrix._21, worldMatrix._22, worldMatrix._23);
+	forward.Normalize();
+	up.Normalize();
+
+	destination.Position = worldMatrix.Translation();
+	destination.ID = mesh;
+	destination.ForwardDirection = forward;
+	destination.MaterialIndex = materialIndex;
+	destination.UpDirection = up;
+	destination.Pad = 0;
+	destination.WorldMatrix = worldMatrix.Transpose();
+}
+
+bool env::Renderer::GetWorldBoundingSphere(const Float4x4& world, const MeshBounds& bounds, Float3& center, float& radius)
+{
+	if (bounds.Radius < 0.f)
+		return false;
+
+	center = Float3::Transform(bounds.Center, world);
+
+	// Scale the radius by the largest axis scale
+	float scaleSquared = std::max({
+		Float3(world._11, world._12, world._13).LengthSquared(),
+		Float3(world._21, world._22, world._23).LengthSquared(),
+		Float3(world._31, world._32, world._33).LengthSquared() });
+	radius = bounds.Radius * std::sqrt(scaleSquared);
+
+	return true;
+}
+
+UINT env::Renderer::SelectLod(const FramePacket& packet, const Mesh* mesh, const Float3& center, float radius) const
+{
+	if (!m_lodEnabled || mesh->NumLods == 0 || mesh->Bounds.Radius <= 0.f)
+		return 0;
+
+	// Distance to the closest point of the sphere, instances around the
+	// camera are never closer than the near plane
+	float distance = std::max((center - packet.Camera.Position).Length() - radius, packet.Camera.Settings.DistanceNearPlane);
+
+	// The errors are in object space, the bounds give the scale to world space
+	float pixelsPerUnit = packet.Camera.LodScale * (radius / mesh->Bounds.Radius) / distance;
+
+	// The errors grow with every LOD
+	UINT lod = 0;
+	while (lod < mesh->NumLods && mesh->Lods[lod].Error * pixelsPerUnit <= m_lodErrorThreshold)
+		lod++;
+
+	return lod;
+}
+
+ID env::Renderer::GetStreamKey(ID mesh, UINT lod)
+{
+	assert(mesh >= 0 && mesh < (1ll << 56));
+	return mesh | ((ID)lod << 56);
+}
+
+ID env::Renderer::GetStreamKeyMesh(ID key)
+{
+	return key & ((1ll << 56) - 1);
+}
+
+UINT env::Renderer::GetStreamKeyLod(ID key)
+{
+	return (UINT)(key >> 56);
+}
+
+void env::Renderer::Submit(Transform& transform, ID mesh, ID material)
+{
+	Submit(transform.GetMatrix(), mesh, material);
+}
+
+void env::Renderer::Submit(const Float4x4& worldMatrix, ID mesh, ID material)
+{
+	FramePacket& packet = GetCurrentFramePacket();
+	const Mesh* meshAsset = AssetManager::Get()->GetMesh(mesh);
+	if (!meshAsset) {
+		RejectSubmit("Submitted a mesh that does not exist");
+		return;
+	}
+
+	Float3 center;
+	float radius;
+	bool hasBounds = GetWorldBoundingSphere(worldMatrix, meshAsset->Bounds, center, radius);
+
+	if (m_cullingEnabled && hasBounds &&
+		!IsSphereVisible(packet.Camera.Frustum, center.x, center.y, center.z, radius)) {
+		m_statistics.NumCulled++;
+		return;
+	}
+	m_statistics.NumVisible++;
+
+	UINT materialIndex = GetMaterialIndex(packet, material);
+
+	if (packet.InstanceStream.Enabled) {
+		assert(packet.InstanceStream.Data); // BeginInstanceStream has not been called
+
+		// Reserved per mesh, so always at full detail. Writing past the
+		// reserved range would overwrite the instances of another mesh.
+		auto rangeIt = packet.InstanceStream.MeshRanges.find(GetStreamKey(mesh, 0));
+		if (rangeIt == packet.InstanceStream.MeshRanges.end()) {
+			RejectSubmit("Submitted a mesh without reserved instances");
+			return;
+		}
+
+		MeshInstanceRange& range = rangeIt->second;
+		if (range.NextInstance == range.Offset + range.NumInstances) {
+			RejectSubmit("Submitted more instances of a mesh than were reserved");
+			return;
+		}
+
+		// The memory is write-combined, so each member is written once and never read back
+		WriteInstanceData(packet.InstanceStream.Data[range.NextInstance++], worldMatrix, mesh, materialIndex);
+		return;
+	}
+
+	// Depth along the camera forward, quantized over [0, far plane]
+	Float3 toInstance = worldMatrix.Translation() - packet.Camera.Position;
+	float depth = toInstance.Dot(packet.Camera.Forward) / packet.Camera.Settings.DistanceFarPlane;
+	depth = std::min(std::max(depth, 0.0f), 1.0f);
+	UINT quantizedDepth = (UINT)(depth * (float)((1u << DrawKey::DEPTH_BITS) - 1));
+
+	UINT lod = hasBounds ? SelectLod(packet, meshAsset, center, radius) : 0;
+
+	// The draw would be sorted with the wrong mesh or material
+	UINT meshIndex = GetDrawKeyMeshIndex(packet, mesh);
+	if (meshIndex >= DrawKey::MAX_MESHES || materialIndex >= DrawKey::MAX_MATERIALS) {
+		RejectSubmit("More meshes or materials in the frame than the draw keys can hold");
+		return;
+	}
+
+	packet.DrawKeys.push_back(DrawKey::Create(0, meshIndex, lod, materialIndex, quantizedDepth));
+	packet.DrawKeyInstances.push_back((UINT)packet.Instances.size());
+	WriteInstanceData(packet.Instances.emplace_back(), worldMatrix, mesh, materialIndex);
+}
+
+void env::Renderer::ReserveInstances(ID mesh, UINT numInstances)
+{
+	ReserveLodInstances(mesh, 0, numInstances);
+}
+
+void env::Renderer::ReserveLodInstances(ID mesh, UINT lod, UINT numInstances)
+{
+	FramePacket& packet = GetCurrentFramePacket();
+	assert(!packet.InstanceStream.Data); // Can't reserve after BeginInstanceStream
+
+	packet.InstanceStream.Enabled = true;
+	packet.InstanceStream.MeshRanges[GetStreamKey(mesh, lod)].NumInstances += numInstances;
+}
+
+void env::Renderer::RejectSubmit(const char* reason, UINT numRejected)
+{
+	if (numRejected == 0)
+		return;
+
+	if (m_statistics.NumRejected == 0)
+		OutputDebugStringA((std::string("Renderer: ") + reason + "\n").c_str());
+	m_statistics.NumRejected += numRejected;
+}
+
+void env::Renderer::BeginInstanceStream()
+{
+	FramePacket& packet = GetCurrentFramePacket();
+
+	if (!packet.InstanceStream.Enabled)
+		return;
+
+	// Prefix sum over the reserved counts gives each mesh a contiguous
+	// range, so instances can be written in any order during Submit.
+	UINT instanceOffset = 0;
+	for (auto& [key, range] : packet.InstanceStream.MeshRanges) {
+		range.Offset = instanceOffset;
+		range.NextInstance = instanceOffset;
+		instanceOffset += range.NumInstances;
 	}
 
-	InstanceBufferElementData objectData;
-	objectData.Position = transform.GetPosition();
-	objectData.ID = mesh;
-	objectData.ForwardDirection = transform.GetForward();
-	objectData.MaterialIndex = materialIndex;
-	objectData.UpDirection = transform.GetUp();
-	objectData.Pad = 0;
-	objectData.WorldMatrix = transform.GetMatrixTransposed();
-
-	if (packet.MeshOpaqueInstances.count(mesh) == 0) {
-		std::vector<InstanceBufferElementData>& meshInstances = packet.MeshOpaqueInstances[mesh];
-		meshInstances.push_back(objectData);
+	packet.InstanceStream.NumInstances = instanceOffset;
+	packet.InstanceStream.Data = EnsureInstanceCapacity(packet, instanceOffset);
+}
+
+void env::Renderer::SubmitParallel(Scene& scene, UINT maxThreads)
+{
+	FramePacket& packet = GetCurrentFramePacket();
+	assert(!packet.InstanceStream.Data); // Can't be called after BeginInstanceStream
+
+	auto view = scene.View<RenderComponent, WorldTransformComponent>();
+	const auto& entities = view.handle();
+	const size_t numEntities = entities.size();
+	const size_t numChunks = (numEntities + SUBMIT_CHUNK_SIZE - 1) / SUBMIT_CHUNK_SIZE;
+
+	// Only touched by the thread processing the chunk, except when merging
+	struct SubmitChunk
+	{
+		std::vector<uint8_t> Visible; // One per entity in the chunk, zero if it is skipped
+		std::vector<uint8_t> Lods; // One per entity in the chunk, only set for the visible ones
+		UINT NumVisible = 0;
+		UINT NumCulled = 0;
+		UINT NumMissingMeshes = 0;
+		float LodSelectTime = 0.f;
+		std::unordered_map<ID, UINT> MeshCursors; // By stream key. Instance count when counting, write position when writing
+		std::vector<ID> Materials; // In the order they are first used
+	};
+	std::vector<SubmitChunk> chunks(numChunks);
+
+	// A. Find the visible entities of each chunk and their LODs. The bounding
+	//	spheres are gathered in small batches and tested four at a time.
+	Timepoint cullBegin = Time::Now();
+	JobSystem::Get()->ParallelFor(numChunks, [&](size_t chunkIndex) {
+		SubmitChunk& chunk = chunks[chunkIndex];
+
+		const size_t begin = chunkIndex * SUBMIT_CHUNK_SIZE;
+		const size_t end = std::min(numEntities, begin + SUBMIT_CHUNK_SIZE);
+		chunk.Visible.resize(end - begin);
+		chunk.Lods.resize(end - begin);
+
+		const size_t BATCH_SIZE = 64;
+		float centersX[BATCH_SIZE];
+		float centersY[BATCH_SIZE];
+		float centersZ[BATCH_SIZE];
+		float radii[BATCH_SIZE];
+		uint8_t overrides[BATCH_SIZE]; // 0 to use the test result, 1 to skip, 2 to always keep
+		const Mesh* meshAssets[BATCH_SIZE]; // nullptr if the bounds are unknown
+
+		for (size_t batchBegin = begin; batchBegin < end; batchBegin += BATCH_SIZE) {
+			const size_t batchSize = std::min(BATCH_SIZE, end - batchBegin);
+
+			for (size_t k = 0; k < batchSize; k++) {
+				centersX[k] = centersY[k] = centersZ[k] = radii[k] = 0.f;
+				meshAssets[k] = nullptr;
+
+				const entt::entity entity = entities[batchBegin + k];
+				if (!view.contains(entity)) {
+					overrides[k] = 1;
+					continue;
+				}
+
+				auto [render, transform] = view.get<RenderComponent, WorldTransformComponent>(entity);
+				const Mesh* meshAsset = AssetManager::Get()->GetMesh(render.Mesh);
+				if (!meshAsset) {
+					chunk.NumMissingMeshes++;
+					overrides[k] = 1;
+					continue;
+				}
+
+				Float3 center;
+				if (!GetWorldBoundingSphere(transform.Matrix, meshAsset->Bounds, center, radii[k])) {
+					overrides[k] = 2;
+					continue;
+				}
+
+				// The sphere is needed for the LOD even without culling
+				centersX[k] = center.x;
+				centersY[k] = center.y;
+				centersZ[k] = center.z;
+				meshAssets[k] = meshAsset;
+				overrides[k] = m_cullingEnabled ? 0 : 2;
+			}
+
+			uint8_t* visible = &chunk.Visible[batchBegin - begin];
+			CullSpheres(packet.Camera.Frustum, centersX, centersY, centersZ, radii, batchSize, visible);
+
+			for (size_t k = 0; k < batchSize; k++) {
+				if (overrides[k] != 0)
+					visible[k] = (overrides[k] == 2) ? 1 : 0;
+				else if (!visible[k])
+					chunk.NumCulled++;
+				chunk.NumVisible += visible[k];
+			}
+
+			Timepoint lodBegin = Time::Now();
+			uint8_t* lods = &chunk.Lods[batchBegin - begin];
+			for (size_t k = 0; k < batchSize; k++) {
+				lods[k] = (visible[k] && meshAssets[k]) ?
+					(uint8_t)SelectLod(packet, meshAssets[k], { centersX[k], centersY[k], centersZ[k] }, radii[k]) :
+					0;
+			}
+			chunk.LodSelectTime += (Time::Now() - lodBegin).InSeconds();
+		}
+	}, maxThreads);
+	m_statistics.CullTime = (Time::Now() - cullBegin).InSeconds();
+
+	for (SubmitChunk& chunk : chunks) {
+		m_statistics.NumVisible += chunk.NumVisible;
+		m_statistics.NumCulled += chunk.NumCulled;
+		m_statistics.LodSelectTime += chunk.LodSelectTime;
+		RejectSubmit("Submitted a mesh that does not exist", chunk.NumMissingMeshes);
 	}
-	else {
-		packet.MeshOpaqueInstances[mesh].push_back(objectData);
+
+	// B. Count instances per mesh and collect the materials of each chunk
+	JobSystem::Get()->ParallelFor(numChunks, [&](size_t chunkIndex) {
+		SubmitChunk& chunk = chunks[chunkIndex];
+		std::unordered_set<ID> usedMaterials;
+
+		const size_t begin = chunkIndex * SUBMIT_CHUNK_SIZE;
+		const size_t end = std::min(numEntities, begin + SUBMIT_CHUNK_SIZE);
+		for (size_t i = begin; i < end; i++) {
+			if (!chunk.Visible[i - begin])
+				continue;
+
+			const entt::entity entity = entities[i];
+
+			const RenderComponent& render = view.get<RenderComponent>(entity);
+			++chunk.MeshCursors[GetStreamKey(render.Mesh, chunk.Lods[i - begin])];
+			if (usedMaterials.insert(render.Material).second)
+				chunk.Materials.push_back(render.Material);
+		}
+	}, maxThreads);
+
+	// C. Merge in chunk order, this gives the same material table and
+	//	instance order as submitting the view serially
+	for (SubmitChunk& chunk : chunks) {
+		for (ID material : chunk.Materials)
+			GetMaterialIndex(packet, material);
+		for (auto& [key, numInstances] : chunk.MeshCursors)
+			ReserveLodInstances(GetStreamKeyMesh(key), GetStreamKeyLod(key), numInstances);
+	}
+
+	BeginInstanceStream();
+
+	// Each chunk gets a consecutive part of every mesh range
+	for (SubmitChunk& chunk : chunks) {
+		for (auto& [key, cursor] : chunk.MeshCursors) {
+			MeshInstanceRange& range = packet.InstanceStream.MeshRanges[key];
+			UINT numInstances = cursor;
+			cursor = range.NextInstance;
+			range.NextInstance += numInstances;
+		}
 	}
+
+	// D. Write the instances, the material table is only read from here on
+	InstanceBufferElementData* instanceData = packet.InstanceStream.Data;
+	JobSystem::Get()->ParallelFor(numChunks, [&](size_t chunkIndex) {
+		SubmitChunk& chunk = chunks[chunkIndex];
+
+		const size_t begin = chunkIndex * SUBMIT_CHUNK_SIZE;
+		const size_t end = std::min(numEntities, begin + SUBMIT_CHUNK_SIZE);
+		for (size_t i = begin; i < end; i++) {
+			if (!chunk.Visible[i - begin])
+				continue;
+
+			const entt::entity entity = entities[i];
+
+			auto [render, transform] = view.get<RenderComponent, WorldTransformComponent>(entity);
+			UINT materialIndex = packet.MaterialIndexLookup[(size_t)render.Material] - 1;
+			ID key = GetStreamKey(render.Mesh, chunk.Lods[i - begin]);
+			WriteInstanceData(instanceData[chunk.MeshCursors[key]++], transform.Matrix, render.Mesh, materialIndex);
+		}
+	}, maxThreads);
+}
+
+void env::Renderer::SetCullingEnabled(bool enabled)
+{
+	m_cullingEnabled = enabled;
+}
+
+void env::Renderer::SetLodEnabled(bool enabled)
+{
+	m_lodEnabled = enabled;
+}
+
+void env::Renderer::SetLodErrorThreshold(float pixels)
+{
+	assert(pixels > 0.f);
+	m_lodErrorThreshold = pixels;
+}
+
+void env::Renderer::SetMaxRecordThreads(UINT maxThreads)
+{
+	m_maxRecordThreads = maxThreads;
+}
+
+const env::RendererStatistics& env::Renderer::GetStatistics() const
+{
+	return m_statistics;
+}
+
+const env::RenderGraphExecutor& env::Renderer::GetRenderGraph() const
+{
+	return m_renderGraph;
+}
+
+const env::Frustum& env::Renderer::GetCameraFrustum()
+{
+	return GetCurrentFramePacket().Camera.Frustum;
 }
 
 void env::Renderer::EndFrame()
 {
+	m_statistics.SubmitTime = (Time::Now() - m_submitBegin).InSeconds();
+	m_statistics.SortTime = 0.f;
+
 	ResourceManager* resourceManager = ResourceManager::Get();
 	FramePacket& packet = GetCurrentFramePacket();
 
-	DescriptorAllocator& currentDescriptorAllocator = m_descriptorAllocators[m_currentFramePacketIndex];
-	currentDescriptorAllocator.Clear();
-
 	PipelineState* pipeline = resourceManager->GetPipelineState(m_pipelineState);
 	WindowTarget* target = resourceManager->GetTarget(packet.Targets.Result);
-	Texture2D* depth = resourceManager->GetTexture2D(packet.Targets.Depth);
 
 	const Float4 TARGET_CLEAR_COLOR = { 0.2f, 0.2f, 0.2f, 1.0f };
 	const float DEPTH_CLEAR_VALUE = 1.0f;
 
-	m_directList->Reset();
-	m_directList->ClearRenderTarget(target->Views.RenderTarget, TARGET_CLEAR_COLOR);
-	m_directList->ClearDepthStencil(depth, true, false, DEPTH_CLEAR_VALUE, 0);
-	m_directList->SetTarget(target, depth);
-	m_directList->SetPipelineState(pipeline);
-
-	ID3D12DescriptorHeap* descriptorHeap = currentDescriptorAllocator.GetHeap();
-	m_directList->SetDescriptorHeaps(1, &descriptorHeap);
+	// Views are indexed in the bindless heap, nothing is copied per frame
+	BindlessHeap& bindlessHeap = resourceManager->GetBindlessHeap();
+	ID3D12DescriptorHeap* descriptorHeap = bindlessHeap.GetHeap();
+	D3D12_GPU_DESCRIPTOR_HANDLE bindlessTable = bindlessHeap.GetTable();
+	D3D12_GPU_VIRTUAL_ADDRESS cameraBufferAddress = 0;
+	UINT materialBufferIndex = 0;
+	UINT instanceBufferIndex = 0;
 
 	{ // Update and set camera buffer
 		using namespace DirectX;
@@ -269,8 +717,7 @@ void env::Renderer::EndFrame()
 			&bufferData,
 			sizeof(bufferData));
 
-		m_directList->GetNative()->SetGraphicsRootConstantBufferView(ROOT_INDEX_CAMERA_BUFFER,
-			cameraBuffer->Native->GetGPUVirtualAddress());
+		cameraBufferAddress = cameraBuffer->GetGPUAddress();
 	}
 
 	{ // Update and set material buffer
@@ -279,79 +726,257 @@ void env::Renderer::EndFrame()
 		packet.MaterialInstances.size() * sizeof(MaterialBufferInstanceData));
 
 		BufferArray* materialBuffer = ResourceManager::Get()->GetBufferArray(packet.Buffers.Material);
-		D3D12_CPU_DESCRIPTOR_HANDLE bufferShaderResource = materialBuffer->Views.ShaderResource;
-		DescriptorAllocation frameAllocation = currentDescriptorAllocator.Allocate();
-		GPU::GetDevice()->CopyDescriptorsSimple(1,
-			frameAllocation.CPUHandle,
-			bufferShaderResource,
-			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-		m_directList->GetNative()->SetGraphicsRootDescriptorTable(ROOT_INDEX_MATERIAL_TABLE,
-			frameAllocation.GPUHandle);
+		materialBufferIndex = materialBuffer->Views.ShaderResource.Index;
 	}
 
 	struct RenderJob {
 		ID Mesh;
+		UINT Lod;
 		UINT InstanceOffset;
 		UINT NumInstances;
+
+		// Resolved before recording, the lookups are not thread safe
+		const env::Mesh* MeshAsset = nullptr;
+		Buffer* VertexBuffer = nullptr;
+		Buffer* IndexBuffer = nullptr;
+		UINT OffsetIndices = 0;
+		UINT NumIndices = 0;
 	};
 	std::vector<RenderJob> jobs;
 
+	UINT numInstances = 0;
+
 	{ // Update and set instance buffer, create render jobs
-		std::vector<InstanceBufferElementData> intermediateInstanceData;
-
-		// Iterate all submission and
-		//	A. Copy memory to intermediate instance buffer (CPU, to be uploaded to GPU)
-		//	B. Create instance render jobs
-
-		UINT instanceOffset = 0;
-		for (auto& [meshID, meshInstances] : packet.MeshOpaqueInstances) {
-			RenderJob job;
-			job.Mesh = meshID;
-			job.InstanceOffset = instanceOffset;
-			job.NumInstances = (UINT)meshInstances.size();
-			jobs.push_back(job);
-
-			intermediateInstanceData.insert(intermediateInstanceData.end(), meshInstances.begin(), meshInstances.end());
-			instanceOffset += job.NumInstances;
+		if (packet.InstanceStream.Enabled) {
+			// The instances are already in place, only create the render jobs
+			for (auto& [key, range] : packet.InstanceStream.MeshRanges) {
+				UINT numSubmitted = range.NextInstance - range.Offset;
+				if (numSubmitted == 0)
+					continue;
+
+				RenderJob job;
+				job.Mesh = GetStreamKeyMesh(key);
+				job.Lod = GetStreamKeyLod(key);
+				job.InstanceOffset = range.Offset;
+				job.NumInstances = numSubmitted;
+				jobs.push_back(job);
+
+				numInstances += numSubmitted;
+			}
+		}
+		else {
+			const size_t numKeys = packet.DrawKeys.size();
+			packet.SortScratchKeys.resize(numKeys);
+			packet.SortScratchInstances.resize(numKeys);
+
+			Timepoint sortBegin = Time::Now();
+			bool sortedInScratch = RadixSort(packet.DrawKeys.data(),
+				packet.DrawKeyInstances.data(),
+				packet.SortScratchKeys.data(),
+				packet.SortScratchInstances.data(),
+				numKeys);
+			m_statistics.SortTime = (Time::Now() - sortBegin).InSeconds();
+
+			const UINT64* sortedKeys = sortedInScratch ? packet.SortScratchKeys.data() : packet.DrawKeys.data();
+			const UINT* sortedInstances = sortedInScratch ? packet.SortScratchInstances.data() : packet.DrawKeyInstances.data();
+
+			numInstances = (UINT)numKeys;
+			InstanceBufferElementData* instanceData = EnsureInstanceCapacity(packet, numInstances);
+
+			// Gather the instances in key order to the mapped instance buffer,
+			// each run of keys with the same batch becomes one render job
+			for (UINT i = 0; i < numInstances; i++) {
+				if (i == 0 || DrawKey::GetBatch(sortedKeys[i]) != DrawKey::GetBatch(sortedKeys[i - 1])) {
+					RenderJob job;
+					job.Mesh = packet.DrawKeyMeshes[DrawKey::GetMeshIndex(sortedKeys[i])];
+					job.Lod = DrawKey::GetLod(sortedKeys[i]);
+					job.InstanceOffset = i;
+					job.NumInstances = 0;
+					jobs.push_back(job);
+				}
+
+				jobs.back().NumInstances++;
+				instanceData[i] = packet.Instances[sortedInstances[i]];
+			}
 		}
 
-		ResourceManager::Get()->UploadBufferData(packet.Buffers.Instance,
-			intermediateInstanceData.data(),
-			intermediateInstanceData.size() * sizeof(InstanceBufferElementData));
-
+		// Read after EnsureInstanceCapacity, which recreates the view when the buffer grows
 		BufferArray* instanceBuffer = ResourceManager::Get()->GetBufferArray(packet.Buffers.Instance);
-		D3D12_CPU_DESCRIPTOR_HANDLE bufferShaderResource = instanceBuffer->Views.ShaderResource;
-		DescriptorAllocation frameAllocation = currentDescriptorAllocator.Allocate();
-		GPU::GetDevice()->CopyDescriptorsSimple(1,
-			frameAllocation.CPUHandle,
-			bufferShaderResource,
-			D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-
-		m_directList->GetNative()->SetGraphicsRootDescriptorTable(ROOT_INDEX_INSTANCE_TABLE,
-			frameAllocation.GPUHandle);
+		instanceBufferIndex = instanceBuffer->Views.ShaderResource.Index;
+	}
+
+	m_statistics.NumTriangles = 0;
+	m_statistics.NumFullDetailTriangles = 0;
+	for (UINT lod = 0; lod < MAX_MESH_LODS; lod++)
+		m_statistics.NumInstancesPerLod[lod] = 0;
+
+	for (RenderJob& job : jobs) {
+		job.MeshAsset = AssetManager::Get()->GetMesh(job.Mesh);
+		job.VertexBuffer = ResourceManager::Get()->GetBuffer(job.MeshAsset->VertexBuffer);
+		job.IndexBuffer = ResourceManager::Get()->GetBuffer(job.MeshAsset->IndexBuffer);
+		GetLodIndices(job.MeshAsset, job.Lod, job.OffsetIndices, job.NumIndices);
+
+		m_statistics.NumTriangles += (UINT64)job.NumInstances * (job.NumIndices / 3);
+		m_statistics.NumFullDetailTriangles += (UINT64)job.NumInstances * (job.MeshAsset->NumIndices / 3);
+		m_statistics.NumInstancesPerLod[std::min(job.Lod, MAX_MESH_LODS - 1)] += job.NumInstances;
 	}
 
-	for (auto& job : jobs) {
-		const Mesh* meshAsset = AssetManager::Get()->GetMesh(job.Mesh);
-		Buffer* vertexBuffer = ResourceManager::Get()->GetBuffer(meshAsset->VertexBuffer);
-		Buffer* indexBuffer = ResourceManager::Get()->GetBuffer(meshAsset->IndexBuffer);
-
-		m_directList->SetVertexBuffer(vertexBuffer, 0);
-		m_directList->SetIndexBuffer(indexBuffer);
-		m_directList->GetNative()->SetGraphicsRoot32BitConstant(ROOT_INDEX_INSTANCE_OFFSET_CONSTANT,
-			job.InstanceOffset, 0);
-
-		m_directList->DrawIndexedInstanced(meshAsset->NumIndices,
-			job.NumInstances,
-			meshAsset->OffsetIndices,
-			meshAsset->OffsetVertices,
-			0);
+	// Set in the pass, the depth buffer only lives while the graph executes
+	Texture2D* depth = nullptr;
+
+	// Every list starts without any state
+	auto setDrawState = [&](DirectList* list) {
+		list->SetTarget(target, depth);
+		list->SetPipelineState(pipeline);
+		list->SetDescriptorHeaps(1, &descriptorHeap);
+		list->SetRootConstantBufferView(ROOT_INDEX_CAMERA_BUFFER, cameraBufferAddress);
+		list->SetRootDescriptorTable(ROOT_INDEX_BINDLESS_TABLE, bindlessTable);
+		list->SetRoot32BitConstant(ROOT_INDEX_CONSTANTS, instanceBufferIndex, ROOT_CONSTANT_INSTANCE_BUFFER);
+		list->SetRoot32BitConstant(ROOT_INDEX_CONSTANTS, materialBufferIndex, ROOT_CONSTANT_MATERIAL_BUFFER);
+	};
+
+	auto setPositionBox = [&](DirectList* list, const MeshBounds& bounds) {
+		const float box[6] = {
+			(bounds.Min.x + bounds.Max.x) * 0.5f,
+			(bounds.Min.y + bounds.Max.y) * 0.5f,
+			(bounds.Min.z + bounds.Max.z) * 0.5f,
+			(bounds.Max.x - bounds.Min.x) * 0.5f,
+			(bounds.Max.y - bounds.Min.y) * 0.5f,
+			(bounds.Max.z - bounds.Min.z) * 0.5f,
+		};
+
+		for (UINT j = 0; j < 3; j++) {
+			UINT center, extent;
+			memcpy(&center, &box[j], sizeof(UINT));
+			memcpy(&extent, &box[3 + j], sizeof(UINT));
+			list->SetRoot32BitConstant(ROOT_INDEX_CONSTANTS, center, ROOT_CONSTANT_POSITION_CENTER + j);
+			list->SetRoot32BitConstant(ROOT_INDEX_CONSTANTS, extent, ROOT_CONSTANT_POSITION_EXTENTS + j);
+		}
+	};
+
+	auto recordJobs = [&](DirectList* list, size_t begin, size_t end) {
+		const env::Mesh* lastMesh = nullptr;
+		for (size_t i = begin; i < end; i++) {
+			const RenderJob& job = jobs[i];
+
+			list->SetVertexBuffer(job.VertexBuffer, 0);
+			list->SetIndexBuffer(job.IndexBuffer);
+			list->SetRoot32BitConstant(ROOT_INDEX_CONSTANTS, job.InstanceOffset, ROOT_CONSTANT_INSTANCE_OFFSET);
+
+			// Positions are quantized to the mesh bounds, jobs of the same
+			// mesh are next to each other
+			if (job.MeshAsset != lastMesh) {
+				setPositionBox(list, job.MeshAsset->Bounds);
+				lastMesh = job.MeshAsset;
+			}
+
+			list->DrawIndexedInstanced(job.NumIndices,
+				job.NumInstances,
+				job.OffsetIndices,
+				job.MeshAsset->OffsetVertices,
+				0);
+		}
+	};
+
+	// Large frames are split in ranges of jobs, each recorded into its own
+	// list on the job system. The lists are executed in range order.
+	size_t numLists = (jobs.size() + RECORD_CHUNK_SIZE - 1) / RECORD_CHUNK_SIZE;
+	numLists = std::min(numLists, (size_t)JobSystem::Get()->GetNumThreads());
+	if (m_maxRecordThreads > 0)
+		numLists = std::min(numLists, (size_t)m_maxRecordThreads);
+
+	// The target and the mesh buffers are transitioned by the graph in one
+	// batch before the pass, so the lists recorded on other threads only
+	// read the resource states. The depth buffer covers the whole window,
+	// like the backbuffers.
+	m_renderGraph.Begin();
+	UINT targetResource = m_renderGraph.ImportResource(target);
+	UINT depthResource = m_renderGraph.CreateTexture("DepthStencil",
+		target->AppWindow->GetWidth(),
+		target->AppWindow->GetHeight(),
+		DXGI_FORMAT_D32_FLOAT,
+		TextureBindType::DepthStencil);
+
+	UINT mainPass = m_renderGraph.AddPass("Main", [&](RenderGraphContext& context) {
+		DirectList* directList = context.GetList();
+		depth = context.GetTexture(depthResource);
+
+		// Clears the depth buffer before anything else, its memory may
+		// have held another target
+		directList->ClearRenderTarget(target->Views.RenderTarget, TARGET_CLEAR_COLOR);
+		directList->ClearDepthStencil(depth, true, false, DEPTH_CLEAR_VALUE, 0);
+
+		Timepoint recordBegin = Time::Now();
+		setDrawState(directList);
+
+		if (numLists <= 1) {
+			recordJobs(directList, 0, jobs.size());
+		}
+		else {
+			std::vector<DirectList*> jobLists(numLists);
+			JobSystem::Get()->ParallelFor(numLists, [&](size_t listIndex) {
+				DirectList* list = GPU::AcquireDirectList();
+				setDrawState(list);
+				recordJobs(list, listIndex * jobs.size() / numLists, (listIndex + 1) * jobs.size() / numLists);
+				list->Close();
+				jobLists[listIndex] = list;
+			});
+			context.QueueLists(jobLists.data(), (UINT)numLists);
+		}
+		m_statistics.RecordTime = (Time::Now() - recordBegin).InSeconds();
+	});
+
+	m_renderGraph.Write(mainPass, targetResource, D3D12_RESOURCE_STATE_RENDER_TARGET);
+	m_renderGraph.Write(mainPass, depthResource, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+	for (const RenderJob& job : jobs) {
+		m_renderGraph.Read(mainPass, m_renderGraph.ImportResource(job.VertexBuffer), D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+		m_renderGraph.Read(mainPass, m_renderGraph.ImportResource(job.IndexBuffer), D3D12_RESOURCE_STATE_INDEX_BUFFER);
 	}
 
+	// Executed together with the rest of the frame in SubmitFrame
+	m_renderGraph.Execute(GPU::GetPresentQueue());
+
+	m_statistics.NumCommandLists = (UINT)std::max(numLists, (size_t)1);
+	m_statistics.NumInstances = numInstances;
+	m_statistics.NumDrawCalls = (UINT)jobs.size();
+	m_statistics.InstanceCapacity = resourceManager->GetBufferArray(packet.Buffers.Instance)->Layout.GetNumRepetitions();
 
-	m_directList->Close();
+	// Submit this frame's uploads as one batch, the present queue
+	// waits for it before executing the frame.
+	ResourceManager::Get()->FlushUploads();
+}
 
+UINT64 env::Renderer::SubmitFrame()
+{
 	CommandQueue& queue = GPU::GetPresentQueue();
-	queue.QueueList(m_directList);
+	queue.Execute();
+	UINT64 fenceValue = m_framePipeline.EndFrame();
+
+	ResourceManager::Get()->ReleaseCompletedResources();
+	return fenceValue;
+}
+
+void env::Renderer::SetFramePipelineDepth(UINT depth)
+{
+	m_framePipeline.SetDepth(depth);
+}
+
+UINT env::Renderer::GetFramePipelineDepth() const
+{
+	return m_framePipeline.GetDepth();
+}
+
+UINT env::Renderer::GetNumFramesInFlight()
+{
+	return m_framePipeline.GetNumFramesInFlight();
+}
+
+UINT env::Renderer::GetFramePacketIndex() const
+{
+	return (UINT)m_currentFramePacketIndex;
+}
+
+UINT env::Renderer::GetMaxFramesInFlight()
+{
+	return NUM_FRAME_PACKETS;
 }
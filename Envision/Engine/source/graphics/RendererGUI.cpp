@@ -1,6 +1,7 @@
 #include "envision/graphics/RendererGUI.h"
 #include "envision/core/GPU.h"
 #include "envision/core/Window.h"
+#include "envision/graphics/Renderer.h"
 #include "envision/resource/ResourceManager.h"
 
 env::RendererGUI* env::RendererGUI::s_instance = nullptr;
@@ -35,8 +36,6 @@ env::RendererGUI::RendererGUI(env::IDGenerator& commonIDGenerator) :
 	}
 
 	{ // Init rendering API for ImGui
-		m_directList = GPU::CreateDirectCommandList();
-		
 		D3D12_DESCRIPTOR_HEAP_DESC desc;
 		ZeroMemory(&desc, sizeof(desc));
 		desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
@@ -50,7 +49,7 @@ env::RendererGUI::RendererGUI(env::IDGenerator& commonIDGenerator) :
 
 env::RendererGUI::~RendererGUI()
 {
-	delete m_directList;
+	//
 }
 
 void env::RendererGUI::BeginFrame(ID target)
@@ -61,22 +60,36 @@ void env::RendererGUI::BeginFrame(ID target)
 
 		WindowTarget* targetResource = ResourceManager::Get()->GetTarget(m_target);
 		Window* window = targetResource->AppWindow;
+#ifdef PLATFORM_NULL
+		// No platform or renderer backend, ImGui only needs a display size
+		// and its font atlas built
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2((float)window->GetWidth(), (float)window->GetHeight());
+		unsigned char* fontPixels = nullptr;
+		int fontWidth = 0, fontHeight = 0;
+		io.Fonts->GetTexDataAsRGBA32(&fontPixels, &fontWidth, &fontHeight);
+#else
 		ImGui_ImplWin32_Init(window->GetHandle());
 
 		Texture2D* backbuffer = window->GetCurrentBackbuffer();
 		ImGui_ImplDX12_Init(GPU::GetDevice(),
-			1,
+			(int)Renderer::GetMaxFramesInFlight(),
 			backbuffer->Format,
 			m_imguiDescriptorHeap,
 			m_imguiDescriptorHeap->GetCPUDescriptorHandleForHeapStart(),
 			m_imguiDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+#endif
 
 		window->InitializeGUI();
 	}
-	m_directList->Reset();
+	m_directList = GPU::AcquireDirectList();
 
+#ifdef PLATFORM_NULL
+	ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+#else
 	ImGui_ImplDX12_NewFrame();
 	ImGui_ImplWin32_NewFrame();
+#endif
 	ImGui::NewFrame();
 }
 
@@ -88,8 +101,12 @@ void env::RendererGUI::EndFrame()
 	WindowTarget* target = ResourceManager::Get()->GetTarget(m_target);
 	m_directList->SetTarget(target);
 	m_directList->SetDescriptorHeaps(1, &m_imguiDescriptorHeap);
+#ifdef PLATFORM_DIRECT3D_12
 	ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), m_directList->GetNative());
-	
+#endif
+
+	// The GUI is drawn last, the target is handed to the swap chain from here
+	m_directList->TransitionResource(target, D3D12_RESOURCE_STATE_PRESENT);
 	m_directList->Close();
 	CommandQueue& queue = GPU::GetPresentQueue();
 	queue.QueueList(m_directList);
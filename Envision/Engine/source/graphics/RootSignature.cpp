@@ -48,16 +48,10 @@ void env::RootSignature::AdjustRangeTablePointers()
 	for (auto& p : m_parameters) {
 		if (p.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE) {
 
+			// Ranges keep the offsets they were declared with, so they can
+			// overlap. D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND places a range
+			// right after the previous one.
 			p.DescriptorTable.pDescriptorRanges = (m_ranges.data() + rangeOffset);
-
-			int descriptorOffset = 0;
-			auto itRangesBegin = m_ranges.begin() + rangeOffset;
-			auto itRangesEnd = itRangesBegin + p.DescriptorTable.NumDescriptorRanges;
-			for (auto itRange = itRangesBegin; itRange != itRangesEnd; itRange++) {
-				itRange->OffsetInDescriptorsFromTableStart = descriptorOffset;
-				descriptorOffset += itRange->NumDescriptors;
-			}
-
 			rangeOffset += p.DescriptorTable.NumDescriptorRanges;
 		}
 	}
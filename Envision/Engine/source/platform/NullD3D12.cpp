@@ -0,0 +1,1039 @@
+#include "envision/envpch.h"
+
+#ifdef PLATFORM_NULL
+#include <fstream>
+#include <iterator>
+
+// ######################################################################### //
+// ################################ WIN32 ################################## //
+// ######################################################################### //
+
+namespace
+{
+	struct NullEvent
+	{
+		std::mutex Mutex;
+		std::condition_variable Condition;
+		bool ManualReset;
+		bool Signaled;
+	};
+
+	void SignalEvent(HANDLE handle)
+	{
+		NullEvent* event = (NullEvent*)handle;
+		{
+			std::lock_guard<std::mutex> lock(event->Mutex);
+			event->Signaled = true;
+		}
+		event->Condition.notify_all();
+	}
+
+	UINT64 AlignUp(UINT64 value, UINT64 alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// Content of every cached pipeline blob
+	const BYTE NULL_CACHED_PIPELINE[8] = { 'N', 'U', 'L', 'L', 'P', 'S', 'O', 0 };
+}
+
+HANDLE CreateEvent(void* attributes, BOOL manualReset, BOOL initialState, const void* name)
+{
+	NullEvent* event = new NullEvent();
+	event->ManualReset = manualReset;
+	event->Signaled = initialState;
+	return event;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+	NullEvent* event = (NullEvent*)handle;
+	std::unique_lock<std::mutex> lock(event->Mutex);
+
+	// Timeouts are not supported, all waits in the engine are infinite
+	assert(milliseconds == INFINITE);
+	event->Condition.wait(lock, [&]() { return event->Signaled; });
+
+	if (!event->ManualReset)
+		event->Signaled = false;
+	return WAIT_OBJECT_0;
+}
+
+BOOL CloseHandle(HANDLE handle)
+{
+	delete (NullEvent*)handle;
+	return TRUE;
+}
+
+void OutputDebugStringA(LPCSTR text)
+{
+	std::cerr << text;
+}
+
+ULONG IUnknown::AddRef()
+{
+	return ++m_refCount;
+}
+
+ULONG IUnknown::Release()
+{
+	ULONG refCount = --m_refCount;
+	if (refCount == 0)
+		delete this;
+	return refCount;
+}
+
+// ######################################################################### //
+// ################################# DXGI ################################## //
+// ######################################################################### //
+
+UINT NullGetFormatSize(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+	case DXGI_FORMAT_R32G32B32A32_UINT:
+	case DXGI_FORMAT_R32G32B32A32_SINT:
+		return 16;
+
+	case DXGI_FORMAT_R32G32B32_FLOAT:
+	case DXGI_FORMAT_R32G32B32_UINT:
+	case DXGI_FORMAT_R32G32B32_SINT:
+		return 12;
+
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R16G16B16A16_UINT:
+	case DXGI_FORMAT_R16G16B16A16_SNORM:
+	case DXGI_FORMAT_R16G16B16A16_SINT:
+	case DXGI_FORMAT_R32G32_FLOAT:
+	case DXGI_FORMAT_R32G32_UINT:
+	case DXGI_FORMAT_R32G32_SINT:
+		return 8;
+
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UINT:
+	case DXGI_FORMAT_R8G8B8A8_SNORM:
+	case DXGI_FORMAT_R8G8B8A8_SINT:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R16G16_UNORM:
+	case DXGI_FORMAT_R16G16_UINT:
+	case DXGI_FORMAT_R16G16_SNORM:
+	case DXGI_FORMAT_R16G16_SINT:
+	case DXGI_FORMAT_D32_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_R32_UINT:
+	case DXGI_FORMAT_R32_SINT:
+		return 4;
+
+	case DXGI_FORMAT_R16_UINT:
+		return 2;
+
+	default:
+		return 0;
+	}
+}
+
+HRESULT IDXGIAdapter1::GetDesc1(DXGI_ADAPTER_DESC1* desc)
+{
+	ZeroMemory(desc, sizeof(*desc));
+	const wchar_t name[] = L"Null device";
+	memcpy(desc->Description, name, sizeof(name));
+	desc->DedicatedVideoMemory = (SIZE_T)4 * 1024 * 1024 * 1024; // Only reported, never enforced
+	return S_OK;
+}
+
+IDXGISwapChain1::IDXGISwapChain1(ID3D12Device* device, const DXGI_SWAP_CHAIN_DESC1& desc) :
+	m_device(device),
+	m_currentBuffer(0)
+{
+	m_device->AddRef();
+
+	D3D12_HEAP_PROPERTIES heapProperties;
+	ZeroMemory(&heapProperties, sizeof(heapProperties));
+	heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+
+	D3D12_RESOURCE_DESC bufferDesc;
+	ZeroMemory(&bufferDesc, sizeof(bufferDesc));
+	bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	bufferDesc.Width = desc.Width;
+	bufferDesc.Height = desc.Height;
+	bufferDesc.DepthOrArraySize = 1;
+	bufferDesc.MipLevels = 1;
+	bufferDesc.Format = desc.Format;
+	bufferDesc.SampleDesc = desc.SampleDesc;
+	bufferDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+	for (UINT i = 0; i < desc.BufferCount; i++) {
+		ID3D12Resource* buffer = nullptr;
+		m_device->CreateCommittedResource(&heapProperties,
+			D3D12_HEAP_FLAG_NONE,
+			&bufferDesc,
+			D3D12_RESOURCE_STATE_PRESENT,
+			nullptr,
+			IID_PPV_ARGS(&buffer));
+		m_buffers.push_back(buffer);
+	}
+}
+
+IDXGISwapChain1::~IDXGISwapChain1()
+{
+	for (ID3D12Resource* buffer : m_buffers)
+		buffer->Release();
+	m_device->Release();
+}
+
+HRESULT IDXGISwapChain1::GetBuffer(UINT buffer, REFIID riid, void** surface)
+{
+	if (buffer >= m_buffers.size())
+		return E_INVALIDARG;
+
+	m_buffers[buffer]->AddRef();
+	*surface = m_buffers[buffer];
+	return S_OK;
+}
+
+HRESULT IDXGISwapChain1::Present(UINT syncInterval, UINT flags)
+{
+	m_currentBuffer = (m_currentBuffer + 1) % (UINT)m_buffers.size();
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumPresents++; });
+	return S_OK;
+}
+
+UINT IDXGISwapChain1::GetCurrentBackBufferIndex()
+{
+	return m_currentBuffer;
+}
+
+HRESULT IDXGIFactory7::EnumAdapters1(UINT adapter, IDXGIAdapter1** adapterOut)
+{
+	// A single adapter, which the null device is created on
+	if (adapter > 0)
+		return DXGI_ERROR_NOT_FOUND;
+
+	*adapterOut = new IDXGIAdapter1();
+	return S_OK;
+}
+
+HRESULT IDXGIFactory7::CreateSwapChainForHwnd(IUnknown* device, HWND window, const DXGI_SWAP_CHAIN_DESC1* desc, const void* fullscreenDesc, void* restrictToOutput, IDXGISwapChain1** swapChain)
+{
+	ID3D12CommandQueue* queue = dynamic_cast<ID3D12CommandQueue*>(device);
+	if (!queue || desc->BufferCount == 0)
+		return E_INVALIDARG;
+
+	*swapChain = new IDXGISwapChain1(queue->GetNullDevice(), *desc);
+	return S_OK;
+}
+
+// ######################################################################### //
+// ############################ DEVICE CHILDREN ############################ //
+// ######################################################################### //
+
+void NullCommandCounts::Add(const NullCommandCounts& other)
+{
+	Draws += other.Draws;
+	Dispatches += other.Dispatches;
+	Barriers += other.Barriers;
+	Copies += other.Copies;
+	CopiedBytes += other.CopiedBytes;
+	Clears += other.Clears;
+	StateSets += other.StateSets;
+	BufferBindings += other.BufferBindings;
+	RootArguments += other.RootArguments;
+	DescriptorHeapSets += other.DescriptorHeapSets;
+}
+
+UINT64 NullCommandCounts::GetTotal() const
+{
+	return Draws + Dispatches + Barriers + Copies + Clears + StateSets + BufferBindings + RootArguments + DescriptorHeapSets;
+}
+
+ID3D12DeviceChild::ID3D12DeviceChild(ID3D12Device* device) :
+	m_device(device)
+{
+	m_device->AddRef();
+}
+
+ID3D12DeviceChild::~ID3D12DeviceChild()
+{
+	m_device->Release();
+}
+
+ID3D12Device* ID3D12DeviceChild::GetNullDevice() const
+{
+	return m_device;
+}
+
+ID3D12Resource::ID3D12Resource(ID3D12Device* device, const D3D12_RESOURCE_DESC& desc, D3D12_HEAP_TYPE heapType, D3D12_GPU_VIRTUAL_ADDRESS address, UINT64 byteWidth) :
+	ID3D12DeviceChild(device),
+	m_desc(desc),
+	m_heapType(heapType),
+	m_address(address),
+	m_byteWidth(byteWidth)
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumResources++;
+		statistics.ResourceBytes += m_byteWidth;
+	});
+}
+
+ID3D12Resource::~ID3D12Resource()
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumResources--;
+		statistics.ResourceBytes -= m_byteWidth;
+		statistics.MappedBytes -= m_memory.size();
+	});
+}
+
+HRESULT ID3D12Resource::Map(UINT subresource, const D3D12_RANGE* readRange, void** data)
+{
+	// Default heaps can't be mapped on a GPU either
+	if (m_heapType == D3D12_HEAP_TYPE_DEFAULT)
+		return E_INVALIDARG;
+
+	if (m_memory.empty()) {
+		m_memory.resize((size_t)m_byteWidth);
+		m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) { statistics.MappedBytes += m_memory.size(); });
+	}
+
+	if (data)
+		*data = m_memory.data();
+	return S_OK;
+}
+
+void ID3D12Resource::Unmap(UINT subresource, const D3D12_RANGE* writtenRange)
+{
+	// The memory stays, so a later Map returns the same data
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ID3D12Resource::GetGPUVirtualAddress()
+{
+	return m_address;
+}
+
+D3D12_RESOURCE_DESC ID3D12Resource::GetDesc()
+{
+	return m_desc;
+}
+
+UINT64 ID3D12Resource::GetNullByteWidth() const
+{
+	return m_byteWidth;
+}
+
+ID3D12Heap::ID3D12Heap(ID3D12Device* device, const D3D12_HEAP_DESC& desc, D3D12_GPU_VIRTUAL_ADDRESS address) :
+	ID3D12DeviceChild(device),
+	m_desc(desc),
+	m_address(address)
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumHeaps++;
+		statistics.HeapBytes += m_desc.SizeInBytes;
+	});
+}
+
+ID3D12Heap::~ID3D12Heap()
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumHeaps--;
+		statistics.HeapBytes -= m_desc.SizeInBytes;
+	});
+}
+
+D3D12_HEAP_DESC ID3D12Heap::GetDesc()
+{
+	return m_desc;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS ID3D12Heap::GetNullAddress() const
+{
+	return m_address;
+}
+
+ID3D12DescriptorHeap::ID3D12DescriptorHeap(ID3D12Device* device, const D3D12_DESCRIPTOR_HEAP_DESC& desc, UINT64 gpuStart) :
+	ID3D12DeviceChild(device),
+	m_desc(desc),
+	m_descriptors(desc.NumDescriptors, NullDescriptor{ NullDescriptorType::None, nullptr, 0, 0, DXGI_FORMAT_UNKNOWN }),
+	m_gpuStart(gpuStart)
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumDescriptorHeaps++;
+		statistics.NumDescriptors += m_desc.NumDescriptors;
+	});
+}
+
+ID3D12DescriptorHeap::~ID3D12DescriptorHeap()
+{
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumDescriptorHeaps--;
+		statistics.NumDescriptors -= m_desc.NumDescriptors;
+	});
+}
+
+D3D12_DESCRIPTOR_HEAP_DESC ID3D12DescriptorHeap::GetDesc()
+{
+	return m_desc;
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE ID3D12DescriptorHeap::GetCPUDescriptorHandleForHeapStart()
+{
+	return { (SIZE_T)m_descriptors.data() };
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE ID3D12DescriptorHeap::GetGPUDescriptorHandleForHeapStart()
+{
+	// Only shader visible heaps have GPU handles
+	if (!(m_desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE))
+		return { 0 };
+	return { m_gpuStart };
+}
+
+ID3D12RootSignature::ID3D12RootSignature(ID3D12Device* device, UINT numParameters) :
+	ID3D12DeviceChild(device),
+	m_numParameters(numParameters)
+{
+	//
+}
+
+UINT ID3D12RootSignature::GetNullNumParameters() const
+{
+	return m_numParameters;
+}
+
+ID3D12PipelineState::ID3D12PipelineState(ID3D12Device* device) :
+	ID3D12DeviceChild(device)
+{
+	//
+}
+
+HRESULT ID3D12PipelineState::GetCachedBlob(ID3D10Blob** blob)
+{
+	*blob = new ID3D10Blob(std::vector<BYTE>(NULL_CACHED_PIPELINE, NULL_CACHED_PIPELINE + sizeof(NULL_CACHED_PIPELINE)));
+	return S_OK;
+}
+
+ID3D12CommandAllocator::ID3D12CommandAllocator(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) :
+	ID3D12DeviceChild(device),
+	m_type(type)
+{
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumCommandAllocators++; });
+}
+
+ID3D12CommandAllocator::~ID3D12CommandAllocator()
+{
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumCommandAllocators--; });
+}
+
+HRESULT ID3D12CommandAllocator::Reset()
+{
+	return S_OK;
+}
+
+// ######################################################################### //
+// ############################ COMMAND LISTS ############################## //
+// ######################################################################### //
+
+ID3D12CommandList::ID3D12CommandList(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) :
+	ID3D12DeviceChild(device),
+	m_type(type),
+	m_recording(true)
+{
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumCommandLists++; });
+}
+
+ID3D12CommandList::~ID3D12CommandList()
+{
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumCommandLists--; });
+}
+
+D3D12_COMMAND_LIST_TYPE ID3D12CommandList::GetType()
+{
+	return m_type;
+}
+
+bool ID3D12CommandList::IsNullRecording() const
+{
+	return m_recording;
+}
+
+const NullCommandCounts& ID3D12CommandList::GetNullCounts() const
+{
+	return m_counts;
+}
+
+ID3D12GraphicsCommandList::ID3D12GraphicsCommandList(ID3D12Device* device, D3D12_COMMAND_LIST_TYPE type) :
+	ID3D12CommandList(device, type)
+{
+	//
+}
+
+HRESULT ID3D12GraphicsCommandList::Close()
+{
+	if (!m_recording)
+		return E_FAIL;
+	m_recording = false;
+	return S_OK;
+}
+
+HRESULT ID3D12GraphicsCommandList::Reset(ID3D12CommandAllocator* allocator, ID3D12PipelineState* initialState)
+{
+	if (m_recording || !allocator)
+		return E_FAIL;
+
+	m_recording = true;
+	m_counts = NullCommandCounts();
+	return S_OK;
+}
+
+void ID3D12GraphicsCommandList::ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* barriers)
+{
+	assert(m_recording);
+	m_counts.Barriers += numBarriers;
+}
+
+void ID3D12GraphicsCommandList::CopyBufferRegion(ID3D12Resource* dest, UINT64 destOffset, ID3D12Resource* src, UINT64 srcOffset, UINT64 numBytes)
+{
+	assert(m_recording);
+	assert(destOffset + numBytes <= dest->GetNullByteWidth());
+	assert(srcOffset + numBytes <= src->GetNullByteWidth());
+	m_counts.Copies++;
+	m_counts.CopiedBytes += numBytes;
+}
+
+void ID3D12GraphicsCommandList::CopyResource(ID3D12Resource* dest, ID3D12Resource* src)
+{
+	assert(m_recording);
+	m_counts.Copies++;
+	m_counts.CopiedBytes += src->GetNullByteWidth();
+}
+
+void ID3D12GraphicsCommandList::Dispatch(UINT numThreadGroupsX, UINT numThreadGroupsY, UINT numThreadGroupsZ)
+{
+	assert(m_recording);
+	m_counts.Dispatches++;
+}
+
+void ID3D12GraphicsCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE view, const FLOAT color[4], UINT numRects, const D3D12_RECT* rects)
+{
+	assert(m_recording);
+	assert(((NullDescriptor*)view.ptr)->Type == NullDescriptorType::RTV);
+	m_counts.Clears++;
+}
+
+void ID3D12GraphicsCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE view, D3D12_CLEAR_FLAGS flags, FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* rects)
+{
+	assert(m_recording);
+	assert(((NullDescriptor*)view.ptr)->Type == NullDescriptorType::DSV);
+	m_counts.Clears++;
+}
+
+void ID3D12GraphicsCommandList::DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation, UINT startInstanceLocation)
+{
+	assert(m_recording);
+	m_counts.Draws++;
+}
+
+void ID3D12GraphicsCommandList::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation, INT baseVertexLocation, UINT startInstanceLocation)
+{
+	assert(m_recording);
+	m_counts.Draws++;
+}
+
+void ID3D12GraphicsCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* view)
+{
+	assert(m_recording);
+	m_counts.BufferBindings++;
+}
+
+void ID3D12GraphicsCommandList::IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* views)
+{
+	assert(m_recording);
+	m_counts.BufferBindings += numViews;
+}
+
+void ID3D12GraphicsCommandList::RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* viewports)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::RSSetScissorRects(UINT numRects, const D3D12_RECT* rects)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::OMSetRenderTargets(UINT numRenderTargets, const D3D12_CPU_DESCRIPTOR_HANDLE* renderTargets, BOOL singleHandleToDescriptorRange, const D3D12_CPU_DESCRIPTOR_HANDLE* depthStencil)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::SetPipelineState(ID3D12PipelineState* state)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRootSignature(ID3D12RootSignature* rootSignature)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::SetComputeRootSignature(ID3D12RootSignature* rootSignature)
+{
+	assert(m_recording);
+	m_counts.StateSets++;
+}
+
+void ID3D12GraphicsCommandList::SetDescriptorHeaps(UINT numHeaps, ID3D12DescriptorHeap* const* heaps)
+{
+	assert(m_recording);
+	m_counts.DescriptorHeapSets++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT data, UINT destOffsetIn32BitValues)
+{
+	assert(m_recording);
+	m_counts.RootArguments++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues, const void* data, UINT destOffsetIn32BitValues)
+{
+	assert(m_recording);
+	m_counts.RootArguments++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+	assert(m_recording);
+	m_counts.RootArguments++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+	assert(m_recording);
+	m_counts.RootArguments++;
+}
+
+void ID3D12GraphicsCommandList::SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+{
+	assert(m_recording);
+	m_counts.RootArguments++;
+}
+
+// ######################################################################### //
+// ########################## QUEUES AND FENCES ############################ //
+// ######################################################################### //
+
+ID3D12Fence::ID3D12Fence(ID3D12Device* device, UINT64 initialValue) :
+	ID3D12DeviceChild(device),
+	m_completedValue(initialValue)
+{
+	//
+}
+
+UINT64 ID3D12Fence::GetCompletedValue()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_completedValue;
+}
+
+HRESULT ID3D12Fence::SetEventOnCompletion(UINT64 value, HANDLE event)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (value > m_completedValue) {
+			m_pendingEvents.push_back({ value, event });
+			return S_OK;
+		}
+	}
+	SignalEvent(event);
+	return S_OK;
+}
+
+HRESULT ID3D12Fence::Signal(UINT64 value)
+{
+	std::vector<HANDLE> reached;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_completedValue = value;
+
+		auto firstReached = std::stable_partition(m_pendingEvents.begin(), m_pendingEvents.end(),
+			[value](const PendingEvent& pending) { return pending.Value > value; });
+		for (auto it = firstReached; it != m_pendingEvents.end(); ++it)
+			reached.push_back(it->Event);
+		m_pendingEvents.erase(firstReached, m_pendingEvents.end());
+	}
+
+	for (HANDLE event : reached)
+		SignalEvent(event);
+	return S_OK;
+}
+
+ID3D12CommandQueue::ID3D12CommandQueue(ID3D12Device* device, const D3D12_COMMAND_QUEUE_DESC& desc) :
+	ID3D12DeviceChild(device),
+	m_desc(desc)
+{
+	//
+}
+
+void ID3D12CommandQueue::ExecuteCommandLists(UINT numLists, ID3D12CommandList* const* lists)
+{
+	NullCommandCounts executed;
+	for (UINT i = 0; i < numLists; i++) {
+		assert(!lists[i]->IsNullRecording()); // Lists have to be closed
+		executed.Add(lists[i]->GetNullCounts());
+	}
+
+	m_device->UpdateStatistics([&](NullDeviceStatistics& statistics) {
+		statistics.NumExecutedLists += numLists;
+		statistics.ExecutedCommands.Add(executed);
+	});
+}
+
+HRESULT ID3D12CommandQueue::Signal(ID3D12Fence* fence, UINT64 value)
+{
+	// All work executed before the signal is done by now
+	m_device->UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumFenceSignals++; });
+	return fence->Signal(value);
+}
+
+HRESULT ID3D12CommandQueue::Wait(ID3D12Fence* fence, UINT64 value)
+{
+	// Signals complete right away, so there is never anything to wait for
+	return S_OK;
+}
+
+D3D12_COMMAND_QUEUE_DESC ID3D12CommandQueue::GetDesc()
+{
+	return m_desc;
+}
+
+void ID3D12Debug::EnableDebugLayer()
+{
+	//
+}
+
+// ######################################################################### //
+// ################################ DEVICE ################################# //
+// ######################################################################### //
+
+ID3D12Device::ID3D12Device() :
+	m_nextVirtualAddress(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+	m_nextDescriptorAddress(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+{
+	//
+}
+
+HRESULT ID3D12Device::CreateCommandQueue(const D3D12_COMMAND_QUEUE_DESC* desc, REFIID riid, void** commandQueue)
+{
+	*commandQueue = new ID3D12CommandQueue(this, *desc);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, REFIID riid, void** commandAllocator)
+{
+	*commandAllocator = new ID3D12CommandAllocator(this, type);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateCommandList(UINT nodeMask, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* allocator, ID3D12PipelineState* initialState, REFIID riid, void** commandList)
+{
+	if (!allocator)
+		return E_INVALIDARG;
+
+	*commandList = new ID3D12GraphicsCommandList(this, type);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS flags, REFIID riid, void** fence)
+{
+	*fence = new ID3D12Fence(this, initialValue);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateCommittedResource(const D3D12_HEAP_PROPERTIES* heapProperties, D3D12_HEAP_FLAGS heapFlags, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue, REFIID riid, void** resource)
+{
+	UINT64 byteWidth = 0;
+	if (desc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		byteWidth = desc->Width;
+	else
+		GetCopyableFootprints(desc, 0, std::max<UINT>(desc->MipLevels, 1) * std::max<UINT>(desc->DepthOrArraySize, 1), 0, nullptr, nullptr, nullptr, &byteWidth);
+
+	if (byteWidth == 0)
+		return E_INVALIDARG;
+
+	D3D12_GPU_VIRTUAL_ADDRESS address;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		address = m_nextVirtualAddress;
+		m_nextVirtualAddress += AlignUp(byteWidth, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	}
+
+	*resource = new ID3D12Resource(this, *desc, heapProperties->Type, address, byteWidth);
+	return S_OK;
+}
+
+void ID3D12Device::GetCopyableFootprints(const D3D12_RESOURCE_DESC* desc, UINT firstSubresource, UINT numSubresources, UINT64 baseOffset, D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts, UINT* numRows, UINT64* rowSizesInBytes, UINT64* totalBytes)
+{
+	UINT elementSize = NullGetFormatSize(desc->Format);
+	UINT mipLevels = (desc->MipLevels > 0) ? desc->MipLevels : 1;
+
+	UINT64 offset = baseOffset;
+	for (UINT i = 0; i < numSubresources; i++) {
+		UINT mip = (firstSubresource + i) % mipLevels;
+		UINT width = std::max<UINT>((UINT)(desc->Width >> mip), 1);
+		UINT height = std::max<UINT>(desc->Height >> mip, 1);
+
+		UINT64 rowSize = (UINT64)width * elementSize;
+		UINT rowPitch = (UINT)AlignUp(rowSize, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+
+		// Subresources are placed with the same alignment as on a GPU
+		offset = AlignUp(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		if (layouts) {
+			layouts[i].Offset = offset;
+			layouts[i].Footprint = { desc->Format, width, height, 1, rowPitch };
+		}
+		if (numRows)
+			numRows[i] = height;
+		if (rowSizesInBytes)
+			rowSizesInBytes[i] = rowSize;
+
+		offset += (UINT64)rowPitch * (height - 1) + rowSize;
+	}
+
+	if (totalBytes)
+		*totalBytes = offset - baseOffset;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO ID3D12Device::GetResourceAllocationInfo(UINT visibleMask, UINT numResourceDescs, const D3D12_RESOURCE_DESC* resourceDescs)
+{
+	// Every resource takes whole 64 KB pages, like on most GPUs
+	D3D12_RESOURCE_ALLOCATION_INFO info = { 0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT };
+	for (UINT i = 0; i < numResourceDescs; i++) {
+		const D3D12_RESOURCE_DESC& desc = resourceDescs[i];
+
+		UINT64 byteWidth = 0;
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+			byteWidth = desc.Width;
+		else
+			GetCopyableFootprints(&desc, 0, std::max<UINT>(desc.MipLevels, 1) * std::max<UINT>(desc.DepthOrArraySize, 1), 0, nullptr, nullptr, nullptr, &byteWidth);
+
+		info.SizeInBytes += AlignUp(byteWidth, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	}
+	return info;
+}
+
+HRESULT ID3D12Device::CreateHeap(const D3D12_HEAP_DESC* desc, REFIID riid, void** heap)
+{
+	if (desc->SizeInBytes == 0)
+		return E_INVALIDARG;
+
+	D3D12_GPU_VIRTUAL_ADDRESS address;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		address = m_nextVirtualAddress;
+		m_nextVirtualAddress += AlignUp(desc->SizeInBytes, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	}
+
+	*heap = new ID3D12Heap(this, *desc, address);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreatePlacedResource(ID3D12Heap* heap, UINT64 heapOffset, const D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* optimizedClearValue, REFIID riid, void** resource)
+{
+	D3D12_RESOURCE_ALLOCATION_INFO info = GetResourceAllocationInfo(0, 1, desc);
+	D3D12_HEAP_DESC heapDesc = heap->GetDesc();
+
+	// Placed resources have to be aligned and fit in the heap
+	if (info.SizeInBytes == 0 || heapOffset % info.Alignment != 0 || heapOffset + info.SizeInBytes > heapDesc.SizeInBytes)
+		return E_INVALIDARG;
+
+	UINT64 byteWidth = 0;
+	if (desc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		byteWidth = desc->Width;
+	else
+		GetCopyableFootprints(desc, 0, std::max<UINT>(desc->MipLevels, 1) * std::max<UINT>(desc->DepthOrArraySize, 1), 0, nullptr, nullptr, nullptr, &byteWidth);
+
+	*resource = new ID3D12Resource(this, *desc, heapDesc.Properties.Type, heap->GetNullAddress() + heapOffset, byteWidth);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* desc, REFIID riid, void** heap)
+{
+	if (desc->NumDescriptors == 0)
+		return E_INVALIDARG;
+
+	UINT64 gpuStart;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		gpuStart = m_nextDescriptorAddress;
+		m_nextDescriptorAddress += AlignUp((UINT64)desc->NumDescriptors * sizeof(NullDescriptor), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+	}
+
+	*heap = new ID3D12DescriptorHeap(this, *desc, gpuStart);
+	return S_OK;
+}
+
+UINT ID3D12Device::GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+	return (UINT)sizeof(NullDescriptor);
+}
+
+void ID3D12Device::CreateConstantBufferView(const D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+	*(NullDescriptor*)destDescriptor.ptr = { NullDescriptorType::CBV, nullptr, desc->BufferLocation, desc->SizeInBytes, DXGI_FORMAT_UNKNOWN };
+	UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumViewsCreated++; });
+}
+
+void ID3D12Device::CreateShaderResourceView(ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+	*(NullDescriptor*)destDescriptor.ptr = { NullDescriptorType::SRV, resource, 0, 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN };
+	UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumViewsCreated++; });
+}
+
+void ID3D12Device::CreateUnorderedAccessView(ID3D12Resource* resource, ID3D12Resource* counterResource, const D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+	*(NullDescriptor*)destDescriptor.ptr = { NullDescriptorType::UAV, resource, 0, 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN };
+	UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumViewsCreated++; });
+}
+
+void ID3D12Device::CreateRenderTargetView(ID3D12Resource* resource, const D3D12_RENDER_TARGET_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+	*(NullDescriptor*)destDescriptor.ptr = { NullDescriptorType::RTV, resource, 0, 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN };
+	UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumViewsCreated++; });
+}
+
+void ID3D12Device::CreateDepthStencilView(ID3D12Resource* resource, const D3D12_DEPTH_STENCIL_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE destDescriptor)
+{
+	*(NullDescriptor*)destDescriptor.ptr = { NullDescriptorType::DSV, resource, 0, 0, desc ? desc->Format : DXGI_FORMAT_UNKNOWN };
+	UpdateStatistics([](NullDeviceStatistics& statistics) { statistics.NumViewsCreated++; });
+}
+
+void ID3D12Device::CopyDescriptorsSimple(UINT numDescriptors, D3D12_CPU_DESCRIPTOR_HANDLE destStart, D3D12_CPU_DESCRIPTOR_HANDLE srcStart, D3D12_DESCRIPTOR_HEAP_TYPE type)
+{
+	memcpy((void*)destStart.ptr, (const void*)srcStart.ptr, numDescriptors * sizeof(NullDescriptor));
+	UpdateStatistics([&](NullDeviceStatistics& statistics) { statistics.NumDescriptorsCopied += numDescriptors; });
+}
+
+HRESULT ID3D12Device::CreateRootSignature(UINT nodeMask, const void* blob, SIZE_T blobLength, REFIID riid, void** rootSignature)
+{
+	// Serialized by D3D12SerializeRootSignature below
+	if (blobLength < sizeof(UINT))
+		return E_INVALIDARG;
+
+	UINT numParameters;
+	memcpy(&numParameters, blob, sizeof(UINT));
+	*rootSignature = new ID3D12RootSignature(this, numParameters);
+	return S_OK;
+}
+
+HRESULT ID3D12Device::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, REFIID riid, void** pipelineState)
+{
+	if (!desc->pRootSignature || !desc->VS.pShaderBytecode)
+		return E_INVALIDARG;
+
+	// Like a driver, blobs it did not create itself are refused
+	const D3D12_CACHED_PIPELINE_STATE& cached = desc->CachedPSO;
+	if (cached.CachedBlobSizeInBytes > 0) {
+		if (cached.CachedBlobSizeInBytes != sizeof(NULL_CACHED_PIPELINE) ||
+			memcmp(cached.pCachedBlob, NULL_CACHED_PIPELINE, sizeof(NULL_CACHED_PIPELINE)) != 0)
+			return D3D12_ERROR_DRIVER_VERSION_MISMATCH;
+	}
+
+	*pipelineState = new ID3D12PipelineState(this);
+	return S_OK;
+}
+
+NullDeviceStatistics ID3D12Device::GetNullStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_statistics;
+}
+
+// ######################################################################### //
+// ############################### FUNCTIONS ############################### //
+// ######################################################################### //
+
+ID3D10Blob::ID3D10Blob(std::vector<BYTE> data) :
+	m_data(std::move(data))
+{
+	//
+}
+
+void* ID3D10Blob::GetBufferPointer()
+{
+	return m_data.data();
+}
+
+SIZE_T ID3D10Blob::GetBufferSize()
+{
+	return m_data.size();
+}
+
+HRESULT D3D12CreateDevice(IUnknown* adapter, D3D_FEATURE_LEVEL minimumFeatureLevel, REFIID riid, void** device)
+{
+	// Without an output the call only checks for support
+	if (device)
+		*device = new ID3D12Device();
+	return S_OK;
+}
+
+HRESULT D3D12GetDebugInterface(REFIID riid, void** debug)
+{
+	*debug = new ID3D12Debug();
+	return S_OK;
+}
+
+HRESULT CreateDXGIFactory(REFIID riid, void** factory)
+{
+	*factory = new IDXGIFactory7();
+	return S_OK;
+}
+
+HRESULT CreateDXGIFactory2(UINT flags, REFIID riid, void** factory)
+{
+	return CreateDXGIFactory(riid, factory);
+}
+
+HRESULT D3DCompileFromFile(LPCWSTR fileName, const D3D_SHADER_MACRO* defines, ID3DInclude* include, LPCSTR entryPoint, LPCSTR target, UINT flags1, UINT flags2, ID3DBlob** code, ID3DBlob** errorMessages)
+{
+	std::wstring wpath(fileName);
+	std::string path(wpath.begin(), wpath.end());
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		std::string message = "Could not open " + path + "\n";
+		if (errorMessages)
+			*errorMessages = new ID3DBlob(std::vector<BYTE>(message.c_str(), message.c_str() + message.size() + 1));
+		return E_FAIL;
+	}
+
+	if (errorMessages)
+		*errorMessages = nullptr;
+	*code = new ID3DBlob(std::vector<BYTE>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()));
+	return S_OK;
+}
+
+HRESULT D3D12SerializeRootSignature(const D3D12_ROOT_SIGNATURE_DESC* rootSignature, D3D_ROOT_SIGNATURE_VERSION version, ID3DBlob** blob, ID3DBlob** errorBlob)
+{
+	if (errorBlob)
+		*errorBlob = nullptr;
+
+	std::vector<BYTE> data(sizeof(UINT));
+	memcpy(data.data(), &rootSignature->NumParameters, sizeof(UINT));
+	*blob = new ID3DBlob(std::move(data));
+	return S_OK;
+}
+
+#endif
@@ -48,6 +48,22 @@ DXGI_FORMAT env::BufferLayout::GetDXGIFormat() const
 	return env::GetDXGIFormat(m_elements[0].Type);
 }
 
+void env::BufferLayout::GetInputElements(std::vector<D3D12_INPUT_ELEMENT_DESC>& elements) const
+{
+	elements.clear();
+	for (const BufferElement& element : m_elements) {
+		D3D12_INPUT_ELEMENT_DESC desc = {};
+		desc.SemanticName = element.Name.c_str();
+		desc.SemanticIndex = (UINT)element.Index;
+		desc.Format = env::GetDXGIFormat(element.Type);
+		desc.InputSlot = (UINT)element.BufferSlot;
+		desc.AlignedByteOffset = (UINT)element.Offset;
+		desc.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+		desc.InstanceDataStepRate = 0;
+		elements.push_back(desc);
+	}
+}
+
 void env::BufferLayout::CalculateOffsetsAndStrides()
 {
 	m_repetitionStride = 0;
@@ -59,3 +75,12 @@ void env::BufferLayout::CalculateOffsetsAndStrides()
 		m_repetitionStride += e.Stride;
 	}
 }
+
+env::BufferLayout env::GetVertexTypeLayout(UINT numVertices)
+{
+	return BufferLayout({
+		{ "POSITION", ShaderDataType::Snorm16x4 },
+		{ "NORMAL", ShaderDataType::Snorm16x2 },
+		{ "TEXCOORD", ShaderDataType::Half2 } },
+		numVertices);
+}
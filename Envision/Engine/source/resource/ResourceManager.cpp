@@ -1,13 +1,49 @@
 #include "envision/envpch.h"
 #include "envision/resource/ResourceManager.h"
 #include "envision/core/GPU.h"
+#include "envision/core/Time.h"
+
+namespace
+{
+	D3D12_RESOURCE_DESC GetTexture2DDesc(int width, int height, DXGI_FORMAT format, env::TextureBindType bindType)
+	{
+		using env::TextureBindType;
+
+		D3D12_RESOURCE_DESC resourceDescription;
+		ZeroMemory(&resourceDescription, sizeof(resourceDescription));
+		resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		resourceDescription.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		resourceDescription.Width = (UINT64)width;
+		resourceDescription.Height = height;
+		resourceDescription.DepthOrArraySize = 1;
+		resourceDescription.MipLevels = 1;
+		resourceDescription.Format = format;
+		resourceDescription.SampleDesc.Count = 1;
+		resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+		bool isRenderTarget = any(bindType & TextureBindType::RenderTarget) || (bindType == TextureBindType::Unknown);
+		bool isUnorderedAccess = any(bindType & TextureBindType::UnorderedAccess) || (bindType == TextureBindType::Unknown);
+		bool isDepthStencil = any(bindType & TextureBindType::DepthStencil);
+
+		if (isRenderTarget)
+			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+		//if (!any(bindType & BindType::ShaderResource)) // requires D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL or D3D12_RESOURCE_FLAG_VIDEO_DECODE_REFERENCE_ONLY
+		//	resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
+		if (isUnorderedAccess)
+			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+		if (isDepthStencil)
+			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+		return resourceDescription;
+	}
+}
 
 env::ResourceManager* env::ResourceManager::s_instance = nullptr;
 
-env::ResourceManager* env::ResourceManager::Initialize(IDGenerator& commonIDGenerator)
+env::ResourceManager* env::ResourceManager::Initialize()
 {
 	if (!s_instance)
-		s_instance = new ResourceManager(commonIDGenerator);
+		s_instance = new ResourceManager();
 	return s_instance;
 }
 
@@ -23,28 +59,31 @@ void env::ResourceManager::Finalize()
 	s_instance = nullptr;
 }
 
-env::ResourceManager::ResourceManager(IDGenerator& commonIDGenerator) :
-	m_commonIDGenerator(commonIDGenerator),
-	m_CBVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 100, false),
-	m_SRVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 100, false),
-	m_UAVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 100, false),
+env::ResourceManager::ResourceManager() :
+	m_buffersArrays((uint32_t)ResourceType::BufferArray),
+	m_buffers((uint32_t)ResourceType::Buffer),
+	m_texture2Ds((uint32_t)ResourceType::Texture2D),
+	m_texture2DArrays((uint32_t)ResourceType::Texture2DArray),
+	m_pipelineStates((uint32_t)ResourceType::PipelineState),
+	m_targets((uint32_t)ResourceType::WindowTarget),
+	m_bindlessHeap(BINDLESS_HEAP_SIZE),
 	m_SamplerAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, 10, false),
 	m_RTVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 20, false),
-	m_DSVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 20, false)
+	m_DSVAllocator(D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 20, false),
+	m_uploadBufferMapped(nullptr),
+	m_uploadAllocator(UPLOAD_BUFFER_SIZE),
+	m_uploadList(nullptr),
+	m_hasPendingUploads(false),
+	m_shaderCache(SHADER_CACHE_DIRECTORY),
+	m_pipelineCreateTime(0.0f)
 {
 	HRESULT hr = S_OK;
 
 	m_uploadBuffer.Name = "UploadBuffer";
 	m_uploadBuffer.State = D3D12_RESOURCE_STATE_GENERIC_READ;
-	m_uploadBuffer.Layout = { BufferElement("Data", ShaderDataType::Float, 0, 0, 1000000000) };
+	m_uploadBuffer.Layout = { BufferElement("Data", ShaderDataType::Float, 0, 0, UPLOAD_BUFFER_SIZE) };
 
 	{
-		D3D12_HEAP_PROPERTIES heapProperties;
-		ZeroMemory(&heapProperties, sizeof(heapProperties));
-		heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
-		heapProperties.CreationNodeMask = 1;
-		heapProperties.VisibleNodeMask = 1;
-
 		D3D12_RESOURCE_DESC resourceDescription;
 		ZeroMemory(&resourceDescription, sizeof(resourceDescription));
 		resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -57,59 +96,59 @@ env::ResourceManager::ResourceManager(IDGenerator& commonIDGenerator) :
 		resourceDescription.SampleDesc.Count = 1;
 		resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-		hr = GPU::GetDevice()->CreateCommittedResource(&heapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDescription,
+		m_uploadBuffer.Native = m_memory.CreateResource(resourceDescription,
+			D3D12_HEAP_TYPE_UPLOAD,
 			m_uploadBuffer.State,
-			NULL,
-			IID_PPV_ARGS(&m_uploadBuffer.Native));
+			nullptr,
+			m_uploadBuffer.Memory);
 
-		ASSERT_HR(hr, "Could not create upload buffer");
+		// Upload heaps can stay mapped for their whole lifetime
+		D3D12_RANGE readRange = { 0, 0 };
+		hr = m_uploadBuffer.Native->Map(0, &readRange, (void**)&m_uploadBufferMapped);
+		ASSERT_HR(hr, "Could not map upload buffer");
 	}
-
-	m_transitionList = GPU::CreateDirectCommandList();
-	m_copyList = GPU::CreateCopyCommandList();
 }
 
 env::ResourceManager::~ResourceManager()
 {
-	for (auto& pair : m_buffersArrays) { delete pair.second; }
-	m_buffersArrays.clear();
+	for (auto* resource : m_buffersArrays) { delete resource; }
+	m_buffersArrays.Clear();
 
-	for (auto& pair : m_buffers) { delete pair.second; }
-	m_buffers.clear();
+	for (auto* resource : m_buffers) { delete resource; }
+	m_buffers.Clear();
 
-	for (auto& pair : m_texture2Ds) { delete pair.second; }
-	m_texture2Ds.clear();
+	for (auto* resource : m_texture2Ds) { delete resource; }
+	m_texture2Ds.Clear();
 
-	for (auto& pair : m_texture2DArrays) { delete pair.second; }
-	m_texture2DArrays.clear();
+	for (auto* resource : m_texture2DArrays) { delete resource; }
+	m_texture2DArrays.Clear();
 
-	for (auto& pair : m_pipelineStates) { delete pair.second; }
-	m_pipelineStates.clear();
+	for (auto* resource : m_pipelineStates) { delete resource; }
+	m_pipelineStates.Clear();
 
 	//for (auto& pair : m_windowTargets) { delete pair.second; }
 	//m_windowTargets.clear();
 
-	for (auto& pair : m_targets) { delete pair.second; }
-	m_targets.clear();
+	for (auto* resource : m_targets) { delete resource; }
+	m_targets.Clear();
+
+	// Only finalized once the queues are idle
+	m_deferredReleases.ReleaseAll();
 }
 
 env::Resource* env::ResourceManager::GetResourceNonConst(ID resourceID)
 {
-	if (m_buffersArrays.count(resourceID) > 0)
-		return m_buffersArrays[resourceID];
-	else if (m_buffers.count(resourceID) > 0)
-		return m_buffers[resourceID];
-	else if (m_texture2Ds.count(resourceID) > 0)
-		return m_texture2Ds[resourceID];
-	else if (m_texture2DArrays.count(resourceID) > 0)
-		return m_texture2DArrays[resourceID];
-	else if (m_pipelineStates.count(resourceID) > 0)
-		return m_pipelineStates[resourceID];
-	else if (m_targets.count(resourceID) > 0)
-		return m_targets[resourceID];
-	return nullptr;
+	// The tag of the handle says which map it belongs to
+	switch ((ResourceType)SlotMap<Resource*>::GetTag((uint64_t)resourceID))
+	{
+	case ResourceType::BufferArray:		return GetBufferArray(resourceID);
+	case ResourceType::Buffer:			return GetBuffer(resourceID);
+	case ResourceType::Texture2D:		return GetTexture2D(resourceID);
+	case ResourceType::Texture2DArray:	return GetTexture2DArray(resourceID);
+	case ResourceType::PipelineState:	return GetPipelineState(resourceID);
+	case ResourceType::WindowTarget:	return GetTarget(resourceID);
+	default:							return nullptr;
+	}
 }
 
 void env::ResourceManager::AdjustViewportAndScissorRect(WindowTarget& target, const Window& window)
@@ -129,24 +168,151 @@ void env::ResourceManager::AdjustViewportAndScissorRect(WindowTarget& target, co
 	target.ScissorRect.bottom = (LONG)target.Viewport.TopLeftY + (LONG)target.Viewport.Height;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateCBV(Resource* resource)
+ID3D12Resource* env::ResourceManager::CreateBufferNative(UINT64 width, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES initialState, GPUAllocation& allocation)
+{
+	D3D12_RESOURCE_DESC resourceDescription;
+	ZeroMemory(&resourceDescription, sizeof(resourceDescription));
+	resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	resourceDescription.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	resourceDescription.Width = width;
+	resourceDescription.Height = 1;
+	resourceDescription.DepthOrArraySize = 1;
+	resourceDescription.MipLevels = 1;
+	resourceDescription.Format = DXGI_FORMAT_UNKNOWN;
+	resourceDescription.SampleDesc.Count = 1;
+	resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+
+	return m_memory.CreateResource(resourceDescription, heapType, initialState, nullptr, allocation);
+}
+
+ID env::ResourceManager::AddTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType, ID3D12Heap* heap, UINT64 heapOffset)
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE handle = m_CBVAllocator.Allocate().CPUHandle;
+	Texture2D textureDesc;
+
+	textureDesc.Name = name;
+	textureDesc.State = D3D12_RESOURCE_STATE_COMMON;
+
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.Format = format;
+
+	{ // Create the resource
+		D3D12_RESOURCE_DESC resourceDescription = GetTexture2DDesc(width, height, format, bindType);
+
+		bool isDepthStencil = any(bindType & TextureBindType::DepthStencil);
+		if (isDepthStencil)
+			textureDesc.State = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+
+		D3D12_CLEAR_VALUE clearValue = {};
+		D3D12_CLEAR_VALUE* clearValuePtr = nullptr;
+
+		if (isDepthStencil) {
+			clearValue.Format = resourceDescription.Format;
+			clearValue.DepthStencil.Depth = 1.0f;
+			clearValue.DepthStencil.Stencil = 0;
+			clearValuePtr = &clearValue;
+		}
+
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = { 0 };
+		UINT numRows = 0;
+		GPU::GetDevice()->GetCopyableFootprints(&resourceDescription,
+			0,
+			1,
+			0,
+			&footprint,
+			&numRows,
+			&textureDesc.RowPitch,
+			&textureDesc.ByteWidth);
+
+		if (heap) {
+			// Not from m_memory, so the allocation stays empty
+			HRESULT hr = GPU::GetDevice()->CreatePlacedResource(heap,
+				heapOffset,
+				&resourceDescription,
+				textureDesc.State,
+				clearValuePtr,
+				IID_PPV_ARGS(&textureDesc.Native));
+
+			ASSERT_HR(hr, "Could not create placed texture");
+		}
+		else {
+			textureDesc.Native = m_memory.CreateResource(resourceDescription,
+				D3D12_HEAP_TYPE_DEFAULT,
+				textureDesc.State,
+				clearValuePtr,
+				textureDesc.Memory);
+		}
+	}
+
+	{
+		if (any(bindType & TextureBindType::RenderTarget))
+			textureDesc.Views.RenderTarget = CreateRTV(&textureDesc);
+		if (any(bindType & TextureBindType::ShaderResource))
+			textureDesc.Views.ShaderResource = CreateSRV(&textureDesc);
+		if (any(bindType & TextureBindType::UnorderedAccess))
+			textureDesc.Views.UnorderedAccess = CreateUAV(&textureDesc);
+		if (any(bindType & TextureBindType::DepthStencil)) {
+			textureDesc.Views.DepthStencil = CreateDSV(&textureDesc);
+		}
+	}
+
+	Texture2D* texture = new Texture2D(std::move(textureDesc));
+	ID resourceID = (ID)m_texture2Ds.Insert(texture);
+
+	return resourceID;
+}
+
+env::CopyList* env::ResourceManager::GetUploadList()
+{
+	// The list goes back to the pool when the batch is executed
+	if (!m_hasPendingUploads) {
+		m_uploadList = GPU::AcquireCopyList();
+		m_hasPendingUploads = true;
+	}
+
+	return m_uploadList;
+}
+
+UINT64 env::ResourceManager::AllocateUploadMemory(UINT64 numBytes)
+{
+	CommandQueue& copyQueue = GPU::GetCopyQueue();
+
+	m_uploadAllocator.Reclaim(copyQueue.GetCompletedFenceValue());
+	UINT64 offset = m_uploadAllocator.Allocate(numBytes, UPLOAD_ALIGNMENT);
+
+	if (offset == RingAllocator::INVALID_OFFSET) {
+		// The ring is full. Submit what has been recorded so far and wait
+		// for the oldest batches, one at a time, until there is room.
+		FlushUploads();
+		while (offset == RingAllocator::INVALID_OFFSET && m_uploadAllocator.GetNumSubmissionsInFlight() > 0) {
+			copyQueue.WaitForFenceCPU(m_uploadAllocator.GetOldestFenceValue());
+			m_uploadAllocator.Reclaim(copyQueue.GetCompletedFenceValue());
+			offset = m_uploadAllocator.Allocate(numBytes, UPLOAD_ALIGNMENT);
+		}
+	}
+
+	assert(offset != RingAllocator::INVALID_OFFSET); // Upload larger than the upload buffer
+	return offset;
+}
+
+env::BindlessHandle env::ResourceManager::CreateCBV(Resource* resource)
+{
+	BindlessHandle handle = m_bindlessHeap.Allocate();
+	if (!handle.IsValid())
+		return handle;
 
 	D3D12_CONSTANT_BUFFER_VIEW_DESC desc;
 	ZeroMemory(&desc, sizeof(desc));
-	desc.BufferLocation = resource->Native->GetGPUVirtualAddress();
+	desc.BufferLocation = resource->GetGPUAddress();
 	desc.SizeInBytes = resource->GetByteWidth();
 
-	GPU::GetDevice()->CreateConstantBufferView(&desc, handle);
+	GPU::GetDevice()->CreateConstantBufferView(&desc, m_bindlessHeap.GetCPUHandle(handle));
 
 	return handle;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateSRV(Resource* resource)
+env::BindlessHandle env::ResourceManager::CreateSRV(Resource* resource)
 {
-	D3D12_CPU_DESCRIPTOR_HANDLE handle = m_SRVAllocator.Allocate().CPUHandle;
-
 	D3D12_SHADER_RESOURCE_VIEW_DESC desc;
 	ZeroMemory(&desc, sizeof(desc));
 
@@ -206,21 +372,25 @@ D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateSRV(Resource* resource)
 	}
 	
 	default:
-		return D3D12_CPU_DESCRIPTOR_HANDLE(); // TODO: handle error
+		return BindlessHandle(); // TODO: handle error
 	}
 
+	BindlessHandle handle = m_bindlessHeap.Allocate();
+	if (!handle.IsValid())
+		return handle;
+
 	GPU::GetDevice()->CreateShaderResourceView(resource->Native,
 		&desc,
-		handle);
+		m_bindlessHeap.GetCPUHandle(handle));
 
 	return handle;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateUAV(Resource* resource)
+env::BindlessHandle env::ResourceManager::CreateUAV(Resource* resource)
 {
 
 	//GPU::GetDevice()->CreateUnorderedAccessView()
-	return D3D12_CPU_DESCRIPTOR_HANDLE();
+	return BindlessHandle();
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateSampler(Resource* resource)
@@ -228,7 +398,7 @@ D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateSampler(Resource* resour
 	return D3D12_CPU_DESCRIPTOR_HANDLE();
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateRTV(Resource* resource)
+env::DescriptorAllocation env::ResourceManager::CreateRTV(Resource* resource)
 {
 	{
 		bool isTexture2D = (resource->GetType() == ResourceType::Texture2D);
@@ -236,7 +406,7 @@ D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateRTV(Resource* resource)
 		// There exist RTV for buffers, may need to add this later?
 	}
 
-	D3D12_CPU_DESCRIPTOR_HANDLE handle = m_RTVAllocator.Allocate().CPUHandle;
+	DescriptorAllocation allocation = m_RTVAllocator.Allocate();
 
 	D3D12_RENDER_TARGET_VIEW_DESC desc;
 	ZeroMemory(&desc, sizeof(desc));
@@ -256,24 +426,25 @@ D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateRTV(Resource* resource)
 	}
 
 	default:
-		return D3D12_CPU_DESCRIPTOR_HANDLE(); // TODO: handle error
+		m_RTVAllocator.Free(allocation);
+		return DescriptorAllocation(); // TODO: handle error
 	}
 
 	GPU::GetDevice()->CreateRenderTargetView(resource->Native,
 		&desc,
-		handle);
+		allocation.CPUHandle);
 
-	return handle;
+	return allocation;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateDSV(Resource* resource)
+env::DescriptorAllocation env::ResourceManager::CreateDSV(Resource* resource)
 {
 	{
 		bool isTexture2D = (resource->GetType() == ResourceType::Texture2D);
 		assert(isTexture2D);
 	}
 
-	D3D12_CPU_DESCRIPTOR_HANDLE handle = m_DSVAllocator.Allocate().CPUHandle;
+	DescriptorAllocation allocation = m_DSVAllocator.Allocate();
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC desc;
 	ZeroMemory(&desc, sizeof(desc));
@@ -292,20 +463,19 @@ D3D12_CPU_DESCRIPTOR_HANDLE env::ResourceManager::CreateDSV(Resource* resource)
 	}
 
 	default:
-		return D3D12_CPU_DESCRIPTOR_HANDLE(); // TODO: handle error
+		m_DSVAllocator.Free(allocation);
+		return DescriptorAllocation(); // TODO: handle error
 	}
 
 	GPU::GetDevice()->CreateDepthStencilView(resource->Native,
 		&desc,
-		handle);
+		allocation.CPUHandle);
 
-	return handle;
+	return allocation;
 }
 
 ID env::ResourceManager::CreateBufferArray(const std::string& name, const BufferLayout& layout, BufferBindType bindType, void* initialData)
 {
-	HRESULT hr = S_OK;
-
 	bool isShaderResource = any(bindType & BufferBindType::ShaderResource) || (bindType == BufferBindType::Unknown);
 	bool isUnorderedAccess = any(bindType & BufferBindType::UnorderedAccess) || (bindType == BufferBindType::Unknown);
 
@@ -320,34 +490,7 @@ ID env::ResourceManager::CreateBufferArray(const std::string& name, const Buffer
 
 	UINT bufferWidth = elementStride * numElements;
 
-	{ // Create the resource
-		D3D12_HEAP_PROPERTIES heapProperties;
-		ZeroMemory(&heapProperties, sizeof(heapProperties));
-		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-		heapProperties.CreationNodeMask = 1;
-		heapProperties.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC resourceDescription;
-		ZeroMemory(&resourceDescription, sizeof(resourceDescription));
-		resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		resourceDescription.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		resourceDescription.Width = (UINT64)bufferWidth;
-		resourceDescription.Height = 1;
-		resourceDescription.DepthOrArraySize = 1;
-		resourceDescription.MipLevels = 1;
-		resourceDescription.Format = DXGI_FORMAT_UNKNOWN;
-		resourceDescription.SampleDesc.Count = 1;
-		resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-
-		hr = GPU::GetDevice()->CreateCommittedResource(&heapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDescription,
-			bufferDesc.State,
-			NULL,
-			IID_PPV_ARGS(&bufferDesc.Native));
-
-		ASSERT_HR(hr, "Could not create buffer array");
-	}
+	bufferDesc.Native = CreateBufferNative((UINT64)bufferWidth, D3D12_HEAP_TYPE_DEFAULT, bufferDesc.State, bufferDesc.Memory);
 
 	{ // Create views
 		if (isShaderResource) {
@@ -358,9 +501,8 @@ ID env::ResourceManager::CreateBufferArray(const std::string& name, const Buffer
 		}
 	}
 
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
 	BufferArray* buffer = new BufferArray(std::move(bufferDesc));
-	m_buffersArrays[resourceID] = buffer;
+	ID resourceID = (ID)m_buffersArrays.Insert(buffer);
 
 	if (initialData) {
 		UploadBufferData(resourceID, initialData, bufferWidth);
@@ -369,10 +511,30 @@ ID env::ResourceManager::CreateBufferArray(const std::string& name, const Buffer
 	return resourceID;
 }
 
-ID env::ResourceManager::CreateBuffer(const std::string& name, const BufferLayout& layout, BufferBindType bindType, void* initialData)
+ID env::ResourceManager::CreateMappedBufferArray(const std::string& name, const BufferLayout& layout)
 {
 	HRESULT hr = S_OK;
 
+	BufferArray bufferDesc;
+
+	bufferDesc.Name = name;
+	bufferDesc.State = D3D12_RESOURCE_STATE_GENERIC_READ;
+	bufferDesc.Layout = layout;
+	bufferDesc.Native = CreateBufferNative((UINT64)bufferDesc.GetByteWidth(), D3D12_HEAP_TYPE_UPLOAD, bufferDesc.State, bufferDesc.Memory);
+
+	D3D12_RANGE readRange = { 0, 0 };
+	hr = bufferDesc.Native->Map(0, &readRange, &bufferDesc.MappedData);
+	ASSERT_HR(hr, "Could not map buffer array");
+
+	bufferDesc.Views.ShaderResource = CreateSRV(&bufferDesc);
+
+	ID resourceID = (ID)m_buffersArrays.Insert(new BufferArray(std::move(bufferDesc)));
+
+	return resourceID;
+}
+
+ID env::ResourceManager::CreateBuffer(const std::string& name, const BufferLayout& layout, BufferBindType bindType, void* initialData)
+{
 	bool isConstantBuffer = any(bindType & BufferBindType::Constant) || (bindType == BufferBindType::Unknown);
 	bool isIndexBuffer = any(bindType & BufferBindType::Index) || (bindType == BufferBindType::Unknown);
 	bool isVertexBuffer = any(bindType & BufferBindType::Vertex) || (bindType == BufferBindType::Unknown);
@@ -390,47 +552,26 @@ ID env::ResourceManager::CreateBuffer(const std::string& name, const BufferLayou
 		bufferWidth = (bufferWidth + 255) & ~255;
 	}
 
-	{ // Create the resource
-		D3D12_HEAP_PROPERTIES heapProperties;
-		ZeroMemory(&heapProperties, sizeof(heapProperties));
-		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-		heapProperties.CreationNodeMask = 1;
-		heapProperties.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC resourceDescription;
-		ZeroMemory(&resourceDescription, sizeof(resourceDescription));
-		resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-		resourceDescription.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		resourceDescription.Width = (UINT64)bufferWidth;
-		resourceDescription.Height = 1;
-		resourceDescription.DepthOrArraySize = 1;
-		resourceDescription.MipLevels = 1;
-		resourceDescription.Format = DXGI_FORMAT_UNKNOWN;
-		resourceDescription.SampleDesc.Count = 1;
-		resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	// Buffers only read as constants are never transitioned, so small ones
+	// can share a native buffer
+	bool isSmallConstantBuffer = (bindType == BufferBindType::Constant) && bufferWidth <= GPUMemoryPools::SMALL_BUFFER_MAX_SIZE;
 
-
-		hr = GPU::GetDevice()->CreateCommittedResource(&heapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDescription,
-			bufferDesc.State,
-			NULL,
-			IID_PPV_ARGS(&bufferDesc.Native));
-
-		ASSERT_HR(hr, "Could not create buffer");
-	}
+	if (isSmallConstantBuffer)
+		bufferDesc.Native = m_memory.CreateSmallBuffer(bufferWidth, bufferDesc.Memory);
+	else
+		bufferDesc.Native = CreateBufferNative(bufferWidth, D3D12_HEAP_TYPE_DEFAULT, bufferDesc.State, bufferDesc.Memory);
 
 	{ // Create views
 		if (isConstantBuffer) {
 			bufferDesc.Views.Constant = CreateCBV(&bufferDesc);
 		}
 		if (isIndexBuffer) {
-			bufferDesc.Views.Index.BufferLocation = bufferDesc.Native->GetGPUVirtualAddress();
+			bufferDesc.Views.Index.BufferLocation = bufferDesc.GetGPUAddress();
 			bufferDesc.Views.Index.SizeInBytes = bufferWidth;
 			bufferDesc.Views.Index.Format = layout.GetDXGIFormat();
 		}
 		if (isVertexBuffer) {
-			bufferDesc.Views.Vertex.BufferLocation = bufferDesc.Native->GetGPUVirtualAddress();
+			bufferDesc.Views.Vertex.BufferLocation = bufferDesc.GetGPUAddress();
 			bufferDesc.Views.Vertex.SizeInBytes = bufferWidth;
 			bufferDesc.Views.Vertex.StrideInBytes = layout.GetByteWidth();
 		}
@@ -439,9 +580,8 @@ ID env::ResourceManager::CreateBuffer(const std::string& name, const BufferLayou
 		}
 	}
 
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
 	Buffer* buffer = new Buffer(std::move(bufferDesc));
-	m_buffers[resourceID] = buffer;
+	ID resourceID = (ID)m_buffers.Insert(buffer);
 
 	if (initialData) {
 		UploadBufferData(resourceID, initialData, bufferWidth);
@@ -452,99 +592,7 @@ ID env::ResourceManager::CreateBuffer(const std::string& name, const BufferLayou
 
 ID env::ResourceManager::CreateTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType, void* initialData)
 {
-	HRESULT hr = S_OK;
-
-	Texture2D textureDesc;
-
-	textureDesc.Name = name;
-	textureDesc.State = D3D12_RESOURCE_STATE_COMMON;
-
-	textureDesc.Width = width;
-	textureDesc.Height = height;
-	textureDesc.Format = format;
-
-	{ // Create the resource
-		D3D12_HEAP_PROPERTIES heapProperties;
-		ZeroMemory(&heapProperties, sizeof(heapProperties));
-		heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
-		heapProperties.CreationNodeMask = 1;
-		heapProperties.VisibleNodeMask = 1;
-
-		D3D12_RESOURCE_DESC resourceDescription;
-		ZeroMemory(&resourceDescription, sizeof(resourceDescription));
-		resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-		resourceDescription.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
-		resourceDescription.Width = (UINT64)textureDesc.Width;
-		resourceDescription.Height = textureDesc.Height;
-		resourceDescription.DepthOrArraySize = 1;
-		resourceDescription.MipLevels = 1;
-		resourceDescription.Format = format;
-		resourceDescription.SampleDesc.Count = 1;
-		resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
-
-		bool isRenderTarget = any(bindType & TextureBindType::RenderTarget) || (bindType == TextureBindType::Unknown);
-		bool isShaderResource = any(bindType & TextureBindType::ShaderResource) || (bindType == TextureBindType::Unknown);
-		bool isUnorderedAccess = any(bindType & TextureBindType::UnorderedAccess) || (bindType == TextureBindType::Unknown);
-		bool isDepthStencil = any(bindType & TextureBindType::DepthStencil);
-
-		if (isRenderTarget)
-			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
-		//if (!any(bindType & BindType::ShaderResource)) // requires D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL or D3D12_RESOURCE_FLAG_VIDEO_DECODE_REFERENCE_ONLY
-		//	resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE;
-		if (isUnorderedAccess)
-			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
-		if (isDepthStencil) {
-			resourceDescription.Flags = resourceDescription.Flags | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-			textureDesc.State = D3D12_RESOURCE_STATE_DEPTH_WRITE;
-		}
-
-		D3D12_CLEAR_VALUE clearValue = {};
-		D3D12_CLEAR_VALUE* clearValuePtr = nullptr;
-
-		if (isDepthStencil) {
-			clearValue.Format = resourceDescription.Format;
-			clearValue.DepthStencil.Depth = 1.0f;
-			clearValue.DepthStencil.Stencil = 0;
-			clearValuePtr = &clearValue;
-		}
-
-		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = { 0 };
-		UINT numRows = 0;
-		GPU::GetDevice()->GetCopyableFootprints(&resourceDescription,
-			0,
-			1,
-			0,
-			&footprint,
-			&numRows,
-			&textureDesc.RowPitch,
-			&textureDesc.ByteWidth);
-
-		hr = GPU::GetDevice()->CreateCommittedResource(&heapProperties,
-			D3D12_HEAP_FLAG_NONE,
-			&resourceDescription,
-			textureDesc.State,
-			clearValuePtr,
-			IID_PPV_ARGS(&textureDesc.Native));
-
-		ASSERT_HR(hr, "Could not create texture 2D buffer");
-	}
-
-	{
-		if (any(bindType & TextureBindType::RenderTarget))
-			textureDesc.Views.RenderTarget = CreateRTV(&textureDesc);
-		if (any(bindType & TextureBindType::ShaderResource))
-			textureDesc.Views.ShaderResource = CreateSRV(&textureDesc);
-		if (any(bindType & TextureBindType::UnorderedAccess))
-			textureDesc.Views.UnorderedAccess = CreateUAV(&textureDesc);
-		if (any(bindType & TextureBindType::DepthStencil)) {
-			textureDesc.Views.DepthStencil = CreateDSV(&textureDesc);
-		}
-	}
-
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
-	Texture2D* texture = new Texture2D(std::move(textureDesc));
-	m_texture2Ds[resourceID] = texture;
-
+	ID resourceID = AddTexture2D(name, width, height, format, bindType, nullptr, 0);
 
 	if (initialData)
 	{
@@ -603,19 +651,24 @@ ID env::ResourceManager::CreateTexture2D(const std::string& name, TextureBindTyp
 			textureDesc.Views.UnorderedAccess = CreateUAV(&textureDesc);
 	}
 
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
 	Texture2D* texture = new Texture2D(std::move(textureDesc));
-	m_texture2Ds[resourceID] = texture;
+	ID resourceID = (ID)m_texture2Ds.Insert(texture);
 
 	return resourceID;
 }
 
+ID env::ResourceManager::CreatePlacedTexture2D(const std::string& name, int width, int height, DXGI_FORMAT format, TextureBindType bindType, ID3D12Heap* heap, UINT64 heapOffset)
+{
+	assert(heap);
+	return AddTexture2D(name, width, height, format, bindType, heap, heapOffset);
+}
+
 ID env::ResourceManager::CreateTexture2DArray(const std::string& name, int numTextures, int width, int height, DXGI_FORMAT format, void* initialData)
 {
 	return ID();
 }
 
-ID env::ResourceManager::CreatePipelineState(const std::string& name, std::initializer_list<ShaderDesc> shaderDescs, bool useInputLayout, const RootSignature& rootSignature)
+ID env::ResourceManager::CreatePipelineState(const std::string& name, std::initializer_list<ShaderDesc> shaderDescs, const BufferLayout& vertexLayout, const RootSignature& rootSignature)
 {
 	// Sanity check that there's at most one desc per shader stage
 	ShaderStage stages = ShaderStage::Unknown;
@@ -625,27 +678,57 @@ ID env::ResourceManager::CreatePipelineState(const std::string& name, std::initi
 		stages = stages | s.Stage;
 	}
 
+	Timepoint createStart = Time::Now();
 	HRESULT hr = S_OK;
 
 	PipelineState resourceDesc;
 
-	std::unordered_map<ShaderStage, ID3DBlob*> shaders;
+	// Everything the pipeline blob depends on, added to as the parts are made
+	ShaderCacheKey pipelineKey;
+
+	std::unordered_map<ShaderStage, std::vector<uint8_t>> shaders;
 	ID3DBlob* errorBlob;
 
-	{ // Compile shaders
+	{ // Compile shaders, or read them from the cache
+
+		const UINT compileFlags = 0;
 
 		for (auto& s : shaderDescs)
 		{
 			std::string targetModel = GetTargetModelString(s.Stage, s.Model);
+
+			ShaderCacheKey shaderKey;
+			shaderKey.AddValue(ShaderCache::HashSource(s.Path));
+			shaderKey.AddString(s.EntryPoint);
+			shaderKey.AddString(targetModel);
+			for (const ShaderDefine& define : s.Defines) {
+				shaderKey.AddString(define.Name);
+				shaderKey.AddString(define.Value);
+			}
+			shaderKey.AddValue(compileFlags);
+			shaderKey.AddValue((UINT)D3D_COMPILER_VERSION);
+
+			pipelineKey.AddValue(s.Stage);
+			pipelineKey.AddValue(shaderKey.Get());
+
+			std::vector<uint8_t>& bytecode = shaders[s.Stage];
+			if (m_shaderCache.Read(ShaderCacheEntry::Shader, shaderKey.Get(), bytecode))
+				continue;
+
+			std::vector<D3D_SHADER_MACRO> macros;
+			for (const ShaderDefine& define : s.Defines)
+				macros.push_back({ define.Name.c_str(), define.Value.c_str() });
+			macros.push_back({ NULL, NULL });
+
 			std::wstring path(s.Path.begin(), s.Path.end());
 
 			ID3DBlob* blob = nullptr;
 			hr = D3DCompileFromFile(path.c_str(),
-				NULL,
-				NULL,
+				macros.data(),
+				D3D_COMPILE_STANDARD_FILE_INCLUDE,
 				s.EntryPoint.c_str(),
 				targetModel.c_str(),
-				NULL,
+				compileFlags,
 				NULL,
 				&blob,
 				&errorBlob);
@@ -660,37 +743,76 @@ ID env::ResourceManager::CreatePipelineState(const std::string& name, std::initi
 				ASSERT_HR(hr, "Failed to compile shader");
 			}
 
-			shaders[s.Stage] = blob;
+			const uint8_t* code = (const uint8_t*)blob->GetBufferPointer();
+			bytecode.assign(code, code + blob->GetBufferSize());
+			blob->Release();
+
+			m_shaderCache.Write(ShaderCacheEntry::Shader, shaderKey.Get(), bytecode.data(), bytecode.size());
 		}
 	}
 
 	{
-		ID3DBlob* rootSignatureBlob = nullptr;
-
 		D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc;
 		ZeroMemory(&rootSignatureDesc, sizeof(rootSignatureDesc));
 		rootSignatureDesc.NumParameters = rootSignature.GetNumParameters();
 		rootSignatureDesc.pParameters = rootSignature.GetParameterArrayStart();
 
-		if (useInputLayout)
+		if (vertexLayout.GetNumElements() > 0)
 			rootSignatureDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
-		hr = D3D12SerializeRootSignature(&rootSignatureDesc,
-			D3D_ROOT_SIGNATURE_VERSION_1_0,
-			&rootSignatureBlob,
-			&errorBlob);
+		// The layout, without the pointers between its parts
+		ShaderCacheKey rootSignatureKey;
+		rootSignatureKey.AddValue(D3D_ROOT_SIGNATURE_VERSION_1_0);
+		rootSignatureKey.AddValue(rootSignatureDesc.Flags);
+		for (UINT i = 0; i < rootSignatureDesc.NumParameters; i++) {
+			const D3D12_ROOT_PARAMETER& parameter = rootSignatureDesc.pParameters[i];
+			rootSignatureKey.AddValue(parameter.ParameterType);
+			rootSignatureKey.AddValue(parameter.ShaderVisibility);
 
-		if (FAILED(hr)) {
-			if (errorBlob) {
-				OutputDebugStringA((LPCSTR)errorBlob->GetBufferPointer());
-				errorBlob->Release();
+			switch (parameter.ParameterType)
+			{
+			case D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE:
+				rootSignatureKey.AddValue(parameter.DescriptorTable.NumDescriptorRanges);
+				rootSignatureKey.AddBytes(parameter.DescriptorTable.pDescriptorRanges,
+					parameter.DescriptorTable.NumDescriptorRanges * sizeof(D3D12_DESCRIPTOR_RANGE));
+				break;
+			case D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS:
+				rootSignatureKey.AddValue(parameter.Constants);
+				break;
+			default:
+				rootSignatureKey.AddValue(parameter.Descriptor);
+				break;
 			}
-			ASSERT_HR(hr, "Failed to resialize root signature");
+		}
+		pipelineKey.AddValue(rootSignatureKey.Get());
+
+		std::vector<uint8_t> serializedRootSignature;
+		if (!m_shaderCache.Read(ShaderCacheEntry::RootSignature, rootSignatureKey.Get(), serializedRootSignature)) {
+			ID3DBlob* rootSignatureBlob = nullptr;
+
+			hr = D3D12SerializeRootSignature(&rootSignatureDesc,
+				D3D_ROOT_SIGNATURE_VERSION_1_0,
+				&rootSignatureBlob,
+				&errorBlob);
+
+			if (FAILED(hr)) {
+				if (errorBlob) {
+					OutputDebugStringA((LPCSTR)errorBlob->GetBufferPointer());
+					errorBlob->Release();
+				}
+				ASSERT_HR(hr, "Failed to resialize root signature");
+			}
+
+			const uint8_t* data = (const uint8_t*)rootSignatureBlob->GetBufferPointer();
+			serializedRootSignature.assign(data, data + rootSignatureBlob->GetBufferSize());
+			rootSignatureBlob->Release();
+
+			m_shaderCache.Write(ShaderCacheEntry::RootSignature, rootSignatureKey.Get(), serializedRootSignature.data(), serializedRootSignature.size());
 		}
 
 		hr = GPU::GetDevice()->CreateRootSignature(NULL,
-			rootSignatureBlob->GetBufferPointer(),
-			rootSignatureBlob->GetBufferSize(),
+			serializedRootSignature.data(),
+			serializedRootSignature.size(),
 			IID_PPV_ARGS(&resourceDesc.RootSignature));
 
 		ASSERT_HR(hr, "Could not create root signature");
@@ -734,41 +856,87 @@ ID env::ResourceManager::CreatePipelineState(const std::string& name, std::initi
 		}
 
 		// Set required shaders
-		pipelineDesc.VS.pShaderBytecode = shaders[ShaderStage::Vertex]->GetBufferPointer();
-		pipelineDesc.VS.BytecodeLength = shaders[ShaderStage::Vertex]->GetBufferSize();
-		pipelineDesc.PS.pShaderBytecode = shaders[ShaderStage::Pixel]->GetBufferPointer();
-		pipelineDesc.PS.BytecodeLength = shaders[ShaderStage::Pixel]->GetBufferSize();
+		pipelineDesc.VS.pShaderBytecode = shaders[ShaderStage::Vertex].data();
+		pipelineDesc.VS.BytecodeLength = shaders[ShaderStage::Vertex].size();
+		pipelineDesc.PS.pShaderBytecode = shaders[ShaderStage::Pixel].data();
+		pipelineDesc.PS.BytecodeLength = shaders[ShaderStage::Pixel].size();
 
 		// Set optional shaders
 		if (any(stages & ShaderStage::Domain)) {
-			pipelineDesc.DS.pShaderBytecode = shaders[ShaderStage::Domain]->GetBufferPointer();
-			pipelineDesc.DS.BytecodeLength = shaders[ShaderStage::Domain]->GetBufferSize();
+			pipelineDesc.DS.pShaderBytecode = shaders[ShaderStage::Domain].data();
+			pipelineDesc.DS.BytecodeLength = shaders[ShaderStage::Domain].size();
 		}
 		if (any(stages & ShaderStage::Hull)) {
-			pipelineDesc.HS.pShaderBytecode = shaders[ShaderStage::Hull]->GetBufferPointer();
-			pipelineDesc.HS.BytecodeLength = shaders[ShaderStage::Hull]->GetBufferSize();
+			pipelineDesc.HS.pShaderBytecode = shaders[ShaderStage::Hull].data();
+			pipelineDesc.HS.BytecodeLength = shaders[ShaderStage::Hull].size();
 		}
 		if (any(stages & ShaderStage::Geometry)) {
-			pipelineDesc.GS.pShaderBytecode = shaders[ShaderStage::Geometry]->GetBufferPointer();
-			pipelineDesc.GS.BytecodeLength = shaders[ShaderStage::Geometry]->GetBufferSize();
+			pipelineDesc.GS.pShaderBytecode = shaders[ShaderStage::Geometry].data();
+			pipelineDesc.GS.BytecodeLength = shaders[ShaderStage::Geometry].size();
 		}
 
 		
-		std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout = {
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		};
+		std::vector<D3D12_INPUT_ELEMENT_DESC> inputLayout;
+		vertexLayout.GetInputElements(inputLayout);
 		pipelineDesc.InputLayout.NumElements = (UINT)inputLayout.size();
 		pipelineDesc.InputLayout.pInputElementDescs = inputLayout.data();
 
-		hr = GPU::GetDevice()->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&resourceDesc.State));
-		ASSERT_HR(hr, "Could not create pipeline state");
+		// The fixed function state, the desc is zeroed so padding hashes the same every time
+		pipelineKey.AddValue(pipelineDesc.BlendState);
+		pipelineKey.AddValue(pipelineDesc.SampleMask);
+		pipelineKey.AddValue(pipelineDesc.RasterizerState);
+		pipelineKey.AddValue(pipelineDesc.DepthStencilState);
+		pipelineKey.AddValue(pipelineDesc.IBStripCutValue);
+		pipelineKey.AddValue(pipelineDesc.PrimitiveTopologyType);
+		pipelineKey.AddValue(pipelineDesc.NumRenderTargets);
+		pipelineKey.AddValue(pipelineDesc.RTVFormats);
+		pipelineKey.AddValue(pipelineDesc.DSVFormat);
+		pipelineKey.AddValue(pipelineDesc.SampleDesc);
+		pipelineKey.AddValue(pipelineDesc.NodeMask);
+		pipelineKey.AddValue(pipelineDesc.Flags);
+		for (const D3D12_INPUT_ELEMENT_DESC& element : inputLayout) {
+			pipelineKey.AddString(element.SemanticName);
+			pipelineKey.AddValue(element.SemanticIndex);
+			pipelineKey.AddValue(element.Format);
+			pipelineKey.AddValue(element.InputSlot);
+			pipelineKey.AddValue(element.AlignedByteOffset);
+			pipelineKey.AddValue(element.InputSlotClass);
+			pipelineKey.AddValue(element.InstanceDataStepRate);
+		}
+
+		// Cached blobs only work with the adapter and driver that made them,
+		// any other is refused and the pipeline is created from scratch
+		resourceDesc.State = nullptr;
+		std::vector<uint8_t> cachedPipeline;
+		if (m_shaderCache.Read(ShaderCacheEntry::Pipeline, pipelineKey.Get(), cachedPipeline)) {
+			pipelineDesc.CachedPSO.pCachedBlob = cachedPipeline.data();
+			pipelineDesc.CachedPSO.CachedBlobSizeInBytes = cachedPipeline.size();
+
+			hr = GPU::GetDevice()->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&resourceDesc.State));
+			if (FAILED(hr)) {
+				m_shaderCache.Reject(ShaderCacheEntry::Pipeline);
+				pipelineDesc.CachedPSO.pCachedBlob = nullptr;
+				pipelineDesc.CachedPSO.CachedBlobSizeInBytes = 0;
+				resourceDesc.State = nullptr;
+			}
+		}
+
+		if (!resourceDesc.State) {
+			hr = GPU::GetDevice()->CreateGraphicsPipelineState(&pipelineDesc, IID_PPV_ARGS(&resourceDesc.State));
+			ASSERT_HR(hr, "Could not create pipeline state");
+
+			ID3DBlob* pipelineBlob = nullptr;
+			if (SUCCEEDED(resourceDesc.State->GetCachedBlob(&pipelineBlob))) {
+				m_shaderCache.Write(ShaderCacheEntry::Pipeline, pipelineKey.Get(), pipelineBlob->GetBufferPointer(), pipelineBlob->GetBufferSize());
+				pipelineBlob->Release();
+			}
+		}
 	}
 
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
+	m_pipelineCreateTime += (Time::Now() - createStart).InSeconds();
+
 	PipelineState* pipeline = new PipelineState(std::move(resourceDesc));
-	m_pipelineStates[resourceID] = pipeline;
+	ID resourceID = (ID)m_pipelineStates.Insert(pipeline);
 
 	return resourceID;
 }
@@ -788,9 +956,8 @@ ID env::ResourceManager::CreateWindowTarget(const std::string& name, Window* win
 
 	AdjustViewportAndScissorRect(targetDesc, *window);
 
-	ID resourceID = m_commonIDGenerator.GenerateUnique();
 	WindowTarget* target = new WindowTarget(std::move(targetDesc));
-	m_targets[resourceID] = target;
+	ID resourceID = (ID)m_targets.Insert(target);
 
 	window->PushTarget(target);
 
@@ -799,37 +966,32 @@ ID env::ResourceManager::CreateWindowTarget(const std::string& name, Window* win
 
 env::BufferArray* env::ResourceManager::GetBufferArray(ID resourceID)
 {
-	if (m_buffersArrays.count(resourceID) == 0)
-		return nullptr;
-	return m_buffersArrays[resourceID];
+	BufferArray** resource = m_buffersArrays.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 env::Buffer* env::ResourceManager::GetBuffer(ID resourceID)
 {
-	if (m_buffers.count(resourceID) == 0)
-		return nullptr;
-	return m_buffers[resourceID];
+	Buffer** resource = m_buffers.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 env::Texture2D* env::ResourceManager::GetTexture2D(ID resourceID)
 {
-	if (m_texture2Ds.count(resourceID) == 0)
-		return nullptr;
-	return m_texture2Ds[resourceID];
+	Texture2D** resource = m_texture2Ds.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 env::Texture2DArray* env::ResourceManager::GetTexture2DArray(ID resourceID)
 {
-	if (m_texture2DArrays.count(resourceID) == 0)
-		return nullptr;
-	return m_texture2DArrays[resourceID];
+	Texture2DArray** resource = m_texture2DArrays.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 env::PipelineState* env::ResourceManager::GetPipelineState(ID resourceID)
 {
-	if (m_pipelineStates.count(resourceID) == 0)
-		return nullptr;
-	return m_pipelineStates[resourceID];
+	PipelineState** resource = m_pipelineStates.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 //env::WindowTarget* env::ResourceManager::GetWindowTarget(ID resourceID)
@@ -841,9 +1003,8 @@ env::PipelineState* env::ResourceManager::GetPipelineState(ID resourceID)
 
 env::WindowTarget* env::ResourceManager::GetTarget(ID resourceID)
 {
-	if (m_targets.count(resourceID) == 0)
-		return nullptr;
-	return m_targets[resourceID];
+	WindowTarget** resource = m_targets.Find((uint64_t)resourceID);
+	return resource ? *resource : nullptr;
 }
 
 env::Resource* env::ResourceManager::GetResource(ID resourceID)
@@ -851,6 +1012,131 @@ env::Resource* env::ResourceManager::GetResource(ID resourceID)
 	return (env::Resource*)GetResourceNonConst(resourceID);
 }
 
+env::BindlessHeap& env::ResourceManager::GetBindlessHeap()
+{
+	return m_bindlessHeap;
+}
+
+env::GPUMemoryStatistics env::ResourceManager::GetMemoryStatistics() const
+{
+	return m_memory.GetStatistics();
+}
+
+env::ShaderCache& env::ResourceManager::GetShaderCache()
+{
+	return m_shaderCache;
+}
+
+float env::ResourceManager::GetPipelineCreateTime() const
+{
+	return m_pipelineCreateTime;
+}
+
+D3D12_RESOURCE_ALLOCATION_INFO env::ResourceManager::GetTexture2DAllocationInfo(int width, int height, DXGI_FORMAT format, TextureBindType bindType) const
+{
+	D3D12_RESOURCE_DESC desc = GetTexture2DDesc(width, height, format, bindType);
+	return GPU::GetDevice()->GetResourceAllocationInfo(0, 1, &desc);
+}
+
+void env::ResourceManager::ReleaseTexture2D(ID resourceID)
+{
+	Texture2D* texture = GetTexture2D(resourceID);
+	assert(texture);
+	m_texture2Ds.Erase((uint64_t)resourceID);
+
+	// Textures placed in a heap of the caller have no allocation here
+	ID3D12Resource* oldNative = texture->Native;
+	GPUAllocation oldMemory = texture->Memory;
+	DescriptorAllocation oldRenderTarget = texture->Views.RenderTarget;
+	DescriptorAllocation oldDepthStencil = texture->Views.DepthStencil;
+	BindlessHandle oldShaderResource = texture->Views.ShaderResource;
+	BindlessHandle oldUnorderedAccess = texture->Views.UnorderedAccess;
+	bool isAllocated = (oldMemory.NumBytes > 0);
+
+	m_deferredReleases.Push({ &GPU::GetDirectQueue(), &GPU::GetPresentQueue() },
+		[this, oldNative, oldMemory, oldRenderTarget, oldDepthStencil, oldShaderResource, oldUnorderedAccess, isAllocated]() {
+			oldNative->Release();
+			if (isAllocated)
+				m_memory.Free(oldMemory);
+			if (oldRenderTarget.IsValid())
+				m_RTVAllocator.Free(oldRenderTarget);
+			if (oldDepthStencil.IsValid())
+				m_DSVAllocator.Free(oldDepthStencil);
+			if (oldShaderResource.IsValid())
+				m_bindlessHeap.Free(oldShaderResource);
+			if (oldUnorderedAccess.IsValid())
+				m_bindlessHeap.Free(oldUnorderedAccess);
+		});
+
+	delete texture;
+}
+
+void env::ResourceManager::ReleaseBuffer(ID resourceID)
+{
+	Buffer* buffer = GetBuffer(resourceID);
+	assert(buffer);
+	m_buffers.Erase((uint64_t)resourceID);
+
+	ID3D12Resource* oldNative = buffer->Native;
+	GPUAllocation oldMemory = buffer->Memory;
+	BindlessHandle oldConstant = buffer->Views.Constant;
+	BindlessHandle oldUnorderedAccess = buffer->Views.UnorderedAccess;
+
+	m_deferredReleases.Push({ &GPU::GetDirectQueue(), &GPU::GetPresentQueue() },
+		[this, oldNative, oldMemory, oldConstant, oldUnorderedAccess]() {
+			oldNative->Release();
+			m_memory.Free(oldMemory);
+			if (oldConstant.IsValid())
+				m_bindlessHeap.Free(oldConstant);
+			if (oldUnorderedAccess.IsValid())
+				m_bindlessHeap.Free(oldUnorderedAccess);
+		});
+
+	delete buffer;
+}
+
+void env::ResourceManager::ResizeBufferArray(ID resourceID, UINT numElements)
+{
+	BufferArray* buffer = GetBufferArray(resourceID);
+	assert(buffer);
+
+	bool isMapped = (buffer->MappedData != nullptr);
+
+	// The old buffer is released once the queues are done with the work
+	// executed so far, its memory can be reused after that
+	ID3D12Resource* oldNative = buffer->Native;
+	GPUAllocation oldMemory = buffer->Memory;
+	m_deferredReleases.Push({ &GPU::GetDirectQueue(), &GPU::GetPresentQueue() },
+		[this, oldNative, oldMemory]() {
+			oldNative->Release();
+			m_memory.Free(oldMemory);
+		});
+
+	buffer->Layout.SetRepetitions(numElements);
+
+	if (isMapped) {
+		buffer->State = D3D12_RESOURCE_STATE_GENERIC_READ;
+		buffer->Native = CreateBufferNative((UINT64)buffer->GetByteWidth(), D3D12_HEAP_TYPE_UPLOAD, buffer->State, buffer->Memory);
+
+		D3D12_RANGE readRange = { 0, 0 };
+		HRESULT hr = buffer->Native->Map(0, &readRange, &buffer->MappedData);
+		ASSERT_HR(hr, "Could not map buffer array");
+	}
+	else {
+		buffer->State = D3D12_RESOURCE_STATE_COMMON;
+		buffer->Native = CreateBufferNative((UINT64)buffer->GetByteWidth(), D3D12_HEAP_TYPE_DEFAULT, buffer->State, buffer->Memory);
+	}
+
+	// The view holds the element count, so it has to be recreated as well
+	// The old index is freed with the old buffer, frames in flight still use it
+	if (buffer->Views.ShaderResource.IsValid()) {
+		BindlessHandle oldView = buffer->Views.ShaderResource;
+		m_deferredReleases.Push({ &GPU::GetDirectQueue(), &GPU::GetPresentQueue() },
+			[this, oldView]() { m_bindlessHeap.Free(oldView); });
+		buffer->Views.ShaderResource = CreateSRV(buffer);
+	}
+}
+
 void env::ResourceManager::UploadBufferData(ID resourceID, void* data, UINT numBytes, UINT destinationOffset)
 {
 	Resource* buffer = GetResourceNonConst(resourceID);
@@ -859,35 +1145,40 @@ void env::ResourceManager::UploadBufferData(ID resourceID, void* data, UINT numB
 	if (numBytes == 0)
 		numBytes = buffer->GetByteWidth();
 
-	{ // Upload data
-		void* destination = nullptr;
-		D3D12_RANGE readRange = { 0,0 };
+	UINT64 uploadOffset = AllocateUploadMemory(numBytes);
+	memcpy(m_uploadBufferMapped + uploadOffset, data, numBytes);
 
-		HRESULT hr = S_OK;
-		hr = m_uploadBuffer.Native->Map(0, &readRange, &destination);
-		ASSERT_HR(hr, "Could not map constant buffer");
+	// Buffers are implicitly promoted to COPY_DEST on the copy queue and
+	// decay back to COMMON once the batch has been executed.
+	CopyList* list = GetUploadList();
+	list->CopyBufferRegion(buffer, buffer->Memory.Offset + destinationOffset, &m_uploadBuffer, uploadOffset, numBytes);
+	buffer->State = D3D12_RESOURCE_STATE_COMMON;
+}
 
-		destination = ((char*)destination) + destinationOffset;
-		memcpy(destination, data, numBytes);
+UINT64 env::ResourceManager::FlushUploads()
+{
+	CommandQueue& copyQueue = GPU::GetCopyQueue();
 
-		m_uploadBuffer.Native->Unmap(0, NULL);
-	}
+	if (!m_hasPendingUploads)
+		return copyQueue.GetFenceValue();
 
-	{ // Copy data to the actual buffer
+	m_uploadList->Close();
+	copyQueue.QueueList(m_uploadList);
 
-		CommandQueue& directQueue = GPU::GetDirectQueue();
+	UINT64 fenceValue = copyQueue.Execute();
+	m_uploadAllocator.Submit(fenceValue);
+	m_uploadList = nullptr;
+	m_hasPendingUploads = false;
 
-		D3D12_RESOURCE_STATES initialState = buffer->State;
+	// Everything that could read the uploaded data waits on the GPU timeline
+	GPU::GetDirectQueue().WaitForQueue(&copyQueue, fenceValue);
+	GPU::GetComputeQueue().WaitForQueue(&copyQueue, fenceValue);
+	GPU::GetPresentQueue().WaitForQueue(&copyQueue, fenceValue);
 
-		{
-			m_transitionList->Reset();
-			m_transitionList->TransitionResource(buffer, D3D12_RESOURCE_STATE_COPY_DEST);
-			m_transitionList->CopyBufferRegion(buffer, 0, &m_uploadBuffer, 0, numBytes);
-			m_transitionList->TransitionResource(buffer, initialState);
-			m_transitionList->Close();
-			directQueue.QueueList(m_transitionList);
-			directQueue.Execute();
-			directQueue.WaitForIdle();
-		}
-	}
+	return fenceValue;
+}
+
+void env::ResourceManager::ReleaseCompletedResources()
+{
+	m_deferredReleases.Collect();
 }
@@ -74,6 +74,17 @@ size_t env::GetShaderDataTypeSize(ShaderDataType type)
 	case ShaderDataType::Double4x2:		return sizeof(double) * 4 * 2;
 	case ShaderDataType::Double4x3:		return sizeof(double) * 4 * 3;
 	case ShaderDataType::Double4x4:		return sizeof(double) * 4 * 4;
+
+		// Packed
+	case ShaderDataType::Half2:			return sizeof(uint16_t) * 2;
+	case ShaderDataType::Half4:			return sizeof(uint16_t) * 4;
+	case ShaderDataType::Snorm16x2:		return sizeof(int16_t) * 2;
+	case ShaderDataType::Snorm16x4:		return sizeof(int16_t) * 4;
+	case ShaderDataType::Unorm16x2:		return sizeof(uint16_t) * 2;
+	case ShaderDataType::Unorm16x4:		return sizeof(uint16_t) * 4;
+	case ShaderDataType::Snorm8x4:		return sizeof(int8_t) * 4;
+	case ShaderDataType::Unorm8x4:		return sizeof(uint8_t) * 4;
+	case ShaderDataType::Unorm10x3_2:	return sizeof(uint32_t);
 	}
 	return 0;
 }
@@ -97,5 +108,16 @@ DXGI_FORMAT env::GetDXGIFormat(ShaderDataType type)
 	case ShaderDataType::Float2: return DXGI_FORMAT_R32G32_FLOAT;
 	case ShaderDataType::Float3: return DXGI_FORMAT_R32G32B32_FLOAT;
 	case ShaderDataType::Float4: return DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+	case ShaderDataType::Half2: return DXGI_FORMAT_R16G16_FLOAT;
+	case ShaderDataType::Half4: return DXGI_FORMAT_R16G16B16A16_FLOAT;
+	case ShaderDataType::Snorm16x2: return DXGI_FORMAT_R16G16_SNORM;
+	case ShaderDataType::Snorm16x4: return DXGI_FORMAT_R16G16B16A16_SNORM;
+	case ShaderDataType::Unorm16x2: return DXGI_FORMAT_R16G16_UNORM;
+	case ShaderDataType::Unorm16x4: return DXGI_FORMAT_R16G16B16A16_UNORM;
+	case ShaderDataType::Snorm8x4: return DXGI_FORMAT_R8G8B8A8_SNORM;
+	case ShaderDataType::Unorm8x4: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case ShaderDataType::Unorm10x3_2: return DXGI_FORMAT_R10G10B10A2_UNORM;
 	}
+	return DXGI_FORMAT_UNKNOWN;
 }
@@ -0,0 +1,49 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace env::test
+{
+	// A test is a function registered under a name of the form Suite.Name.
+	// CHECK records a failure and the test goes on, so one run reports all
+	// failed checks. Benchmarks are tests as well and print their timings.
+	struct TestCase
+	{
+		const char* Name;
+		void (*Function)();
+	};
+
+	std::vector<TestCase>& GetTests();
+	void ReportFailure(const char* file, int line, const char* expression);
+
+	struct TestRegistrar
+	{
+		TestRegistrar(const char* name, void (*function)()) { GetTests().push_back({ name, function }); }
+	};
+
+	// Seconds since the start, for benchmarks
+	inline double Now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Keeps the compiler from dropping work whose result is otherwise unused
+	template <typename T>
+	void DoNotOptimize(const T& value)
+	{
+		static T sink;
+		*(volatile T*)&sink = value;
+	}
+}
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST(suite, name) \
+	static void TEST_CONCAT(suite##_, name)(); \
+	static env::test::TestRegistrar TEST_CONCAT(suite##_##name, _registrar)(#suite "." #name, &TEST_CONCAT(suite##_, name)); \
+	static void TEST_CONCAT(suite##_, name)()
+
+#define CHECK(expression) \
+	do { if (!(expression)) env::test::ReportFailure(__FILE__, __LINE__, #expression); } while (false)
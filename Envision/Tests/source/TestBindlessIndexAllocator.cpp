@@ -0,0 +1,91 @@
+#include "Test.h"
+#include "envision/core/BindlessIndexAllocator.h"
+#include <random>
+
+TEST(BindlessIndexAllocator, FailsWhenFull)
+{
+	env::BindlessIndexAllocator allocator(3);
+
+	for (uint32_t i = 0; i < 3; i++) {
+		env::BindlessHandle handle = allocator.Allocate();
+		CHECK(handle.IsValid() && handle.Index == i);
+	}
+	CHECK(!allocator.Allocate().IsValid());
+	CHECK(allocator.GetNumAllocated() == 3);
+
+	env::BindlessIndexAllocator empty(0);
+	CHECK(!empty.Allocate().IsValid());
+}
+
+TEST(BindlessIndexAllocator, ReusesMostRecentlyFreed)
+{
+	env::BindlessIndexAllocator allocator(8);
+
+	env::BindlessHandle a = allocator.Allocate();
+	env::BindlessHandle b = allocator.Allocate();
+	env::BindlessHandle c = allocator.Allocate();
+	allocator.Free(a);
+	allocator.Free(c);
+
+	CHECK(allocator.Allocate().Index == c.Index);
+	CHECK(allocator.Allocate().Index == a.Index);
+	CHECK(allocator.GetHighWaterMark() == 3);
+	CHECK(allocator.IsCurrent(b));
+}
+
+TEST(BindlessIndexAllocator, DetectsStaleHandles)
+{
+	env::BindlessIndexAllocator allocator(4);
+
+	env::BindlessHandle old = allocator.Allocate();
+	CHECK(allocator.IsCurrent(old));
+	allocator.Free(old);
+	CHECK(!allocator.IsCurrent(old));
+
+	// Same index, new generation
+	env::BindlessHandle reused = allocator.Allocate();
+	CHECK(reused.Index == old.Index);
+	CHECK(reused.Generation != old.Generation);
+	CHECK(allocator.IsCurrent(reused));
+	CHECK(!allocator.IsCurrent(old));
+
+	CHECK(!allocator.IsCurrent(env::BindlessHandle()));
+	CHECK(!allocator.IsCurrent({ 3, 0 })); // Never handed out
+}
+
+TEST(BindlessIndexAllocator, RandomChurn)
+{
+	const uint32_t CAPACITY = 1024;
+
+	env::BindlessIndexAllocator allocator(CAPACITY);
+	std::vector<env::BindlessHandle> live;
+	std::vector<bool> inUse(CAPACITY, false);
+	std::mt19937 random(1);
+
+	bool allUnique = true;
+	bool allCurrent = true;
+	for (int i = 0; i < 100000; i++) {
+		if (live.empty() || (random() % 3 != 0 && live.size() < CAPACITY)) {
+			env::BindlessHandle handle = allocator.Allocate();
+			allUnique = allUnique && handle.IsValid() && !inUse[handle.Index];
+			if (handle.IsValid()) {
+				inUse[handle.Index] = true;
+				live.push_back(handle);
+			}
+		}
+		else {
+			size_t picked = random() % live.size();
+			env::BindlessHandle handle = live[picked];
+			allCurrent = allCurrent && allocator.IsCurrent(handle);
+			allocator.Free(handle);
+			inUse[handle.Index] = false;
+			live[picked] = live.back();
+			live.pop_back();
+		}
+	}
+
+	CHECK(allUnique);
+	CHECK(allCurrent);
+	CHECK(allocator.GetNumAllocated() == live.size());
+	CHECK(allocator.GetHighWaterMark() <= CAPACITY);
+}
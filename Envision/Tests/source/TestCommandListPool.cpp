@@ -0,0 +1,106 @@
+#include "Test.h"
+#include "envision/core/CommandListPool.h"
+#include "envision/core/JobSystem.h"
+#include <atomic>
+#include <thread>
+
+namespace
+{
+	// Stands in for a command list, InUse is set by whoever holds it
+	struct FakeList
+	{
+		int ID;
+		std::atomic<bool> InUse;
+
+		FakeList(int id) : ID(id), InUse(false) {}
+	};
+}
+
+TEST(CommandListPool, CreatesOnlyWhenNoneIsFree)
+{
+	int numCreated = 0;
+	env::CommandListPool<FakeList> pool([&]() { return new FakeList(numCreated++); });
+	CHECK(pool.GetNumLists() == 0);
+	CHECK(pool.GetNumFree() == 0);
+
+	FakeList* a = pool.Acquire();
+	FakeList* b = pool.Acquire();
+	CHECK(a != b);
+	CHECK(numCreated == 2);
+	CHECK(pool.GetNumLists() == 2);
+	CHECK(pool.GetNumFree() == 0);
+
+	pool.Release(a);
+	CHECK(pool.GetNumLists() == 2);
+	CHECK(pool.GetNumFree() == 1);
+
+	// The released list comes back instead of a new one
+	FakeList* c = pool.Acquire();
+	CHECK(c == a);
+	CHECK(numCreated == 2);
+	CHECK(pool.GetNumFree() == 0);
+
+	pool.Release(b);
+	pool.Release(c);
+	CHECK(pool.GetNumFree() == 2);
+}
+
+TEST(CommandListPool, ClearDeletesEverything)
+{
+	int numCreated = 0;
+	env::CommandListPool<FakeList> pool([&]() { return new FakeList(numCreated++); });
+
+	FakeList* released = pool.Acquire();
+	pool.Acquire();
+	pool.Release(released);
+	pool.Clear();
+	CHECK(pool.GetNumLists() == 0);
+	CHECK(pool.GetNumFree() == 0);
+
+	// Nothing to reuse, so a new list is created
+	FakeList* list = pool.Acquire();
+	CHECK(list->ID == 2);
+	CHECK(pool.GetNumLists() == 1);
+}
+
+// Jobs record into lists of their own, as the renderer's recording jobs do.
+// A list held by one job is never handed to another.
+TEST(CommandListPool, ConcurrentAcquire)
+{
+	const size_t NUM_TASKS = 100000;
+
+	std::atomic<int> numCreated(0);
+	env::CommandListPool<FakeList> pool([&]() { return new FakeList(numCreated++); });
+
+	std::atomic<size_t> numShared(0);
+	std::atomic<size_t> numRecorded(0);
+	double start = env::test::Now();
+	env::JobSystem::Get()->ParallelFor(NUM_TASKS, [&](size_t) {
+		FakeList* list = pool.Acquire();
+		if (list->InUse.exchange(true))
+			numShared++;
+
+		// Gives other jobs the chance to acquire while this one holds the list
+		numRecorded++;
+		std::this_thread::yield();
+
+		list->InUse = false;
+		pool.Release(list);
+	});
+	double time = env::test::Now() - start;
+
+	CHECK(numShared == 0);
+	CHECK(numRecorded == NUM_TASKS);
+
+	// At most one list per thread, the caller included, all back in the pool
+	CHECK(numCreated > 0);
+	CHECK((size_t)numCreated <= env::JobSystem::Get()->GetNumThreads());
+	CHECK(pool.GetNumLists() == (size_t)numCreated);
+	CHECK(pool.GetNumFree() == pool.GetNumLists());
+
+	std::printf("  %zu acquires on %u threads: %.2f ms, %d lists created\n",
+		NUM_TASKS,
+		env::JobSystem::Get()->GetNumThreads(),
+		time * 1000.0,
+		numCreated.load());
+}
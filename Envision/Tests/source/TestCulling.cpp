@@ -0,0 +1,98 @@
+#include "Test.h"
+#include "envision/core/Culling.h"
+#include <limits>
+#include <random>
+
+namespace
+{
+	// With the identity as view projection the frustum is the box
+	// [-1, 1] x [-1, 1] x [0, 1]
+	env::Frustum GetUnitFrustum()
+	{
+		const float identity[16] = {
+			1.f, 0.f, 0.f, 0.f,
+			0.f, 1.f, 0.f, 0.f,
+			0.f, 0.f, 1.f, 0.f,
+			0.f, 0.f, 0.f, 1.f };
+		return env::Frustum::FromViewProjection(identity);
+	}
+}
+
+TEST(Culling, SpheresAgainstUnitFrustum)
+{
+	env::Frustum frustum = GetUnitFrustum();
+
+	CHECK(env::IsSphereVisible(frustum, 0.f, 0.f, 0.5f, 0.1f));
+	CHECK(env::IsSphereVisible(frustum, 1.5f, 0.f, 0.5f, 0.6f)); // Overlaps the right plane
+	CHECK(env::IsSphereVisible(frustum, 1.5f, 0.f, 0.5f, 0.5f)); // Touches it
+	CHECK(!env::IsSphereVisible(frustum, 1.5f, 0.f, 0.5f, 0.4f));
+	CHECK(!env::IsSphereVisible(frustum, 0.f, -3.f, 0.5f, 1.f));
+	CHECK(!env::IsSphereVisible(frustum, 0.f, 0.f, -0.5f, 0.25f)); // Behind the near plane
+	CHECK(!env::IsSphereVisible(frustum, 0.f, 0.f, 2.f, 0.5f)); // Past the far plane
+}
+
+TEST(Culling, NaNSpheresAreCulled)
+{
+	const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+	env::Frustum frustum = GetUnitFrustum();
+
+	CHECK(!env::IsSphereVisible(frustum, NOT_A_NUMBER, 0.f, 0.5f, 0.1f));
+	CHECK(!env::IsSphereVisible(frustum, 0.f, NOT_A_NUMBER, 0.5f, 0.1f));
+	CHECK(!env::IsSphereVisible(frustum, 0.f, 0.f, NOT_A_NUMBER, 0.1f));
+	CHECK(!env::IsSphereVisible(frustum, 0.f, 0.f, 0.5f, NOT_A_NUMBER));
+
+	// The first four are tested together, the last three one at a time. The
+	// result can't depend on where in the batch a sphere ends up.
+	const size_t COUNT = 7;
+	std::vector<float> x(COUNT, 0.f), y(COUNT, 0.f), z(COUNT, 0.5f), r(COUNT, 0.1f);
+	x[0] = y[1] = z[2] = r[3] = NOT_A_NUMBER;
+	x[4] = r[5] = NOT_A_NUMBER;
+
+	std::vector<uint8_t> visible(COUNT);
+	size_t numVisible = env::CullSpheres(frustum, x.data(), y.data(), z.data(), r.data(), COUNT, visible.data());
+	CHECK(numVisible == 1);
+	bool onlyLastVisible = true;
+	for (size_t i = 0; i < COUNT; i++)
+		onlyLastVisible = onlyLastVisible && visible[i] == (i == COUNT - 1 ? 1 : 0);
+	CHECK(onlyLastVisible);
+}
+
+TEST(Culling, BatchMatchesSingleTests)
+{
+	// Not a multiple of four, so the tail is covered as well
+	const size_t COUNT = 1000003;
+	env::Frustum frustum = GetUnitFrustum();
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> position(-3.f, 3.f);
+	std::uniform_real_distribution<float> radius(0.f, 1.f);
+	std::vector<float> x(COUNT), y(COUNT), z(COUNT), r(COUNT);
+	for (size_t i = 0; i < COUNT; i++) {
+		x[i] = position(random);
+		y[i] = position(random);
+		z[i] = position(random);
+		r[i] = radius(random);
+	}
+
+	std::vector<uint8_t> visible(COUNT);
+	double batchStart = env::test::Now();
+	size_t numVisible = env::CullSpheres(frustum, x.data(), y.data(), z.data(), r.data(), COUNT, visible.data());
+	double batchTime = env::test::Now() - batchStart;
+
+	size_t numExpected = 0;
+	bool allMatch = true;
+	double singleStart = env::test::Now();
+	for (size_t i = 0; i < COUNT; i++) {
+		bool isVisible = env::IsSphereVisible(frustum, x[i], y[i], z[i], r[i]);
+		numExpected += isVisible ? 1 : 0;
+		allMatch = allMatch && visible[i] == (isVisible ? 1 : 0);
+	}
+	double singleTime = env::test::Now() - singleStart;
+
+	CHECK(allMatch);
+	CHECK(numVisible == numExpected);
+	CHECK(numVisible > 0 && numVisible < COUNT);
+
+	std::printf("  %zu spheres, %zu visible: batch %.2f ms, one at a time %.2f ms\n",
+		COUNT, numVisible, batchTime * 1000.0, singleTime * 1000.0);
+}
@@ -0,0 +1,102 @@
+#include "Test.h"
+#include "envision/core/FencedPool.h"
+#include "envision/core/MockQueue.h"
+#include <memory>
+
+namespace
+{
+	// Timeline whose completed value is set by the test
+	class ManualTimeline : public env::FenceTimeline
+	{
+	public:
+
+		uint64_t Value = 0;
+		uint64_t Completed = 0;
+
+		uint64_t IncrementFence() override { return ++Value; }
+		uint64_t GetCompletedFenceValue() const override { return Completed; }
+	};
+}
+
+TEST(FencedPool, WaitsForTheFence)
+{
+	ManualTimeline timeline;
+	env::FencedPool<int> pool;
+
+	pool.Retire(1, timeline, timeline.IncrementFence());
+	pool.Retire(2, timeline, timeline.IncrementFence());
+	CHECK(pool.GetNumRetired() == 2);
+
+	int item = 0;
+	CHECK(!pool.Acquire(item));
+
+	timeline.Completed = 1;
+	CHECK(pool.Acquire(item) && item == 1);
+	CHECK(!pool.Acquire(item));
+
+	timeline.Completed = 2;
+	CHECK(pool.Acquire(item) && item == 2);
+	CHECK(pool.GetNumRetired() == 0);
+}
+
+TEST(FencedPool, TimelinesAreIndependent)
+{
+	ManualTimeline direct;
+	ManualTimeline copy;
+	env::FencedPool<int> pool;
+
+	// The older item waits on a queue that is behind, the newer one is free
+	pool.Retire(1, direct, direct.IncrementFence());
+	pool.Retire(2, copy, copy.IncrementFence());
+
+	int item = 0;
+	copy.Completed = 1;
+	CHECK(pool.Acquire(item) && item == 2);
+	CHECK(!pool.Acquire(item));
+
+	direct.Completed = 1;
+	CHECK(pool.Acquire(item) && item == 1);
+}
+
+TEST(FencedPool, ClearIgnoresFences)
+{
+	ManualTimeline timeline;
+	env::FencedPool<std::unique_ptr<int>> pool;
+
+	for (int i = 0; i < 4; i++)
+		pool.Retire(std::make_unique<int>(i), timeline, timeline.IncrementFence());
+
+	int sum = 0;
+	pool.Clear([&](std::unique_ptr<int>& item) { sum += *item; });
+	CHECK(sum == 0 + 1 + 2 + 3);
+	CHECK(pool.GetNumRetired() == 0);
+}
+
+TEST(FencedPool, RecyclesOnMockQueue)
+{
+	const int NUM_FRAMES = 100;
+
+	env::MockQueue queue;
+	env::FencedPool<int> pool;
+
+	// A new item is only created when none has completed, so the number of
+	// items stays at about the number of frames the queue is behind
+	int numCreated = 0;
+	for (int frame = 0; frame < NUM_FRAMES; frame++) {
+		int item = 0;
+		if (!pool.Acquire(item))
+			item = numCreated++;
+
+		queue.Execute(0.0002f);
+		uint64_t fenceValue = queue.IncrementFence();
+		pool.Retire(item, queue, fenceValue);
+
+		if (frame % 4 == 3)
+			queue.WaitForFenceCPU(fenceValue);
+	}
+	queue.WaitForIdle();
+
+	CHECK(numCreated <= 4);
+	CHECK((int)pool.GetNumRetired() == numCreated);
+	std::printf("  %d frames used %d items\n", NUM_FRAMES, numCreated);
+}
@@ -0,0 +1,124 @@
+#include "Test.h"
+#include "envision/core/FramePipeline.h"
+#include "envision/core/MockQueue.h"
+#include <thread>
+
+namespace
+{
+	using Clock = env::MockQueue::Clock;
+
+	void Spin(float seconds)
+	{
+		Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(seconds));
+		while (Clock::now() < end)
+			std::this_thread::yield();
+	}
+
+	struct FramePipelineMeasurement
+	{
+		float FramesPerSecond = 0.0f;
+		float Latency = 0.0f; // Seconds from beginning a frame until the queue completed it
+	};
+
+	// Runs frames through a frame pipeline on a mock queue. Each frame keeps the
+	// CPU busy for cpuTime and the queue for gpuTime.
+	FramePipelineMeasurement MeasureFramePipeline(unsigned int depth, float cpuTime, float gpuTime, int numFrames)
+	{
+		env::MockQueue queue;
+		env::FramePipeline<env::MockQueue> pipeline(queue, depth);
+
+		std::vector<Clock::time_point> frameBegins(numFrames);
+		std::vector<uint64_t> frameFenceValues(numFrames);
+
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < numFrames; i++) {
+			pipeline.BeginFrame();
+			frameBegins[i] = Clock::now();
+			Spin(cpuTime);
+
+			queue.Execute(gpuTime);
+			frameFenceValues[i] = pipeline.EndFrame();
+		}
+		pipeline.Flush();
+
+		FramePipelineMeasurement measurement;
+		measurement.FramesPerSecond = numFrames / std::chrono::duration<float>(Clock::now() - start).count();
+		for (int i = 0; i < numFrames; i++)
+			measurement.Latency += std::chrono::duration<float>(queue.GetCompletionTime(frameFenceValues[i]) - frameBegins[i]).count();
+		measurement.Latency /= numFrames;
+
+		return measurement;
+	}
+}
+
+TEST(FramePipeline, CyclesThroughSlots)
+{
+	env::MockQueue queue;
+	env::FramePipeline<env::MockQueue> pipeline(queue, 3);
+
+	for (unsigned int i = 0; i < 7; i++) {
+		CHECK(pipeline.BeginFrame() == i % 3);
+		CHECK(pipeline.GetFrameIndex() == i % 3);
+		CHECK(pipeline.EndFrame() == i + 1);
+	}
+	pipeline.Flush();
+	CHECK(pipeline.GetNumFramesInFlight() == 0);
+}
+
+TEST(FramePipeline, SlotWaitsForItsLastFrame)
+{
+	const unsigned int DEPTH = 2;
+
+	env::MockQueue queue;
+	env::FramePipeline<env::MockQueue> pipeline(queue, DEPTH);
+
+	std::vector<uint64_t> fenceValues;
+	for (unsigned int i = 0; i < 10; i++) {
+		pipeline.BeginFrame();
+
+		// The frame that used this slot before has to be done by now
+		if (i >= DEPTH)
+			CHECK(queue.IsFenceReached(fenceValues[i - DEPTH]));
+
+		queue.Execute(0.001f);
+		fenceValues.push_back(pipeline.EndFrame());
+		CHECK(pipeline.GetNumFramesInFlight() <= DEPTH);
+	}
+	pipeline.Flush();
+	CHECK(queue.IsFenceReached(fenceValues.back()));
+}
+
+TEST(FramePipeline, SetDepthFlushes)
+{
+	env::MockQueue queue;
+	env::FramePipeline<env::MockQueue> pipeline(queue, 3);
+
+	for (int i = 0; i < 3; i++) {
+		pipeline.BeginFrame();
+		queue.Execute(0.002f);
+		pipeline.EndFrame();
+	}
+
+	pipeline.SetDepth(1);
+	CHECK(pipeline.GetDepth() == 1);
+	CHECK(pipeline.GetNumFramesInFlight() == 0);
+	CHECK(pipeline.BeginFrame() == 0);
+	pipeline.EndFrame();
+	pipeline.Flush();
+}
+
+TEST(FramePipeline, MockFrameBenchmark)
+{
+	const float CPU_TIME = 0.004f;
+	const float GPU_TIME = 0.004f;
+
+	// How much depth helps depends on the number of cores, so only the lower
+	// bound of the latency is checked: a frame is done after both its parts
+	for (unsigned int depth = 1; depth <= env::FramePipeline<env::MockQueue>::MAX_DEPTH; depth++) {
+		FramePipelineMeasurement measurement = MeasureFramePipeline(depth, CPU_TIME, GPU_TIME, 50);
+		CHECK(measurement.Latency >= (CPU_TIME + GPU_TIME) * 0.99f);
+		CHECK(measurement.FramesPerSecond > 0.f);
+
+		std::printf("  Depth %u: %.0f FPS, latency %.1f ms\n", depth, measurement.FramesPerSecond, measurement.Latency * 1000.f);
+	}
+}
@@ -0,0 +1,211 @@
+#include "Test.h"
+#include "envision/core/GPUMemoryPools.h"
+
+// The page bookkeeping of GPUMemoryAllocator, which creates the heaps and
+// resources on the device through GPUMemoryBlockFactory
+
+namespace
+{
+	// Records the blocks instead of creating heaps. Like the allocator, the
+	// buffer of a small buffer block is allocated from DefaultBuffers.
+	class FakeDevice : public env::GPUMemoryBlockFactory
+	{
+	public:
+
+		struct Block
+		{
+			env::GPUMemoryPool Pool;
+			uint64_t NumBytes;
+			env::GPUAllocation BufferAllocation;
+		};
+
+		env::GPUMemoryPools* Pools = nullptr;
+		std::vector<Block> Blocks;
+
+		void CreateBlock(env::GPUMemoryPool pool, uint64_t numBytes) override
+		{
+			Block block = { pool, numBytes, env::GPUAllocation() };
+			if (pool == env::GPUMemoryPool::SmallBuffers)
+				block.BufferAllocation = Pools->Allocate(env::GPUMemoryPool::DefaultBuffers, numBytes, env::GPUMemoryPools::PAGE_SIZE);
+			Blocks.push_back(block);
+		}
+	};
+
+	const uint64_t PAGE_SIZE = env::GPUMemoryPools::PAGE_SIZE;
+	const uint64_t BLOCK_SIZE = env::GPUMemoryPools::BLOCK_SIZE;
+}
+
+TEST(GPUMemoryAllocator, RoundsToWholePages)
+{
+	FakeDevice device;
+	env::GPUMemoryPools pools(device);
+	device.Pools = &pools;
+
+	env::GPUAllocation a = pools.Allocate(env::GPUMemoryPool::DefaultBuffers, 1, PAGE_SIZE);
+	CHECK(a.Pool == env::GPUMemoryPool::DefaultBuffers);
+	CHECK(a.NumBytes == PAGE_SIZE);
+	CHECK(a.Range.Offset == 0 && a.Range.Size == 1);
+	CHECK(a.Offset == 0);
+
+	env::GPUAllocation b = pools.Allocate(env::GPUMemoryPool::DefaultBuffers, PAGE_SIZE + 1, PAGE_SIZE);
+	CHECK(b.NumBytes == 2 * PAGE_SIZE);
+	CHECK(b.Range.Offset == 1 && b.Range.Size == 2);
+
+	env::GPUAllocation c = pools.Allocate(env::GPUMemoryPool::DefaultBuffers, PAGE_SIZE, PAGE_SIZE);
+	CHECK(c.NumBytes == PAGE_SIZE && c.Range.Offset == 3);
+
+	// Small textures are 4 KB aligned, which fits in a page
+	env::GPUAllocation d = pools.Allocate(env::GPUMemoryPool::DefaultTextures, 4096, 4096);
+	CHECK(d.Pool == env::GPUMemoryPool::DefaultTextures);
+	CHECK(d.NumBytes == PAGE_SIZE);
+
+	CHECK(device.Blocks.size() == 2);
+	CHECK(device.Blocks[0].Pool == env::GPUMemoryPool::DefaultBuffers && device.Blocks[0].NumBytes == BLOCK_SIZE);
+	CHECK(device.Blocks[1].Pool == env::GPUMemoryPool::DefaultTextures);
+
+	env::GPUMemoryStatistics statistics = pools.GetStatistics();
+	const env::GPUMemoryPoolStatistics& buffers = statistics.Pools[(uint32_t)env::GPUMemoryPool::DefaultBuffers];
+	CHECK(buffers.NumBlocks == 1 && buffers.BlockBytes == BLOCK_SIZE);
+	CHECK(buffers.NumAllocations == 3 && buffers.AllocatedBytes == 4 * PAGE_SIZE);
+	CHECK(statistics.GetReservedBytes() == 2 * BLOCK_SIZE);
+}
+
+TEST(GPUMemoryAllocator, CommitsLargeAllocations)
+{
+	FakeDevice device;
+	env::GPUMemoryPools pools(device);
+	device.Pools = &pools;
+
+	// Just below half a block is still placed
+	env::GPUAllocation placed = pools.Allocate(env::GPUMemoryPool::DefaultTargets, BLOCK_SIZE / 2 - 1, PAGE_SIZE);
+	CHECK(placed.Pool == env::GPUMemoryPool::DefaultTargets);
+
+	env::GPUAllocation large = pools.Allocate(env::GPUMemoryPool::DefaultTargets, BLOCK_SIZE / 2, PAGE_SIZE);
+	CHECK(large.Pool == env::GPUMemoryPool::Committed);
+	CHECK(large.NumBytes == BLOCK_SIZE / 2);
+
+	// Multisampled textures are 4 MB aligned
+	env::GPUAllocation multisampled = pools.Allocate(env::GPUMemoryPool::DefaultTargets, PAGE_SIZE, 4 * 1024 * 1024);
+	CHECK(multisampled.Pool == env::GPUMemoryPool::Committed);
+	CHECK(multisampled.NumBytes == PAGE_SIZE);
+
+	// Committed memory takes no pages and adds no blocks
+	CHECK(device.Blocks.size() == 1);
+	env::GPUMemoryStatistics statistics = pools.GetStatistics();
+	CHECK(statistics.Pools[(uint32_t)env::GPUMemoryPool::DefaultTargets].NumAllocations == 1);
+	CHECK(statistics.NumCommitted == 2);
+	CHECK(statistics.CommittedBytes == BLOCK_SIZE / 2 + PAGE_SIZE);
+	CHECK(statistics.GetReservedBytes() == BLOCK_SIZE + BLOCK_SIZE / 2 + PAGE_SIZE);
+
+	pools.Free(large);
+	pools.Free(multisampled);
+	statistics = pools.GetStatistics();
+	CHECK(statistics.NumCommitted == 0);
+	CHECK(statistics.CommittedBytes == 0);
+}
+
+TEST(GPUMemoryAllocator, PacksSmallBuffers)
+{
+	FakeDevice device;
+	env::GPUMemoryPools pools(device);
+	device.Pools = &pools;
+
+	env::GPUAllocation a = pools.AllocateSmallBuffer(256);
+	env::GPUAllocation b = pools.AllocateSmallBuffer(300);
+	env::GPUAllocation c = pools.AllocateSmallBuffer(env::GPUMemoryPools::SMALL_BUFFER_MAX_SIZE);
+	env::GPUAllocation d = pools.AllocateSmallBuffer(1);
+
+	CHECK(a.Pool == env::GPUMemoryPool::SmallBuffers);
+	CHECK(a.Offset == 0 && a.NumBytes == 256);
+	CHECK(b.Offset == 256 && b.NumBytes == 512);
+	CHECK(c.Offset == 768 && c.NumBytes == 4096);
+	CHECK(d.Offset == 768 + 4096 && d.NumBytes == 256);
+	CHECK(a.BlockIndex == 0 && b.BlockIndex == 0 && c.BlockIndex == 0 && d.BlockIndex == 0);
+
+	// One shared buffer, a page of DefaultBuffers
+	CHECK(device.Blocks.size() == 2);
+	CHECK(device.Blocks[0].Pool == env::GPUMemoryPool::DefaultBuffers);
+	CHECK(device.Blocks[1].Pool == env::GPUMemoryPool::SmallBuffers && device.Blocks[1].NumBytes == PAGE_SIZE);
+	CHECK(device.Blocks[1].BufferAllocation.Pool == env::GPUMemoryPool::DefaultBuffers);
+	CHECK(device.Blocks[1].BufferAllocation.NumBytes == PAGE_SIZE);
+
+	// Freed slots are reused before the end of the buffer
+	pools.Free(b);
+	env::GPUAllocation e = pools.AllocateSmallBuffer(512);
+	CHECK(e.BlockIndex == 0 && e.Offset == 256);
+
+	// Only the buffers themselves count as reserved memory
+	env::GPUMemoryStatistics statistics = pools.GetStatistics();
+	CHECK(statistics.Pools[(uint32_t)env::GPUMemoryPool::SmallBuffers].AllocatedBytes == 256 + 4096 + 256 + 512);
+	CHECK(statistics.GetReservedBytes() == BLOCK_SIZE);
+}
+
+TEST(GPUMemoryAllocator, AddsSmallBufferBlocksWhenFull)
+{
+	FakeDevice device;
+	env::GPUMemoryPools pools(device);
+	device.Pools = &pools;
+
+	const uint64_t SLOTS_PER_BLOCK = PAGE_SIZE / env::GPUMemoryPools::SMALL_BUFFER_ALIGNMENT;
+	bool allInFirst = true;
+	for (uint64_t i = 0; i < SLOTS_PER_BLOCK; i++) {
+		env::GPUAllocation allocation = pools.AllocateSmallBuffer(256);
+		allInFirst = allInFirst && allocation.BlockIndex == 0 && allocation.Offset == i * 256;
+	}
+	CHECK(allInFirst);
+	CHECK(pools.GetNumBlocks(env::GPUMemoryPool::SmallBuffers) == 1);
+
+	env::GPUAllocation next = pools.AllocateSmallBuffer(256);
+	CHECK(next.BlockIndex == 1 && next.Offset == 0);
+	CHECK(pools.GetNumBlocks(env::GPUMemoryPool::SmallBuffers) == 2);
+
+	// Both shared buffers share the one block of DefaultBuffers
+	CHECK(pools.GetNumBlocks(env::GPUMemoryPool::DefaultBuffers) == 1);
+	CHECK(device.Blocks.back().BufferAllocation.Range.Offset == 1);
+}
+
+TEST(GPUMemoryAllocator, GrowsAndReusesBlocks)
+{
+	FakeDevice device;
+	env::GPUMemoryPools pools(device);
+	device.Pools = &pools;
+
+	// Four quarters fill a block, the fifth needs another
+	const uint64_t QUARTER = BLOCK_SIZE / 4;
+	std::vector<env::GPUAllocation> allocations;
+	for (int i = 0; i < 5; i++)
+		allocations.push_back(pools.Allocate(env::GPUMemoryPool::UploadBuffers, QUARTER, PAGE_SIZE));
+
+	bool firstFour = true;
+	for (int i = 0; i < 4; i++)
+		firstFour = firstFour && allocations[i].BlockIndex == 0 && allocations[i].Range.Offset == i * QUARTER / PAGE_SIZE;
+	CHECK(firstFour);
+	CHECK(allocations[4].BlockIndex == 1 && allocations[4].Range.Offset == 0);
+	CHECK(device.Blocks.size() == 2);
+	CHECK(device.Blocks[1].Pool == env::GPUMemoryPool::UploadBuffers);
+
+	// Freed pages in the first block are taken before the second one
+	pools.Free(allocations[2]);
+	env::GPUAllocation reused = pools.Allocate(env::GPUMemoryPool::UploadBuffers, QUARTER, PAGE_SIZE);
+	CHECK(reused.BlockIndex == 0 && reused.Range.Offset == allocations[2].Range.Offset);
+
+	// A freed block is kept and filled again, no block is added
+	for (int i = 0; i < 5; i++) {
+		if (i != 2)
+			pools.Free(allocations[i]);
+	}
+	pools.Free(reused);
+	for (int i = 0; i < 8; i++)
+		pools.Allocate(env::GPUMemoryPool::UploadBuffers, QUARTER, PAGE_SIZE);
+	CHECK(device.Blocks.size() == 2);
+
+	env::GPUMemoryStatistics statistics = pools.GetStatistics();
+	const env::GPUMemoryPoolStatistics& upload = statistics.Pools[(uint32_t)env::GPUMemoryPool::UploadBuffers];
+	CHECK(upload.NumBlocks == 2 && upload.NumAllocations == 8);
+	CHECK(upload.AllocatedBytes == upload.BlockBytes);
+
+	// Other pools have blocks of their own
+	env::GPUAllocation texture = pools.Allocate(env::GPUMemoryPool::DefaultTextures, PAGE_SIZE, PAGE_SIZE);
+	CHECK(texture.BlockIndex == 0 && texture.Range.Offset == 0);
+	CHECK(device.Blocks.size() == 3);
+}
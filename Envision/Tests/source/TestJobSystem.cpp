@@ -0,0 +1,93 @@
+#include "Test.h"
+#include "envision/core/JobSystem.h"
+#include <atomic>
+
+TEST(JobSystem, ScheduleRunsEveryJob)
+{
+	// Overhead of scheduling many small jobs
+	const size_t NUM_JOBS = 100000;
+	std::atomic<size_t> numRun(0);
+
+	double start = env::test::Now();
+	std::vector<env::JobSystem::JobHandle> jobs;
+	jobs.reserve(NUM_JOBS);
+	for (size_t i = 0; i < NUM_JOBS; i++)
+		jobs.push_back(env::JobSystem::Get()->Schedule([&]() { numRun++; }));
+	env::JobSystem::Get()->Wait(jobs);
+	double time = env::test::Now() - start;
+
+	CHECK(numRun == NUM_JOBS);
+	for (const env::JobSystem::JobHandle& job : jobs)
+		CHECK(job->Done);
+
+	std::printf("  %zu jobs on %u threads: %.2f ms, %llu stolen\n",
+		NUM_JOBS,
+		env::JobSystem::Get()->GetNumThreads(),
+		time * 1000.0,
+		(unsigned long long)env::JobSystem::Get()->GetNumStolen());
+}
+
+TEST(JobSystem, ParallelForCallsEveryIndexOnce)
+{
+	const size_t NUM_TASKS = 100000;
+	std::vector<std::atomic<int>> calls(NUM_TASKS);
+	for (std::atomic<int>& count : calls)
+		count = 0;
+
+	double start = env::test::Now();
+	env::JobSystem::Get()->ParallelFor(NUM_TASKS, [&](size_t i) { calls[i]++; });
+	double time = env::test::Now() - start;
+
+	bool allOnce = true;
+	for (const std::atomic<int>& count : calls)
+		allOnce = allOnce && count == 1;
+	CHECK(allOnce);
+
+	std::printf("  ParallelFor over %zu tasks: %.2f ms\n", NUM_TASKS, time * 1000.0);
+}
+
+TEST(JobSystem, ParallelForWithOneThread)
+{
+	std::vector<size_t> order;
+	env::JobSystem::Get()->ParallelFor(100, [&](size_t i) { order.push_back(i); }, 1);
+
+	CHECK(order.size() == 100);
+	for (size_t i = 0; i < order.size(); i++)
+		CHECK(order[i] == i);
+}
+
+TEST(JobSystem, DependenciesRunFirst)
+{
+	std::atomic<int> numDone(0);
+	std::atomic<bool> ranAfterDependencies(false);
+
+	std::vector<env::JobSystem::JobHandle> dependencies;
+	for (int i = 0; i < 16; i++)
+		dependencies.push_back(env::JobSystem::Get()->Schedule([&]() { numDone++; }));
+
+	env::JobSystem::JobHandle job = env::JobSystem::Get()->Schedule([&]() {
+		ranAfterDependencies = (numDone == 16);
+	}, dependencies);
+	env::JobSystem::Get()->Wait(job);
+
+	CHECK(ranAfterDependencies);
+}
+
+TEST(JobSystem, WaitInsideJob)
+{
+	// The waiting job runs other jobs meanwhile, so this finishes even with
+	// more nested waits than threads
+	std::atomic<int> numLeaves(0);
+	std::vector<env::JobSystem::JobHandle> jobs;
+	for (int i = 0; i < 64; i++) {
+		jobs.push_back(env::JobSystem::Get()->Schedule([&]() {
+			std::vector<env::JobSystem::JobHandle> children;
+			for (int j = 0; j < 8; j++)
+				children.push_back(env::JobSystem::Get()->Schedule([&]() { numLeaves++; }));
+			env::JobSystem::Get()->Wait(children);
+		}));
+	}
+	env::JobSystem::Get()->Wait(jobs);
+
+	CHECK(numLeaves == 64 * 8);
+}
@@ -0,0 +1,191 @@
+#include "Test.h"
+#include "envision/core/MeshSimplifier.h"
+#include <cmath>
+
+namespace
+{
+	struct Vertex
+	{
+		float Position[3];
+		float Normal[3];
+		float Texcoord[2];
+	};
+
+	// Grid of size x size quads over [0, 1] x [0, 1] at z = 0, facing +z
+	void CreateGrid(int size, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		for (int y = 0; y <= size; y++) {
+			for (int x = 0; x <= size; x++) {
+				float u = (float)x / size;
+				float v = (float)y / size;
+				vertices.push_back({ { u, v, 0.f }, { 0.f, 0.f, 1.f }, { u, v } });
+			}
+		}
+
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				uint32_t corner = (uint32_t)(y * (size + 1) + x);
+				uint32_t quad[4] = { corner, corner + 1, corner + size + 2, corner + size + 1 };
+				indices.insert(indices.end(), { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] });
+			}
+		}
+	}
+
+	// Sphere of radius 1 from latitude and longitude rings, without seams
+	// so it is closed
+	void CreateSphere(int numRings, int numSegments, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		const float PI = 3.14159265f;
+
+		vertices.push_back({ { 0.f, 1.f, 0.f }, { 0.f, 1.f, 0.f }, { 0.f, 0.f } });
+		for (int ring = 1; ring < numRings; ring++) {
+			float theta = PI * ring / numRings;
+			for (int segment = 0; segment < numSegments; segment++) {
+				float phi = 2.f * PI * segment / numSegments;
+				float x = std::sin(theta) * std::cos(phi);
+				float y = std::cos(theta);
+				float z = std::sin(theta) * std::sin(phi);
+				vertices.push_back({ { x, y, z }, { x, y, z }, { 0.f, 0.f } });
+			}
+		}
+		vertices.push_back({ { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f } });
+
+		auto ringVertex = [numSegments](int ring, int segment) {
+			return (uint32_t)(1 + (ring - 1) * numSegments + segment % numSegments);
+		};
+
+		uint32_t bottom = (uint32_t)vertices.size() - 1;
+		for (int segment = 0; segment < numSegments; segment++) {
+			indices.insert(indices.end(), { 0, ringVertex(1, segment + 1), ringVertex(1, segment) });
+			indices.insert(indices.end(), { bottom, ringVertex(numRings - 1, segment), ringVertex(numRings - 1, segment + 1) });
+		}
+		for (int ring = 1; ring < numRings - 1; ring++) {
+			for (int segment = 0; segment < numSegments; segment++) {
+				uint32_t a = ringVertex(ring, segment);
+				uint32_t b = ringVertex(ring, segment + 1);
+				uint32_t c = ringVertex(ring + 1, segment + 1);
+				uint32_t d = ringVertex(ring + 1, segment);
+				indices.insert(indices.end(), { a, b, c, a, c, d });
+			}
+		}
+	}
+
+	void Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+		const std::vector<size_t>& targets, std::vector<env::SimplifiedMesh>& results)
+	{
+		env::SimplifyMesh(&vertices[0].Position[0], sizeof(Vertex), vertices.size(),
+			indices.data(), indices.size(),
+			targets.data(), targets.size(),
+			results);
+	}
+
+	// Whole triangles over existing vertices, none of them collapsed to a line
+	bool IsValidIndexList(const std::vector<uint32_t>& indices, size_t numVertices)
+	{
+		if (indices.empty() || indices.size() % 3 != 0)
+			return false;
+
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			if (a >= numVertices || b >= numVertices || c >= numVertices)
+				return false;
+			if (a == b || b == c || a == c)
+				return false;
+		}
+		return true;
+	}
+
+	// Twice the area of the triangle projected on z = 0, positive when
+	// facing +z
+	float GetSignedArea(const std::vector<Vertex>& vertices, uint32_t a, uint32_t b, uint32_t c)
+	{
+		const float* p0 = vertices[a].Position;
+		const float* p1 = vertices[b].Position;
+		const float* p2 = vertices[c].Position;
+		return (p1[0] - p0[0]) * (p2[1] - p0[1]) - (p2[0] - p0[0]) * (p1[1] - p0[1]);
+	}
+}
+
+TEST(MeshSimplifier, PlaneKeepsItsShape)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateGrid(32, vertices, indices);
+
+	std::vector<size_t> targets = { indices.size() / 2, indices.size() / 8, indices.size() / 32 };
+	std::vector<env::SimplifiedMesh> results;
+	Simplify(vertices, indices, targets, results);
+	CHECK(results.size() == targets.size());
+
+	size_t previousNumIndices = indices.size();
+	for (size_t i = 0; i < results.size(); i++) {
+		const env::SimplifiedMesh& result = results[i];
+		CHECK(IsValidIndexList(result.Indices, vertices.size()));
+		CHECK(result.Indices.size() <= targets[i]);
+		CHECK(result.Indices.size() < previousNumIndices);
+		previousNumIndices = result.Indices.size();
+
+		// Flat, so collapses cost nothing. The borders are kept in place and
+		// no triangle folds over, so the triangles still cover the square.
+		CHECK(result.Error < 1e-4f);
+
+		float area = 0.f;
+		bool allFacingUp = true;
+		for (size_t j = 0; j < result.Indices.size(); j += 3) {
+			float triangleArea = GetSignedArea(vertices, result.Indices[j], result.Indices[j + 1], result.Indices[j + 2]);
+			allFacingUp = allFacingUp && triangleArea > 0.f;
+			area += triangleArea * 0.5f;
+		}
+		CHECK(allFacingUp);
+		CHECK(std::fabs(area - 1.f) < 1e-4f);
+	}
+}
+
+TEST(MeshSimplifier, SphereErrorGrows)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateSphere(24, 48, vertices, indices);
+
+	std::vector<size_t> targets = { indices.size() / 2, indices.size() / 4, indices.size() / 16 };
+	std::vector<env::SimplifiedMesh> results;
+	Simplify(vertices, indices, targets, results);
+	CHECK(results.size() == targets.size());
+
+	float previousError = 0.f;
+	for (const env::SimplifiedMesh& result : results) {
+		CHECK(IsValidIndexList(result.Indices, vertices.size()));
+		CHECK(result.Error > 0.f);
+		CHECK(result.Error >= previousError);
+		previousError = result.Error;
+	}
+
+	// A sixteenth of the triangles still looks like the sphere
+	CHECK(previousError < 0.2f);
+}
+
+TEST(MeshSimplifier, SimplifyBenchmark)
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	CreateSphere(128, 256, vertices, indices);
+
+	std::vector<size_t> targets = { indices.size() / 2, indices.size() / 4, indices.size() / 8, indices.size() / 16 };
+	std::vector<env::SimplifiedMesh> results;
+
+	double start = env::test::Now();
+	Simplify(vertices, indices, targets, results);
+	double time = env::test::Now() - start;
+
+	CHECK(results.size() == targets.size());
+	bool allValid = true;
+	for (const env::SimplifiedMesh& result : results)
+		allValid = allValid && IsValidIndexList(result.Indices, vertices.size());
+	CHECK(allValid);
+
+	std::printf("  %zu triangles into %zu LODs: %.2f ms, last error %.4f\n",
+		indices.size() / 3,
+		results.size(),
+		time * 1000.0,
+		results.empty() ? 0.f : results.back().Error);
+}
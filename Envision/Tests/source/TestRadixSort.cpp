@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "envision/core/RadixSort.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	// Sorts with RadixSort and returns the result wherever it ended up
+	void Sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+	{
+		std::vector<uint64_t> scratchKeys(keys.size());
+		std::vector<uint32_t> scratchValues(values.size());
+		if (env::RadixSort(keys.data(), values.data(), scratchKeys.data(), scratchValues.data(), keys.size())) {
+			keys.swap(scratchKeys);
+			values.swap(scratchValues);
+		}
+	}
+
+	// Values are the original positions, so stability can be checked
+	bool IsStableSorted(const std::vector<uint64_t>& keys, const std::vector<uint32_t>& values)
+	{
+		for (size_t i = 1; i < keys.size(); i++) {
+			if (keys[i - 1] > keys[i] || (keys[i - 1] == keys[i] && values[i - 1] > values[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(RadixSort, SortsStably)
+{
+	std::mt19937_64 random(1);
+	std::vector<uint64_t> keys(10000);
+	std::vector<uint32_t> values(keys.size());
+	for (size_t i = 0; i < keys.size(); i++) {
+		// Few distinct keys so many are equal
+		keys[i] = random() % 64 << 40 | random() % 4;
+		values[i] = (uint32_t)i;
+	}
+	std::vector<uint64_t> expected = keys;
+	std::sort(expected.begin(), expected.end());
+
+	Sort(keys, values);
+
+	CHECK(keys == expected);
+	CHECK(IsStableSorted(keys, values));
+}
+
+TEST(RadixSort, SkipsSharedDigits)
+{
+	// Only the lowest byte differs, every other pass is skipped, so the
+	// result is in the scratch arrays after a single pass
+	std::vector<uint64_t> keys = { 0xAB00000000000005ull, 0xAB00000000000001ull, 0xAB00000000000003ull };
+	std::vector<uint32_t> values = { 0, 1, 2 };
+	std::vector<uint64_t> scratchKeys(3);
+	std::vector<uint32_t> scratchValues(3);
+
+	CHECK(env::RadixSort(keys.data(), values.data(), scratchKeys.data(), scratchValues.data(), 3));
+	CHECK(scratchKeys[0] == 0xAB00000000000001ull && scratchValues[0] == 1);
+	CHECK(scratchKeys[1] == 0xAB00000000000003ull && scratchValues[1] == 2);
+	CHECK(scratchKeys[2] == 0xAB00000000000005ull && scratchValues[2] == 0);
+}
+
+TEST(RadixSort, HandlesTrivialInputs)
+{
+	std::vector<uint64_t> keys;
+	std::vector<uint32_t> values;
+	Sort(keys, values);
+	CHECK(keys.empty());
+
+	keys = { 7, 7, 7 };
+	values = { 0, 1, 2 };
+	Sort(keys, values);
+	CHECK(IsStableSorted(keys, values));
+}
+
+TEST(RadixSort, AgainstStdSort)
+{
+	// Draw key sized input with full 64-bit keys
+	const size_t COUNT = 1000000;
+	std::mt19937_64 random(2);
+	std::vector<uint64_t> keys(COUNT);
+	std::vector<uint32_t> values(COUNT);
+	for (size_t i = 0; i < COUNT; i++) {
+		keys[i] = random();
+		values[i] = (uint32_t)i;
+	}
+
+	std::vector<std::pair<uint64_t, uint32_t>> pairs(COUNT);
+	for (size_t i = 0; i < COUNT; i++)
+		pairs[i] = { keys[i], values[i] };
+
+	std::vector<uint64_t> scratchKeys(COUNT);
+	std::vector<uint32_t> scratchValues(COUNT);
+	double radixStart = env::test::Now();
+	if (env::RadixSort(keys.data(), values.data(), scratchKeys.data(), scratchValues.data(), COUNT)) {
+		keys.swap(scratchKeys);
+		values.swap(scratchValues);
+	}
+	double radixTime = env::test::Now() - radixStart;
+
+	double stdStart = env::test::Now();
+	std::stable_sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+	double stdTime = env::test::Now() - stdStart;
+
+	bool equal = true;
+	for (size_t i = 0; i < COUNT; i++)
+		equal = equal && keys[i] == pairs[i].first && values[i] == pairs[i].second;
+	CHECK(equal);
+
+	std::printf("  %zu keys: radix %.2f ms, std::stable_sort %.2f ms\n", COUNT, radixTime * 1000.0, stdTime * 1000.0);
+}
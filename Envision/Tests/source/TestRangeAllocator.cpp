@@ -0,0 +1,152 @@
+#include "Test.h"
+#include "envision/core/RangeAllocator.h"
+#include <random>
+
+TEST(RangeAllocator, AllocatesInOrder)
+{
+	env::RangeAllocator allocator(100);
+
+	env::RangeAllocation a = allocator.Allocate(10);
+	env::RangeAllocation b = allocator.Allocate(20);
+	CHECK(a.IsValid() && a.Offset == 0 && a.Size == 10);
+	CHECK(b.IsValid() && b.Offset == 10 && b.Size == 20);
+	CHECK(allocator.GetNumAllocated() == 30);
+	CHECK(allocator.GetNumAllocations() == 2);
+	CHECK(allocator.GetNumFreeRanges() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 70);
+}
+
+TEST(RangeAllocator, FailsWhenNothingFits)
+{
+	env::RangeAllocator allocator(64);
+
+	CHECK(!allocator.Allocate(0).IsValid());
+	CHECK(!allocator.Allocate(65).IsValid());
+	CHECK(allocator.Allocate(64).IsValid());
+	CHECK(!allocator.Allocate(1).IsValid());
+	CHECK(allocator.GetNumFreeRanges() == 0);
+	CHECK(allocator.GetLargestFreeRange() == 0);
+}
+
+TEST(RangeAllocator, MergesFreedNeighbours)
+{
+	env::RangeAllocator allocator(30);
+
+	env::RangeAllocation a = allocator.Allocate(10);
+	env::RangeAllocation b = allocator.Allocate(10);
+	env::RangeAllocation c = allocator.Allocate(10);
+
+	allocator.Free(a);
+	allocator.Free(c);
+	CHECK(allocator.GetNumFreeRanges() == 2);
+	CHECK(!allocator.Allocate(20).IsValid());
+
+	// Freeing the middle joins all three
+	allocator.Free(b);
+	CHECK(allocator.GetNumFreeRanges() == 1);
+	CHECK(allocator.GetLargestFreeRange() == 30);
+
+	env::RangeAllocation all = allocator.Allocate(30);
+	CHECK(all.IsValid() && all.Offset == 0);
+}
+
+TEST(RangeAllocator, ClearFreesEverything)
+{
+	env::RangeAllocator allocator(1000);
+	for (int i = 0; i < 50; i++)
+		allocator.Allocate(7);
+
+	allocator.Clear();
+	CHECK(allocator.GetNumAllocated() == 0);
+	CHECK(allocator.GetNumAllocations() == 0);
+	CHECK(allocator.GetLargestFreeRange() == 1000);
+}
+
+// Fills a fake heap with table sized ranges, then frees a random half of
+// them so the next round has to fit ranges between the survivors. Ranges are
+// checked against an occupancy map of the heap.
+TEST(RangeAllocator, StressBenchmark)
+{
+	const uint32_t HEAP_SIZE = 65536;
+	const int BATCH_SIZE = 4096;
+	const int NUM_OPERATIONS = 1000000;
+
+	env::RangeAllocator allocator(HEAP_SIZE);
+	std::vector<env::RangeAllocation> allocations;
+	allocations.reserve(HEAP_SIZE);
+	std::vector<bool> used(HEAP_SIZE, false);
+	std::mt19937 random(1);
+
+	double allocateTime = 0.0;
+	double freeTime = 0.0;
+	int numAllocations = 0;
+	int numFrees = 0;
+	int numFailed = 0;
+	bool noOverlaps = true;
+	while (numAllocations + numFrees < NUM_OPERATIONS) {
+		size_t firstNew = allocations.size();
+
+		double allocateStart = env::test::Now();
+		for (int i = 0; i < BATCH_SIZE; i++) {
+			// Mostly small tables, some large ones
+			uint32_t size = (random() % 16 == 0) ? 1 + random() % 256 : 1 + random() % 8;
+			env::RangeAllocation allocation = allocator.Allocate(size);
+			if (allocation.IsValid())
+				allocations.push_back(allocation);
+			else
+				numFailed++;
+		}
+		allocateTime += env::test::Now() - allocateStart;
+		numAllocations += BATCH_SIZE;
+
+		for (size_t i = firstNew; i < allocations.size(); i++) {
+			const env::RangeAllocation& allocation = allocations[i];
+			noOverlaps = noOverlaps && allocation.Offset + allocation.Size <= HEAP_SIZE;
+			for (uint32_t j = allocation.Offset; j < allocation.Offset + allocation.Size && j < HEAP_SIZE; j++) {
+				noOverlaps = noOverlaps && !used[j];
+				used[j] = true;
+			}
+		}
+
+		std::vector<env::RangeAllocation> freed;
+		double freeStart = env::test::Now();
+		size_t numToFree = allocations.size() / 2;
+		for (size_t i = 0; i < numToFree; i++) {
+			size_t index = random() % allocations.size();
+			allocator.Free(allocations[index]);
+			freed.push_back(allocations[index]);
+			allocations[index] = allocations.back();
+			allocations.pop_back();
+		}
+		freeTime += env::test::Now() - freeStart;
+		numFrees += (int)numToFree;
+
+		for (const env::RangeAllocation& allocation : freed) {
+			for (uint32_t j = allocation.Offset; j < allocation.Offset + allocation.Size; j++)
+				used[j] = false;
+		}
+	}
+	CHECK(noOverlaps);
+
+	uint32_t numAllocated = 0;
+	for (const env::RangeAllocation& allocation : allocations)
+		numAllocated += allocation.Size;
+	CHECK(allocator.GetNumAllocated() == numAllocated);
+	CHECK(allocator.GetNumAllocations() == allocations.size());
+	uint32_t numFreeRanges = allocator.GetNumFreeRanges();
+	uint32_t largestFreeRange = allocator.GetLargestFreeRange();
+
+	// Everything merges back into one range
+	for (const env::RangeAllocation& allocation : allocations)
+		allocator.Free(allocation);
+	CHECK(allocator.GetNumFreeRanges() == 1);
+	CHECK(allocator.GetLargestFreeRange() == HEAP_SIZE);
+
+	std::printf("  %d operations: allocate %.1f M/s, free %.1f M/s, %d failed\n",
+		numAllocations + numFrees,
+		numAllocations / allocateTime / 1000000.0,
+		numFrees / freeTime / 1000000.0,
+		numFailed);
+	std::printf("  Used %u of %u in %zu ranges, %u free ranges, largest %u\n",
+		numAllocated, HEAP_SIZE, allocations.size(), numFreeRanges, largestFreeRange);
+}
@@ -0,0 +1,231 @@
+#include "Test.h"
+#include "envision/core/RenderGraph.h"
+
+namespace
+{
+	// Values of D3D12_RESOURCE_STATES, opaque to the graph
+	const uint32_t STATE_PRESENT = 0x0;
+	const uint32_t STATE_RENDER_TARGET = 0x4;
+	const uint32_t STATE_DEPTH_WRITE = 0x10;
+	const uint32_t STATE_NON_PIXEL_SHADER_RESOURCE = 0x40;
+	const uint32_t STATE_PIXEL_SHADER_RESOURCE = 0x80;
+
+	env::RenderGraphTextureDesc GetTextureDesc(uint32_t size)
+	{
+		env::RenderGraphTextureDesc desc;
+		desc.Width = size;
+		desc.Height = size;
+		desc.NumBytes = (uint64_t)size * size * 4;
+		desc.Alignment = env::RenderGraph::PAGE_SIZE;
+		return desc;
+	}
+
+	bool HasBarrier(const env::RenderGraph& graph, uint32_t pass, env::RenderGraphBarrierType type, uint32_t resource)
+	{
+		const env::RenderGraphBarrier* barriers = graph.GetPassBarriers(pass);
+		for (uint32_t i = 0; i < graph.GetNumPassBarriers(pass); i++) {
+			if (barriers[i].Type == type && barriers[i].Resource == resource)
+				return true;
+		}
+		return false;
+	}
+}
+
+TEST(RenderGraph, CullsUnusedPasses)
+{
+	env::RenderGraph graph;
+	uint32_t backbuffer = graph.ImportResource("Backbuffer", STATE_PRESENT, STATE_PRESENT);
+	uint32_t unused = graph.CreateTexture("Unused", GetTextureDesc(256));
+	uint32_t color = graph.CreateTexture("Color", GetTextureDesc(256));
+
+	uint32_t unusedPass = graph.AddPass("Unused");
+	graph.Write(unusedPass, unused, STATE_RENDER_TARGET);
+
+	uint32_t colorPass = graph.AddPass("Color");
+	graph.Write(colorPass, color, STATE_RENDER_TARGET);
+
+	uint32_t readbackPass = graph.AddPass("Readback", true);
+	graph.Read(readbackPass, unused, STATE_PIXEL_SHADER_RESOURCE);
+
+	uint32_t presentPass = graph.AddPass("Present");
+	graph.Read(presentPass, color, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(presentPass, backbuffer, STATE_RENDER_TARGET);
+
+	uint32_t deadPass = graph.AddPass("Dead");
+	graph.Write(deadPass, color, STATE_RENDER_TARGET);
+
+	graph.Compile();
+
+	// The readback has side effects, so what it reads is kept as well
+	CHECK(!graph.IsPassCulled(unusedPass));
+	CHECK(!graph.IsPassCulled(colorPass));
+	CHECK(!graph.IsPassCulled(readbackPass));
+	CHECK(!graph.IsPassCulled(presentPass));
+	CHECK(graph.IsPassCulled(deadPass));
+	CHECK(graph.GetStatistics().NumCulledPasses == 1);
+	CHECK(graph.GetNumPassBarriers(deadPass) == 0);
+}
+
+TEST(RenderGraph, CullsChainsWithoutUse)
+{
+	env::RenderGraph graph;
+	uint32_t a = graph.CreateTexture("A", GetTextureDesc(256));
+	uint32_t b = graph.CreateTexture("B", GetTextureDesc(256));
+
+	uint32_t first = graph.AddPass("First");
+	graph.Write(first, a, STATE_RENDER_TARGET);
+	uint32_t second = graph.AddPass("Second");
+	graph.Read(second, a, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(second, b, STATE_RENDER_TARGET);
+
+	graph.Compile();
+
+	CHECK(graph.IsPassCulled(first));
+	CHECK(graph.IsPassCulled(second));
+	CHECK(!graph.IsResourceUsed(a));
+	CHECK(!graph.IsResourceUsed(b));
+	CHECK(graph.GetStatistics().NumTransientTextures == 0);
+	CHECK(graph.GetHeapSize() == 0);
+}
+
+TEST(RenderGraph, CombinesReadsAndRestoresImports)
+{
+	env::RenderGraph graph;
+	uint32_t backbuffer = graph.ImportResource("Backbuffer", STATE_PRESENT, STATE_PRESENT);
+	uint32_t depth = graph.ImportResource("Depth", STATE_DEPTH_WRITE);
+	uint32_t color = graph.CreateTexture("Color", GetTextureDesc(256));
+
+	uint32_t colorPass = graph.AddPass("Color");
+	graph.Write(colorPass, color, STATE_RENDER_TARGET);
+	graph.Write(colorPass, depth, STATE_DEPTH_WRITE);
+
+	uint32_t presentPass = graph.AddPass("Present");
+	graph.Read(presentPass, color, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Read(presentPass, color, STATE_NON_PIXEL_SHADER_RESOURCE);
+	graph.Read(presentPass, depth, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(presentPass, backbuffer, STATE_RENDER_TARGET);
+
+	graph.Compile();
+
+	// Depth starts in the state it is written in, the color texture has no
+	// state before its first use
+	CHECK(graph.GetNumPassBarriers(colorPass) == 1);
+	const env::RenderGraphBarrier& first = graph.GetPassBarriers(colorPass)[0];
+	CHECK(first.Type == env::RenderGraphBarrierType::Transition && first.Resource == color);
+	CHECK(first.StateBefore == env::RenderGraph::UNKNOWN_STATE && first.StateAfter == STATE_RENDER_TARGET);
+
+	// Both reads of the color texture in one transition
+	CHECK(graph.GetNumPassBarriers(presentPass) == 3);
+	const env::RenderGraphBarrier* barriers = graph.GetPassBarriers(presentPass);
+	bool hasCombinedRead = false;
+	for (uint32_t i = 0; i < graph.GetNumPassBarriers(presentPass); i++) {
+		if (barriers[i].Resource == color)
+			hasCombinedRead = barriers[i].StateAfter == (STATE_PIXEL_SHADER_RESOURCE | STATE_NON_PIXEL_SHADER_RESOURCE);
+	}
+	CHECK(hasCombinedRead);
+
+	// Only the backbuffer has a final state, depth stays as the last pass left it
+	CHECK(graph.GetNumFinalBarriers() == 1);
+	const env::RenderGraphBarrier& last = graph.GetFinalBarriers()[0];
+	CHECK(last.Resource == backbuffer);
+	CHECK(last.StateBefore == STATE_RENDER_TARGET && last.StateAfter == STATE_PRESENT);
+
+	const env::RenderGraphStatistics& statistics = graph.GetStatistics();
+	CHECK(statistics.NumTransitions == 5);
+	CHECK(statistics.NumBarrierBatches == 3);
+}
+
+TEST(RenderGraph, AliasesDisjointLifetimes)
+{
+	env::RenderGraph graph;
+	uint32_t backbuffer = graph.ImportResource("Backbuffer", STATE_PRESENT, STATE_PRESENT);
+	uint32_t a = graph.CreateTexture("A", GetTextureDesc(512));
+	uint32_t b = graph.CreateTexture("B", GetTextureDesc(512));
+	uint32_t c = graph.CreateTexture("C", GetTextureDesc(512));
+
+	uint32_t writeA = graph.AddPass("Write A");
+	graph.Write(writeA, a, STATE_RENDER_TARGET);
+
+	uint32_t writeB = graph.AddPass("Write B");
+	graph.Read(writeB, a, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(writeB, b, STATE_RENDER_TARGET);
+
+	// A is done, so C can take its memory
+	uint32_t writeC = graph.AddPass("Write C");
+	graph.Read(writeC, b, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(writeC, c, STATE_RENDER_TARGET);
+
+	uint32_t presentPass = graph.AddPass("Present");
+	graph.Read(presentPass, c, STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(presentPass, backbuffer, STATE_RENDER_TARGET);
+
+	graph.Compile();
+
+	uint64_t size = GetTextureDesc(512).NumBytes;
+	CHECK(graph.GetHeapOffset(a) == graph.GetHeapOffset(c));
+	CHECK(graph.GetHeapOffset(a) != graph.GetHeapOffset(b));
+	CHECK(graph.GetHeapSize() == 2 * size);
+	CHECK(graph.GetStatistics().TransientBytes == 3 * size);
+
+	CHECK(HasBarrier(graph, writeA, env::RenderGraphBarrierType::Aliasing, a));
+	CHECK(!HasBarrier(graph, writeB, env::RenderGraphBarrierType::Aliasing, b));
+	CHECK(HasBarrier(graph, writeC, env::RenderGraphBarrierType::Aliasing, c));
+	CHECK(graph.GetStatistics().NumAliasingBarriers == 2);
+}
+
+// A chain of passes, each reading the target of the one before and of a few
+// before that, with targets of varying size
+TEST(RenderGraph, CompileBenchmark)
+{
+	const uint32_t NUM_PASSES = 2000;
+	const uint32_t LONGEST_READ = 7;
+
+	env::RenderGraph graph;
+	std::vector<uint32_t> targets;
+
+	uint32_t backbuffer = graph.ImportResource("Backbuffer", STATE_PRESENT, STATE_PRESENT);
+	for (uint32_t i = 0; i < NUM_PASSES; i++) {
+		targets.push_back(graph.CreateTexture("Target", GetTextureDesc(256u << (i % 4))));
+
+		uint32_t pass = graph.AddPass("Pass");
+		graph.Write(pass, targets.back(), STATE_RENDER_TARGET);
+		for (uint32_t j = 2; j <= LONGEST_READ + 1 && j <= i + 1; j *= 2)
+			graph.Read(pass, targets[i + 1 - j], STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	uint32_t pass = graph.AddPass("Present");
+	graph.Read(pass, targets.back(), STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(pass, backbuffer, STATE_RENDER_TARGET);
+
+	double compileStart = env::test::Now();
+	graph.Compile();
+	double compileTime = env::test::Now() - compileStart;
+
+	const env::RenderGraphStatistics& statistics = graph.GetStatistics();
+	CHECK(statistics.NumCulledPasses == 0);
+	CHECK(statistics.NumTransientTextures == NUM_PASSES);
+	CHECK(statistics.HeapBytes < statistics.TransientBytes);
+
+	// Targets alive at the same time never share memory. Target i lives
+	// from pass i until the pass LONGEST_READ after it reads it, the last
+	// few are read less and end earlier.
+	bool noOverlaps = true;
+	for (uint32_t i = 0; i + LONGEST_READ < NUM_PASSES; i++) {
+		for (uint32_t k = i + 1; k <= i + LONGEST_READ; k++) {
+			uint64_t beginI = graph.GetHeapOffset(targets[i]);
+			uint64_t beginK = graph.GetHeapOffset(targets[k]);
+			uint64_t endI = beginI + graph.GetTextureDesc(targets[i]).NumBytes;
+			uint64_t endK = beginK + graph.GetTextureDesc(targets[k]).NumBytes;
+			noOverlaps = noOverlaps && (endI <= beginK || endK <= beginI);
+		}
+	}
+	CHECK(noOverlaps);
+
+	std::printf("  %u passes compiled in %.2f ms, %u barriers in %u batches, %.1f MB aliased into %.1f MB\n",
+		NUM_PASSES + 1,
+		compileTime * 1000.0,
+		statistics.NumTransitions + statistics.NumAliasingBarriers,
+		statistics.NumBarrierBatches,
+		statistics.TransientBytes / (1024.0 * 1024.0),
+		statistics.HeapBytes / (1024.0 * 1024.0));
+}
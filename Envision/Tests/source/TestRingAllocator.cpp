@@ -0,0 +1,113 @@
+#include "Test.h"
+#include "envision/core/RingAllocator.h"
+#include <deque>
+
+TEST(RingAllocator, AlignsOffsets)
+{
+	env::RingAllocator ring(1024);
+
+	CHECK(ring.Allocate(10) == 0);
+	CHECK(ring.Allocate(16, 16) == 16);
+	CHECK(ring.Allocate(1, 256) == 256);
+	CHECK(ring.GetUsed() == 257);
+	CHECK(ring.GetPendingSize() == 257);
+}
+
+TEST(RingAllocator, FailsWhenFull)
+{
+	env::RingAllocator ring(256);
+
+	CHECK(ring.Allocate(0) == env::RingAllocator::INVALID_OFFSET);
+	CHECK(ring.Allocate(257) == env::RingAllocator::INVALID_OFFSET);
+	CHECK(ring.Allocate(256) == 0);
+	CHECK(ring.Allocate(1) == env::RingAllocator::INVALID_OFFSET);
+}
+
+TEST(RingAllocator, ReclaimsInSubmitOrder)
+{
+	env::RingAllocator ring(256);
+
+	ring.Allocate(100);
+	ring.Submit(1);
+	ring.Allocate(100);
+	ring.Submit(2);
+	CHECK(ring.GetNumSubmissionsInFlight() == 2);
+	CHECK(ring.GetOldestFenceValue() == 1);
+
+	ring.Reclaim(0);
+	CHECK(ring.GetUsed() == 200);
+
+	ring.Reclaim(1);
+	CHECK(ring.GetUsed() == 100);
+	CHECK(ring.GetOldestFenceValue() == 2);
+
+	ring.Reclaim(2);
+	CHECK(ring.GetUsed() == 0);
+	CHECK(ring.GetNumSubmissionsInFlight() == 0);
+
+	// Empty again, so the whole ring is available in one piece
+	CHECK(ring.Allocate(256) == 0);
+}
+
+TEST(RingAllocator, WrapsAround)
+{
+	env::RingAllocator ring(256);
+
+	ring.Allocate(128);
+	ring.Submit(1);
+	CHECK(ring.Allocate(100) == 128);
+	ring.Submit(2);
+	ring.Reclaim(1);
+
+	// 28 bytes left at the end are skipped, the first 128 are free again
+	CHECK(ring.Allocate(64) == 0);
+	CHECK(ring.GetUsed() == 100 + 28 + 64);
+	CHECK(ring.Allocate(65) == env::RingAllocator::INVALID_OFFSET);
+	CHECK(ring.Allocate(64) == 64);
+}
+
+TEST(RingAllocator, FramesInFlightNeverOverlap)
+{
+	// Uploads of varying size, with the fence lagging two frames behind
+	const uint64_t CAPACITY = 1 << 20;
+	const int NUM_FRAMES = 10000;
+	env::RingAllocator ring(CAPACITY);
+
+	struct Range { uint64_t Begin, End, FenceValue; };
+	std::deque<Range> live;
+	uint32_t random = 12345;
+	int numFailed = 0;
+	bool overlaps = false;
+
+	double start = env::test::Now();
+	for (int frame = 1; frame <= NUM_FRAMES; frame++) {
+		if (frame > 2) {
+			ring.Reclaim(frame - 2);
+			while (!live.empty() && live.front().FenceValue <= (uint64_t)frame - 2)
+				live.pop_front();
+		}
+
+		for (int i = 0; i < 16; i++) {
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			uint64_t size = 1 + random % 32768;
+
+			uint64_t offset = ring.Allocate(size, 256);
+			if (offset == env::RingAllocator::INVALID_OFFSET) {
+				numFailed++;
+				continue;
+			}
+
+			CHECK(offset % 256 == 0 && offset + size <= CAPACITY);
+			for (const Range& range : live)
+				overlaps = overlaps || (offset < range.End && range.Begin < offset + size);
+			live.push_back({ offset, offset + size, (uint64_t)frame });
+		}
+		ring.Submit(frame);
+	}
+	double time = env::test::Now() - start;
+
+	CHECK(!overlaps);
+	std::printf("  %d frames: %.2f ms, %d allocations did not fit\n", NUM_FRAMES, time * 1000.0, numFailed);
+}
@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "envision/core/SceneBVH.h"
+#include <algorithm>
+#include <cfloat>
+#include <random>
+
+namespace
+{
+	std::vector<env::AABB> CreateRandomBoxes(size_t count, unsigned int seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+		std::uniform_real_distribution<float> size(0.5f, 20.f);
+
+		std::vector<env::AABB> boxes(count);
+		for (env::AABB& box : boxes) {
+			for (int i = 0; i < 3; i++) {
+				box.Min[i] = position(random);
+				box.Max[i] = box.Min[i] + size(random);
+			}
+		}
+		return boxes;
+	}
+
+	std::vector<uint64_t> CreateValues(size_t count)
+	{
+		std::vector<uint64_t> values(count);
+		for (size_t i = 0; i < count; i++)
+			values[i] = i;
+		return values;
+	}
+
+	bool Overlaps(const env::AABB& a, const env::AABB& b)
+	{
+		for (int i = 0; i < 3; i++) {
+			if (a.Max[i] < b.Min[i] || a.Min[i] > b.Max[i])
+				return false;
+		}
+		return true;
+	}
+
+	// Values of all boxes overlapping the query, sorted
+	std::vector<uint64_t> QueryBruteForce(const std::vector<env::AABB>& boxes, const env::AABB& query)
+	{
+		std::vector<uint64_t> results;
+		for (size_t i = 0; i < boxes.size(); i++) {
+			if (Overlaps(boxes[i], query))
+				results.push_back(i);
+		}
+		return results;
+	}
+
+	std::vector<uint64_t> Query(const env::SceneBVH& bvh, const env::AABB& query)
+	{
+		std::vector<uint64_t> results;
+		bvh.QueryAABB(query, results);
+		std::sort(results.begin(), results.end());
+		return results;
+	}
+}
+
+TEST(SceneBVH, BoxQueriesMatchBruteForce)
+{
+	const size_t COUNT = 100000;
+	std::vector<env::AABB> boxes = CreateRandomBoxes(COUNT, 1);
+	std::vector<uint64_t> values = CreateValues(COUNT);
+
+	env::SceneBVH bvh;
+	double buildStart = env::test::Now();
+	bvh.Build(boxes.data(), values.data(), COUNT);
+	double buildTime = env::test::Now() - buildStart;
+
+	CHECK(bvh.GetNumItems() == COUNT);
+
+	std::vector<env::AABB> queries = CreateRandomBoxes(100, 2);
+	bool allMatch = true;
+	double queryStart = env::test::Now();
+	for (const env::AABB& query : queries)
+		allMatch = allMatch && Query(bvh, query) == QueryBruteForce(boxes, query);
+	double queryTime = env::test::Now() - queryStart;
+	CHECK(allMatch);
+
+	std::printf("  %zu items: build %.2f ms, %zu nodes, depth %u, 100 checked queries %.2f ms\n",
+		COUNT, buildTime * 1000.0, bvh.GetNumNodes(), bvh.GetDepth(), queryTime * 1000.0);
+}
+
+TEST(SceneBVH, RefitFollowsMovedItems)
+{
+	const size_t COUNT = 1000;
+	std::vector<env::AABB> boxes = CreateRandomBoxes(COUNT, 3);
+	std::vector<uint64_t> values = CreateValues(COUNT);
+
+	env::SceneBVH bvh;
+	bvh.Build(boxes.data(), values.data(), COUNT);
+
+	// Every tenth item moves far outside of where anything was
+	for (size_t i = 0; i < COUNT; i += 10) {
+		for (int j = 0; j < 3; j++) {
+			boxes[i].Min[j] += 5000.f;
+			boxes[i].Max[j] += 5000.f;
+		}
+		bvh.SetItemBounds((uint32_t)i, boxes[i]);
+	}
+	bvh.Refit();
+
+	env::AABB everything = { { -10000.f, -10000.f, -10000.f }, { 10000.f, 10000.f, 10000.f } };
+	env::AABB moved = { { 3000.f, 3000.f, 3000.f }, { 7000.f, 7000.f, 7000.f } };
+	CHECK(Query(bvh, everything).size() == COUNT);
+	CHECK(Query(bvh, moved) == QueryBruteForce(boxes, moved));
+	CHECK(Query(bvh, moved).size() == COUNT / 10);
+}
+
+TEST(SceneBVH, RemovedItemsAreNotFound)
+{
+	const size_t COUNT = 1000;
+	std::vector<env::AABB> boxes = CreateRandomBoxes(COUNT, 4);
+	std::vector<uint64_t> values = CreateValues(COUNT);
+
+	env::SceneBVH bvh;
+	bvh.Build(boxes.data(), values.data(), COUNT);
+	for (uint32_t i = 0; i < COUNT; i += 2)
+		bvh.RemoveItem(i);
+	bvh.Refit();
+
+	env::AABB everything = { { -10000.f, -10000.f, -10000.f }, { 10000.f, 10000.f, 10000.f } };
+	std::vector<uint64_t> found = Query(bvh, everything);
+	CHECK(found.size() == COUNT / 2);
+	CHECK(std::all_of(found.begin(), found.end(), [](uint64_t value) { return value % 2 == 1; }));
+
+	// A ray through the center of a removed item misses it
+	const env::AABB& removed = boxes[0];
+	float origin[3] = { (removed.Min[0] + removed.Max[0]) * 0.5f, (removed.Min[1] + removed.Max[1]) * 0.5f, -5000.f };
+	float direction[3] = { 0.f, 0.f, 1.f };
+	uint64_t hitValue = ~0ull;
+	float hitDistance = 0.f;
+	if (bvh.Raycast(origin, direction, 20000.f, hitValue, hitDistance))
+		CHECK(hitValue != 0);
+
+	std::vector<uint64_t> visible;
+	env::Frustum frustum;
+	const float planes[6][4] = {
+		{ 1.f, 0.f, 0.f, 10000.f }, { -1.f, 0.f, 0.f, 10000.f },
+		{ 0.f, 1.f, 0.f, 10000.f }, { 0.f, -1.f, 0.f, 10000.f },
+		{ 0.f, 0.f, 1.f, 10000.f }, { 0.f, 0.f, -1.f, 10000.f } };
+	std::copy(&planes[0][0], &planes[0][0] + 24, &frustum.Planes[0][0]);
+	bvh.QueryFrustum(frustum, visible);
+	CHECK(visible.size() == COUNT / 2);
+}
+
+TEST(SceneBVH, RaycastFindsClosestItem)
+{
+	// A row of boxes along x, the ray starts left of them
+	std::vector<env::AABB> boxes;
+	for (int i = 0; i < 100; i++)
+		boxes.push_back({ { i * 10.f, -1.f, -1.f }, { i * 10.f + 2.f, 1.f, 1.f } });
+	std::vector<uint64_t> values = CreateValues(boxes.size());
+
+	env::SceneBVH bvh;
+	bvh.Build(boxes.data(), values.data(), boxes.size());
+
+	float origin[3] = { 55.f, 0.f, 0.f };
+	float direction[3] = { 1.f, 0.f, 0.f };
+	uint64_t hitValue = 0;
+	float hitDistance = 0.f;
+	CHECK(bvh.Raycast(origin, direction, 1000.f, hitValue, hitDistance));
+	CHECK(hitValue == 6);
+	CHECK(hitDistance == 5.f);
+
+	CHECK(!bvh.Raycast(origin, direction, 4.f, hitValue, hitDistance));
+
+	float up[3] = { 0.f, 1.f, 0.f };
+	CHECK(!bvh.Raycast(origin, up, 1000.f, hitValue, hitDistance));
+}
@@ -0,0 +1,148 @@
+#include "Test.h"
+#include "envision/core/SlotMap.h"
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+TEST(SlotMap, FindsInsertedValues)
+{
+	env::SlotMap<int> map(3);
+
+	uint64_t a = map.Insert(10);
+	uint64_t b = map.Insert(20);
+	CHECK(a != 0 && b != 0 && a != b);
+	CHECK(env::SlotMap<int>::GetTag(a) == 3);
+	CHECK((int64_t)a > 0);
+
+	CHECK(map.Find(a) && *map.Find(a) == 10);
+	CHECK(map.Find(b) && *map.Find(b) == 20);
+	CHECK(map.Contains(a));
+	CHECK(map.GetSize() == 2);
+}
+
+TEST(SlotMap, DetectsStaleHandles)
+{
+	env::SlotMap<int> map(1);
+
+	uint64_t old = map.Insert(1);
+	CHECK(map.Erase(old));
+	CHECK(!map.Erase(old));
+	CHECK(map.Find(old) == nullptr);
+
+	// The slot is reused with a new generation
+	uint64_t reused = map.Insert(2);
+	CHECK((uint32_t)reused == (uint32_t)old);
+	CHECK(reused != old);
+	CHECK(map.Find(old) == nullptr);
+	CHECK(map.Find(reused) && *map.Find(reused) == 2);
+}
+
+TEST(SlotMap, RejectsHandlesOfOtherMaps)
+{
+	env::SlotMap<int> first(1);
+	env::SlotMap<int> second(2);
+
+	uint64_t handle = first.Insert(1);
+	second.Insert(2);
+	CHECK(second.Find(handle) == nullptr);
+	CHECK(!second.Erase(handle));
+	CHECK(second.GetSize() == 1);
+}
+
+TEST(SlotMap, EraseKeepsValuesDense)
+{
+	env::SlotMap<std::unique_ptr<int>> map(1);
+
+	std::vector<uint64_t> handles;
+	for (int i = 0; i < 5; i++)
+		handles.push_back(map.Insert(std::make_unique<int>(i)));
+
+	// The last value moves into the hole and is still found by its handle
+	CHECK(map.Erase(handles[1]));
+	CHECK(map.GetSize() == 4);
+	CHECK(map.Find(handles[4]) && **map.Find(handles[4]) == 4);
+
+	int sum = 0;
+	for (const std::unique_ptr<int>& value : map)
+		sum += *value;
+	CHECK(sum == 0 + 2 + 3 + 4);
+}
+
+TEST(SlotMap, ClearInvalidatesEverything)
+{
+	env::SlotMap<int> map(1);
+
+	std::vector<uint64_t> handles;
+	for (int i = 0; i < 10; i++)
+		handles.push_back(map.Insert(i));
+	map.Clear();
+
+	CHECK(map.GetSize() == 0);
+	bool noneFound = true;
+	for (uint64_t handle : handles)
+		noneFound = noneFound && !map.Contains(handle);
+	CHECK(noneFound);
+
+	uint64_t handle = map.Insert(42);
+	CHECK(map.Find(handle) && *map.Find(handle) == 42);
+	CHECK(std::find(handles.begin(), handles.end(), handle) == handles.end());
+}
+
+// Two lookups per draw, as Renderer::EndFrame does for the vertex and index
+// buffer of every job. The unordered_map does it the way the ResourceManager
+// used to, count() and operator[].
+TEST(SlotMap, LookupBenchmark)
+{
+	struct Buffer
+	{
+		uint64_t NumBytes;
+	};
+
+	const size_t NUM_RESOURCES = 4096;
+	const size_t NUM_DRAWS = 100000;
+	const int NUM_ROUNDS = 10;
+
+	std::vector<Buffer> buffers(NUM_RESOURCES);
+	env::SlotMap<Buffer*> slotMap(1);
+	std::unordered_map<int64_t, Buffer*> hashMap;
+	std::vector<int64_t> ids;
+	for (size_t i = 0; i < NUM_RESOURCES; i++) {
+		buffers[i].NumBytes = i;
+		int64_t id = (int64_t)slotMap.Insert(&buffers[i]);
+		hashMap[id] = &buffers[i];
+		ids.push_back(id);
+	}
+
+	// Draws don't come in creation order
+	std::vector<int64_t> drawIDs;
+	for (size_t i = 0; i < NUM_DRAWS * 2; i++)
+		drawIDs.push_back(ids[(i * 2654435761u) % ids.size()]);
+
+	uint64_t slotMapSum = 0;
+	double slotMapStart = env::test::Now();
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		for (int64_t id : drawIDs) {
+			Buffer** buffer = slotMap.Find((uint64_t)id);
+			slotMapSum += buffer ? (*buffer)->NumBytes : 0;
+		}
+	}
+	double slotMapTime = (env::test::Now() - slotMapStart) / NUM_ROUNDS;
+
+	uint64_t hashMapSum = 0;
+	double hashMapStart = env::test::Now();
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		for (int64_t id : drawIDs) {
+			Buffer* buffer = (hashMap.count(id) == 0) ? nullptr : hashMap[id];
+			hashMapSum += buffer ? buffer->NumBytes : 0;
+		}
+	}
+	double hashMapTime = (env::test::Now() - hashMapStart) / NUM_ROUNDS;
+
+	CHECK(slotMapSum == hashMapSum);
+	env::test::DoNotOptimize(slotMapSum);
+
+	std::printf("  %zu draws: slot map %.1f ns, hash map %.1f ns per draw\n",
+		NUM_DRAWS,
+		slotMapTime * 1e9 / NUM_DRAWS,
+		hashMapTime * 1e9 / NUM_DRAWS);
+}
@@ -0,0 +1,201 @@
+#include "Test.h"
+#include "envision/core/TransformPool.h"
+#include <cmath>
+#include <random>
+
+namespace
+{
+	// Scale * rotation * translation written out as three matrix products,
+	// independent of the expanded formulas of ComposeWorldMatrix
+	void ComposeReference(const float* position, const float* rotation, const float* scale, float* matrix)
+	{
+		const float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+
+		const float rotationMatrix[3][3] = {
+			{ 1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y) },
+			{ 2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x) },
+			{ 2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y) } };
+
+		for (int row = 0; row < 3; row++) {
+			for (int column = 0; column < 3; column++)
+				matrix[row * 4 + column] = scale[row] * rotationMatrix[row][column];
+			matrix[row * 4 + 3] = 0.f;
+		}
+
+		matrix[12] = position[0];
+		matrix[13] = position[1];
+		matrix[14] = position[2];
+		matrix[15] = 1.f;
+	}
+
+	bool IsNear(const float* a, const float* b, float epsilon)
+	{
+		for (int i = 0; i < 16; i++) {
+			if (std::fabs(a[i] - b[i]) > epsilon)
+				return false;
+		}
+		return true;
+	}
+
+	void SetRandomTransform(env::TransformPool& pool, uint32_t index, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> position(-100.f, 100.f);
+		std::uniform_real_distribution<float> component(-1.f, 1.f);
+		std::uniform_real_distribution<float> scale(0.1f, 4.f);
+
+		float rotation[4];
+		float length = 0.f;
+		while (length < 0.01f) {
+			for (float& value : rotation)
+				value = component(random);
+			length = std::sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]);
+		}
+
+		pool.SetPosition(index, position(random), position(random), position(random));
+		pool.SetRotation(index, rotation[0] / length, rotation[1] / length, rotation[2] / length, rotation[3] / length);
+		pool.SetScale(index, scale(random), scale(random), scale(random));
+	}
+}
+
+TEST(TransformPool, KnownMatrix)
+{
+	env::TransformPool pool;
+	uint32_t index = pool.Add(0);
+
+	// A quarter turn around y takes x to -z
+	const float halfAngle = 3.14159265f * 0.25f;
+	pool.SetPosition(index, 1.f, 2.f, 3.f);
+	pool.SetRotation(index, 0.f, std::sin(halfAngle), 0.f, std::cos(halfAngle));
+	pool.SetScale(index, 2.f, 2.f, 2.f);
+	pool.ComposeWorldMatrices();
+
+	const float expected[16] = {
+		0.f, 0.f, -2.f, 0.f,
+		0.f, 2.f, 0.f, 0.f,
+		2.f, 0.f, 0.f, 0.f,
+		1.f, 2.f, 3.f, 1.f };
+	CHECK(IsNear(pool.GetWorldMatrix(index), expected, 1e-5f));
+}
+
+TEST(TransformPool, BatchMatchesReference)
+{
+	// Not a multiple of four, so the scalar tail is covered as well
+	const uint32_t COUNT = 1003;
+
+	env::TransformPool pool;
+	std::mt19937 random(1);
+	for (uint32_t i = 0; i < COUNT; i++)
+		SetRandomTransform(pool, pool.Add(i), random);
+
+	CHECK(pool.HasChanged());
+	pool.ComposeWorldMatrices();
+	CHECK(!pool.HasChanged());
+
+	bool allMatch = true;
+	for (uint32_t i = 0; i < COUNT; i++) {
+		float position[3], rotation[4], scale[3], expected[16];
+		pool.GetPosition(i, position);
+		pool.GetRotation(i, rotation);
+		pool.GetScale(i, scale);
+		ComposeReference(position, rotation, scale, expected);
+
+		allMatch = allMatch && IsNear(pool.GetWorldMatrix(i), expected, 1e-4f);
+	}
+	CHECK(allMatch);
+}
+
+TEST(TransformPool, NewSlotsAreIdentity)
+{
+	env::TransformPool pool;
+	uint32_t index = pool.Add(7);
+	pool.ComposeWorldMatrices();
+
+	const float identity[16] = {
+		1.f, 0.f, 0.f, 0.f,
+		0.f, 1.f, 0.f, 0.f,
+		0.f, 0.f, 1.f, 0.f,
+		0.f, 0.f, 0.f, 1.f };
+	CHECK(IsNear(pool.GetWorldMatrix(index), identity, 0.f));
+	CHECK(pool.GetOwner(index) == 7);
+}
+
+TEST(TransformPool, RemoveMovesLastSlot)
+{
+	env::TransformPool pool;
+	for (uint64_t owner = 10; owner < 14; owner++) {
+		uint32_t index = pool.Add(owner);
+		pool.SetPosition(index, (float)owner, 0.f, 0.f);
+	}
+	pool.ComposeWorldMatrices();
+
+	// The last slot moves into the hole, matrix and all
+	CHECK(pool.Remove(1) == 13);
+	CHECK(pool.GetSize() == 3);
+	CHECK(pool.GetOwner(1) == 13);
+	CHECK(pool.GetWorldMatrix(1)[12] == 13.f);
+
+	float position[3];
+	pool.GetPosition(1, position);
+	CHECK(position[0] == 13.f);
+
+	// Removing the last slot moves nothing
+	CHECK(pool.Remove(2) == 12);
+	CHECK(pool.GetSize() == 2);
+	CHECK(pool.GetOwner(0) == 10);
+	CHECK(pool.GetOwner(1) == 13);
+}
+
+TEST(TransformPool, GrowKeepsTransforms)
+{
+	env::TransformPool pool;
+	pool.Reserve(4);
+	for (uint32_t i = 0; i < 1000; i++) {
+		uint32_t index = pool.Add(i);
+		pool.SetPosition(index, (float)i, 0.f, 0.f);
+	}
+
+	bool allKept = true;
+	for (uint32_t i = 0; i < 1000; i++) {
+		float position[3];
+		pool.GetPosition(i, position);
+		allKept = allKept && position[0] == (float)i && pool.GetOwner(i) == i;
+	}
+	CHECK(allKept);
+}
+
+TEST(TransformPool, ComposeBenchmark)
+{
+	const uint32_t COUNT = 100000;
+	const int NUM_ROUNDS = 10;
+
+	env::TransformPool pool;
+	pool.Reserve(COUNT);
+	std::mt19937 random(2);
+	for (uint32_t i = 0; i < COUNT; i++)
+		SetRandomTransform(pool, pool.Add(i), random);
+
+	// One matrix at a time against four per iteration
+	std::vector<float> matrices(COUNT * 16);
+	env::TransformArrays arrays = pool.GetArrays();
+	double singleStart = env::test::Now();
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		for (uint32_t i = 0; i < COUNT; i++)
+			env::ComposeWorldMatrix(arrays, i, matrices.data() + i * 16);
+		env::test::DoNotOptimize(matrices[round]);
+	}
+	double singleTime = (env::test::Now() - singleStart) / NUM_ROUNDS;
+
+	double batchStart = env::test::Now();
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		pool.ComposeWorldMatrices();
+		env::test::DoNotOptimize(pool.GetWorldMatrix(round)[0]);
+	}
+	double batchTime = (env::test::Now() - batchStart) / NUM_ROUNDS;
+
+	bool allMatch = true;
+	for (uint32_t i = 0; i < COUNT; i++)
+		allMatch = allMatch && IsNear(pool.GetWorldMatrix(i), matrices.data() + i * 16, 1e-5f);
+	CHECK(allMatch);
+
+	std::printf("  %u matrices: batch %.2f ms, one at a time %.2f ms\n", COUNT, batchTime * 1000.0, singleTime * 1000.0);
+}
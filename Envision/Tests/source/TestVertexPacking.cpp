@@ -0,0 +1,226 @@
+#include "Test.h"
+#include "envision/core/VertexPacking.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace
+{
+	// Same layout as env::VertexType, which needs the engine headers
+	struct PackedVertex
+	{
+		int16_t Position[4];
+		int16_t Normal[2];
+		uint16_t Texcoord[2];
+	};
+
+	// Position, normal and texcoord as floats, the layout vertices are packed from
+	struct FloatVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float Texcoord[2];
+	};
+
+	// In degrees. Computed in double, the cosine of angles this small is
+	// within float precision of one.
+	float GetAngle(const float* a, const float* b)
+	{
+		double dot = (double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2];
+		double lengths = std::sqrt(((double)a[0] * a[0] + (double)a[1] * a[1] + (double)a[2] * a[2]) *
+			((double)b[0] * b[0] + (double)b[1] * b[1] + (double)b[2] * b[2]));
+		return (float)(std::acos(std::min(dot / lengths, 1.0)) * 180.0 / 3.14159265358979);
+	}
+
+	void Normalize(float* vector)
+	{
+		float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+		for (int i = 0; i < 3; i++)
+			vector[i] /= length;
+	}
+}
+
+TEST(VertexPacking, HalfKnownValues)
+{
+	const float INFINITE = std::numeric_limits<float>::infinity();
+
+	CHECK(env::FloatToHalf(0.f) == 0x0000);
+	CHECK(env::FloatToHalf(-0.f) == 0x8000);
+	CHECK(env::FloatToHalf(1.f) == 0x3c00);
+	CHECK(env::FloatToHalf(-2.f) == 0xc000);
+	CHECK(env::FloatToHalf(65504.f) == 0x7bff);
+	CHECK(env::FloatToHalf(65520.f) == 0x7c00); // Rounds up to infinity
+	CHECK(env::FloatToHalf(1e10f) == 0x7c00);
+	CHECK(env::FloatToHalf(INFINITE) == 0x7c00);
+	CHECK(env::FloatToHalf(-INFINITE) == 0xfc00);
+
+	uint16_t nan = env::FloatToHalf(std::numeric_limits<float>::quiet_NaN());
+	CHECK((nan & 0x7c00) == 0x7c00 && (nan & 0x03ff) != 0);
+
+	// Subnormals, and ties rounding to even
+	CHECK(env::FloatToHalf(std::ldexp(1.f, -24)) == 0x0001);
+	CHECK(env::FloatToHalf(std::ldexp(1.f, -25)) == 0x0000);
+	CHECK(env::FloatToHalf(std::ldexp(3.f, -25)) == 0x0002);
+	CHECK(env::FloatToHalf(1.f + std::ldexp(1.f, -11)) == 0x3c00);
+	CHECK(env::FloatToHalf(1.f + std::ldexp(3.f, -11)) == 0x3c02);
+}
+
+TEST(VertexPacking, HalfRoundTrips)
+{
+	bool allMatch = true;
+	for (uint32_t half = 0; half <= 0xffff; half++) {
+		bool isNaN = (half & 0x7c00) == 0x7c00 && (half & 0x03ff) != 0;
+		if (!isNaN)
+			allMatch = allMatch && env::FloatToHalf(env::HalfToFloat((uint16_t)half)) == half;
+	}
+	CHECK(allMatch);
+	CHECK(env::HalfToFloat(0x3c00) == 1.f);
+	CHECK(env::HalfToFloat(0x0001) == std::ldexp(1.f, -24));
+}
+
+TEST(VertexPacking, Snorm16Clamps)
+{
+	CHECK(env::FloatToSnorm16(0.f) == 0);
+	CHECK(env::FloatToSnorm16(1.f) == 32767);
+	CHECK(env::FloatToSnorm16(-1.f) == -32767);
+	CHECK(env::FloatToSnorm16(2.f) == 32767);
+	CHECK(env::FloatToSnorm16(-2.f) == -32767);
+	CHECK(env::FloatToSnorm16(1.f / 32767.f) == 1);
+}
+
+TEST(VertexPacking, OctahedralRoundTrips)
+{
+	int16_t encoded[2];
+	float decoded[3];
+
+	const float zero[3] = { 0.f, 0.f, 0.f };
+	env::EncodeOctahedral(zero, encoded);
+	CHECK(encoded[0] == 0 && encoded[1] == 0);
+
+	// Axes are corners and edges of the octahedron, they are exact
+	const float axes[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	bool axesExact = true;
+	for (const float* axis : axes) {
+		env::EncodeOctahedral(axis, encoded);
+		env::DecodeOctahedral(encoded, decoded);
+		axesExact = axesExact && decoded[0] == axis[0] && decoded[1] == axis[1] && decoded[2] == axis[2];
+	}
+	CHECK(axesExact);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	float maxError = 0.f;
+	for (int i = 0; i < 100000; i++) {
+		float normal[3] = { unit(random), unit(random), unit(random) };
+		Normalize(normal);
+		env::EncodeOctahedral(normal, encoded);
+		env::DecodeOctahedral(encoded, decoded);
+		maxError = std::max(maxError, GetAngle(normal, decoded));
+	}
+	CHECK(maxError < 0.01f);
+}
+
+// Positions in a city sized box, unit normals and tiling texcoords, packed
+// four at a time and one at a time. The results have to be the same bytes.
+TEST(VertexPacking, BatchMatchesScalar)
+{
+	// Not a multiple of four, so the tail is covered as well
+	const size_t COUNT = 1000003;
+
+	std::vector<FloatVertex> vertices(COUNT);
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> unit(-1.f, 1.f);
+	for (FloatVertex& vertex : vertices) {
+		vertex.Position[0] = unit(random) * 500.f;
+		vertex.Position[1] = unit(random) * 50.f + 50.f;
+		vertex.Position[2] = unit(random) * 500.f;
+		vertex.Normal[0] = unit(random);
+		vertex.Normal[1] = unit(random);
+		vertex.Normal[2] = unit(random);
+		Normalize(vertex.Normal);
+		vertex.Texcoord[0] = unit(random) * 4.f;
+		vertex.Texcoord[1] = unit(random) * 4.f;
+	}
+
+	// Values the encoders have to agree on as well
+	vertices[1].Normal[0] = vertices[1].Normal[1] = vertices[1].Normal[2] = 0.f;
+	vertices[2].Texcoord[0] = 1e6f;
+	vertices[2].Texcoord[1] = std::ldexp(1.f, -20);
+	vertices[3].Position[0] = -500.f;
+
+	float boundsMin[3] = { 1e30f, 1e30f, 1e30f };
+	float boundsMax[3] = { -1e30f, -1e30f, -1e30f };
+	for (const FloatVertex& vertex : vertices) {
+		for (int i = 0; i < 3; i++) {
+			boundsMin[i] = std::min(boundsMin[i], vertex.Position[i]);
+			boundsMax[i] = std::max(boundsMax[i], vertex.Position[i]);
+		}
+	}
+	float center[3], extents[3], scale[3];
+	for (int i = 0; i < 3; i++) {
+		center[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+		extents[i] = (boundsMax[i] - boundsMin[i]) * 0.5f;
+		scale[i] = (extents[i] > 0.f) ? 1.f / extents[i] : 0.f;
+	}
+
+	std::vector<PackedVertex> packed(COUNT);
+	double packStart = env::test::Now();
+	env::PackPositions(vertices[0].Position, sizeof(FloatVertex), COUNT, center, extents, packed[0].Position, sizeof(PackedVertex));
+	env::PackOctahedralNormals(vertices[0].Normal, sizeof(FloatVertex), COUNT, packed[0].Normal, sizeof(PackedVertex));
+	env::PackHalf2(vertices[0].Texcoord, sizeof(FloatVertex), COUNT, packed[0].Texcoord, sizeof(PackedVertex));
+	double packTime = env::test::Now() - packStart;
+
+	std::vector<PackedVertex> packedScalar(COUNT);
+	double scalarStart = env::test::Now();
+	for (size_t i = 0; i < COUNT; i++) {
+		const FloatVertex& vertex = vertices[i];
+		PackedVertex& result = packedScalar[i];
+		for (int k = 0; k < 3; k++)
+			result.Position[k] = env::FloatToSnorm16((vertex.Position[k] - center[k]) * scale[k]);
+		result.Position[3] = 0;
+		env::EncodeOctahedral(vertex.Normal, result.Normal);
+		result.Texcoord[0] = env::FloatToHalf(vertex.Texcoord[0]);
+		result.Texcoord[1] = env::FloatToHalf(vertex.Texcoord[1]);
+	}
+	double scalarTime = env::test::Now() - scalarStart;
+
+	CHECK(memcmp(packed.data(), packedScalar.data(), COUNT * sizeof(PackedVertex)) == 0);
+
+	// Each value is within half a step of its encoding, the special values
+	// above are left out
+	float maxPositionError[3] = { 0.f, 0.f, 0.f };
+	float maxNormalError = 0.f;
+	float maxTexcoordError = 0.f;
+	for (size_t i = 4; i < COUNT; i++) {
+		const FloatVertex& vertex = vertices[i];
+		const PackedVertex& result = packed[i];
+
+		for (int k = 0; k < 3; k++) {
+			float position = center[k] + std::max(result.Position[k] / 32767.f, -1.f) * extents[k];
+			maxPositionError[k] = std::max(maxPositionError[k], std::fabs(position - vertex.Position[k]));
+		}
+
+		float normal[3];
+		env::DecodeOctahedral(result.Normal, normal);
+		maxNormalError = std::max(maxNormalError, GetAngle(normal, vertex.Normal));
+
+		for (int k = 0; k < 2; k++)
+			maxTexcoordError = std::max(maxTexcoordError, std::fabs(env::HalfToFloat(result.Texcoord[k]) - vertex.Texcoord[k]));
+	}
+
+	for (int k = 0; k < 3; k++)
+		CHECK(maxPositionError[k] <= extents[k] / 32767.f * 0.5f * 1.01f);
+	CHECK(maxNormalError < 0.01f);
+	CHECK(maxTexcoordError <= std::ldexp(1.f, -10)); // Half a step of a half in [2, 4)
+
+	std::printf("  %zu vertices: batch %.2f ns, one at a time %.2f ns per vertex\n",
+		COUNT,
+		packTime * 1e9 / COUNT,
+		scalarTime * 1e9 / COUNT);
+	std::printf("  Max error: position %.4f, normal %.4f deg, texcoord %.5f\n",
+		std::max(maxPositionError[0], std::max(maxPositionError[1], maxPositionError[2])),
+		maxNormalError,
+		maxTexcoordError);
+}
@@ -0,0 +1,70 @@
+#include "Test.h"
+#include "envision/core/JobSystem.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	int s_numFailures = 0;
+}
+
+std::vector<env::test::TestCase>& env::test::GetTests()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+void env::test::ReportFailure(const char* file, int line, const char* expression)
+{
+	std::printf("  %s(%d): CHECK(%s) failed\n", file, line, expression);
+	s_numFailures++;
+}
+
+// Runs every test, or only those whose name starts with one of the
+// arguments, e.g. "JobSystem" or "JobSystem.Dependencies". Returns nonzero
+// if any check failed or an argument matched no test.
+int main(int argc, char** argv)
+{
+	// At least a few workers, so stealing and waiting inside jobs are
+	// exercised on small machines too
+	env::JobSystem::Initialize(std::max(4u, std::thread::hardware_concurrency()));
+
+	int numRun = 0;
+	int numFailed = 0;
+	bool allMatched = true;
+
+	std::vector<bool> selected(env::test::GetTests().size(), argc <= 1);
+	for (int i = 1; i < argc; i++) {
+		bool matched = false;
+		for (size_t j = 0; j < selected.size(); j++) {
+			if (std::strncmp(env::test::GetTests()[j].Name, argv[i], std::strlen(argv[i])) == 0) {
+				selected[j] = true;
+				matched = true;
+			}
+		}
+		if (!matched) {
+			std::printf("No test matches %s\n", argv[i]);
+			allMatched = false;
+		}
+	}
+
+	for (size_t i = 0; i < selected.size(); i++) {
+		if (!selected[i])
+			continue;
+
+		const env::test::TestCase& test = env::test::GetTests()[i];
+		std::printf("%s\n", test.Name);
+
+		int numFailuresBefore = s_numFailures;
+		test.Function();
+		numRun++;
+		if (s_numFailures > numFailuresBefore)
+			numFailed++;
+	}
+
+	std::printf("%d of %d tests passed\n", numRun - numFailed, numRun);
+
+	env::JobSystem::Finalize();
+	return (numFailed == 0 && allMatched) ? 0 : 1;
+}